@@ -0,0 +1,253 @@
+#include "Arena.h"
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <new>
+
+#ifdef _WIN32
+#include <malloc.h>
+#endif
+
+namespace meta
+{
+	namespace
+	{
+		//what operator new already aligns for
+		const size_t newAlignment = std::alignment_of<std::max_align_t>::value;
+
+		class HeapMemory : public MemoryResource
+		{
+		public:
+			void* Allocate(size_t bytes, size_t alignment)
+			{
+				if (alignment <= newAlignment)
+				{
+					return ::operator new(bytes);
+				}
+
+#ifdef _WIN32
+				void* data = _aligned_malloc(bytes, alignment);
+#else
+				void* data = NULL;
+				if (posix_memalign(&data, alignment, bytes) != 0)
+				{
+					data = NULL;
+				}
+#endif
+				if (data == NULL)
+				{
+					throw std::bad_alloc();
+				}
+				return data;
+			}
+
+			void Deallocate(void* data, size_t, size_t alignment)
+			{
+				if (alignment <= newAlignment)
+				{
+					::operator delete(data);
+					return;
+				}
+
+#ifdef _WIN32
+				_aligned_free(data);
+#else
+				free(data);
+#endif
+			}
+		};
+
+		//chunks come from upstream aligned for anything; wider alignments are made inside them
+		const size_t chunkAlignment = 16;
+
+		META_THREAD_LOCAL MemoryResource* currentResource = NULL;
+
+		char* AlignUp(char* at, size_t alignment)
+		{
+			uintptr_t address = reinterpret_cast<uintptr_t>(at);
+			return reinterpret_cast<char*>((address + alignment - 1) & ~(uintptr_t)(alignment - 1));
+		}
+	}
+
+	MemoryResource* HeapResource(void)
+	{
+		//a function static, so arena members of other static objects can use it
+		static HeapMemory heap;
+		return &heap;
+	}
+
+	namespace
+	{
+		//built during static initialization, while there's one thread: VS2013's function statics aren't thread safe
+		MemoryResource* const eagerHeap = HeapResource();
+	}
+
+	MemoryResource* CurrentResource(void)
+	{
+		return currentResource != NULL ? currentResource : HeapResource();
+	}
+
+	ScopedResource::ScopedResource(MemoryResource* resource) : previous(currentResource)
+	{
+		currentResource = resource;
+	}
+
+	ScopedResource::~ScopedResource()
+	{
+		currentResource = previous;
+	}
+
+	//////////////////////////////////////////////////////////////////////////////
+	//  MonotonicArena
+	//////////////////////////////////////////////////////////////////////////////
+
+	MonotonicArena::MonotonicArena(size_t chunkSize, MemoryResource* upstream) : upstream(upstream), chunkSize(chunkSize), current(0), at(NULL), end(NULL), used(0)
+	{
+	}
+
+	MonotonicArena::~MonotonicArena()
+	{
+		Release();
+	}
+
+	void* MonotonicArena::Allocate(size_t bytes, size_t alignment)
+	{
+		alignment = alignment > 0 ? alignment : 1;
+		if (at != NULL)
+		{
+			char* aligned = AlignUp(at, alignment);
+			if (aligned <= end && bytes <= (size_t)(end - aligned))
+			{
+				at = aligned + bytes;
+				return aligned;
+			}
+		}
+
+		if (!NextChunk(bytes, alignment))
+		{
+			return NULL;
+		}
+		char* aligned = AlignUp(at, alignment);
+		at = aligned + bytes;
+		return aligned;
+	}
+
+	void MonotonicArena::Deallocate(void*, size_t, size_t)
+	{
+	}
+
+	//the first chunk after the current one with room, reused from before a Reset or new from upstream
+	bool MonotonicArena::NextChunk(size_t bytes, size_t alignment)
+	{
+		size_t needed = bytes + (alignment > chunkAlignment ? alignment : 0);
+		unsigned next = 0;
+		if (at != NULL)
+		{
+			used += at - chunks[current].data;
+			next = current + 1;
+		}
+
+		while (next < chunks.size() && chunks[next].size < needed)
+		{
+			++next;
+		}
+		if (next == chunks.size())
+		{
+			Chunk chunk;
+			chunk.size = std::max(chunkSize, needed);
+			chunk.data = static_cast<char*>(upstream->Allocate(chunk.size, chunkAlignment));
+			if (chunk.data == NULL)
+			{
+				std::cout << "MonotonicArena is out of memory allocating " << chunk.size << " bytes" << std::endl;
+				return false;
+			}
+			chunks.push_back(chunk);
+		}
+
+		current = next;
+		at = chunks[current].data;
+		end = at + chunks[current].size;
+		return true;
+	}
+
+	void MonotonicArena::Reset(void)
+	{
+		used = 0;
+		current = 0;
+		if (chunks.empty())
+		{
+			at = end = NULL;
+			return;
+		}
+		at = chunks[0].data;
+		end = at + chunks[0].size;
+	}
+
+	void MonotonicArena::Release(void)
+	{
+		for (unsigned i = 0; i < chunks.size(); ++i)
+		{
+			upstream->Deallocate(chunks[i].data, chunks[i].size, chunkAlignment);
+		}
+		chunks.clear();
+		Reset();
+	}
+
+	size_t MonotonicArena::BytesUsed(void) const
+	{
+		return at != NULL ? used + (at - chunks[current].data) : used;
+	}
+
+	size_t MonotonicArena::BytesReserved(void) const
+	{
+		size_t reserved = 0;
+		for (unsigned i = 0; i < chunks.size(); ++i)
+		{
+			reserved += chunks[i].size;
+		}
+		return reserved;
+	}
+
+	//////////////////////////////////////////////////////////////////////////////
+	//  Objects in a resource
+	//////////////////////////////////////////////////////////////////////////////
+
+	void* NewObjects(const Type* type, unsigned count, MemoryResource* resource)
+	{
+		if (!type->IsConstructible())
+		{
+			std::cout << type->Name() << " can't be default constructed" << std::endl;
+			return NULL;
+		}
+
+		char* objects = static_cast<char*>(resource->Allocate((size_t)type->Size() * count, type->Alignment()));
+		if (objects == NULL)
+		{
+			return NULL;
+		}
+
+		ScopedResource scope(resource);
+		for (unsigned i = 0; i < count; ++i)
+		{
+			type->Construct(objects + (size_t)i * type->Size());
+		}
+		return objects;
+	}
+
+	void DeleteObjects(const Type* type, void* objects, unsigned count, MemoryResource* resource)
+	{
+		if (objects == NULL)
+		{
+			return;
+		}
+
+		char* object = static_cast<char*>(objects);
+		for (unsigned i = 0; i < count; ++i)
+		{
+			type->Destruct(object + (size_t)i * type->Size());
+		}
+		resource->Deallocate(objects, (size_t)type->Size() * count, type->Alignment());
+	}
+}
@@ -0,0 +1,187 @@
+#pragma once
+
+#include "Meta.h"
+#include <memory>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace meta
+{
+	//////////////////////////////////////////////////////////////////////////////
+	//  MemoryResource
+	//////////////////////////////////////////////////////////////////////////////
+	// Purpose: Where an ArenaAllocator gets its memory, shaped like std::pmr::memory_resource
+	//          so it can be swapped for it once the toolset has <memory_resource>.
+	class MemoryResource
+	{
+	public:
+		virtual ~MemoryResource() {}
+
+		virtual void* Allocate(size_t bytes, size_t alignment) = 0;
+		virtual void Deallocate(void* data, size_t bytes, size_t alignment) = 0;
+	};
+
+	//operator new and delete
+	MemoryResource* HeapResource(void);
+
+	//The resource default constructed ArenaAllocators take on this thread: the innermost
+	//ScopedResource's, or the heap.
+	MemoryResource* CurrentResource(void);
+
+	//////////////////////////////////////////////////////////////////////////////
+	//  ScopedResource
+	//////////////////////////////////////////////////////////////////////////////
+	// Purpose: Makes resource the current one on this thread for its scope, so objects
+	//          constructed inside it (and the arena members of those objects) allocate from it.
+	class ScopedResource
+	{
+	public:
+		explicit ScopedResource(MemoryResource* resource);
+		~ScopedResource();
+
+	private:
+		// Non-Copyable
+		ScopedResource(const ScopedResource&); // = delete
+		void operator=(const ScopedResource&); // = delete
+
+		MemoryResource* previous;
+	};
+
+	//////////////////////////////////////////////////////////////////////////////
+	//  MonotonicArena
+	//////////////////////////////////////////////////////////////////////////////
+	// Purpose: Bump allocation out of chunks taken from upstream. Deallocate does nothing; the
+	//          whole arena is given back at once, so a document's objects and every string and
+	//          array they own are freed together without running a destructor, provided all
+	//          of their memory came from the arena.
+	class MonotonicArena : public MemoryResource
+	{
+	public:
+		explicit MonotonicArena(size_t chunkSize = 64 * 1024, MemoryResource* upstream = HeapResource());
+		~MonotonicArena();
+
+		void* Allocate(size_t bytes, size_t alignment);
+		void Deallocate(void* data, size_t bytes, size_t alignment);
+
+		//Rewinds to the first chunk and keeps every chunk for the next document. O(1): nothing
+		//allocated from the arena may be used afterwards.
+		void Reset(void);
+
+		//gives the chunks back to upstream
+		void Release(void);
+
+		size_t BytesUsed(void) const;		//handed out since the last Reset, alignment included
+		size_t BytesReserved(void) const;	//held in chunks
+
+	private:
+		// Non-Copyable
+		MonotonicArena(const MonotonicArena&); // = delete
+		void operator=(const MonotonicArena&); // = delete
+
+		struct Chunk
+		{
+			char* data;
+			size_t size;
+		};
+
+		bool NextChunk(size_t bytes, size_t alignment);
+
+		MemoryResource* upstream;
+		size_t chunkSize;
+		std::vector<Chunk> chunks;
+		unsigned current; //chunk being bumped through; chunks.size() when there's none
+		char* at;
+		char* end;
+		size_t used;	//by the chunks before current
+	};
+
+	//////////////////////////////////////////////////////////////////////////////
+	//  ArenaAllocator
+	//////////////////////////////////////////////////////////////////////////////
+	// Purpose: A standard allocator over a MemoryResource, like std::pmr::polymorphic_allocator.
+	//          Default constructed it takes the current resource, which is how objects built
+	//          by NewObjects (or under a ScopedResource) tie their members to an arena. Copies
+	//          made with the copy constructor take the current resource too, never the source's.
+	//          Elements that take an allocator are given this one when constructed, so the
+	//          strings in an ArenaVector<ArenaString> moved to another arena move with it.
+	template <typename T>
+	class ArenaAllocator
+	{
+	public:
+		typedef T value_type;
+
+		ArenaAllocator() : resource(CurrentResource()) {}
+		ArenaAllocator(MemoryResource* resource) : resource(resource) {}
+		template <typename U>
+		ArenaAllocator(const ArenaAllocator<U>& other) : resource(other.Resource()) {}
+
+		T* allocate(size_t count)
+		{
+			return static_cast<T*>(resource->Allocate(count * sizeof(T), std::alignment_of<T>::value));
+		}
+
+		void deallocate(T* data, size_t count)
+		{
+			resource->Deallocate(data, count * sizeof(T), std::alignment_of<T>::value);
+		}
+
+		template <typename U, typename... Args>
+		void construct(U* at, Args&&... args)
+		{
+			Construct(at, typename std::uses_allocator<U, ArenaAllocator>::type(), std::forward<Args>(args)...);
+		}
+
+		ArenaAllocator select_on_container_copy_construction(void) const
+		{
+			return ArenaAllocator();
+		}
+
+		MemoryResource* Resource(void) const { return resource; }
+
+	private:
+		template <typename U, typename... Args>
+		void Construct(U* at, std::false_type, Args&&... args)
+		{
+			::new(static_cast<void*>(at)) U(std::forward<Args>(args)...);
+		}
+
+		template <typename U, typename... Args>
+		void Construct(U* at, std::true_type, Args&&... args)
+		{
+			::new(static_cast<void*>(at)) U(std::forward<Args>(args)..., *this);
+		}
+
+		MemoryResource* resource;
+	};
+
+	template <typename T, typename U>
+	bool operator==(const ArenaAllocator<T>& lhs, const ArenaAllocator<U>& rhs)
+	{
+		return lhs.Resource() == rhs.Resource();
+	}
+
+	template <typename T, typename U>
+	bool operator!=(const ArenaAllocator<T>& lhs, const ArenaAllocator<U>& rhs)
+	{
+		return lhs.Resource() != rhs.Resource();
+	}
+
+	//Member types the loaders fill through the member's own allocator. Registered: ArenaString,
+	//ArenaVector<int>, ArenaVector<float> and ArenaVector<ArenaString>.
+	typedef std::basic_string<char, std::char_traits<char>, ArenaAllocator<char> > ArenaString;
+
+	template <typename T>
+	using ArenaVector = std::vector<T, ArenaAllocator<T> >;
+
+	//Default constructs count objects in resource, with resource current so their arena members
+	//allocate from it as well. NULL if the type can't be default constructed.
+	void* NewObjects(const Type* type, unsigned count, MemoryResource* resource);
+
+	//Destructs and deallocates objects from NewObjects. Objects in a MonotonicArena that hold
+	//nothing but arena memory can be dropped with Reset instead.
+	void DeleteObjects(const Type* type, void* objects, unsigned count, MemoryResource* resource);
+}
+
+void TestArena();
@@ -0,0 +1,171 @@
+#include "Arena.h"
+#include "MmapJson.h"
+#include "SerializationTest.h"
+#include "Test.h"
+#include <chrono>
+#include <cstdio>
+
+namespace
+{
+	//counts what goes to the heap through it
+	class CountingResource : public meta::MemoryResource
+	{
+	public:
+		CountingResource() : allocations(0) {}
+
+		void* Allocate(size_t bytes, size_t alignment)
+		{
+			++allocations;
+			return meta::HeapResource()->Allocate(bytes, alignment);
+		}
+
+		void Deallocate(void* data, size_t bytes, size_t alignment)
+		{
+			meta::HeapResource()->Deallocate(data, bytes, alignment);
+		}
+
+		unsigned allocations;
+	};
+
+	//long enough that none of the strings fit in a small string buffer
+	std::string ArticlesJson(unsigned count)
+	{
+		std::string json = "[";
+		char article[512];
+		for (unsigned i = 0; i < count; ++i)
+		{
+			sprintf(article, "%s{ \"id\": %u, \"title\": \"Article number %06u about arenas\", "
+				"\"body\": \"Every string and array of a document comes out of one arena, which is given back at once when the document goes away.\", "
+				"\"scores\": [%u.5, 2, -3.25], \"tags\": [\"monotonic-allocation\", \"tag-number-%06u\", \"deserialization\"] }",
+				i > 0 ? ",\n" : "", i, i, i % 100, i);
+			json += article;
+		}
+		json += "]";
+		return json;
+	}
+
+	bool IsArticle(const Article& article, unsigned i, meta::MemoryResource* resource)
+	{
+		char title[64];
+		sprintf(title, "Article number %06u about arenas", i);
+		return article.id == (int)i && article.title == title && article.body.size() == 117 &&
+			article.scores.size() == 3 && article.scores[0] == (float)(i % 100) + 0.5f && article.scores[2] == -3.25f &&
+			article.tags.size() == 3 && article.tags[2] == "deserialization" &&
+			article.title.get_allocator().Resource() == resource && article.tags.get_allocator().Resource() == resource &&
+			article.tags[1].get_allocator().Resource() == resource;
+	}
+}
+
+void TestArena()
+{
+	typedef std::chrono::high_resolution_clock Clock;
+	typedef std::chrono::duration<double, std::milli> Milliseconds;
+
+	//bump allocation: aligned, oversized requests get their own chunk, Reset rewinds to the first
+	CountingResource upstream;
+	{
+		meta::MonotonicArena arena(1024, &upstream);
+		char* first = static_cast<char*>(arena.Allocate(1, 1));
+		double* aligned = static_cast<double*>(arena.Allocate(sizeof(double), sizeof(double)));
+		if ((size_t)aligned % sizeof(double) != 0 || (char*)aligned - first != sizeof(double) || arena.BytesUsed() != 2 * sizeof(double))
+			printf("MonotonicArena didn't align an allocation\n");
+		void* big = arena.Allocate(4096, 64);
+		if ((size_t)big % 64 != 0 || upstream.allocations != 2 || arena.BytesReserved() < 1024 + 4096)
+			printf("MonotonicArena didn't give a large allocation its own chunk\n");
+
+		size_t reserved = arena.BytesReserved();
+		arena.Reset();
+		if (arena.BytesUsed() != 0 || arena.BytesReserved() != reserved || arena.Allocate(1, 1) != first)
+			printf("MonotonicArena Reset didn't rewind to its first chunk\n");
+		arena.Allocate(2000, 1); //reuses the large chunk
+		if (upstream.allocations != 2)
+			printf("MonotonicArena took a new chunk when it had one\n");
+	}
+
+	//the heap honors alignments wider than operator new's
+	{
+		meta::MemoryResource* heap = meta::HeapResource();
+		void* wide = heap->Allocate(100, 256);
+		void* narrow = heap->Allocate(100, 8);
+		if ((size_t)wide % 256 != 0 || (size_t)narrow % 8 != 0)
+			printf("HeapResource didn't align an allocation\n");
+		heap->Deallocate(wide, 100, 256);
+		heap->Deallocate(narrow, 100, 8);
+	}
+
+	//objects built in an arena keep every member allocation in it, whichever loader fills them
+	meta::MonotonicArena arena(256 * 1024, &upstream);
+	const meta::Type* articleType = meta::get<Article>();
+	const unsigned small = 100;
+	std::string json = ArticlesJson(small);
+	Article* articles = static_cast<Article*>(meta::NewObjects(articleType, small, &arena));
+	meta::StringPool pool;
+	unsigned parsed = meta::ParseJsonArrayInSitu(&json[0], json.size(), articleType, articles, small, pool);
+	for (unsigned i = 0; i < parsed; ++i)
+	{
+		if (!IsArticle(articles[i], i, &arena))
+		{
+			printf("Article %u didn't load in situ into the arena\n", i);
+			break;
+		}
+	}
+	if (parsed != small || meta::CurrentResource() != meta::HeapResource())
+		printf("Loaded %u of %u Articles in situ\n", parsed, small);
+
+	json_t* document = json_loads("{ \"id\": 7, \"title\": \"Article number 000007 about arenas\", \"scores\": [7.5, 1, -3.25],"
+		" \"tags\": [\"a\", 3, \"another tag that is long\", \"deserialization\"] }", 0, NULL);
+	DeSerializeJsonObject(document, &articles[0], "Article");
+	json_decref(document);
+	if (articles[0].id != 7 || articles[0].scores[0] != 7.5f || articles[0].tags.size() != 3 || articles[0].tags[1] != "another tag that is long" ||
+		articles[0].tags[1].get_allocator().Resource() != &arena)
+		printf("Article didn't load from jansson into the arena\n");
+	arena.Release();
+
+	//moved to an object in another arena, the strings in a vector go with the vector
+	{
+		meta::MonotonicArena from, to;
+		Article* source = static_cast<Article*>(meta::NewObjects(articleType, 1, &from));
+		Article* target = static_cast<Article*>(meta::NewObjects(articleType, 1, &to));
+		{
+			meta::ScopedResource scope(&from);
+			source->tags.push_back(meta::ArenaString("a tag long enough to allocate in the arena"));
+		}
+		articleType->Move(target, source);
+		meta::DeleteObjects(articleType, source, 1, &from);
+		from.Release();
+		if (target->tags.size() != 1 || target->tags[0] != "a tag long enough to allocate in the arena" || target->tags[0].get_allocator().Resource() != &to)
+			printf("Article tags didn't move to another arena\n");
+		meta::DeleteObjects(articleType, target, 1, &to);
+	}
+
+	//a batch of documents, on the heap one allocation at a time and in an arena given back with Reset
+	const unsigned count = 100000;
+	std::string text = ArticlesJson(count);
+	printf("%u Articles, ms:\n", count);
+	printf("%18s %12s %8s %8s\n", "", "allocations", "load", "free");
+	for (unsigned useArena = 0; useArena < 2; ++useArena)
+	{
+		CountingResource heap;
+		meta::MonotonicArena batch(1024 * 1024, &heap);
+		meta::MemoryResource* resource = useArena ? (meta::MemoryResource*)&batch : &heap;
+		std::string copy = text;
+
+		Clock::time_point start = Clock::now();
+		Article* loaded = static_cast<Article*>(meta::NewObjects(articleType, count, resource));
+		parsed = meta::ParseJsonArrayInSitu(&copy[0], copy.size(), articleType, loaded, count, pool);
+		Milliseconds load = Clock::now() - start;
+
+		if (parsed != count || !IsArticle(loaded[count - 1], count - 1, resource))
+			printf("Articles didn't load into the %s\n", useArena ? "arena" : "heap");
+
+		start = Clock::now();
+		if (useArena)
+			batch.Reset();
+		else
+			meta::DeleteObjects(articleType, loaded, count, resource);
+		Milliseconds teardown = Clock::now() - start;
+
+		printf("%18s %12u %8.2f %8.2f\n", useArena ? "arena" : "heap", heap.allocations, load.count(), teardown.count());
+	}
+	printf("\n");
+}
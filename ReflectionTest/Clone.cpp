@@ -0,0 +1,158 @@
+#include "Clone.h"
+#include <algorithm>
+#include <mutex>
+
+namespace meta
+{
+	namespace
+	{
+		std::mutex planMutex;
+
+		//The members that need a real copy constructor. A member's own copy constructor may do more
+		//than copy its members (own a buffer, count references), so it's called for the member whole.
+		void CollectCalls(const Type* type, std::vector<CopyPlan::Call>& calls)
+		{
+			for (unsigned i = 0; i < type->members.size(); ++i)
+			{
+				const Member* member = type->members[i];
+				const Type* memberType = member->Meta();
+
+				if (!memberType->IsTriviallyCopyable())
+				{
+					CopyPlan::Call call = { member->Offset(), memberType };
+					calls.push_back(call);
+				}
+			}
+		}
+
+		bool CallBefore(const CopyPlan::Call& a, const CopyPlan::Call& b)
+		{
+			return a.offset < b.offset;
+		}
+
+		CopyPlan* BuildPlan(const Type* type)
+		{
+			CopyPlan* plan = new CopyPlan;
+			plan->trivial = type->IsTriviallyCopyable();
+
+			if (plan->trivial)
+			{
+				CopyPlan::Run run = { 0, type->Size() };
+				plan->runs.push_back(run);
+				return plan;
+			}
+
+			if (type->members.empty())
+			{
+				//a leaf like std::string: only its own copy constructor knows how
+				CopyPlan::Call call = { 0, type };
+				plan->calls.push_back(call);
+				return plan;
+			}
+
+			std::vector<CopyPlan::Call> calls;
+			CollectCalls(type, calls);
+			std::stable_sort(calls.begin(), calls.end(), CallBefore);
+
+			//everything between the calls is memcpy'd, padding and all
+			unsigned cursor = 0;
+			for (unsigned i = 0; i < calls.size(); ++i)
+			{
+				const CopyPlan::Call& call = calls[i];
+				if (call.offset < cursor)
+				{
+					continue; //same member reached twice through the hierarchy
+				}
+
+				if (call.offset > cursor)
+				{
+					CopyPlan::Run run = { cursor, call.offset - cursor };
+					plan->runs.push_back(run);
+				}
+
+				plan->calls.push_back(call);
+				cursor = call.offset + call.type->Size();
+			}
+
+			if (cursor < type->Size())
+			{
+				CopyPlan::Run run = { cursor, type->Size() - cursor };
+				plan->runs.push_back(run);
+			}
+
+			return plan;
+		}
+
+		void ApplyPlan(const CopyPlan& plan, char* dst, const char* src)
+		{
+			for (unsigned i = 0; i < plan.runs.size(); ++i)
+			{
+				std::memcpy(dst + plan.runs[i].offset, src + plan.runs[i].offset, plan.runs[i].size);
+			}
+
+			for (unsigned i = 0; i < plan.calls.size(); ++i)
+			{
+				plan.calls[i].type->CopyConstruct(dst + plan.calls[i].offset, src + plan.calls[i].offset);
+			}
+		}
+	}
+
+	const CopyPlan& GetCopyPlan(const Type* type)
+	{
+		const CopyPlan* plan = type->copyPlan.load(std::memory_order_acquire);
+		if (plan != NULL)
+		{
+			return *plan;
+		}
+
+		//types are registered before threads start, so only the first build needs guarding;
+		//the release store publishes the plan whole to threads that load it without the lock
+		std::lock_guard<std::mutex> lock(planMutex);
+		plan = type->copyPlan.load(std::memory_order_relaxed);
+		if (plan == NULL)
+		{
+			plan = BuildPlan(type);
+			type->copyPlan.store(plan, std::memory_order_release);
+		}
+		return *plan;
+	}
+
+	void Clone(const Type* type, void* dst, const void* src)
+	{
+		const CopyPlan& plan = GetCopyPlan(type);
+
+		if (plan.trivial)
+		{
+			std::memcpy(dst, src, type->Size());
+		}
+		else
+		{
+			ApplyPlan(plan, static_cast<char*>(dst), static_cast<const char*>(src));
+		}
+	}
+
+	void CloneN(const Type* type, void* dst, const void* src, unsigned count, unsigned stride)
+	{
+		const CopyPlan& plan = GetCopyPlan(type);
+
+		if (stride == 0)
+		{
+			stride = type->Size();
+		}
+
+		char* to = static_cast<char*>(dst);
+		const char* from = static_cast<const char*>(src);
+
+		if (plan.trivial && stride == type->Size())
+		{
+			//the whole range is one run
+			std::memcpy(to, from, (size_t)count * stride);
+			return;
+		}
+
+		for (unsigned i = 0; i < count; ++i, to += stride, from += stride)
+		{
+			ApplyPlan(plan, to, from);
+		}
+	}
+}
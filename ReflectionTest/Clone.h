@@ -0,0 +1,47 @@
+#pragma once
+
+#include "Meta.h"
+
+namespace meta
+{
+	//////////////////////////////////////////////////////////////////////////////
+	//  CopyPlan
+	//////////////////////////////////////////////////////////////////////////////
+	// Purpose: How to copy construct an object of a type, worked out once per type from its members.
+	//          Every byte of the object is covered by a memcpy run, except members that aren't
+	//          trivially copyable (like std::string, or a struct that owns a buffer), which get
+	//          their own copy constructor call, whole. Runs span padding and adjacent members, so
+	//          a Vector3 or a run of floats is one memcpy.
+	//
+	//          All members that aren't trivially copyable must be registered; unregistered bytes are
+	//          memcpy'd. The type's own copy constructor is taken to copy member by member.
+	struct CopyPlan
+	{
+		struct Run
+		{
+			unsigned offset;
+			unsigned size;
+		};
+
+		struct Call
+		{
+			unsigned offset;
+			const Type* type;
+		};
+
+		std::vector<Run> runs;
+		std::vector<Call> calls;
+		bool trivial;	//the whole object is one memcpy
+	};
+
+	//Built on first use and cached on the type.
+	const CopyPlan& GetCopyPlan(const Type* type);
+
+	//Copy constructs src into the uninitialized storage dst.
+	void Clone(const Type* type, void* dst, const void* src);
+
+	//Copy constructs count objects. Objects are stride bytes apart (0 means type->Size()).
+	void CloneN(const Type* type, void* dst, const void* src, unsigned count, unsigned stride = 0);
+}
+
+void TestClone();
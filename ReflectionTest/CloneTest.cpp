@@ -0,0 +1,95 @@
+#include "Clone.h"
+#include "SerializationTest.h"
+#include "Test.h"
+#include <chrono>
+
+//the obvious generic copy: one copy per member
+static void CopyPerMember(const meta::Type* type, char* dst, const char* src)
+{
+	for (unsigned i = 0; i < type->members.size(); ++i)
+	{
+		const meta::Member* member = type->members[i];
+		if (member->Meta()->IsTriviallyCopyable())
+			std::memcpy(dst + member->Offset(), src + member->Offset(), member->Size());
+		else
+			member->Meta()->CopyConstruct(dst + member->Offset(), src + member->Offset());
+	}
+}
+
+void TestClone()
+{
+	typedef std::chrono::high_resolution_clock Clock;
+
+	const meta::Type* thingType = meta::get<Thing>();
+	const meta::CopyPlan& plan = meta::GetCopyPlan(thingType);
+
+	printf("Thing copy plan:\n");
+	for (unsigned i = 0; i < plan.runs.size(); ++i)
+		printf("    memcpy %2u bytes @%u\n", plan.runs[i].size, plan.runs[i].offset);
+	for (unsigned i = 0; i < plan.calls.size(); ++i)
+		printf("    copy %s @%u\n", plan.calls[i].type->Name().c_str(), plan.calls[i].offset);
+
+	Thing thing = Thing();
+	thing.id = 4;
+	thing.name = "a name long enough to live on the heap";
+	thing.radius = 1.5f;
+	thing.position = Vector3(1.0f, 2.0f, 3.0f);
+	thing.kind = Thing_Apple;
+
+	Thing* clone = static_cast<Thing*>(operator new(sizeof(Thing)));
+	meta::Clone(thingType, clone, &thing);
+	if (clone->name != thing.name || clone->name.c_str() == thing.name.c_str() ||
+		clone->id != 4 || clone->radius != 1.5f || clone->position.z != 3.0f || clone->kind != Thing_Apple)
+		printf("Clone didn't copy Thing\n");
+	clone->~Thing();
+	operator delete(clone);
+
+	//a member with a copy constructor of its own is copied by it, not by its bytes
+	{
+		Badge badge;
+		badge.id = 3;
+		badge.label = Label("a label it owns");
+		badge.scale = 0.5f;
+		Badge* copy = static_cast<Badge*>(operator new(sizeof(Badge)));
+		meta::Clone(meta::get<Badge>(), copy, &badge);
+		if (copy->id != 3 || copy->scale != 0.5f || copy->label.text == badge.label.text || std::strcmp(copy->label.text, "a label it owns") != 0)
+			printf("Clone didn't copy Badge's label with its copy constructor\n");
+		copy->~Badge();
+		operator delete(copy);
+	}
+
+	//N clones: per member copies, Clone per object, one CloneN
+	const unsigned count = 200000;
+	std::vector<Thing> things(count, thing);
+	char* storage = static_cast<char*>(operator new(sizeof(Thing) * count));
+
+	Clock::time_point start = Clock::now();
+	for (unsigned i = 0; i < count; ++i)
+		CopyPerMember(thingType, storage + i * sizeof(Thing), reinterpret_cast<const char*>(&things[i]));
+	std::chrono::duration<double, std::nano> perMember = Clock::now() - start;
+	for (unsigned i = 0; i < count; ++i)
+		reinterpret_cast<Thing*>(storage)[i].~Thing();
+
+	start = Clock::now();
+	for (unsigned i = 0; i < count; ++i)
+		meta::Clone(thingType, storage + i * sizeof(Thing), &things[i]);
+	std::chrono::duration<double, std::nano> cloneEach = Clock::now() - start;
+	for (unsigned i = 0; i < count; ++i)
+		reinterpret_cast<Thing*>(storage)[i].~Thing();
+
+	start = Clock::now();
+	meta::CloneN(thingType, storage, things.data(), count);
+	std::chrono::duration<double, std::nano> cloneN = Clock::now() - start;
+	if (reinterpret_cast<Thing*>(storage)[count - 1].name != thing.name)
+		printf("CloneN didn't copy Thing\n");
+	for (unsigned i = 0; i < count; ++i)
+		reinterpret_cast<Thing*>(storage)[i].~Thing();
+
+	operator delete(storage);
+
+	printf("Thing copy, ns per object:\n");
+	printf("%18s %8.2f\n", "per member", perMember.count() / count);
+	printf("%18s %8.2f\n", "Clone", cloneEach.count() / count);
+	printf("%18s %8.2f\n", "CloneN", cloneN.count() / count);
+	printf("\n");
+}
@@ -0,0 +1,579 @@
+#include "Columnar.h"
+#include "FieldKind.h"
+#include <unordered_map>
+
+namespace meta
+{
+	namespace
+	{
+		const char columnsMagic[4] = { 'M', 'C', 'O', 'L' };
+		const unsigned columnsFormat = 1;
+
+		typedef unsigned long long Word;
+
+		enum LeafKind
+		{
+			SignedLeaf,
+			UnsignedLeaf,
+			Real32Leaf,
+			Real64Leaf,
+			StringLeaf
+		};
+
+		//what a numeric column's words are
+		enum Domain
+		{
+			Domain_Signed,		//integers, sign extended
+			Domain_Unsigned,	//integers and bools, zero extended
+			Domain_Whole,		//reals that are all whole numbers, as signed integers
+			Domain_Bits			//reals as their bit patterns
+		};
+
+		//a member with no members of its own, reached from the collection's type
+		struct Leaf
+		{
+			std::string path;
+			const Type* type;
+			unsigned offset;
+			LeafKind kind;
+		};
+
+		//enums are stored as their values, bools as unsigned integers
+		bool LeafKindOf(const Type* type, LeafKind& kind)
+		{
+			switch (Classify(type))
+			{
+				case Kind_Signed:
+				case Kind_Enumeration: kind = SignedLeaf; return true;
+				case Kind_Unsigned:
+				case Kind_Boolean: kind = UnsignedLeaf; return true;
+				case Kind_Real32: kind = Real32Leaf; return true;
+				case Kind_Real64: kind = Real64Leaf; return true;
+				case Kind_String: kind = StringLeaf; return true;
+				default: return false;
+			}
+		}
+
+		void CollectLeaves(const Type* type, const std::string& prefix, unsigned offset, std::vector<Leaf>& leaves)
+		{
+			for (unsigned i = 0; i < type->members.size(); ++i)
+			{
+				const Member* member = type->members[i];
+				const Type* memberType = member->Meta();
+				LeafKind kind;
+
+				if (!memberType->members.empty())
+				{
+					CollectLeaves(memberType, prefix + member->Name() + ".", offset + member->Offset(), leaves);
+				}
+				else if (LeafKindOf(memberType, kind))
+				{
+					Leaf leaf = { prefix + member->Name(), memberType, offset + member->Offset(), kind };
+					leaves.push_back(leaf);
+				}
+			}
+		}
+
+		//////// Integers ////////
+
+		Word LoadInteger(const char* at, unsigned size, bool isSigned)
+		{
+			switch (size)
+			{
+				case 1: { unsigned char v; std::memcpy(&v, at, 1); return isSigned ? (Word)(long long)(signed char)v : v; }
+				case 2: { unsigned short v; std::memcpy(&v, at, 2); return isSigned ? (Word)(long long)(short)v : v; }
+				case 4: { unsigned v; std::memcpy(&v, at, 4); return isSigned ? (Word)(long long)(int)v : v; }
+				default: { Word v; std::memcpy(&v, at, 8); return v; }
+			}
+		}
+
+		//a real that converts to a long long and back unchanged; not -0, which would lose its sign
+		bool IsWhole(double value)
+		{
+			if (!(value > -9223372036854775808.0 && value < 9223372036854775808.0))
+			{
+				return false;
+			}
+			double whole = (double)(long long)value;
+			return std::memcmp(&whole, &value, sizeof(value)) == 0;
+		}
+
+		unsigned BitsFor(Word value)
+		{
+			unsigned bits = 0;
+			for (; value != 0; value >>= 1)
+			{
+				++bits;
+			}
+			return bits;
+		}
+
+		Word Mask(unsigned bits)
+		{
+			return bits >= 64 ? ~0ULL : (1ULL << bits) - 1;
+		}
+
+		Word ZigZag(Word value)
+		{
+			return (value << 1) ^ (Word)((long long)value >> 63);
+		}
+
+		Word UnZigZag(Word value)
+		{
+			return (value >> 1) ^ (0 - (value & 1));
+		}
+
+		//bytes for count values of bits each, in whole words
+		size_t PackedBytes(size_t count, unsigned bits)
+		{
+			return (count * bits + 63) / 64 * sizeof(Word);
+		}
+
+		//values, low bits first, in little words
+		void Pack(std::vector<char>& out, const std::vector<Word>& values, size_t first, unsigned bits)
+		{
+			size_t start = out.size();
+			out.resize(start + PackedBytes(values.size() - first, bits), 0);
+			char* words = &out[0] + start;
+			for (size_t i = first, at = 0; bits > 0 && i < values.size(); ++i, at += bits)
+			{
+				size_t index = at / 64;
+				unsigned shift = at % 64;
+				Word word;
+				std::memcpy(&word, words + index * 8, 8);
+				word |= values[i] << shift;
+				std::memcpy(words + index * 8, &word, 8);
+				if (shift + bits > 64)
+				{
+					std::memcpy(&word, words + index * 8 + 8, 8);
+					word |= values[i] >> (64 - shift);
+					std::memcpy(words + index * 8 + 8, &word, 8);
+				}
+			}
+		}
+
+		//a constant column has no words at all
+		Word Unpack(const char* words, size_t index, unsigned bits)
+		{
+			if (bits == 0)
+			{
+				return 0;
+			}
+			size_t at = index * bits;
+			unsigned shift = at % 64;
+			Word word;
+			std::memcpy(&word, words + at / 64 * 8, 8);
+			Word value = word >> shift;
+			if (shift + bits > 64)
+			{
+				std::memcpy(&word, words + at / 64 * 8 + 8, 8);
+				value |= word << (64 - shift);
+			}
+			return value & Mask(bits);
+		}
+
+		//////// Byte Streams ////////
+
+		void Write(std::vector<char>& out, const void* data, size_t size)
+		{
+			const char* bytes = static_cast<const char*>(data);
+			out.insert(out.end(), bytes, bytes + size);
+		}
+
+		void WriteU32(std::vector<char>& out, unsigned value)
+		{
+			Write(out, &value, sizeof(value));
+		}
+
+		void WriteString(std::vector<char>& out, const std::string& str)
+		{
+			WriteU32(out, (unsigned)str.size());
+			Write(out, str.data(), str.size());
+		}
+
+		struct Reader
+		{
+			const char* cursor;
+			const char* end;
+
+			bool Read(void* dest, size_t size)
+			{
+				if ((size_t)(end - cursor) < size)
+					return false;
+				std::memcpy(dest, cursor, size);
+				cursor += size;
+				return true;
+			}
+
+			bool ReadU32(unsigned& value)
+			{
+				return Read(&value, sizeof(value));
+			}
+
+			bool ReadString(std::string& str)
+			{
+				unsigned length;
+				if (!ReadU32(length) || (size_t)(end - cursor) < length)
+					return false;
+				str.assign(cursor, length);
+				cursor += length;
+				return true;
+			}
+		};
+
+		//////// Columns ////////
+
+		//a numeric column: its domain, then frame of reference or delta, whichever packs smaller
+		void WriteNumbers(std::vector<char>& out, const Leaf& leaf, const char* objects, unsigned count, unsigned stride, ColumnInfo& info)
+		{
+			std::vector<Word> values(count);
+			Domain domain = leaf.kind == SignedLeaf ? Domain_Signed : Domain_Unsigned;
+			if (leaf.kind == Real32Leaf || leaf.kind == Real64Leaf)
+			{
+				domain = Domain_Whole;
+				for (unsigned i = 0; i < count && domain == Domain_Whole; ++i)
+				{
+					double value;
+					if (leaf.kind == Real32Leaf)
+					{
+						float real;
+						std::memcpy(&real, objects + (size_t)i * stride + leaf.offset, sizeof(real));
+						value = real;
+					}
+					else
+					{
+						std::memcpy(&value, objects + (size_t)i * stride + leaf.offset, sizeof(value));
+					}
+					if (IsWhole(value))
+						values[i] = (Word)(long long)value;
+					else
+						domain = Domain_Bits;
+				}
+			}
+			if (domain != Domain_Whole)
+			{
+				for (unsigned i = 0; i < count; ++i)
+				{
+					values[i] = LoadInteger(objects + (size_t)i * stride + leaf.offset, leaf.type->Size(), domain == Domain_Signed);
+				}
+			}
+
+			//signed domains order as signed; unsigned ones (and bit patterns) as unsigned
+			bool isSigned = domain == Domain_Signed || domain == Domain_Whole;
+			Word flip = isSigned ? 1ULL << 63 : 0;
+			Word low = ~0ULL;
+			Word high = 0;
+			Word steps = 0;
+			for (unsigned i = 0; i < count; ++i)
+			{
+				low = std::min(low, values[i] ^ flip);
+				high = std::max(high, values[i] ^ flip);
+				if (i > 0)
+					steps |= ZigZag(values[i] - values[i - 1]);
+			}
+
+			Word base = count > 0 ? low ^ flip : 0;
+			unsigned referenceBits = count > 0 ? BitsFor(high - low) : 0;
+			unsigned deltaBits = BitsFor(steps);
+			bool delta = count > 1 && PackedBytes(count - 1, deltaBits) < PackedBytes(count, referenceBits);
+			if (delta)
+			{
+				base = values[0];
+				for (unsigned i = count - 1; i > 0; --i)
+					values[i] = ZigZag(values[i] - values[i - 1]);
+			}
+			else
+			{
+				for (unsigned i = 0; i < count; ++i)
+					values[i] -= base;
+			}
+
+			out.push_back((char)domain);
+			Write(out, &base, sizeof(base));
+			Pack(out, values, delta ? 1 : 0, delta ? deltaBits : referenceBits);
+			info.encoding = delta ? Column_Delta : Column_FrameOfReference;
+			info.bits = delta ? deltaBits : referenceBits;
+		}
+
+		//a dictionary of the distinct strings and an index per object, unless most are distinct
+		void WriteStrings(std::vector<char>& out, const Leaf& leaf, const char* objects, unsigned count, unsigned stride, ColumnInfo& info)
+		{
+			std::unordered_map<std::string, unsigned> ids;
+			std::vector<const std::string*> distinct;
+			std::vector<Word> indices(count);
+			for (unsigned i = 0; i < count; ++i)
+			{
+				const std::string& str = *reinterpret_cast<const std::string*>(objects + (size_t)i * stride + leaf.offset);
+				std::pair<std::unordered_map<std::string, unsigned>::iterator, bool> found = ids.insert(std::make_pair(str, (unsigned)distinct.size()));
+				if (found.second)
+					distinct.push_back(&found.first->first);
+				indices[i] = found.first->second;
+			}
+
+			if (distinct.size() * 2 > count)
+			{
+				for (unsigned i = 0; i < count; ++i)
+					WriteString(out, *reinterpret_cast<const std::string*>(objects + (size_t)i * stride + leaf.offset));
+				info.encoding = Column_Strings;
+				info.bits = 0;
+				return;
+			}
+
+			WriteU32(out, (unsigned)distinct.size());
+			for (unsigned i = 0; i < distinct.size(); ++i)
+				WriteString(out, *distinct[i]);
+			info.encoding = Column_Dictionary;
+			info.bits = distinct.size() > 1 ? BitsFor(distinct.size() - 1) : 0;
+			Pack(out, indices, 0, info.bits);
+		}
+
+		bool ReadNumbers(Reader reader, const Leaf& leaf, const ColumnInfo& info, char* objects, unsigned count, unsigned stride)
+		{
+			char domain;
+			Word value;
+			bool delta = info.encoding == Column_Delta;
+			if (info.bits > 64 || (!delta && info.encoding != Column_FrameOfReference) || !reader.Read(&domain, 1) || !reader.Read(&value, sizeof(value)) ||
+				(size_t)(reader.end - reader.cursor) < PackedBytes(delta ? count - 1 : count, info.bits))
+			{
+				return false;
+			}
+
+			//reals are whole numbers or bit patterns, integers are neither; an integer column is no wider
+			//than its member, or than its member and a sign bit for zigzagged steps
+			bool whole = domain == Domain_Whole;
+			bool real = leaf.kind == Real32Leaf || leaf.kind == Real64Leaf;
+			unsigned width = leaf.type->Size() * 8 + (delta ? 1 : 0);
+			if (real ? (!whole && domain != Domain_Bits) : (domain != Domain_Signed && domain != Domain_Unsigned) || info.bits > width)
+			{
+				return false;
+			}
+
+			Word base = value;
+			for (unsigned i = 0; i < count; ++i)
+			{
+				if (delta && i > 0)
+					value += UnZigZag(Unpack(reader.cursor, i - 1, info.bits));
+				else if (!delta)
+					value = base + Unpack(reader.cursor, i, info.bits);
+
+				char* at = objects + (size_t)i * stride + leaf.offset;
+				switch (leaf.kind)
+				{
+					case Real32Leaf:
+						if (whole)
+						{
+							*reinterpret_cast<float*>(at) = (float)(long long)value;
+						}
+						else
+						{
+							unsigned bits = (unsigned)value;
+							std::memcpy(at, &bits, sizeof(bits));
+						}
+						break;
+					case Real64Leaf:
+						if (whole)
+							*reinterpret_cast<double*>(at) = (double)(long long)value;
+						else
+							std::memcpy(at, &value, sizeof(value));
+						break;
+					default:
+						StoreInteger(at, leaf.type->Size(), value);
+						break;
+				}
+			}
+			return true;
+		}
+
+		bool ReadStrings(Reader reader, const Leaf& leaf, const ColumnInfo& info, char* objects, unsigned count, unsigned stride)
+		{
+			if (info.encoding == Column_Strings)
+			{
+				for (unsigned i = 0; i < count; ++i)
+				{
+					if (!reader.ReadString(*reinterpret_cast<std::string*>(objects + (size_t)i * stride + leaf.offset)))
+						return false;
+				}
+				return true;
+			}
+
+			unsigned distinctCount;
+			if (info.encoding != Column_Dictionary || info.bits > 32 || !reader.ReadU32(distinctCount) || distinctCount > (size_t)(reader.end - reader.cursor) / 4)
+			{
+				return false;
+			}
+			std::vector<std::string> distinct(distinctCount);
+			for (unsigned i = 0; i < distinctCount; ++i)
+			{
+				if (!reader.ReadString(distinct[i]))
+					return false;
+			}
+			if ((size_t)(reader.end - reader.cursor) < PackedBytes(count, info.bits))
+			{
+				return false;
+			}
+
+			for (unsigned i = 0; i < count; ++i)
+			{
+				Word index = Unpack(reader.cursor, i, info.bits);
+				if (index >= distinctCount)
+					return false;
+				*reinterpret_cast<std::string*>(objects + (size_t)i * stride + leaf.offset) = distinct[(size_t)index];
+			}
+			return true;
+		}
+
+		//the header and directory; cursor is left on the first column
+		bool ReadHeader(Reader& reader, ColumnsHeader& header)
+		{
+			char magic[4];
+			unsigned format;
+			unsigned columnCount;
+
+			if (!reader.Read(magic, sizeof(magic)) || std::memcmp(magic, columnsMagic, sizeof(magic)) != 0 ||
+				!reader.ReadU32(format) || format != columnsFormat || !reader.ReadString(header.typeName) || !reader.ReadU32(header.version) ||
+				!reader.Read(&header.schemaHash, sizeof(header.schemaHash)) || !reader.ReadU32(header.count) || !reader.ReadU32(columnCount))
+			{
+				return false;
+			}
+
+			size_t total = 0;
+			header.columns.clear();
+			for (unsigned i = 0; i < columnCount; ++i)
+			{
+				ColumnInfo info;
+				char encoding;
+				char bits;
+				if (!reader.ReadString(info.path) || !reader.ReadString(info.typeName) || !reader.Read(&encoding, 1) ||
+					!reader.Read(&bits, 1) || !reader.ReadU32(info.bytes) || (unsigned char)encoding > Column_Strings)
+				{
+					return false;
+				}
+				info.encoding = (ColumnEncoding)(unsigned char)encoding;
+				info.bits = (unsigned char)bits;
+				total += info.bytes;
+				header.columns.push_back(info);
+			}
+			return total <= (size_t)(reader.end - reader.cursor);
+		}
+
+		//the path, or a member path under it
+		bool Selected(const std::string& column, const std::string& path)
+		{
+			return column.compare(0, path.size(), path) == 0 && (column.size() == path.size() || column[path.size()] == '.');
+		}
+	}
+
+	void WriteColumns(const Type* type, const void* objects, unsigned count, std::vector<char>& out, unsigned stride)
+	{
+		if (stride == 0)
+		{
+			stride = type->Size();
+		}
+
+		std::vector<Leaf> leaves;
+		CollectLeaves(type, "", 0, leaves);
+
+		std::vector<char> columns;
+		std::vector<ColumnInfo> infos(leaves.size());
+		const char* data = static_cast<const char*>(objects);
+		for (unsigned i = 0; i < leaves.size(); ++i)
+		{
+			size_t start = columns.size();
+			if (leaves[i].kind == StringLeaf)
+				WriteStrings(columns, leaves[i], data, count, stride, infos[i]);
+			else
+				WriteNumbers(columns, leaves[i], data, count, stride, infos[i]);
+			infos[i].bytes = (unsigned)(columns.size() - start);
+		}
+
+		unsigned long long schemaHash = type->SchemaHash();
+		Write(out, columnsMagic, sizeof(columnsMagic));
+		WriteU32(out, columnsFormat);
+		WriteString(out, type->Name());
+		WriteU32(out, type->Version());
+		Write(out, &schemaHash, sizeof(schemaHash));
+		WriteU32(out, count);
+		WriteU32(out, (unsigned)leaves.size());
+		for (unsigned i = 0; i < leaves.size(); ++i)
+		{
+			WriteString(out, leaves[i].path);
+			WriteString(out, leaves[i].type->Name());
+			out.push_back((char)infos[i].encoding);
+			out.push_back((char)infos[i].bits);
+			WriteU32(out, infos[i].bytes);
+		}
+		Write(out, columns.data(), columns.size());
+	}
+
+	bool ReadColumnsHeader(const char* data, size_t size, ColumnsHeader& header)
+	{
+		Reader reader = { data, data + size };
+		return ReadHeader(reader, header);
+	}
+
+	bool ReadColumns(const Type* type, const char* data, size_t size, void* objects, unsigned capacity, const std::vector<std::string>& paths, unsigned stride)
+	{
+		if (stride == 0)
+		{
+			stride = type->Size();
+		}
+
+		Reader reader = { data, data + size };
+		ColumnsHeader header;
+		if (!ReadHeader(reader, header) || header.count > capacity)
+		{
+			return false;
+		}
+		if (header.typeName != type->Name())
+		{
+			std::cout << "Columns of " << header.typeName << " can't load as " << type->Name() << std::endl;
+			return false;
+		}
+
+		for (unsigned p = 0; p < paths.size(); ++p)
+		{
+			bool found = false;
+			for (unsigned c = 0; c < header.columns.size() && !found; ++c)
+				found = Selected(header.columns[c].path, paths[p]);
+			if (!found)
+			{
+				std::cout << "Columns of " << header.typeName << " have no " << paths[p] << std::endl;
+				return false;
+			}
+		}
+
+		std::vector<Leaf> leaves;
+		CollectLeaves(type, "", 0, leaves);
+		std::unordered_map<std::string, const Leaf*> byPath;
+		for (unsigned i = 0; i < leaves.size(); ++i)
+		{
+			byPath[leaves[i].path] = &leaves[i];
+		}
+
+		const char* column = reader.cursor;
+		for (unsigned c = 0; c < header.columns.size(); ++c)
+		{
+			const ColumnInfo& info = header.columns[c];
+			Reader payload = { column, column + info.bytes };
+			column += info.bytes;
+
+			bool selected = paths.empty();
+			for (unsigned p = 0; p < paths.size() && !selected; ++p)
+				selected = Selected(info.path, paths[p]);
+			std::unordered_map<std::string, const Leaf*>::const_iterator leaf = byPath.find(info.path);
+			if (!selected || leaf == byPath.end() || leaf->second->type->Name() != info.typeName)
+			{
+				continue;
+			}
+
+			bool ok = leaf->second->kind == StringLeaf ?
+				ReadStrings(payload, *leaf->second, info, static_cast<char*>(objects), header.count, stride) :
+				ReadNumbers(payload, *leaf->second, info, static_cast<char*>(objects), header.count, stride);
+			if (!ok)
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+#include "Meta.h"
+
+namespace meta
+{
+	//////////////////////////////////////////////////////////////////////////////
+	//  Columnar collections
+	//////////////////////////////////////////////////////////////////////////////
+	// Purpose: Stores an array of a reflected type a column per leaf member path (position.x,
+	//          name, ...), found through Type::members like a snapshot's leaves, so that each
+	//          column holds values of one kind that sit close together and compress well.
+	//
+	//          Integer, enum and bool columns are frame of reference (the minimum, then each
+	//          value's distance from it) or delta (the first value, then each value's zigzagged
+	//          step from the one before) bit packed at the fewest bits the column needs,
+	//          whichever is smaller; a constant column takes no bits per value. Float and double
+	//          columns are encoded the same way, as integers when every value is a whole number
+	//          and as their bit patterns otherwise. std::string columns are a dictionary of their
+	//          distinct strings and bit packed indices into it, or the strings back to back when
+	//          most are distinct. Other leaves (pointers, arena and pooled strings) are left out.
+	//
+	//          A directory of the columns and their byte sizes comes first, so a reader decodes
+	//          only the columns it asks for and never touches the bytes of the rest. Columns are
+	//          matched to the current type by path and type; ones it no longer has are skipped.
+
+	enum ColumnEncoding
+	{
+		Column_FrameOfReference,
+		Column_Delta,
+		Column_Dictionary,
+		Column_Strings
+	};
+
+	struct ColumnInfo
+	{
+		std::string path;
+		std::string typeName;
+		ColumnEncoding encoding;
+		unsigned bits;		//per value, or per dictionary index
+		unsigned bytes;
+	};
+
+	struct ColumnsHeader
+	{
+		std::string typeName;
+		unsigned version;
+		unsigned long long schemaHash;
+		unsigned count;
+		std::vector<ColumnInfo> columns;
+	};
+
+	//Appends count objects of a type to out, a column per leaf. Objects are stride bytes apart (0 means type->Size()).
+	void WriteColumns(const Type* type, const void* objects, unsigned count, std::vector<char>& out, unsigned stride = 0);
+
+	//false if data isn't a columnar collection
+	bool ReadColumnsHeader(const char* data, size_t size, ColumnsHeader& header);
+
+	//Loads the columns under paths ("position" is position.x, .y and .z; an empty list is every
+	//column) into header.count already constructed objects, stride bytes apart (0 means
+	//type->Size()); other members are left as they are. false if the data is malformed or of
+	//another type, capacity is too small or a path names no column.
+	bool ReadColumns(const Type* type, const char* data, size_t size, void* objects, unsigned capacity, const std::vector<std::string>& paths, unsigned stride = 0);
+}
+
+void TestColumnar();
@@ -0,0 +1,231 @@
+#include "Columnar.h"
+#include "Compression.h"
+#include "SerializationTest.h"
+#include "Snapshot.h"
+#include "Test.h"
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <limits>
+#include <random>
+
+namespace
+{
+	Thing MakeThing(std::mt19937& random, unsigned id)
+	{
+		static const char* names[] = { "apple", "banana", "cherry", "damson", "elderberry", "fig", "grape" };
+		Thing thing;
+		thing.id = id;
+		thing.size = 7;
+		thing.name = names[random() % 7];
+		thing.radius = (float)(random() % 64) * 0.25f;
+		thing.height = (double)(random() % 100000) / 100.0;
+		thing.position = Vector3((float)(id % 1000), (float)(random() % 16), 0.0f);
+		thing.kind = random() & 1 ? Thing_Apple : Thing_Banana;
+		return thing;
+	}
+
+	bool SameThing(const Thing& lhs, const Thing& rhs)
+	{
+		return lhs.id == rhs.id && lhs.size == rhs.size && lhs.name == rhs.name && lhs.radius == rhs.radius && lhs.height == rhs.height &&
+			lhs.position.x == rhs.position.x && lhs.position.y == rhs.position.y && lhs.position.z == rhs.position.z && lhs.kind == rhs.kind;
+	}
+
+	bool SameBits(const void* lhs, const void* rhs, size_t size)
+	{
+		return std::memcmp(lhs, rhs, size) == 0;
+	}
+
+	bool SameSample(const Sample& lhs, const Sample& rhs)
+	{
+		return lhs.flag == rhs.flag && lhs.letter == rhs.letter && lhs.byte == rhs.byte && lhs.small == rhs.small && lhs.smallCount == rhs.smallCount &&
+			lhs.large == rhs.large && lhs.largeCount == rhs.largeCount && SameBits(&lhs.ratio, &rhs.ratio, sizeof(float)) &&
+			SameBits(&lhs.value, &rhs.value, sizeof(double)) && lhs.label == rhs.label;
+	}
+
+	const meta::ColumnInfo* FindColumn(const meta::ColumnsHeader& header, const char* path)
+	{
+		for (unsigned i = 0; i < header.columns.size(); ++i)
+		{
+			if (header.columns[i].path == path)
+				return &header.columns[i];
+		}
+		return NULL;
+	}
+}
+
+void TestColumnar()
+{
+	typedef std::chrono::high_resolution_clock Clock;
+	typedef std::chrono::duration<double, std::milli> Milliseconds;
+	std::mt19937 random(50);
+
+	//the extremes of each leaf kind, -0 and NaN bits, alongside ordinary values
+	{
+		std::vector<Sample> samples(64);
+		for (unsigned i = 0; i < samples.size(); ++i)
+		{
+			Sample& sample = samples[i];
+			sample.flag = i % 3 == 0;
+			sample.letter = (char)(i * 37);
+			sample.byte = (unsigned char)(255 - i);
+			sample.small = (short)(i * 1021);
+			sample.smallCount = (unsigned short)(i * 2039);
+			sample.large = (long)i * -100003;
+			sample.largeCount = (unsigned long)i << 40;
+			sample.ratio = (float)i;
+			sample.value = (double)i * 1000.0;
+			sample.label = "label " + std::to_string(i % 5);
+		}
+		samples[1].letter = std::numeric_limits<char>::min();
+		samples[2].letter = std::numeric_limits<char>::max();
+		samples[3].small = std::numeric_limits<short>::min();
+		samples[4].small = std::numeric_limits<short>::max();
+		samples[5].large = std::numeric_limits<long>::min();
+		samples[6].large = std::numeric_limits<long>::max();
+		samples[7].largeCount = std::numeric_limits<unsigned long>::max();
+		samples[8].smallCount = std::numeric_limits<unsigned short>::max();
+		samples[9].ratio = -0.0f;
+		samples[10].value = std::numeric_limits<double>::quiet_NaN();
+		samples[11].value = -std::numeric_limits<double>::infinity();
+		samples[12].ratio = -16777216.0f;
+		samples[13].label = "";
+
+		std::vector<char> data;
+		meta::WriteColumns(meta::get<Sample>(), samples.data(), (unsigned)samples.size(), data);
+		std::vector<Sample> loaded(samples.size());
+		bool ok = meta::ReadColumns(meta::get<Sample>(), data.data(), data.size(), loaded.data(), (unsigned)loaded.size(), std::vector<std::string>());
+		for (unsigned i = 0; ok && i < samples.size(); ++i)
+			ok = SameSample(samples[i], loaded[i]);
+		if (!ok)
+			printf("Sample columns didn't round trip\n");
+
+		//-0 and NaN keep the otherwise whole ratio and value columns as bit patterns
+		meta::ColumnsHeader header;
+		if (!meta::ReadColumnsHeader(data.data(), data.size(), header) || header.columns.size() != 10 || header.count != samples.size() ||
+			FindColumn(header, "label")->encoding != meta::Column_Dictionary || FindColumn(header, "flag")->bits != 1)
+			printf("Sample column directory is wrong\n");
+
+		//damaged columns fail or load something, never outside their bounds
+		for (unsigned i = 0; i < 500; ++i)
+		{
+			std::vector<char> damaged = data;
+			damaged[random() % damaged.size()] ^= (char)(1 + random() % 255);
+			meta::ReadColumns(meta::get<Sample>(), damaged.data(), damaged.size(), loaded.data(), (unsigned)loaded.size(), std::vector<std::string>());
+		}
+
+		if (meta::ReadColumns(meta::get<Body>(), data.data(), data.size(), loaded.data(), (unsigned)loaded.size(), std::vector<std::string>()))
+			printf("Sample columns loaded as Bodies\n");
+
+		std::vector<char> empty;
+		meta::WriteColumns(meta::get<Sample>(), NULL, 0, empty);
+		if (!meta::ReadColumns(meta::get<Sample>(), empty.data(), empty.size(), NULL, 0, std::vector<std::string>()))
+			printf("No Sample columns didn't round trip\n");
+	}
+
+	//a constant last column has no bytes for a reader to run past
+	{
+		std::vector<Body> bodies(100);
+		for (unsigned i = 0; i < bodies.size(); ++i)
+		{
+			bodies[i].id = i;
+			bodies[i].x = (float)i * 0.5f;
+			bodies[i].charge = 1.0;
+		}
+		std::vector<char> data;
+		meta::WriteColumns(meta::get<Body>(), bodies.data(), (unsigned)bodies.size(), data);
+		std::vector<char> exact(data.begin(), data.end());
+		std::vector<Body> loaded(bodies.size());
+		meta::ColumnsHeader header;
+		bool ok = meta::ReadColumnsHeader(exact.data(), exact.size(), header) && header.columns.back().path == "charge" && header.columns.back().bits == 0 &&
+			meta::ReadColumns(meta::get<Body>(), exact.data(), exact.size(), loaded.data(), (unsigned)loaded.size(), std::vector<std::string>());
+		for (unsigned i = 0; ok && i < bodies.size(); ++i)
+			ok = loaded[i].id == bodies[i].id && loaded[i].x == bodies[i].x && loaded[i].charge == 1.0;
+		if (!ok)
+			printf("Body columns with a constant last column didn't round trip\n");
+	}
+
+	//Things whole and by column, and what each column chose
+	const unsigned count = 200000;
+	const meta::Type* thingType = meta::get<Thing>();
+	std::vector<Thing> things;
+	for (unsigned i = 0; i < count; ++i)
+		things.push_back(MakeThing(random, i));
+
+	Clock::time_point start = Clock::now();
+	std::vector<char> columns;
+	meta::WriteColumns(thingType, things.data(), count, columns);
+	Milliseconds write = Clock::now() - start;
+
+	std::vector<Thing> loaded(count);
+	start = Clock::now();
+	bool ok = meta::ReadColumns(thingType, columns.data(), columns.size(), loaded.data(), count, std::vector<std::string>());
+	Milliseconds readAll = Clock::now() - start;
+	for (unsigned i = 0; ok && i < count; ++i)
+		ok = SameThing(things[i], loaded[i]);
+	if (!ok)
+		printf("Thing columns didn't round trip\n");
+
+	std::vector<Thing> positions(count);
+	std::vector<std::string> paths(1, "position");
+	start = Clock::now();
+	ok = meta::ReadColumns(thingType, columns.data(), columns.size(), positions.data(), count, paths);
+	Milliseconds readPosition = Clock::now() - start;
+	for (unsigned i = 0; ok && i < count; ++i)
+	{
+		ok = positions[i].position.x == things[i].position.x && positions[i].position.y == things[i].position.y &&
+			positions[i].position.z == things[i].position.z && positions[i].name.empty() && positions[i].id == 0;
+	}
+	if (!ok)
+		printf("Thing positions didn't load alone\n");
+
+	std::vector<Thing> heights(count);
+	paths[0] = "position.y";
+	paths.push_back("height");
+	ok = meta::ReadColumns(thingType, columns.data(), columns.size(), heights.data(), count, paths);
+	for (unsigned i = 0; ok && i < count; ++i)
+		ok = heights[i].position.y == things[i].position.y && heights[i].position.x == 0.0f && heights[i].height == things[i].height;
+	if (!ok)
+		printf("Thing position.y and height didn't load alone\n");
+
+	paths.assign(1, "pos");
+	if (meta::ReadColumns(thingType, columns.data(), columns.size(), heights.data(), count, paths) ||
+		meta::ReadColumns(thingType, columns.data(), columns.size(), heights.data(), count - 1, std::vector<std::string>()) ||
+		meta::ReadColumns(thingType, columns.data(), columns.size() - 1, heights.data(), count, std::vector<std::string>()))
+		printf("Bad column reads succeeded\n");
+
+	meta::ColumnsHeader header;
+	const meta::ColumnInfo* id = NULL;
+	const meta::ColumnInfo* kind = NULL;
+	const meta::ColumnInfo* name = NULL;
+	const meta::ColumnInfo* size = NULL;
+	const meta::ColumnInfo* x = NULL;
+	if (meta::ReadColumnsHeader(columns.data(), columns.size(), header))
+	{
+		id = FindColumn(header, "id");
+		kind = FindColumn(header, "kind");
+		name = FindColumn(header, "name");
+		size = FindColumn(header, "size");
+		x = FindColumn(header, "position.x");
+	}
+	if (!id || id->encoding != meta::Column_Delta || id->bits != 2 || !kind || kind->encoding != meta::Column_FrameOfReference || kind->bits != 1 ||
+		!name || name->encoding != meta::Column_Dictionary || name->bits != 3 || !size || size->bits != 0 || !x || x->bits != 10 ||
+		header.typeName != thingType->Name() || header.schemaHash != thingType->SchemaHash())
+		printf("Thing column encodings are wrong\n");
+
+	//against a snapshot of the same Things, plain and compressed
+	std::vector<char> plain;
+	meta::WriteSnapshot(thingType, things.data(), count, plain);
+	std::vector<char> plainPacked, columnsPacked;
+	meta::CompressBlock(plain.data(), plain.size(), plainPacked, 1);
+	meta::CompressBlock(columns.data(), columns.size(), columnsPacked, 1);
+
+	printf("Columns of %u Things:\n", count);
+	printf("%18s %8s %8s\n", "", "KB", "level 1");
+	printf("%18s %8u %8u\n", "snapshot", (unsigned)(plain.size() / 1024), (unsigned)(plainPacked.size() / 1024));
+	printf("%18s %8u %8u\n", "columns", (unsigned)(columns.size() / 1024), (unsigned)(columnsPacked.size() / 1024));
+	printf("%18s %8.2f\n", "write", write.count());
+	printf("%18s %8.2f\n", "read all", readAll.count());
+	printf("%18s %8.2f\n", "read position", readPosition.count());
+	printf("\n");
+}
@@ -0,0 +1,327 @@
+#include "Compression.h"
+#include <algorithm>
+#include <cstring>
+
+namespace meta
+{
+	namespace
+	{
+		const size_t minMatch = 4;
+		const size_t maxOffset = 65535;
+		const unsigned hashBits = 16;
+		const size_t chainMask = 65535;
+
+		typedef unsigned char Byte;
+
+		unsigned Load32(const Byte* at)
+		{
+			unsigned value;
+			std::memcpy(&value, at, sizeof(value));
+			return value;
+		}
+
+		unsigned Hash(const Byte* at)
+		{
+			return (Load32(at) * 2654435761U) >> (32 - hashBits);
+		}
+
+		//bytes that match from a and b, up to end from b
+		size_t MatchLength(const Byte* a, const Byte* b, const Byte* end)
+		{
+			const Byte* start = b;
+			while (end - b >= 8 && std::memcmp(a, b, 8) == 0)
+			{
+				a += 8;
+				b += 8;
+			}
+			while (b < end && *a == *b)
+			{
+				++a;
+				++b;
+			}
+			return b - start;
+		}
+
+		//the most a block of size bytes can take: all literals, a length byte per 255 of them
+		size_t CompressBound(size_t size)
+		{
+			return size + size / 255 + 16;
+		}
+
+		//the part of a length past its nibble: 255s, then the rest
+		Byte* WriteLength(Byte* out, size_t length)
+		{
+			for (; length >= 255; length -= 255)
+			{
+				*out++ = 255;
+			}
+			*out++ = (Byte)length;
+			return out;
+		}
+
+		//literals, then a match unless length is 0; returns the end of the sequence
+		Byte* WriteSequence(Byte* out, const Byte* literals, size_t literalCount, size_t offset, size_t length)
+		{
+			size_t extra = length > 0 ? length - minMatch : 0;
+			*out++ = (Byte)((std::min<size_t>(literalCount, 15) << 4) | std::min<size_t>(extra, 15));
+			if (literalCount >= 15)
+			{
+				out = WriteLength(out, literalCount - 15);
+			}
+			std::memcpy(out, literals, literalCount);
+			out += literalCount;
+
+			if (length > 0)
+			{
+				*out++ = (Byte)(offset & 0xff);
+				*out++ = (Byte)(offset >> 8);
+				if (extra >= 15)
+				{
+					out = WriteLength(out, extra - 15);
+				}
+			}
+			return out;
+		}
+
+		bool ReadLength(const Byte*& at, const Byte* end, size_t& length)
+		{
+			Byte next;
+			do
+			{
+				if (at >= end)
+				{
+					return false;
+				}
+				next = *at++;
+				length += next;
+			} while (next == 255);
+			return true;
+		}
+
+		//The positions already seen, by the hash of their first four bytes. Positions are stored plus
+		//one, so 0 is empty. With a chain, each position also links to the one before it with its hash.
+		class MatchFinder
+		{
+		public:
+			MatchFinder(const Byte* data, size_t size, unsigned level)
+				: data(data), end(data + size), depth(level <= 1 ? 1 : 1U << level), inserted(0), head((size_t)1 << hashBits, 0)
+			{
+				if (level > 1)
+				{
+					chain.resize(chainMask + 1, 0);
+				}
+			}
+
+			//the longest earlier match for position at, which is then inserted; 0 if there's none
+			size_t Find(size_t at, size_t& offset)
+			{
+				size_t best = 0;
+				unsigned candidate = Insert(at);
+				for (unsigned probe = 0; candidate != 0 && probe < depth; ++probe)
+				{
+					size_t earlier = candidate - 1;
+					if (earlier >= at || at - earlier > maxOffset)
+					{
+						break;
+					}
+					if (Load32(data + earlier) == Load32(data + at))
+					{
+						size_t length = MatchLength(data + earlier, data + at, end);
+						if (length > best)
+						{
+							best = length;
+							offset = at - earlier;
+							if (data + at + length == end)
+							{
+								break;
+							}
+						}
+					}
+					if (chain.empty())
+					{
+						break;
+					}
+					candidate = chain[earlier & chainMask];
+				}
+				return best >= minMatch ? best : 0;
+			}
+
+			//positions up to, not including, at
+			void InsertUpTo(size_t at)
+			{
+				if (chain.empty())
+				{
+					return;
+				}
+				for (size_t i = inserted; i < at && data + i + minMatch <= end; ++i)
+				{
+					Insert(i);
+				}
+			}
+
+		private:
+			// Non-Copyable
+			MatchFinder(const MatchFinder&); // = delete
+			void operator=(const MatchFinder&); // = delete
+
+			//the previous position with at's hash
+			unsigned Insert(size_t at)
+			{
+				unsigned& slot = head[Hash(data + at)];
+				unsigned previous = slot;
+				if (at < inserted)
+				{
+					return previous;
+				}
+				slot = (unsigned)at + 1;
+				if (!chain.empty())
+				{
+					chain[at & chainMask] = previous;
+				}
+				inserted = at + 1;
+				return previous;
+			}
+
+			const Byte* data;
+			const Byte* end;
+			unsigned depth;
+			size_t inserted;
+			std::vector<unsigned> head;
+			std::vector<unsigned> chain;
+		};
+	}
+
+	size_t CompressBlock(const char* data, size_t size, std::vector<char>& out, unsigned level)
+	{
+		const Byte* in = reinterpret_cast<const Byte*>(data);
+		size_t start = out.size();
+		out.resize(start + CompressBound(size));
+		Byte* begin = reinterpret_cast<Byte*>(&out[start]);
+		Byte* to = begin;
+
+		level = std::min(level, maxCompressionLevel);
+		if (level == 0 || size < minMatch)
+		{
+			to = WriteSequence(to, in, size, 0, 0);
+			out.resize(start + (to - begin));
+			return to - begin;
+		}
+
+		MatchFinder finder(in, size, level);
+		bool lazy = level >= 5;
+		size_t anchor = 0;
+		size_t at = 0;
+		size_t misses = 0;
+		while (at + minMatch <= size)
+		{
+			size_t offset = 0;
+			size_t length = finder.Find(at, offset);
+			if (length == 0)
+			{
+				//level 1 strides over data that doesn't compress
+				at += level == 1 ? 1 + (misses++ >> 5) : 1;
+				continue;
+			}
+
+			if (lazy && at + 1 + minMatch <= size)
+			{
+				size_t nextOffset = 0;
+				size_t next = finder.Find(at + 1, nextOffset);
+				if (next > length)
+				{
+					++at;
+					length = next;
+					offset = nextOffset;
+				}
+			}
+
+			to = WriteSequence(to, in + anchor, at - anchor, offset, length);
+			at += length;
+			anchor = at;
+			misses = 0;
+			finder.InsertUpTo(at);
+		}
+
+		to = WriteSequence(to, in + anchor, size - anchor, 0, 0);
+		out.resize(start + (to - begin));
+		return to - begin;
+	}
+
+	//a length byte adds at most 255 bytes, a literal one, and a token with its offset 19 between them
+	size_t MaxDecompressedSize(size_t blockSize)
+	{
+		return blockSize > (size_t)-1 / 255 ? (size_t)-1 : blockSize * 255;
+	}
+
+	bool DecompressBlock(const char* block, size_t blockSize, char* out, size_t size)
+	{
+		const Byte* at = reinterpret_cast<const Byte*>(block);
+		const Byte* end = at + blockSize;
+		Byte* begin = reinterpret_cast<Byte*>(out);
+		Byte* to = begin;
+		Byte* last = begin + size;
+
+		while (at < end)
+		{
+			Byte token = *at++;
+			size_t literals = token >> 4;
+			if (literals == 15 && !ReadLength(at, end, literals))
+			{
+				return false;
+			}
+			if (literals > (size_t)(end - at) || literals > (size_t)(last - to))
+			{
+				return false;
+			}
+			//short runs copy a fixed 16 bytes when there's room to overrun on both sides
+			if (literals <= 16 && end - at >= 16 && last - to >= 16)
+				std::memcpy(to, at, 16);
+			else
+				std::memcpy(to, at, literals);
+			to += literals;
+			at += literals;
+
+			if (at == end)
+			{
+				break;
+			}
+
+			if (end - at < 2)
+			{
+				return false;
+			}
+			size_t offset = at[0] | ((size_t)at[1] << 8);
+			at += 2;
+			size_t length = token & 15;
+			if (length == 15 && !ReadLength(at, end, length))
+			{
+				return false;
+			}
+			length += minMatch;
+			if (offset == 0 || offset > (size_t)(to - begin) || length > (size_t)(last - to))
+			{
+				return false;
+			}
+
+			//eight bytes at a time when the match doesn't overlap them and there's room to overrun
+			const Byte* match = to - offset;
+			if (offset >= 8 && (size_t)(last - to) >= length + 8)
+			{
+				for (size_t i = 0; i < length; i += 8)
+				{
+					std::memcpy(to + i, match + i, 8);
+				}
+			}
+			else
+			{
+				for (size_t i = 0; i < length; ++i)
+				{
+					to[i] = match[i];
+				}
+			}
+			to += length;
+		}
+
+		return to == last;
+	}
+}
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+namespace meta
+{
+	//////////////////////////////////////////////////////////////////////////////
+	//  Block compression
+	//////////////////////////////////////////////////////////////////////////////
+	// Purpose: A small LZ77 compressor with no dependencies, for blocks that are compressed
+	//          and decompressed independently of each other. A block is a run of sequences in
+	//          LZ4's layout: a token byte (literal count and match length nibbles, 15 meaning
+	//          more bytes follow), the literals, then a two byte offset back into the block's
+	//          output and the match length. The last sequence is literals alone.
+	//
+	//          The level trades ratio against speed. Level 1 looks up one earlier position per
+	//          hash of four bytes and skips ahead faster the longer it goes without a match;
+	//          levels 2 to 9 follow a chain of earlier positions with the same hash, twice as
+	//          far each level, and from level 5 check whether the next byte starts a longer
+	//          match first. Decompression speed is the same at every level. Level 0 stores.
+
+	const unsigned maxCompressionLevel = 9;
+
+	//appends size bytes at data, compressed at level, to out; returns the compressed size
+	size_t CompressBlock(const char* data, size_t size, std::vector<char>& out, unsigned level);
+
+	//The most a block of blockSize bytes can decompress to, for checking a stated size before
+	//allocating it: no byte of a block adds more than 255 to its output.
+	size_t MaxDecompressedSize(size_t blockSize);
+
+	//Decompresses a block into exactly size bytes at out. false if the block is malformed or
+	//decompresses to any other size; a block never reads or writes outside its bounds.
+	bool DecompressBlock(const char* block, size_t blockSize, char* out, size_t size);
+}
+
+void TestCompression();
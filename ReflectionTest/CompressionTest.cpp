@@ -0,0 +1,183 @@
+#include "Compression.h"
+#include "SerializationTest.h"
+#include "Snapshot.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <thread>
+
+namespace
+{
+	bool RoundTrips(const std::string& data, unsigned level)
+	{
+		std::vector<char> block;
+		size_t size = meta::CompressBlock(data.data(), data.size(), block, level);
+		std::string out(data.size() + 1, '\0');
+		return size == block.size() && meta::DecompressBlock(block.data(), block.size(), &out[0], data.size()) && out.compare(0, data.size(), data) == 0 &&
+			out[data.size()] == '\0' && (data.empty() || !meta::DecompressBlock(block.data(), block.size(), &out[0], data.size() - 1));
+	}
+
+	Thing MakeThing(std::mt19937& random, unsigned id)
+	{
+		static const char* names[] = { "apple", "banana", "cherry", "damson", "elderberry", "fig", "grape" };
+		Thing thing;
+		thing.id = id;
+		thing.size = (int)(random() % 1000);
+		thing.name = std::string(names[random() % 7]) + " " + std::to_string(random() % 500);
+		thing.radius = (float)(random() % 64) * 0.25f;
+		thing.height = (double)(random() % 100000) / 100.0;
+		thing.position = Vector3((float)(id % 1000), (float)(random() % 16), 0.0f);
+		thing.kind = random() & 1 ? Thing_Apple : Thing_Banana;
+		return thing;
+	}
+
+	bool SameThing(const Thing& lhs, const Thing& rhs)
+	{
+		return lhs.id == rhs.id && lhs.size == rhs.size && lhs.name == rhs.name && lhs.radius == rhs.radius && lhs.height == rhs.height &&
+			lhs.position.x == rhs.position.x && lhs.position.y == rhs.position.y && lhs.position.z == rhs.position.z && lhs.kind == rhs.kind;
+	}
+
+	bool SameThings(const std::vector<Thing>& things, const std::vector<Thing>& loaded, unsigned first)
+	{
+		for (unsigned i = 0; i < loaded.size(); ++i)
+		{
+			if (!SameThing(things[first + i], loaded[i]))
+				return false;
+		}
+		return true;
+	}
+}
+
+void TestCompression()
+{
+	typedef std::chrono::high_resolution_clock Clock;
+	typedef std::chrono::duration<double, std::milli> Milliseconds;
+
+	//runs of one byte (matches overlapping their own output), long literal runs and matches, noise
+	std::mt19937 random(49);
+	std::vector<std::string> inputs;
+	inputs.push_back("");
+	inputs.push_back("a");
+	inputs.push_back("abcd");
+	inputs.push_back(std::string(100000, 'x'));
+	std::string noise(70000, '\0');
+	for (unsigned i = 0; i < noise.size(); ++i)
+		noise[i] = (char)random();
+	inputs.push_back(noise);
+	inputs.push_back(noise.substr(0, 300) + noise.substr(0, 300) + std::string(1000, 'y') + noise.substr(0, 20));
+	std::string words;
+	static const char* vocabulary[] = { "position", "radius", "height", " ", "thing", "\"name\": ", "{ ", "}, ", "0.25", "apple" };
+	while (words.size() < 200000)
+		words += vocabulary[random() % 10];
+	inputs.push_back(words);
+
+	for (unsigned i = 0; i < inputs.size(); ++i)
+	{
+		for (unsigned level = 0; level <= meta::maxCompressionLevel; ++level)
+		{
+			if (!RoundTrips(inputs[i], level))
+				printf("Block %u (%u bytes) didn't round trip at level %u\n", i, (unsigned)inputs[i].size(), level);
+		}
+	}
+
+	//cut off and damaged blocks fail or decompress to something, never outside their bounds
+	{
+		std::vector<char> block;
+		meta::CompressBlock(words.data(), words.size(), block, 6);
+		std::string out(words.size(), '\0');
+		if (meta::DecompressBlock(block.data(), block.size() / 2, &out[0], out.size()))
+			printf("A cut off block decompressed\n");
+		for (unsigned i = 0; i < 200; ++i)
+		{
+			std::vector<char> damaged = block;
+			damaged[random() % damaged.size()] ^= (char)(1 + random() % 255);
+			meta::DecompressBlock(damaged.data(), damaged.size(), &out[0], out.size());
+		}
+	}
+
+	//compressed Thing snapshots against the plain one, whole and in ranges that cross blocks
+	const unsigned count = 200000;
+	const meta::Type* thingType = meta::get<Thing>();
+	std::vector<Thing> things;
+	for (unsigned i = 0; i < count; ++i)
+		things.push_back(MakeThing(random, i));
+
+	std::vector<char> plain;
+	meta::WriteSnapshot(thingType, things.data(), count, plain);
+	std::vector<Thing> loaded(count);
+	Clock::time_point start = Clock::now();
+	bool plainOk = meta::ReadSnapshot(thingType, plain.data(), plain.size(), loaded.data(), count) && SameThings(things, loaded, 0);
+	Milliseconds plainLoad = Clock::now() - start;
+	if (!plainOk)
+		printf("Plain Thing snapshot didn't round trip\n");
+
+	meta::SnapshotCompression compression;
+	compression.blockSize = 64 * 1024;
+	std::vector<char> packed;
+	meta::WriteCompressedSnapshot(thingType, things.data(), count, packed, compression);
+	meta::SnapshotHeader header;
+	if (!meta::ReadSnapshotHeader(packed.data(), packed.size(), header) || !header.compressed || header.count != count ||
+		header.schemaHash != thingType->SchemaHash() || header.blocks < plain.size() / compression.blockSize)
+		printf("Compressed Thing snapshot header is wrong (%u blocks)\n", header.blocks);
+
+	const unsigned ranges[][2] = { { 0, 1 }, { 0, 0 }, { 1234, 5000 }, { 41000, 30000 }, { count - 7, 7 }, { 0, count } };
+	for (unsigned r = 0; r < 6; ++r)
+	{
+		std::vector<Thing> range(ranges[r][1]);
+		std::vector<Thing> plainRange(ranges[r][1]);
+		if (!meta::ReadSnapshotRange(thingType, packed.data(), packed.size(), ranges[r][0], ranges[r][1], range.data(), 0, r % 3) ||
+			!SameThings(things, range, ranges[r][0]) || !meta::ReadSnapshotRange(thingType, plain.data(), plain.size(), ranges[r][0], ranges[r][1], plainRange.data()) ||
+			!SameThings(things, plainRange, ranges[r][0]))
+			printf("Things %u to %u didn't load from a snapshot range\n", ranges[r][0], ranges[r][0] + ranges[r][1]);
+	}
+	{
+		Thing one;
+		std::vector<char> damaged = packed;
+		damaged[damaged.size() - 5000] ^= 0x5a;
+		damaged.resize(damaged.size() - 1);
+		if (meta::ReadSnapshotRange(thingType, packed.data(), packed.size(), count, 1, &one) ||
+			meta::ReadSnapshot(thingType, packed.data(), packed.size(), loaded.data(), count - 1) ||
+			meta::ReadSnapshot(thingType, damaged.data(), damaged.size(), loaded.data(), count))
+			printf("Bad compressed snapshot reads succeeded\n");
+
+		//a first block claiming far more than it can decompress to, past the header and schema
+		damaged = packed;
+		unsigned schemaBytes, rawSize = 0xfffffff0;
+		size_t schemaAt = 32 + header.typeName.size();	//past the magic, format, name, version, hash, count and blocks
+		std::memcpy(&schemaBytes, &damaged[schemaAt], sizeof(schemaBytes));
+		std::memcpy(&damaged[schemaAt + 4 + schemaBytes + 4], &rawSize, sizeof(rawSize));
+		if (meta::ReadSnapshot(thingType, damaged.data(), damaged.size(), loaded.data(), count))
+			printf("Compressed snapshot with an oversized block loaded\n");
+	}
+
+	//ratio against speed by level, loading on one worker and on every hardware thread
+	unsigned hardware = std::max(1U, std::thread::hardware_concurrency());
+	const unsigned levels[] = { 0, 1, 3, 5, 9 };
+	printf("Compressed snapshot of %u Things (%u KB plain, loads in %.2f ms), 256 KB blocks:\n", count, (unsigned)(plain.size() / 1024), plainLoad.count());
+	printf("%18s %8s %8s %8s %8s %8s\n", "level", "KB", "ratio", "write", "load x1", "load xN");
+	compression.blockSize = 256 * 1024;
+	for (unsigned l = 0; l < sizeof(levels) / sizeof(levels[0]); ++l)
+	{
+		compression.level = levels[l];
+		packed.clear();
+		start = Clock::now();
+		meta::WriteCompressedSnapshot(thingType, things.data(), count, packed, compression);
+		Milliseconds write = Clock::now() - start;
+
+		std::vector<Thing> single(count), parallel(count);
+		start = Clock::now();
+		bool ok = meta::ReadSnapshot(thingType, packed.data(), packed.size(), single.data(), count, 0, 1);
+		Milliseconds loadSingle = Clock::now() - start;
+		start = Clock::now();
+		ok = meta::ReadSnapshot(thingType, packed.data(), packed.size(), parallel.data(), count, 0, hardware) && ok;
+		Milliseconds loadParallel = Clock::now() - start;
+		if (!ok || !SameThings(things, single, 0) || !SameThings(things, parallel, 0))
+			printf("Level %u compressed Things didn't round trip\n", levels[l]);
+
+		printf("%18u %8u %8.2f %8.2f %8.2f %8.2f\n", levels[l], (unsigned)(packed.size() / 1024), (double)plain.size() / packed.size(),
+			write.count(), loadSingle.count(), loadParallel.count());
+	}
+	printf("\n");
+}
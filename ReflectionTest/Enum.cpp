@@ -0,0 +1,179 @@
+#include "Enum.h"
+#include <algorithm>
+#include <cstring>
+#include <assert.h>
+
+namespace meta
+{
+	namespace
+	{
+		struct ValueLess
+		{
+			const std::vector<long long>* values;
+			bool operator()(unsigned a, unsigned b) const { return (*values)[a] < (*values)[b]; }
+		};
+	}
+
+	void EnumTable::AddValue(const std::string& name, long long value)
+	{
+		//scoped enumerators are registered as "Enum::Value"; data files use "Value"
+		size_t scope = name.rfind("::");
+		std::string shortName = scope == std::string::npos ? name : name.substr(scope + 2);
+		assert(std::find(names.begin(), names.end(), shortName) == names.end()); //registered twice
+
+		names.push_back(shortName);
+		values.push_back(value);
+	}
+
+	unsigned EnumTable::Hash(unsigned seed, const char* str, size_t length)
+	{
+		//FNV-1a, seeded
+		unsigned hash = 2166136261u ^ seed;
+		for (size_t i = 0; i < length; ++i)
+		{
+			hash ^= (unsigned char)str[i];
+			hash *= 16777619u;
+		}
+		return hash ^ (hash >> 15);
+	}
+
+	void EnumTable::Build(void)
+	{
+		if (names.empty())
+		{
+			return;
+		}
+
+		//perfect hash: search seeds for a collision free table, growing the table if none turns up
+		unsigned tableSize = 1;
+		while (tableSize < names.size() * 2)
+		{
+			tableSize <<= 1;
+		}
+
+		mask = tableSize - 1;
+		seed = 0;
+		while (!TryPlace())
+		{
+			if (++seed == 1024)
+			{
+				seed = 0;
+				mask = mask * 2 + 1;
+			}
+		}
+
+		//value -> name
+		byValue.resize(values.size());
+		for (unsigned i = 0; i < byValue.size(); ++i)
+		{
+			byValue[i] = i;
+		}
+		ValueLess less = { &values };
+		std::stable_sort(byValue.begin(), byValue.end(), less);
+
+		dense.clear();
+		minValue = values[byValue.front()];
+		long long range = values[byValue.back()] - minValue + 1;
+		if (range <= (long long)values.size() * 4 + 16)
+		{
+			dense.assign((size_t)range, -1);
+			for (unsigned i = 0; i < values.size(); ++i)
+			{
+				int& entry = dense[(size_t)(values[i] - minValue)];
+				if (entry == -1) //aliases map back to the first name
+				{
+					entry = (int)i;
+				}
+			}
+		}
+	}
+
+	bool EnumTable::TryPlace(void)
+	{
+		slots.assign(mask + 1, -1);
+
+		for (unsigned i = 0; i < names.size(); ++i)
+		{
+			int& slot = slots[Hash(seed, names[i].data(), names[i].size()) & mask];
+			if (slot != -1)
+			{
+				return false;
+			}
+			slot = (int)i;
+		}
+		return true;
+	}
+
+	const char* EnumTable::ToString(long long value) const
+	{
+		if (names.empty())
+		{
+			return NULL;
+		}
+
+		if (!dense.empty())
+		{
+			unsigned long long index = (unsigned long long)(value - minValue);
+			if (index >= dense.size() || dense[(size_t)index] == -1)
+			{
+				return NULL;
+			}
+			return names[dense[(size_t)index]].c_str();
+		}
+
+		unsigned low = 0, high = (unsigned)byValue.size();
+		while (low < high)
+		{
+			unsigned mid = (low + high) / 2;
+			if (values[byValue[mid]] < value)
+				low = mid + 1;
+			else
+				high = mid;
+		}
+
+		if (low < byValue.size() && values[byValue[low]] == value)
+		{
+			return names[byValue[low]].c_str();
+		}
+		return NULL;
+	}
+
+	bool EnumTable::FromString(const char* name, size_t length, long long& value) const
+	{
+		if (names.empty())
+		{
+			return false;
+		}
+
+		int index = slots[Hash(seed, name, length) & mask];
+		if (index == -1 || names[index].size() != length || std::memcmp(names[index].data(), name, length) != 0)
+		{
+			return false;
+		}
+
+		value = values[index];
+		return true;
+	}
+
+	long long EnumTable::Get(const void* object) const
+	{
+		switch (size)
+		{
+			case 1: return isSigned ? *static_cast<const signed char*>(object) : *static_cast<const unsigned char*>(object);
+			case 2: return isSigned ? *static_cast<const short*>(object) : *static_cast<const unsigned short*>(object);
+			case 4: return isSigned ? (long long)*static_cast<const int*>(object) : (long long)*static_cast<const unsigned*>(object);
+			default: return *static_cast<const long long*>(object);
+		}
+	}
+
+	void EnumTable::Set(void* object, long long value) const
+	{
+		switch (size)
+		{
+			case 1: *static_cast<signed char*>(object) = (signed char)value; break;
+			case 2: *static_cast<short*>(object) = (short)value; break;
+			case 4: *static_cast<int*>(object) = (int)value; break;
+			default: *static_cast<long long*>(object) = value; break;
+		}
+	}
+}
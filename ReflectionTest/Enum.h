@@ -0,0 +1,61 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+namespace meta
+{
+	//////////////////////////////////////////////////////////////////////////////
+	//  EnumTable
+	//////////////////////////////////////////////////////////////////////////////
+	// Purpose: Name/value table of a registered enum.
+	//          Name -> value goes through a perfect hash built once the enum's values are all
+	//          registered: one hash and one string compare per lookup. Value -> name indexes a dense array when the values are
+	//          reasonably packed (sorted binary search otherwise, e.g. for bit flags).
+	class EnumTable
+	{
+	public:
+		EnumTable(unsigned size, bool isSigned) : size(size), isSigned(isSigned), seed(0), mask(0), minValue(0) {}
+
+		//AddValue the enumerators, then Build the lookups once
+		void AddValue(const std::string& name, long long value);
+		void Build(void);
+
+		unsigned Count(void) const { return (unsigned)names.size(); }
+		const std::string& NameAt(unsigned index) const { return names[index]; }
+		long long ValueAt(unsigned index) const { return values[index]; }
+
+		// NULL if no enumerator has that value
+		const char* ToString(long long value) const;
+
+		// false if name isn't an enumerator
+		bool FromString(const char* name, size_t length, long long& value) const;
+		bool FromString(const std::string& name, long long& value) const { return FromString(name.data(), name.size(), value); }
+
+		//read and write an enum object, whatever its underlying size; unsigned enums zero extend
+		long long Get(const void* object) const;
+		void Set(void* object, long long value) const;
+		bool IsSigned(void) const { return isSigned; }
+
+	private:
+		static unsigned Hash(unsigned seed, const char* str, size_t length);
+		bool TryPlace(void);
+
+		unsigned size;
+		bool isSigned;
+		std::vector<std::string> names;
+		std::vector<long long> values;
+
+		//perfect hash: slot = Hash(seed, name) & mask, slot holds index into names or -1
+		unsigned seed;
+		unsigned mask;
+		std::vector<int> slots;
+
+		//value -> name: dense[value - minValue] is an index into names or -1. Empty when too sparse.
+		long long minValue;
+		std::vector<int> dense;
+		std::vector<unsigned> byValue; //indices sorted by value, for sparse enums
+	};
+}
+
+void TestEnumReflection();
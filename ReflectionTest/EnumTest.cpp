@@ -0,0 +1,54 @@
+#include "Test.h"
+#include "SerializationTest.h"
+#include "Sort.h"
+
+void TestEnumReflection()
+{
+	//every enumerator maps both ways, for the dense ThingType, the sparse TestFlags and the unsigned AccessMask
+	const meta::Type* enumTypes[] = { meta::get<ThingType>(), meta::get<TestFlags>(), meta::get<AccessMask>() };
+	for (const meta::Type* type : enumTypes)
+	{
+		const meta::EnumTable* table = type->Enum();
+		for (unsigned i = 0; i < table->Count(); ++i)
+		{
+			long long value;
+			if (!table->FromString(table->NameAt(i), value) || value != table->ValueAt(i))
+				printf("%s: %s doesn't map to its value\n", type->Name().c_str(), table->NameAt(i).c_str());
+			if (table->ToString(table->ValueAt(i)) != table->NameAt(i))
+				printf("%s: %lld doesn't map to its name\n", type->Name().c_str(), table->ValueAt(i));
+		}
+	}
+
+	long long value;
+	if (meta::get<ThingType>()->Enum()->FromString("Thing_Cherry", value))
+		printf("ThingType accepted an unknown name\n");
+	if (meta::get<TestFlags>()->Enum()->ToString(2) != NULL)
+		printf("TestFlags named a value it doesn't have\n");
+
+	//unsigned enums read back zero extended, so they name and sort past the top of int
+	const meta::Type* maskType = meta::get<AccessMask>();
+	Grant grants[] = { { 0, Access_Admin }, { 1, Access_None }, { 2, Access_Read } };
+	std::vector<unsigned> order;
+	unsigned long long adminKey = 0, readKey = 0;
+	const char* adminName = maskType->Enum()->ToString(maskType->Enum()->Get(&grants[0].access));
+	if (adminName == NULL || std::string(adminName) != "Access_Admin" ||
+		!meta::SortOrder(meta::get<Grant>(), meta::get<Grant>()->mamberNames.at("access"), grants, 3, order) ||
+		order[0] != 1 || order[1] != 2 || order[2] != 0 || !meta::NumericKey(maskType, &grants[0].access, adminKey) ||
+		!meta::NumericKey(maskType, &grants[2].access, readKey) || adminKey <= readKey)
+		printf("AccessMask's top value didn't read back unsigned\n");
+
+	//json writes enum members by name and reads them back
+	Thing thing = Thing();
+	thing.kind = Thing_Apple;
+	json_t* json = SerializeJsonObject(&thing, "Thing");
+	printf("Thing.kind written as: %s\n", json_string_value(json_object_get(json, "kind")));
+
+	Thing loaded = Thing();
+	loaded.kind = Thing_Banana;
+	DeSerializeJsonObject(json, &loaded, "Thing");
+	json_decref(json);
+	if (loaded.kind != Thing_Apple)
+		printf("Thing.kind didn't survive a json round trip\n");
+
+	printf("\n");
+}
@@ -0,0 +1,111 @@
+#pragma once
+
+#include "Meta.h"
+#include "Arena.h"
+#include "StringPool.h"
+
+namespace meta
+{
+	//////////////////////////////////////////////////////////////////////////////
+	//  FieldKind
+	//////////////////////////////////////////////////////////////////////////////
+	// Purpose: What the loaders and writers (json, MessagePack, columns, sorting) do with a
+	//          member, picked once from its type, plus the byte level helpers they share.
+	//          Each handles the kinds it supports and skips the rest.
+	enum FieldKind
+	{
+		Kind_Signed,
+		Kind_Unsigned,
+		Kind_Boolean,
+		Kind_Real32,
+		Kind_Real64,
+		Kind_String,
+		Kind_View,
+		Kind_Interned,
+		Kind_ArenaString,
+		Kind_Integers,
+		Kind_Reals,
+		Kind_Strings,
+		Kind_Enumeration,
+		Kind_Struct,
+		Kind_Other
+	};
+
+	inline FieldKind Classify(const Type* type)
+	{
+		if (type == meta::get<int>() || type == meta::get<short>() || type == meta::get<long>() || type == meta::get<char>())
+			return Kind_Signed;
+		if (type == meta::get<unsigned int>() || type == meta::get<unsigned short>() || type == meta::get<unsigned long>() || type == meta::get<unsigned char>())
+			return Kind_Unsigned;
+		if (type == meta::get<bool>())					return Kind_Boolean;
+		if (type == meta::get<float>())					return Kind_Real32;
+		if (type == meta::get<double>())				return Kind_Real64;
+		if (type == meta::get<std::string>())			return Kind_String;
+		if (type == meta::get<StringView>())			return Kind_View;
+		if (type == meta::get<InternedString>())		return Kind_Interned;
+		if (type == meta::get<ArenaString>())			return Kind_ArenaString;
+		if (type == meta::get<ArenaVector<int> >())		return Kind_Integers;
+		if (type == meta::get<ArenaVector<float> >())	return Kind_Reals;
+		if (type == meta::get<ArenaVector<ArenaString> >())	return Kind_Strings;
+		if (type->Enum() != NULL)						return Kind_Enumeration;
+		if (!type->members.empty())						return Kind_Struct;
+		return Kind_Other;
+	}
+
+	//truncates to the member's size
+	inline void StoreInteger(char* at, unsigned size, unsigned long long value)
+	{
+		switch (size)
+		{
+			case 1: { unsigned char v = (unsigned char)value; std::memcpy(at, &v, 1); break; }
+			case 2: { unsigned short v = (unsigned short)value; std::memcpy(at, &v, 2); break; }
+			case 4: { unsigned v = (unsigned)value; std::memcpy(at, &v, 4); break; }
+			default: std::memcpy(at, &value, 8); break;
+		}
+	}
+
+	//writes code as 1 to 4 bytes at to, returning the end
+	inline char* EncodeUtf8(char* to, unsigned code)
+	{
+		if (code < 0x80)
+		{
+			*to++ = (char)code;
+		}
+		else if (code < 0x800)
+		{
+			*to++ = (char)(0xc0 | (code >> 6));
+			*to++ = (char)(0x80 | (code & 0x3f));
+		}
+		else if (code < 0x10000)
+		{
+			*to++ = (char)(0xe0 | (code >> 12));
+			*to++ = (char)(0x80 | ((code >> 6) & 0x3f));
+			*to++ = (char)(0x80 | (code & 0x3f));
+		}
+		else
+		{
+			*to++ = (char)(0xf0 | (code >> 18));
+			*to++ = (char)(0x80 | ((code >> 12) & 0x3f));
+			*to++ = (char)(0x80 | ((code >> 6) & 0x3f));
+			*to++ = (char)(0x80 | (code & 0x3f));
+		}
+		return to;
+	}
+
+	//the four hex digits at digits
+	inline bool Hex4(const char* digits, unsigned& code)
+	{
+		code = 0;
+		for (unsigned i = 0; i < 4; ++i)
+		{
+			char c = digits[i];
+			unsigned digit;
+			if (c >= '0' && c <= '9')			digit = c - '0';
+			else if (c >= 'a' && c <= 'f')		digit = c - 'a' + 10;
+			else if (c >= 'A' && c <= 'F')		digit = c - 'A' + 10;
+			else								return false;
+			code = (code << 4) | digit;
+		}
+		return true;
+	}
+}
@@ -1,4 +1,7 @@
 #include "FunctionMeta.h"
+#include "FunctionTest.h"
+#include "Test.h"
+#include <chrono>
 #include <iostream>
 
 std::string printVars(char c, double d, int i)
@@ -17,3 +20,117 @@ void FunctionSignatureTest()
 		printf("   Type%d: %s \n", i, thefunc.argArray[i]->Name().c_str());
 	}	
 }
+
+static float Damage(float base, float armor, int level)
+{
+	return base * (1.0f + 0.1f * level) - armor;
+}
+
+static void Grow(float& value, float by)
+{
+	value += by;
+}
+
+static unsigned Take(std::string&& text)
+{
+	std::string taken(std::move(text));
+	return (unsigned)taken.size();
+}
+
+static char First(char* text)
+{
+	return text[0];
+}
+
+void FunctionBatchTest()
+{
+	typedef std::chrono::high_resolution_clock Clock;
+
+	meta::Function damage(Damage);
+
+	const unsigned count = 1000000;
+	std::vector<float> bases(count), armors(count), results(count);
+	std::vector<int> levels(count);
+	std::vector<DamageArgs> tuples(count);
+	for (unsigned i = 0; i < count; ++i)
+	{
+		bases[i] = tuples[i].base = (float)(i % 100);
+		armors[i] = tuples[i].armor = (float)(i % 7);
+		levels[i] = tuples[i].level = (int)(i % 10);
+	}
+
+	//one reflective call per argument set
+	Clock::time_point start = Clock::now();
+	for (unsigned i = 0; i < count; ++i)
+	{
+		meta::RefVariant ret = results[i];
+		meta::RefVariant args[3] = { bases[i], armors[i], levels[i] };
+		damage.Invoke(ret, args, 3);
+	}
+	std::chrono::duration<double, std::nano> single = Clock::now() - start;
+
+	//columns: checked once, then a loop compiled for Damage's signature
+	meta::Column columns[3] = { meta::MakeColumn(bases.data()), meta::MakeColumn(armors.data()), meta::MakeColumn(levels.data()) };
+	std::vector<float> batched(count);
+	start = Clock::now();
+	damage.InvokeBatch(columns, 3, meta::MakeColumn(batched.data()), count);
+	std::chrono::duration<double, std::nano> batch = Clock::now() - start;
+
+	//bound at compile time: the same loop with Damage inlined
+	meta::Function boundDamage = meta_function(Damage);
+	std::vector<float> bound(count);
+	start = Clock::now();
+	boundDamage.InvokeBatch(columns, 3, meta::MakeColumn(bound.data()), count);
+	std::chrono::duration<double, std::nano> boundBatch = Clock::now() - start;
+
+	std::vector<float> fromTuples(count);
+	start = Clock::now();
+	damage.InvokeTuples(meta::get<DamageArgs>(), tuples.data(), count, meta::MakeColumn(fromTuples.data()));
+	std::chrono::duration<double, std::nano> tupled = Clock::now() - start;
+
+	std::vector<float> direct(count);
+	start = Clock::now();
+	for (unsigned i = 0; i < count; ++i)
+		direct[i] = Damage(bases[i], armors[i], levels[i]);
+	std::chrono::duration<double, std::nano> native = Clock::now() - start;
+
+	for (unsigned i = 0; i < count; ++i)
+	{
+		if (results[i] != direct[i] || batched[i] != direct[i] || bound[i] != direct[i] || fromTuples[i] != direct[i])
+		{
+			printf("Batched Damage call %u returned the wrong value\n", i);
+			break;
+		}
+	}
+
+	//mismatched columns are refused before any call is made
+	meta::Column wrong[3] = { meta::MakeColumn(levels.data()), meta::MakeColumn(armors.data()), meta::MakeColumn(levels.data()) };
+	if (damage.InvokeBatch(wrong, 3, meta::MakeColumn(batched.data()), count))
+		printf("InvokeBatch accepted an int column for a float argument\n");
+
+	//reference parameters bind to the column's values, rvalue references move from them, pointers pass as they are
+	{
+		float values[2] = { 1.0f, 2.0f };
+		float by[2] = { 0.5f, 0.25f };
+		meta::Column grown[2] = { meta::MakeColumn(values), meta::MakeColumn(by) };
+		std::string texts[2] = { "taken", "taken too" };
+		meta::Column taken[1] = { meta::MakeColumn(texts) };
+		unsigned lengths[2] = { 0, 0 };
+		char letters[] = "pq";
+		char* words[2] = { letters, letters + 1 };
+		meta::Column firsts[1] = { meta::MakeColumn(words) };
+		char initials[2] = { 0, 0 };
+		if (!meta::Function(Grow).InvokeBatch(grown, 2, meta::Column(), 2) || values[0] != 1.5f || values[1] != 2.25f ||
+			!meta::Function(Take).InvokeBatch(taken, 1, meta::MakeColumn(lengths), 2) || lengths[1] != 9 ||
+			!meta::Function(First).InvokeBatch(firsts, 1, meta::MakeColumn(initials), 2) || initials[0] != 'p' || initials[1] != 'q')
+			printf("InvokeBatch didn't pass reference, rvalue reference or pointer arguments as declared\n");
+	}
+
+	printf("Calling Damage(float, float, int), ns per call:\n");
+	printf("%18s %8.2f\n", "Invoke", single.count() / count);
+	printf("%18s %8.2f\n", "InvokeBatch", batch.count() / count);
+	printf("%18s %8.2f\n", "bound InvokeBatch", boundBatch.count() / count);
+	printf("%18s %8.2f\n", "InvokeTuples", tupled.count() / count);
+	printf("%18s %8.2f\n", "direct", native.count() / count);
+	printf("\n");
+}
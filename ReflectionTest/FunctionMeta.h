@@ -77,4 +77,264 @@ namespace meta
 	{
 		Call(fn, binding, ret, args, argCount, build_indices<sizeof...(Args)>{});
 	}
+
+	//////////////////////////////////////////////////////////////////////////////
+	//  Column
+	//////////////////////////////////////////////////////////////////////////////
+	// Purpose: count values of one type, stride bytes apart (0 means type->Size()). A plain array
+	//          is a column, and so is one member across an array of structs.
+	struct Column
+	{
+		Column() : type(NULL), data(NULL), stride(0) {}
+		Column(const Type* type, void* data, unsigned stride = 0) : type(type), data(static_cast<char*>(data)), stride(stride) {}
+
+		const Type* type;
+		char* data;
+		unsigned stride;
+	};
+
+	template <typename T>
+	Column MakeColumn(T* values, unsigned stride = sizeof(T))
+	{
+		return Column(meta::get<T>(), const_cast<typename std::remove_cv<T>::type*>(values), stride);
+	}
+
+	namespace internal
+	{
+		template <typename T>
+		T& column_value(const Column& column, unsigned i)
+		{
+			return *reinterpret_cast<T*>(column.data + i * column.stride);
+		}
+
+		//What an argument of type Arg is stored as: the parameter without cv-qualifiers or a reference.
+		//Pointers stay pointers. Stored values are passed on as static_cast<Arg>, so reference
+		//parameters bind to them and rvalue references move from them.
+		template <typename Arg>
+		struct stored_argument
+		{
+			typedef typename std::remove_cv<typename std::remove_reference<Arg>::type>::type type;
+		};
+
+		//unpacks type erased arguments into a call; specialized so void functions have no result to store
+		template <typename returnType>
+		struct invoker
+		{
+			template <typename... Args, unsigned int... Is>
+			static void Single(returnType(*fn)(Args...), void* ret, void** args, indices<Is...>)
+			{
+				*static_cast<returnType*>(ret) = fn(static_cast<Args>(*static_cast<typename stored_argument<Args>::type*>(args[Is]))...);
+			}
+
+			template <typename... Args, unsigned int... Is>
+			static void Batch(returnType(*fn)(Args...), const Column& out, const Column* args, unsigned count, indices<Is...>)
+			{
+				char* to = out.data;
+				for (unsigned i = 0; i < count; ++i, to += out.stride)
+				{
+					*reinterpret_cast<returnType*>(to) = fn(static_cast<Args>(column_value<typename stored_argument<Args>::type>(args[Is], i))...);
+				}
+			}
+		};
+
+		template <>
+		struct invoker<void>
+		{
+			template <typename... Args, unsigned int... Is>
+			static void Single(void(*fn)(Args...), void* /*ret*/, void** args, indices<Is...>)
+			{
+				fn(static_cast<Args>(*static_cast<typename stored_argument<Args>::type*>(args[Is]))...);
+			}
+
+			template <typename... Args, unsigned int... Is>
+			static void Batch(void(*fn)(Args...), const Column& /*out*/, const Column* args, unsigned count, indices<Is...>)
+			{
+				for (unsigned i = 0; i < count; ++i)
+				{
+					fn(static_cast<Args>(column_value<typename stored_argument<Args>::type>(args[Is], i))...);
+				}
+			}
+		};
+
+		typedef void(*erased_fn)();
+		typedef void(*single_fn)(erased_fn fn, void* ret, void** args);
+		typedef void(*batch_fn)(erased_fn fn, const Column& out, const Column* args, unsigned count);
+
+		//thunks for a function only known at runtime
+		template <typename retType, typename... Args>
+		struct erased_function
+		{
+			static void Single(erased_fn fn, void* ret, void** args)
+			{
+				invoker<retType>::Single(reinterpret_cast<retType(*)(Args...)>(fn), ret, args, build_indices<sizeof...(Args)>{});
+			}
+
+			static void Batch(erased_fn fn, const Column& out, const Column* args, unsigned count)
+			{
+				invoker<retType>::Batch(reinterpret_cast<retType(*)(Args...)>(fn), out, args, count, build_indices<sizeof...(Args)>{});
+			}
+		};
+
+		//thunks for a function bound at compile time; the batch loop can inline it
+		template <typename FnType, FnType fn>
+		struct bound_function;
+
+		template <typename retType, typename... Args, retType(*fn)(Args...)>
+		struct bound_function<retType(*)(Args...), fn>
+		{
+			static void Single(erased_fn, void* ret, void** args)
+			{
+				invoker<retType>::Single(fn, ret, args, build_indices<sizeof...(Args)>{});
+			}
+
+			static void Batch(erased_fn, const Column& out, const Column* args, unsigned count)
+			{
+				invoker<retType>::Batch(fn, out, args, count, build_indices<sizeof...(Args)>{});
+			}
+		};
+	}
+
+	//////////////////////////////////////////////////////////////////////////////
+	//  Function
+	//////////////////////////////////////////////////////////////////////////////
+	// Purpose: A free function callable through reflection. Invoke makes one call from
+	//          RefVariants, checking every argument against the signature. InvokeBatch calls it
+	//          over argument columns, checking the columns once and then running a loop compiled
+	//          for the function's exact signature.
+	class Function
+	{
+	public:
+		static const unsigned MaxArgs = 16;
+
+		template <typename retType, typename... Args>
+		Function(retType(*fn)(Args...)) :
+			signature(fn),
+			erased(reinterpret_cast<internal::erased_fn>(fn)),
+			single(&internal::erased_function<retType, Args...>::Single),
+			batch(&internal::erased_function<retType, Args...>::Batch)
+		{
+			static_assert(sizeof...(Args) <= MaxArgs, "too many arguments to call reflectively");
+		}
+
+		//binds fn at compile time, so InvokeBatch runs a loop with fn inlined. Use meta_function(FN).
+		template <typename FnType, FnType fn>
+		static Function Bind(void)
+		{
+			return Function(fn, &internal::bound_function<FnType, fn>::Single, &internal::bound_function<FnType, fn>::Batch);
+		}
+
+		const FunctionSignature& Signature(void) const { return signature; }
+
+		//one call; ret is ignored for void functions. false if the arguments don't match the signature.
+		bool Invoke(RefVariant& ret, RefVariant* args, unsigned argCount) const
+		{
+			if (!CheckArgs(argCount) || !CheckReturn(ret.GetType()))
+			{
+				return false;
+			}
+
+			void* raw[MaxArgs];
+			for (unsigned i = 0; i < argCount; ++i)
+			{
+				if (args[i].GetType() != signature.argArray[i])
+				{
+					std::cout << "Argument " << i << " is a " << args[i].GetType()->Name() << ", expected " << signature.argArray[i]->Name() << std::endl;
+					return false;
+				}
+				raw[i] = args[i].GetData();
+			}
+
+			single(erased, ret.GetData(), raw);
+			return true;
+		}
+
+		//count calls: call n reads argument i from args[i] at n and writes its result to out at n
+		//(already constructed; ignored for void functions). false if the columns don't match the signature.
+		bool InvokeBatch(const Column* args, unsigned argCount, const Column& out, unsigned count) const
+		{
+			if (!CheckArgs(argCount) || !CheckReturn(out.type))
+			{
+				return false;
+			}
+
+			Column columns[MaxArgs];
+			for (unsigned i = 0; i < argCount; ++i)
+			{
+				if (args[i].type != signature.argArray[i])
+				{
+					std::cout << "Argument column " << i << " holds " << (args[i].type ? args[i].type->Name() : "nothing") << ", expected " << signature.argArray[i]->Name() << std::endl;
+					return false;
+				}
+				columns[i] = args[i];
+				columns[i].stride = args[i].stride != 0 ? args[i].stride : args[i].type->Size();
+			}
+
+			Column result = out;
+			if (result.type != NULL && result.stride == 0)
+			{
+				result.stride = result.type->Size();
+			}
+
+			batch(erased, result, columns, count);
+			return true;
+		}
+
+		//count calls over an array of argument tuples: the members of tupleType, in order, are the arguments
+		bool InvokeTuples(const Type* tupleType, const void* tuples, unsigned count, const Column& out) const
+		{
+			if (tupleType->members.size() > MaxArgs)
+			{
+				std::cout << tupleType->Name() << " has more members than a function has arguments" << std::endl;
+				return false;
+			}
+
+			Column columns[MaxArgs];
+			char* first = static_cast<char*>(const_cast<void*>(tuples));
+			for (unsigned i = 0; i < tupleType->members.size(); ++i)
+			{
+				const Member* member = tupleType->members[i];
+				columns[i] = Column(member->Meta(), first + member->Offset(), tupleType->Size());
+			}
+
+			return InvokeBatch(columns, (unsigned)tupleType->members.size(), out, count);
+		}
+
+	private:
+		template <typename retType, typename... Args>
+		Function(retType(*fn)(Args...), internal::single_fn single, internal::batch_fn batch) :
+			signature(fn),
+			erased(reinterpret_cast<internal::erased_fn>(fn)),
+			single(single),
+			batch(batch)
+		{
+			static_assert(sizeof...(Args) <= MaxArgs, "too many arguments to call reflectively");
+		}
+
+		bool CheckArgs(unsigned argCount) const
+		{
+			if (argCount != signature.argCount)
+			{
+				std::cout << "Function takes " << signature.argCount << " arguments, given " << argCount << std::endl;
+				return false;
+			}
+			return true;
+		}
+
+		bool CheckReturn(const Type* type) const
+		{
+			if (signature.returnType != meta::get<void>() && type != signature.returnType)
+			{
+				std::cout << "Function returns " << signature.returnType->Name() << ", result is a " << (type ? type->Name() : "nothing") << std::endl;
+				return false;
+			}
+			return true;
+		}
+
+		FunctionSignature signature;
+		internal::erased_fn erased;
+		internal::single_fn single;
+		internal::batch_fn batch;
+	};
+
+#define meta_function(FN) meta::Function::Bind<decltype(&FN), &FN>()
 }
@@ -1,2 +1,3 @@
 
-void FunctionSignatureTest();
\ No newline at end of file
+void FunctionSignatureTest();
+void FunctionBatchTest();
\ No newline at end of file
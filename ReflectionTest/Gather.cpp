@@ -0,0 +1,332 @@
+#include "Gather.h"
+
+#if defined(_M_IX86) || defined(_M_X64) || defined(__SSE2__)
+#define META_SSE2 1
+#include <emmintrin.h>
+#endif
+
+namespace meta
+{
+	namespace
+	{
+		//////// Scalar kernels, unrolled by four ////////
+
+		template <typename Word>
+		void GatherWords(const char* field, unsigned count, unsigned stride, void* out)
+		{
+			Word* to = static_cast<Word*>(out);
+			unsigned i = 0;
+
+			for (; i + 4 <= count; i += 4, field += 4 * stride)
+			{
+				std::memcpy(&to[i + 0], field, sizeof(Word));
+				std::memcpy(&to[i + 1], field + stride, sizeof(Word));
+				std::memcpy(&to[i + 2], field + 2 * stride, sizeof(Word));
+				std::memcpy(&to[i + 3], field + 3 * stride, sizeof(Word));
+			}
+			for (; i < count; ++i, field += stride)
+			{
+				std::memcpy(&to[i], field, sizeof(Word));
+			}
+		}
+
+		template <typename Word>
+		void ScatterWords(char* field, unsigned count, unsigned stride, const void* in)
+		{
+			const Word* from = static_cast<const Word*>(in);
+			unsigned i = 0;
+
+			for (; i + 4 <= count; i += 4, field += 4 * stride)
+			{
+				std::memcpy(field, &from[i + 0], sizeof(Word));
+				std::memcpy(field + stride, &from[i + 1], sizeof(Word));
+				std::memcpy(field + 2 * stride, &from[i + 2], sizeof(Word));
+				std::memcpy(field + 3 * stride, &from[i + 3], sizeof(Word));
+			}
+			for (; i < count; ++i, field += stride)
+			{
+				std::memcpy(field, &from[i], sizeof(Word));
+			}
+		}
+
+		template <typename Word>
+		void FillWords(char* field, unsigned count, unsigned stride, const void* value)
+		{
+			Word word;
+			std::memcpy(&word, value, sizeof(Word));
+			unsigned i = 0;
+
+			for (; i + 4 <= count; i += 4, field += 4 * stride)
+			{
+				std::memcpy(field, &word, sizeof(Word));
+				std::memcpy(field + stride, &word, sizeof(Word));
+				std::memcpy(field + 2 * stride, &word, sizeof(Word));
+				std::memcpy(field + 3 * stride, &word, sizeof(Word));
+			}
+			for (; i < count; ++i, field += stride)
+			{
+				std::memcpy(field, &word, sizeof(Word));
+			}
+		}
+
+		void GatherAny(const char* field, unsigned size, unsigned count, unsigned stride, void* out)
+		{
+			char* to = static_cast<char*>(out);
+			for (unsigned i = 0; i < count; ++i, field += stride, to += size)
+			{
+				std::memcpy(to, field, size);
+			}
+		}
+
+		void ScatterAny(char* field, unsigned size, unsigned count, unsigned stride, const void* in)
+		{
+			const char* from = static_cast<const char*>(in);
+			for (unsigned i = 0; i < count; ++i, field += stride, from += size)
+			{
+				std::memcpy(field, from, size);
+			}
+		}
+
+#if META_SSE2
+		//////// SSE2 kernels ////////
+
+		//four 4 byte fields packed into one 16 byte store
+		void Gather4(const char* field, unsigned count, unsigned stride, void* out)
+		{
+			char* to = static_cast<char*>(out);
+			unsigned i = 0;
+
+			for (; i + 4 <= count; i += 4, field += 4 * stride, to += 16)
+			{
+				int a, b, c, d;
+				std::memcpy(&a, field, 4);
+				std::memcpy(&b, field + stride, 4);
+				std::memcpy(&c, field + 2 * stride, 4);
+				std::memcpy(&d, field + 3 * stride, 4);
+
+				__m128i ab = _mm_unpacklo_epi32(_mm_cvtsi32_si128(a), _mm_cvtsi32_si128(b));
+				__m128i cd = _mm_unpacklo_epi32(_mm_cvtsi32_si128(c), _mm_cvtsi32_si128(d));
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(to), _mm_unpacklo_epi64(ab, cd));
+			}
+
+			GatherWords<unsigned int>(field, count - i, stride, to);
+		}
+
+		//two 8 byte fields packed into one 16 byte store
+		void Gather8(const char* field, unsigned count, unsigned stride, void* out)
+		{
+			char* to = static_cast<char*>(out);
+			unsigned i = 0;
+
+			for (; i + 2 <= count; i += 2, field += 2 * stride, to += 16)
+			{
+				__m128i lo = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(field));
+				__m128i hi = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(field + stride));
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(to), _mm_unpacklo_epi64(lo, hi));
+			}
+
+			GatherWords<unsigned long long>(field, count - i, stride, to);
+		}
+
+		//12 byte fields (Vector3) with one 16 byte load and store each. The extra 4 bytes read stay
+		//inside the array and the extra 4 bytes written are overwritten by the next field, so only
+		//the last field needs an exact copy.
+		void Gather12(const char* field, unsigned count, unsigned stride, void* out)
+		{
+			char* to = static_cast<char*>(out);
+			unsigned i = 0;
+
+			for (; i + 1 < count; ++i, field += stride, to += 12)
+			{
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(to), _mm_loadu_si128(reinterpret_cast<const __m128i*>(field)));
+			}
+
+			if (i < count)
+			{
+				std::memcpy(to, field, 12);
+			}
+		}
+
+		void Scatter12(char* field, unsigned count, unsigned stride, const void* in)
+		{
+			const char* from = static_cast<const char*>(in);
+			unsigned i = 0;
+
+			//a 16 byte store would clobber the bytes after the field, so write 8 + 4
+			for (; i + 1 < count; ++i, field += stride, from += 12)
+			{
+				__m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(from));
+				_mm_storel_epi64(reinterpret_cast<__m128i*>(field), v);
+				int z = _mm_cvtsi128_si32(_mm_srli_si128(v, 8));
+				std::memcpy(field + 8, &z, 4);
+			}
+
+			if (i < count)
+			{
+				std::memcpy(field, from, 12);
+			}
+		}
+
+		void Gather16(const char* field, unsigned count, unsigned stride, void* out)
+		{
+			__m128i* to = static_cast<__m128i*>(out);
+			for (unsigned i = 0; i < count; ++i, field += stride)
+			{
+				_mm_storeu_si128(to + i, _mm_loadu_si128(reinterpret_cast<const __m128i*>(field)));
+			}
+		}
+
+		void Scatter16(char* field, unsigned count, unsigned stride, const void* in)
+		{
+			const __m128i* from = static_cast<const __m128i*>(in);
+			for (unsigned i = 0; i < count; ++i, field += stride)
+			{
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(field), _mm_loadu_si128(from + i));
+			}
+		}
+
+		void Fill16(char* field, unsigned count, unsigned stride, const void* value)
+		{
+			__m128i v = _mm_loadu_si128(static_cast<const __m128i*>(value));
+			for (unsigned i = 0; i < count; ++i, field += stride)
+			{
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(field), v);
+			}
+		}
+#endif
+	}
+
+	void GatherBytes(const void* objects, unsigned offset, unsigned size, unsigned count, unsigned stride, void* out)
+	{
+		const char* field = static_cast<const char*>(objects) + offset;
+
+		if (stride == size)
+		{
+			std::memcpy(out, field, (size_t)size * count);
+			return;
+		}
+
+		switch (size)
+		{
+			case 1: GatherWords<unsigned char>(field, count, stride, out); break;
+			case 2: GatherWords<unsigned short>(field, count, stride, out); break;
+#if META_SSE2
+			case 4: Gather4(field, count, stride, out); break;
+			case 8: Gather8(field, count, stride, out); break;
+			case 12: Gather12(field, count, stride, out); break;
+			case 16: Gather16(field, count, stride, out); break;
+#else
+			case 4: GatherWords<unsigned int>(field, count, stride, out); break;
+			case 8: GatherWords<unsigned long long>(field, count, stride, out); break;
+#endif
+			default: GatherAny(field, size, count, stride, out); break;
+		}
+	}
+
+	void ScatterBytes(void* objects, unsigned offset, unsigned size, unsigned count, unsigned stride, const void* in)
+	{
+		char* field = static_cast<char*>(objects) + offset;
+
+		if (stride == size)
+		{
+			std::memcpy(field, in, (size_t)size * count);
+			return;
+		}
+
+		//stores can't be combined across objects, so the word kernels are as good as it gets for small fields
+		switch (size)
+		{
+			case 1: ScatterWords<unsigned char>(field, count, stride, in); break;
+			case 2: ScatterWords<unsigned short>(field, count, stride, in); break;
+			case 4: ScatterWords<unsigned int>(field, count, stride, in); break;
+			case 8: ScatterWords<unsigned long long>(field, count, stride, in); break;
+#if META_SSE2
+			case 12: Scatter12(field, count, stride, in); break;
+			case 16: Scatter16(field, count, stride, in); break;
+#endif
+			default: ScatterAny(field, size, count, stride, in); break;
+		}
+	}
+
+	void FillBytes(void* objects, unsigned offset, unsigned size, unsigned count, unsigned stride, const void* value)
+	{
+		char* field = static_cast<char*>(objects) + offset;
+
+		switch (size)
+		{
+			case 1: FillWords<unsigned char>(field, count, stride, value); break;
+			case 2: FillWords<unsigned short>(field, count, stride, value); break;
+			case 4: FillWords<unsigned int>(field, count, stride, value); break;
+			case 8: FillWords<unsigned long long>(field, count, stride, value); break;
+#if META_SSE2
+			case 16: Fill16(field, count, stride, value); break;
+#endif
+			default:
+				for (unsigned i = 0; i < count; ++i, field += stride)
+				{
+					std::memcpy(field, value, size);
+				}
+				break;
+		}
+	}
+
+	//////////////////////////////////////////////////////////////////////////////
+	//  Type Gather/Scatter
+	//////////////////////////////////////////////////////////////////////////////
+
+	void Type::Gather(const Member* member, const void* objects, unsigned count, void* out, unsigned stride) const
+	{
+		const Type* field = member->Meta();
+		stride = stride != 0 ? stride : size;
+
+		if (field->IsTriviallyCopyable())
+		{
+			GatherBytes(objects, member->Offset(), field->Size(), count, stride, out);
+			return;
+		}
+
+		const char* from = static_cast<const char*>(objects) + member->Offset();
+		char* to = static_cast<char*>(out);
+		for (unsigned i = 0; i < count; ++i, from += stride, to += field->Size())
+		{
+			field->Copy(to, from);
+		}
+	}
+
+	void Type::Scatter(const Member* member, void* objects, unsigned count, const void* in, unsigned stride) const
+	{
+		const Type* field = member->Meta();
+		stride = stride != 0 ? stride : size;
+
+		if (field->IsTriviallyCopyable())
+		{
+			ScatterBytes(objects, member->Offset(), field->Size(), count, stride, in);
+			return;
+		}
+
+		char* to = static_cast<char*>(objects) + member->Offset();
+		const char* from = static_cast<const char*>(in);
+		for (unsigned i = 0; i < count; ++i, to += stride, from += field->Size())
+		{
+			field->Copy(to, from);
+		}
+	}
+
+	void Type::Fill(const Member* member, void* objects, unsigned count, const void* value, unsigned stride) const
+	{
+		const Type* field = member->Meta();
+		stride = stride != 0 ? stride : size;
+
+		if (field->IsTriviallyCopyable())
+		{
+			FillBytes(objects, member->Offset(), field->Size(), count, stride, value);
+			return;
+		}
+
+		char* to = static_cast<char*>(objects) + member->Offset();
+		for (unsigned i = 0; i < count; ++i, to += stride)
+		{
+			field->Copy(to, value);
+		}
+	}
+}
@@ -0,0 +1,22 @@
+#pragma once
+
+#include "Meta.h"
+
+namespace meta
+{
+	//////////////////////////////////////////////////////////////////////////////
+	//  Strided Gather/Scatter Kernels
+	//////////////////////////////////////////////////////////////////////////////
+	// Purpose: Move one field of size bytes, at offset in each of count objects stride bytes apart,
+	//          to or from a tightly packed array. The kernel is picked by field size (1, 2, 4, 8, 12
+	//          and 16 bytes have SSE2 kernels) and stride (a dense array is a single memcpy).
+	//          Fields must be trivially copyable; Type::Gather and friends handle the rest.
+
+	void GatherBytes(const void* objects, unsigned offset, unsigned size, unsigned count, unsigned stride, void* out);
+	void ScatterBytes(void* objects, unsigned offset, unsigned size, unsigned count, unsigned stride, const void* in);
+
+	//writes the same value into the field of every object
+	void FillBytes(void* objects, unsigned offset, unsigned size, unsigned count, unsigned stride, const void* value);
+}
+
+void TestGatherScatter();
@@ -0,0 +1,107 @@
+#include "Gather.h"
+#include "SerializationTest.h"
+#include <chrono>
+
+template <typename T>
+static T* PointerAdd(void* ptr, int val)
+{
+	return (T*) (static_cast<char*>(ptr) + val);
+}
+
+//the reflective loop Gather replaces: one pointer add and member sized memcpy per object
+static void GatherPerObject(const meta::Member* member, void* objects, unsigned count, unsigned stride, void* out)
+{
+	char* to = static_cast<char*>(out);
+	for (unsigned i = 0; i < count; ++i)
+		std::memcpy(to + i * member->Size(), PointerAdd<char>(objects, i * stride + member->Offset()), member->Size());
+}
+
+static void ScatterPerObject(const meta::Member* member, void* objects, unsigned count, unsigned stride, const void* in)
+{
+	const char* from = static_cast<const char*>(in);
+	for (unsigned i = 0; i < count; ++i)
+		std::memcpy(PointerAdd<char>(objects, i * stride + member->Offset()), from + i * member->Size(), member->Size());
+}
+
+void TestGatherScatter()
+{
+	typedef std::chrono::high_resolution_clock Clock;
+
+	const meta::Type* thingType = meta::get<Thing>();
+	const meta::Member* radius = thingType->mamberNames.at("radius");
+	const meta::Member* height = thingType->mamberNames.at("height");
+	const meta::Member* position = thingType->mamberNames.at("position");
+
+	//odd count so every kernel runs its tail
+	const unsigned count = 1000003;
+	std::vector<Thing> things(count, Thing());
+	for (unsigned i = 0; i < count; ++i)
+	{
+		things[i].radius = (float)i;
+		things[i].height = (double)i * 2.0;
+		things[i].position = Vector3((float)i, (float)i + 1.0f, (float)i + 2.0f);
+		things[i].kind = Thing_Apple;
+	}
+
+	std::vector<float> radii(count);
+	std::vector<double> heights(count);
+	std::vector<Vector3> positions(count);
+
+	thingType->Gather(radius, things.data(), count, radii.data());
+	thingType->Gather(height, things.data(), count, heights.data());
+	thingType->Gather(position, things.data(), count, positions.data());
+	for (unsigned i = 0; i < count; ++i)
+	{
+		if (radii[i] != (float)i || heights[i] != (double)i * 2.0 || positions[i].z != (float)i + 2.0f)
+		{
+			printf("Gather didn't read Thing %u\n", i);
+			break;
+		}
+	}
+
+	for (unsigned i = 0; i < count; ++i)
+		positions[i] = Vector3(-1.0f, -2.0f, -3.0f);
+	thingType->Scatter(position, things.data(), count, positions.data());
+	double value = 7.0;
+	thingType->Fill(height, things.data(), count, &value);
+	for (unsigned i = 0; i < count; ++i)
+	{
+		//neighbours of the written members must survive
+		if (things[i].position.z != -3.0f || things[i].height != 7.0 || things[i].radius != (float)i || things[i].kind != Thing_Apple)
+		{
+			printf("Scatter/Fill didn't write Thing %u\n", i);
+			break;
+		}
+	}
+
+	const meta::Member* benched[] = { radius, height, position };
+	std::vector<char> packed(count * sizeof(Vector3));
+
+	printf("Strided Thing members, ns per object (loop / kernel):\n");
+	for (unsigned m = 0; m < 3; ++m)
+	{
+		const meta::Member* member = benched[m];
+
+		Clock::time_point start = Clock::now();
+		GatherPerObject(member, things.data(), count, sizeof(Thing), packed.data());
+		std::chrono::duration<double, std::nano> gatherLoop = Clock::now() - start;
+
+		start = Clock::now();
+		thingType->Gather(member, things.data(), count, packed.data());
+		std::chrono::duration<double, std::nano> gather = Clock::now() - start;
+
+		start = Clock::now();
+		ScatterPerObject(member, things.data(), count, sizeof(Thing), packed.data());
+		std::chrono::duration<double, std::nano> scatterLoop = Clock::now() - start;
+
+		start = Clock::now();
+		thingType->Scatter(member, things.data(), count, packed.data());
+		std::chrono::duration<double, std::nano> scatter = Clock::now() - start;
+
+		printf("%10s (%2d bytes) gather %6.2f / %6.2f  scatter %6.2f / %6.2f\n",
+			member->Name().c_str(), member->Size(),
+			gatherLoop.count() / count, gather.count() / count,
+			scatterLoop.count() / count, scatter.count() / count);
+	}
+	printf("\n");
+}
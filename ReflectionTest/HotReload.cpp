@@ -0,0 +1,526 @@
+#include "HotReload.h"
+#include "Arena.h"
+#include "MmapJson.h"
+#include <cstdio>
+
+#ifdef _WIN32
+#define NOMINMAX
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#elif defined(__linux__)
+#include <sys/inotify.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#else
+#include <sys/stat.h>
+#endif
+
+namespace meta
+{
+	//////////////////////////////////////////////////////////////////////////////
+	//  FileWatcher
+	//////////////////////////////////////////////////////////////////////////////
+
+	namespace
+	{
+		void SplitPath(const std::string& path, std::string& directory, std::string& name)
+		{
+			size_t slash = path.find_last_of("/\\");
+			if (slash == std::string::npos)
+			{
+				directory = ".";
+				name = path;
+			}
+			else
+			{
+				directory = slash == 0 ? path.substr(0, 1) : path.substr(0, slash);
+				name = path.substr(slash + 1);
+			}
+		}
+
+		void AddOnce(std::vector<std::string>& changed, const std::string& path)
+		{
+			for (unsigned i = 0; i < changed.size(); ++i)
+			{
+				if (changed[i] == path)
+				{
+					return;
+				}
+			}
+			changed.push_back(path);
+		}
+	}
+
+#ifdef _WIN32
+
+	struct FileWatcher::Directory
+	{
+		std::string path;
+		HANDLE handle;
+		OVERLAPPED overlapped;
+		DWORD buffer[4096]; //FILE_NOTIFY_INFORMATION records must be DWORD aligned
+
+		//queues the next read of changes
+		bool Listen(void)
+		{
+			std::memset(&overlapped, 0, sizeof(overlapped));
+			return ReadDirectoryChangesW(handle, buffer, sizeof(buffer), FALSE,
+				FILE_NOTIFY_CHANGE_LAST_WRITE | FILE_NOTIFY_CHANGE_FILE_NAME | FILE_NOTIFY_CHANGE_SIZE, NULL, &overlapped, NULL) != 0;
+		}
+	};
+
+	FileWatcher::FileWatcher()
+	{
+	}
+
+	FileWatcher::~FileWatcher()
+	{
+		for (unsigned i = 0; i < directories.size(); ++i)
+		{
+			CancelIo(directories[i]->handle);
+			CloseHandle(directories[i]->handle);
+			delete directories[i];
+		}
+	}
+
+	bool FileWatcher::Watch(const std::string& path)
+	{
+		Watched watched = { path, "", 0, 0 };
+		std::string directoryPath;
+		SplitPath(path, directoryPath, watched.name);
+
+		for (watched.directory = 0; watched.directory < directories.size(); ++watched.directory)
+		{
+			if (directories[watched.directory]->path == directoryPath)
+			{
+				files.push_back(watched);
+				return true;
+			}
+		}
+
+		Directory* directory = new Directory;
+		directory->path = directoryPath;
+		directory->handle = CreateFileA(directoryPath.c_str(), FILE_LIST_DIRECTORY, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+			NULL, OPEN_EXISTING, FILE_FLAG_BACKUP_SEMANTICS | FILE_FLAG_OVERLAPPED, NULL);
+		if (directory->handle == INVALID_HANDLE_VALUE || !directory->Listen())
+		{
+			std::cout << "Can't watch directory " << directoryPath << std::endl;
+			if (directory->handle != INVALID_HANDLE_VALUE)
+			{
+				CloseHandle(directory->handle);
+			}
+			delete directory;
+			return false;
+		}
+
+		directories.push_back(directory);
+		files.push_back(watched);
+		return true;
+	}
+
+	void FileWatcher::Poll(std::vector<std::string>& changed)
+	{
+		for (unsigned d = 0; d < directories.size(); ++d)
+		{
+			Directory* directory = directories[d];
+			DWORD bytes = 0;
+
+			//FALSE with ERROR_IO_INCOMPLETE while nothing has happened
+			while (GetOverlappedResult(directory->handle, &directory->overlapped, &bytes, FALSE))
+			{
+				for (unsigned i = 0; bytes == 0 && i < files.size(); ++i)
+				{
+					//the buffer overflowed: anything in the directory may have changed
+					if (files[i].directory == d)
+					{
+						AddOnce(changed, files[i].path);
+					}
+				}
+
+				const char* at = reinterpret_cast<const char*>(directory->buffer);
+				while (bytes != 0)
+				{
+					const FILE_NOTIFY_INFORMATION* info = reinterpret_cast<const FILE_NOTIFY_INFORMATION*>(at);
+					char name[MAX_PATH * 3];
+					int length = WideCharToMultiByte(CP_UTF8, 0, info->FileName, info->FileNameLength / sizeof(WCHAR), name, sizeof(name), NULL, NULL);
+
+					if (info->Action != FILE_ACTION_REMOVED && info->Action != FILE_ACTION_RENAMED_OLD_NAME)
+					{
+						for (unsigned i = 0; i < files.size(); ++i)
+						{
+							if (files[i].directory == d && files[i].name.size() == (size_t)length && _strnicmp(files[i].name.c_str(), name, length) == 0)
+							{
+								AddOnce(changed, files[i].path);
+							}
+						}
+					}
+
+					if (info->NextEntryOffset == 0)
+					{
+						break;
+					}
+					at += info->NextEntryOffset;
+				}
+
+				if (!directory->Listen())
+				{
+					break;
+				}
+			}
+		}
+	}
+
+#elif defined(__linux__)
+
+	struct FileWatcher::Directory
+	{
+		std::string path;
+		int watch;
+	};
+
+	FileWatcher::FileWatcher()
+	{
+		notify = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+		if (notify < 0)
+		{
+			std::cout << "inotify_init1 failed: " << errno << std::endl;
+		}
+	}
+
+	FileWatcher::~FileWatcher()
+	{
+		for (unsigned i = 0; i < directories.size(); ++i)
+		{
+			delete directories[i];
+		}
+		if (notify >= 0)
+		{
+			close(notify);
+		}
+	}
+
+	bool FileWatcher::Watch(const std::string& path)
+	{
+		Watched watched = { path, "", 0, 0 };
+		std::string directoryPath;
+		SplitPath(path, directoryPath, watched.name);
+
+		for (watched.directory = 0; watched.directory < directories.size(); ++watched.directory)
+		{
+			if (directories[watched.directory]->path == directoryPath)
+			{
+				files.push_back(watched);
+				return true;
+			}
+		}
+
+		//written in place, or renamed over
+		int watch = notify >= 0 ? inotify_add_watch(notify, directoryPath.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO) : -1;
+		if (watch < 0)
+		{
+			std::cout << "Can't watch directory " << directoryPath << std::endl;
+			return false;
+		}
+
+		Directory* directory = new Directory;
+		directory->path = directoryPath;
+		directory->watch = watch;
+		directories.push_back(directory);
+		files.push_back(watched);
+		return true;
+	}
+
+	void FileWatcher::Poll(std::vector<std::string>& changed)
+	{
+		union
+		{
+			inotify_event event;
+			char bytes[16 * 1024];
+		} buffer;
+
+		for (;;)
+		{
+			ssize_t length = notify >= 0 ? read(notify, buffer.bytes, sizeof(buffer.bytes)) : -1;
+			if (length <= 0)
+			{
+				return; //EAGAIN: nothing more queued
+			}
+
+			for (const char* at = buffer.bytes; at < buffer.bytes + length; )
+			{
+				const inotify_event* event = reinterpret_cast<const inotify_event*>(at);
+				at += sizeof(inotify_event) + event->len;
+
+				for (unsigned i = 0; i < files.size(); ++i)
+				{
+					//an overflowed queue lost events: anything may have changed
+					if ((event->mask & IN_Q_OVERFLOW) != 0 ||
+						(event->len > 0 && directories[files[i].directory]->watch == event->wd && files[i].name == event->name))
+					{
+						AddOnce(changed, files[i].path);
+					}
+				}
+			}
+		}
+	}
+
+#else
+
+	struct FileWatcher::Directory
+	{
+		std::string path;
+	};
+
+	static long long Stamp(const std::string& path)
+	{
+		struct stat info;
+		return stat(path.c_str(), &info) == 0 ? (long long)info.st_mtime * 1000003 + (long long)info.st_size : 0;
+	}
+
+	FileWatcher::FileWatcher()
+	{
+	}
+
+	FileWatcher::~FileWatcher()
+	{
+	}
+
+	bool FileWatcher::Watch(const std::string& path)
+	{
+		Watched watched = { path, path, 0, Stamp(path) };
+		files.push_back(watched);
+		return true;
+	}
+
+	void FileWatcher::Poll(std::vector<std::string>& changed)
+	{
+		for (unsigned i = 0; i < files.size(); ++i)
+		{
+			long long stamp = Stamp(files[i].path);
+			if (stamp != files[i].stamp)
+			{
+				files[i].stamp = stamp;
+				AddOnce(changed, files[i].path);
+			}
+		}
+	}
+
+#endif
+
+	//////////////////////////////////////////////////////////////////////////////
+	//  Member diffing
+	//////////////////////////////////////////////////////////////////////////////
+
+	unsigned PatchChangedMembers(const Type* type, void* target, const void* source, std::vector<std::string>& changed, const std::string& prefix)
+	{
+		unsigned written = 0;
+		for (unsigned i = 0; i < type->members.size(); ++i)
+		{
+			const Member* member = type->members[i];
+			const Type* leaf = member->Meta();
+			if (leaf == NULL)
+			{
+				continue;
+			}
+
+			char* to = static_cast<char*>(target) + member->Offset();
+			const char* from = static_cast<const char*>(source) + member->Offset();
+			std::string path = prefix.empty() ? member->Name() : prefix + "." + member->Name();
+
+			//nested value types diff member by member
+			if (!leaf->members.empty())
+			{
+				written += PatchChangedMembers(leaf, to, from, changed, path);
+				continue;
+			}
+
+			bool differs;
+			if (leaf == meta::get<std::string>())
+			{
+				differs = *reinterpret_cast<const std::string*>(to) != *reinterpret_cast<const std::string*>(from);
+			}
+			else if (leaf == meta::get<ArenaString>())
+			{
+				differs = *reinterpret_cast<const ArenaString*>(to) != *reinterpret_cast<const ArenaString*>(from);
+			}
+			else if (leaf == meta::get<StringView>())
+			{
+				//always repointed at the newest text, but only reported when the characters differ
+				differs = !(*reinterpret_cast<const StringView*>(to) == *reinterpret_cast<const StringView*>(from));
+				if (!differs)
+				{
+					std::memcpy(to, from, sizeof(StringView));
+					continue;
+				}
+			}
+			else if (leaf->IsTriviallyCopyable())
+			{
+				differs = std::memcmp(to, from, leaf->Size()) != 0;
+			}
+			else
+			{
+				differs = true; //no way to compare it
+			}
+
+			if (differs)
+			{
+				leaf->Copy(to, from);
+				changed.push_back(path);
+				++written;
+			}
+		}
+		return written;
+	}
+
+	//////////////////////////////////////////////////////////////////////////////
+	//  HotReloader
+	//////////////////////////////////////////////////////////////////////////////
+
+	namespace
+	{
+		bool HoldsViews(const Type* type)
+		{
+			if (type == meta::get<StringView>())
+			{
+				return true;
+			}
+			for (unsigned i = 0; i < type->members.size(); ++i)
+			{
+				if (type->members[i]->Meta() != NULL && HoldsViews(type->members[i]->Meta()))
+				{
+					return true;
+				}
+			}
+			return false;
+		}
+
+		//the whole file, NUL terminated
+		bool ReadText(const std::string& path, std::vector<char>& text)
+		{
+			FILE* file = fopen(path.c_str(), "rb");
+			if (file == NULL)
+			{
+				return false;
+			}
+			long length = fseek(file, 0, SEEK_END) == 0 ? ftell(file) : -1;
+			if (length < 0 || fseek(file, 0, SEEK_SET) != 0)
+			{
+				fclose(file);
+				return false;
+			}
+
+			text.resize(length + 1);
+			text.resize(fread(text.data(), 1, length, file) + 1);
+			text.back() = '\0';
+			fclose(file);
+			return true;
+		}
+	}
+
+	HotReloader::~HotReloader()
+	{
+		for (unsigned i = 0; i < bindings.size(); ++i)
+		{
+			for (unsigned j = 0; j < bindings[i].texts.size(); ++j)
+			{
+				delete[] bindings[i].texts[j];
+			}
+		}
+	}
+
+	bool HotReloader::Bind(const std::string& path, const Type* type, void* object)
+	{
+		assert(type->IsCopyConstructible()); //reloads parse into a copy
+		if (!watcher.Watch(path))
+		{
+			return false;
+		}
+
+		Binding binding;
+		binding.path = path;
+		binding.type = type;
+		binding.object = object;
+		binding.holdsViews = HoldsViews(type);
+		bindings.push_back(binding);
+		return true;
+	}
+
+	unsigned HotReloader::Poll(std::vector<std::string>* failed)
+	{
+		std::vector<std::string> changed;
+		watcher.Poll(changed);
+
+		unsigned reloaded = 0;
+		for (unsigned i = 0; i < changed.size(); ++i)
+		{
+			if (Reload(changed[i]))
+			{
+				++reloaded;
+			}
+			else if (failed != NULL)
+			{
+				failed->push_back(changed[i]);
+			}
+		}
+		return reloaded;
+	}
+
+	bool HotReloader::Reload(const std::string& path)
+	{
+		std::vector<char> original;
+		if (!ReadText(path, original))
+		{
+			std::cout << "Can't read " << path << " to reload it" << std::endl;
+			return false;
+		}
+
+		bool parsed = true;
+		for (unsigned i = 0; i < bindings.size(); ++i)
+		{
+			Binding& binding = bindings[i];
+			if (binding.path != path)
+			{
+				continue;
+			}
+
+			//in situ parsing rewrites its text, so each object parses its own copy; views keep theirs
+			std::vector<char> copy;
+			char* text;
+			if (binding.holdsViews)
+			{
+				text = new char[original.size()];
+				std::memcpy(text, original.data(), original.size());
+				binding.texts.push_back(text);
+			}
+			else
+			{
+				copy = original;
+				text = copy.data();
+			}
+
+			//members the file leaves out keep their live values
+			void* scratch = binding.type->NewCopy(binding.object);
+			if (!ParseJsonInSitu(text, original.size() - 1, binding.type, scratch, pool))
+			{
+				std::cout << "Can't parse " << path << ", keeping the loaded " << binding.type->Name() << std::endl;
+				parsed = false;
+			}
+			else
+			{
+				Change change;
+				change.path = path;
+				change.type = binding.type;
+				change.object = binding.object;
+				PatchChangedMembers(binding.type, binding.object, scratch, change.members);
+
+				for (unsigned l = 0; !change.members.empty() && l < listeners.size(); ++l)
+				{
+					listeners[l](change);
+				}
+			}
+			binding.type->Delete(scratch);
+		}
+		return parsed;
+	}
+}
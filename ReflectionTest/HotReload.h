@@ -0,0 +1,124 @@
+#pragma once
+
+#include "Meta.h"
+#include "StringPool.h"
+#include <functional>
+
+namespace meta
+{
+	//////////////////////////////////////////////////////////////////////////////
+	//  FileWatcher
+	//////////////////////////////////////////////////////////////////////////////
+	// Purpose: Reports which of a set of files were written since it was last asked. Files are
+	//          watched through their directory, so editors that save by writing a temporary file
+	//          and renaming it over the original are seen too. Backed by inotify on Linux,
+	//          ReadDirectoryChangesW on Windows, and modification times everywhere else.
+	class FileWatcher
+	{
+	public:
+		FileWatcher();
+		~FileWatcher();
+
+		//false if the file's directory can't be watched
+		bool Watch(const std::string& path);
+
+		//appends each watched path (as passed to Watch) that changed since the last poll, once. Doesn't block.
+		void Poll(std::vector<std::string>& changed);
+
+	private:
+		// Non-Copyable
+		FileWatcher(const FileWatcher&); // = delete
+		void operator=(const FileWatcher&); // = delete
+
+		struct Watched
+		{
+			std::string path;
+			std::string name; //the part after the directory
+			unsigned directory;
+			long long stamp; //modification time, for the polling backend
+		};
+
+		struct Directory;
+
+		std::vector<Watched> files;
+		std::vector<Directory*> directories;
+#if !defined(_WIN32) && defined(__linux__)
+		int notify;
+#endif
+	};
+
+	//////////////////////////////////////////////////////////////////////////////
+	//  HotReloader
+	//////////////////////////////////////////////////////////////////////////////
+	// Purpose: Keeps live objects in step with the json files they were loaded from. When a bound
+	//          file changes, only that file is re-parsed, into a scratch copy of its object; the
+	//          copy is diffed against the live object member by member through the type's member
+	//          tables, nested value types included, and only members that differ are written.
+	//          Listeners are then told the dotted paths ("position.y") that changed.
+	//
+	// Members without their own member table are compared by value: std::string by content,
+	// InternedString by pointer, trivially copyable ones bitwise. Others are copied and reported
+	// every time. StringView members point into the text they were parsed from, so every version
+	// of a file bound to a type holding views stays loaded while the reloader lives.
+	// Not thread safe: Poll from the thread that owns the objects.
+	class HotReloader
+	{
+	public:
+		struct Change
+		{
+			std::string path; //the file
+			const Type* type;
+			void* object;
+			std::vector<std::string> members; //dotted member paths that were patched
+		};
+
+		typedef std::function<void(const Change&)> Listener;
+
+		HotReloader() {}
+		~HotReloader();
+
+		//Keeps object, of type, in step with the json file at path (as ParseJsonInSitu reads it).
+		//The object should already hold the file's contents; nothing is loaded until it changes.
+		bool Bind(const std::string& path, const Type* type, void* object);
+
+		template <typename T>
+		bool Bind(const std::string& path, T* object)
+		{
+			return Bind(path, meta::get<T>(), object);
+		}
+
+		void Listen(const Listener& listener) { listeners.push_back(listener); }
+
+		//Reloads every bound file the watcher saw change; returns how many were reloaded. Files that
+		//changed but couldn't be reloaded are appended to failed, when given.
+		unsigned Poll(std::vector<std::string>* failed = NULL);
+
+		//re-parses one bound file now and patches its objects. false if it didn't parse.
+		bool Reload(const std::string& path);
+
+	private:
+		// Non-Copyable
+		HotReloader(const HotReloader&); // = delete
+		void operator=(const HotReloader&); // = delete
+
+		struct Binding
+		{
+			std::string path;
+			const Type* type;
+			void* object;
+			bool holdsViews;
+			std::vector<char*> texts; //every version parsed, when holdsViews
+		};
+
+		FileWatcher watcher;
+		StringPool pool;
+		std::vector<Binding> bindings;
+		std::vector<Listener> listeners;
+	};
+
+	//Writes the members of source that differ from target into target and appends their dotted
+	//paths, under prefix, to changed. Returns how many were written.
+	unsigned PatchChangedMembers(const Type* type, void* target, const void* source, std::vector<std::string>& changed, const std::string& prefix = "");
+}
+
+void TestHotReload();
@@ -0,0 +1,122 @@
+#include "HotReload.h"
+#include "SerializationTest.h"
+#include <chrono>
+#include <cstdio>
+#include <thread>
+
+namespace
+{
+	void WriteThingFile(const char* path, const char* name, float radius, float y)
+	{
+		FILE* out = fopen(path, "wb");
+		fprintf(out, "{\n\t\"Thing\":\n\t{\n\t\t\"id\": 12,\n\t\t\"size\": 2,\n\t\t\"name\": \"%s\",\n\t\t\"radius\": %g,\n\t\t\"height\": 3.8,\n"
+			"\t\t\"position\": { \"x\":1.5, \"y\":%g, \"z\":3.11 },\n\t\t\"kind\": \"Thing_Apple\"\n\t}\n}\n", name, radius, y);
+		fclose(out);
+	}
+
+	//Polls until a changed file is reloaded or fails to; watchers may see the write a little after
+	//it lands. Returns how many were reloaded.
+	unsigned PollUntilReloaded(meta::HotReloader& reloader)
+	{
+		std::vector<std::string> failed;
+		for (unsigned tries = 0; tries < 1000; ++tries)
+		{
+			unsigned reloaded = reloader.Poll(&failed);
+			if (reloaded != 0 || !failed.empty())
+				return reloaded;
+			std::this_thread::sleep_for(std::chrono::milliseconds(2));
+		}
+		return 0;
+	}
+
+	bool SameMembers(const std::vector<std::string>& members, const char* first, const char* second)
+	{
+		return members.size() == (second != NULL ? 2u : 1u) && members[0] == first && (second == NULL || members[1] == second);
+	}
+}
+
+void TestHotReload()
+{
+	typedef std::chrono::high_resolution_clock Clock;
+
+	const char* path = "HotReloadThing.json";
+	WriteThingFile(path, "Bob", 4.5f, 2.63f);
+
+	Thing live = Thing();
+	meta::HotReloader reloader;
+	reloader.Bind(path, &live);
+	if (!reloader.Reload(path) || live.id != 12 || live.name != "Bob" || live.radius != 4.5f)
+		printf("HotReloader didn't load %s\n", path);
+
+	std::vector<std::string> members;
+	unsigned changes = 0;
+	reloader.Listen([&](const meta::HotReloader::Change& change)
+	{
+		members = change.members;
+		++changes;
+	});
+
+	//edited in place: only the two edited members are written
+	const char* name = live.name.data();
+	WriteThingFile(path, "Bob", 9.25f, 7.0f);
+	if (PollUntilReloaded(reloader) != 1 || changes != 1)
+		printf("HotReloader didn't see %s change\n", path);
+	else if (!SameMembers(members, "radius", "position.y") || live.radius != 9.25f || live.position.y != 7.0f)
+		printf("HotReloader patched the wrong members of %s\n", path);
+	if (live.name.data() != name || live.height != 3.8)
+		printf("HotReloader rewrote members that didn't change\n");
+
+	//saved the way editors do: a new file renamed over the old one
+	WriteThingFile("HotReloadThing.json.tmp", "Robert", 9.25f, 7.0f);
+	remove(path);
+	rename("HotReloadThing.json.tmp", path);
+	if (PollUntilReloaded(reloader) != 1 || !SameMembers(members, "name", NULL) || live.name != "Robert")
+		printf("HotReloader didn't follow a renamed save of %s\n", path);
+
+	//a half written file leaves the live object alone
+	FILE* out = fopen(path, "wb");
+	fprintf(out, "{ \"Thing\": { \"radius\": ");
+	fclose(out);
+	changes = 0;
+	Clock::time_point broken = Clock::now();
+	if (PollUntilReloaded(reloader) != 0 || changes != 0 || live.radius != 9.25f)
+		printf("HotReloader patched from a broken file\n");
+	if (Clock::now() - broken > std::chrono::milliseconds(1000))
+		printf("HotReloader didn't report a broken file as it saw it\n");
+	remove(path);
+
+	//one edit among many files: the cost is the edited file, not the data set
+	const unsigned fileCount = 500;
+	std::vector<Thing> things(fileCount, Thing());
+	std::vector<std::string> paths(fileCount);
+	meta::HotReloader many;
+	for (unsigned i = 0; i < fileCount; ++i)
+	{
+		char buffer[64];
+		sprintf(buffer, "HotReloadThing%u.json", i);
+		paths[i] = buffer;
+		WriteThingFile(buffer, "Bob", 4.5f, (float)i);
+		many.Bind(paths[i], &things[i]);
+	}
+
+	Clock::time_point start = Clock::now();
+	for (unsigned i = 0; i < fileCount; ++i)
+		many.Reload(paths[i]);
+	std::chrono::duration<double, std::milli> reloadAll = Clock::now() - start;
+	many.Poll(); //drain the writes above
+
+	WriteThingFile(paths[fileCount / 2].c_str(), "Bob", 5.5f, 1.0f);
+	start = Clock::now();
+	unsigned reloaded = PollUntilReloaded(many);
+	std::chrono::duration<double, std::milli> reloadEdited = Clock::now() - start;
+	if (reloaded != 1 || things[fileCount / 2].radius != 5.5f || things[fileCount / 2 + 1].radius != 4.5f)
+		printf("HotReloader reloaded %u files for one edit\n", reloaded);
+
+	for (unsigned i = 0; i < fileCount; ++i)
+		remove(paths[i].c_str());
+
+	printf("Reloading after one edit among %u bound files, ms:\n", fileCount);
+	printf("%18s %8.2f\n", "every file", reloadAll.count());
+	printf("%18s %8.2f\n", "watched, patched", reloadEdited.count());
+	printf("\n");
+}
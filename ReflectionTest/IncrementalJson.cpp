@@ -0,0 +1,532 @@
+#include "IncrementalJson.h"
+#include "Arena.h"
+#include "FieldKind.h"
+#include "JsonNumber.h"
+#include "Trace.h"
+#include <chrono>
+#include <cstdlib>
+
+namespace meta
+{
+	namespace
+	{
+		//a number token's text, converted to what it lands in
+		template <typename T>
+		T NumberToken(const std::string& token)
+		{
+			T value = T();
+			ParseNumber(token.data(), token.data() + token.size(), value);
+			return value;
+		}
+	}
+
+	IncrementalJson::IncrementalJson(const Type* type, void* objects, unsigned capacity, StringPool& pool, unsigned stride)
+		: type(type), objects(static_cast<char*>(objects)), capacity(capacity), stride(stride != 0 ? stride : type->Size()), pool(pool),
+		at(0), consumed(0), finished(false), status(NeedInput), count(0)
+	{
+		Frame root = { Frame_Root, Expect_Value, false, false, false, NULL, NULL, NULL, 0, NULL };
+		stack.push_back(root);
+	}
+
+	void IncrementalJson::Feed(const char* data, size_t size)
+	{
+		if (size > 0)
+		{
+			pending.push_back(std::string(data, size));
+		}
+	}
+
+	void IncrementalJson::Finish(void)
+	{
+		finished = true;
+	}
+
+	IncrementalJson::Status IncrementalJson::Resume(unsigned microseconds, unsigned objectLimit)
+	{
+		typedef std::chrono::steady_clock Clock;
+
+		if (status == Done || status == Failed)
+		{
+			return status;
+		}
+
+		TraceSpan span("parse incremental", type);
+		size_t begin = consumed + at;
+		Clock::time_point deadline = Clock::now() + std::chrono::microseconds(microseconds);
+		unsigned stopAt = count + objectLimit;
+
+		for (unsigned tokens = 1; ; ++tokens)
+		{
+			if ((objectLimit != 0 && count >= stopAt) || (microseconds != 0 && (tokens & 31) == 0 && Clock::now() >= deadline))
+			{
+				status = Paused;
+				break;
+			}
+
+			char token;
+			Scan scan = NextToken(token);
+			if (scan == Scan_Incomplete && !pending.empty())
+			{
+				NextPart();
+				continue;
+			}
+			if (scan == Scan_Incomplete)
+			{
+				if (finished)
+					Fail("the text ends early");
+				else
+					status = NeedInput;
+				break;
+			}
+			if (scan == Scan_Malformed)
+			{
+				Fail("malformed token");
+				break;
+			}
+			if (!Process(token) || status == Done)
+			{
+				break;
+			}
+		}
+
+		span.SetBytes(consumed + at - begin);
+		return status;
+	}
+
+	//////////////////////////////////////////////////////////////////////////////
+	//  Tokens
+	//////////////////////////////////////////////////////////////////////////////
+	// Purpose: A token is only consumed once it's all there. One cut off by the end of a part
+	//          is scanned again from its start once the next part is behind it.
+
+	//what's left of the current part, a token cut off by its end, goes in front of the next
+	void IncrementalJson::NextPart(void)
+	{
+		consumed += at;
+		if (at == text.size())
+		{
+			text.swap(pending.front());
+		}
+		else
+		{
+			text.erase(0, at);
+			text += pending.front();
+		}
+		at = 0;
+		pending.pop_front();
+	}
+
+	IncrementalJson::Scan IncrementalJson::NextToken(char& token)
+	{
+		while (at < text.size() && (text[at] == ' ' || text[at] == '\n' || text[at] == '\r' || text[at] == '\t'))
+		{
+			++at;
+		}
+		if (at >= text.size())
+		{
+			return Scan_Incomplete;
+		}
+
+		token = text[at];
+		switch (token)
+		{
+			case '{': case '}': case '[': case ']': case ':': case ',':
+				++at;
+				return Scan_Token;
+			case '"':
+				return String();
+			case 't': return Literal("true");
+			case 'f': return Literal("false");
+			case 'n': return Literal("null");
+			default:
+				if (token == '-' || (token >= '0' && token <= '9'))
+				{
+					token = '0';
+					return Number();
+				}
+				return Scan_Malformed;
+		}
+	}
+
+	//unescaped into scratch
+	IncrementalJson::Scan IncrementalJson::String(void)
+	{
+		const char* data = text.data();
+		size_t size = text.size();
+		size_t i = at + 1;
+		scratch.clear();
+
+		while (true)
+		{
+			size_t run = i;
+			while (i < size && data[i] != '"' && data[i] != '\\')
+			{
+				++i;
+			}
+			scratch.append(data + run, i - run);
+
+			if (i >= size || (data[i] == '\\' && i + 1 >= size))
+			{
+				return Scan_Incomplete;
+			}
+			if (data[i] == '"')
+			{
+				break;
+			}
+
+			switch (data[i + 1])
+			{
+				case '"': case '\\': case '/': scratch += data[i + 1]; break;
+				case 'b': scratch += '\b'; break;
+				case 'f': scratch += '\f'; break;
+				case 'n': scratch += '\n'; break;
+				case 'r': scratch += '\r'; break;
+				case 't': scratch += '\t'; break;
+				case 'u':
+				{
+					unsigned code;
+					if (i + 6 > size)
+					{
+						return Scan_Incomplete;
+					}
+					if (!Hex4(data + i + 2, code))
+					{
+						return Scan_Malformed;
+					}
+					i += 4;
+
+					//a high surrogate must pair with a low one in the \u escape after it; a lone low one is malformed
+					if (code >= 0xd800 && code < 0xdc00)
+					{
+						if (i + 4 > size)
+						{
+							return AtEnd() ? Scan_Malformed : Scan_Incomplete;
+						}
+						if (data[i + 2] != '\\' || data[i + 3] != 'u')
+						{
+							return Scan_Malformed;
+						}
+
+						unsigned low;
+						if (i + 8 > size)
+						{
+							return Scan_Incomplete;
+						}
+						if (!Hex4(data + i + 4, low) || low < 0xdc00 || low >= 0xe000)
+						{
+							return Scan_Malformed;
+						}
+						code = 0x10000 + ((code - 0xd800) << 10) + (low - 0xdc00);
+						i += 6;
+					}
+					else if (code >= 0xdc00 && code < 0xe000)
+					{
+						return Scan_Malformed;
+					}
+
+					char utf8[4];
+					scratch.append(utf8, EncodeUtf8(utf8, code) - utf8);
+				}
+					break;
+				default:
+					return Scan_Malformed;
+			}
+			i += 2;
+		}
+
+		at = i + 1;
+		return Scan_Token;
+	}
+
+	//Checked and kept as text in scratch: it's converted once the member it lands in is known,
+	//straight to that member's type
+	IncrementalJson::Scan IncrementalJson::Number(void)
+	{
+		size_t i = at;
+		while (i < text.size())
+		{
+			char c = text[i];
+			if (!(c >= '0' && c <= '9') && c != '-' && c != '+' && c != '.' && c != 'e' && c != 'E')
+				break;
+			++i;
+		}
+		if (i >= text.size() && !AtEnd())
+		{
+			return Scan_Incomplete;
+		}
+
+		const char* begin = text.data() + at;
+		const char* end = text.data() + i;
+		if (SkipNumber(begin, end) != end)
+		{
+			return Scan_Malformed;
+		}
+
+		scratch.assign(begin, end);
+		at = i;
+		return Scan_Token;
+	}
+
+	IncrementalJson::Scan IncrementalJson::Literal(const char* word)
+	{
+		size_t length = std::strlen(word);
+		size_t available = text.size() - at;
+		if (available < length)
+		{
+			return !AtEnd() && std::memcmp(text.data() + at, word, available) == 0 ? Scan_Incomplete : Scan_Malformed;
+		}
+		if (std::memcmp(text.data() + at, word, length) != 0)
+		{
+			return Scan_Malformed;
+		}
+		at += length;
+		return Scan_Token;
+	}
+
+	//////////////////////////////////////////////////////////////////////////////
+	//  Frames
+	//////////////////////////////////////////////////////////////////////////////
+
+	bool IncrementalJson::Process(char token)
+	{
+		Frame& frame = stack.back();
+		switch (frame.expect)
+		{
+			case Expect_FirstValue:
+				if (token == ']')
+				{
+					return Close(token);
+				}
+				return Value(token);
+			case Expect_Value:
+				return Value(token);
+			case Expect_FirstKey:
+				if (token == '}')
+				{
+					return Close(token);
+				}
+				//fall through
+			case Expect_Key:
+				if (token != '"')
+				{
+					return Fail("expected a key");
+				}
+				if (frame.kind == Frame_Object)
+				{
+					frame.member = scratch[0] != '$' ? frame.shape->Find(frame.position++, scratch.c_str()) : NULL;
+					frame.wrapper = frame.member == NULL && frame.root && frame.type->Name() == scratch;
+				}
+				frame.expect = Expect_Colon;
+				return true;
+			case Expect_Colon:
+				if (token != ':')
+				{
+					return Fail("expected a colon");
+				}
+				frame.expect = Expect_Value;
+				return true;
+			case Expect_Next:
+				if (token == ',')
+				{
+					frame.expect = frame.isObject ? Expect_Key : Expect_Value;
+					return true;
+				}
+				return Close(token);
+			default:
+				return Fail("text after the root value");
+		}
+	}
+
+	//the next value into the top frame; the frame moves on before a container is pushed over it
+	bool IncrementalJson::Value(char token)
+	{
+		if (token == '}' || token == ']' || token == ':' || token == ',')
+		{
+			return Fail("expected a value");
+		}
+
+		Frame& frame = stack.back();
+		frame.expect = frame.kind == Frame_Root ? Expect_End : Expect_Next;
+		bool isContainer = token == '{' || token == '[';
+
+		switch (frame.kind)
+		{
+			case Frame_Root:
+				if (token == '[')
+					Push(Frame_Objects, false, NULL, NULL, false);
+				else if (token == '{')
+					Push(Frame_Object, true, type, objects, true);
+				else
+					return Fail("the root isn't an object or an array");
+				return true;
+			case Frame_Objects:
+				if (token != '{')
+				{
+					return Fail("expected an object");
+				}
+				if (count >= capacity)
+				{
+					std::cout << "Json array holds more than " << capacity << " " << type->Name() << std::endl;
+					status = Failed;
+					return false;
+				}
+				Push(Frame_Object, true, type, objects + (size_t)count * stride, false);
+				return true;
+			case Frame_Object:
+			{
+				const Type* memberType = frame.member != NULL ? frame.member->Meta() : NULL;
+				char* value = frame.member != NULL ? frame.data + frame.member->Offset() : NULL;
+				FieldKind kind = memberType != NULL ? Classify(memberType) : Kind_Other;
+
+				if (token == '{' && frame.wrapper)
+				{
+					Push(Frame_Object, true, frame.type, frame.data, false);
+				}
+				else if (token == '{' && memberType != NULL && !memberType->members.empty())
+				{
+					Push(Frame_Object, true, memberType, value, false);
+				}
+				else if (token == '[' && (kind == Kind_Integers || kind == Kind_Reals || kind == Kind_Strings))
+				{
+					switch (kind)
+					{
+						case Kind_Integers: reinterpret_cast<ArenaVector<int>*>(value)->clear(); break;
+						case Kind_Reals: reinterpret_cast<ArenaVector<float>*>(value)->clear(); break;
+						default: reinterpret_cast<ArenaVector<ArenaString>*>(value)->clear(); break;
+					}
+					Push(Frame_Array, false, memberType, value, false);
+				}
+				else if (isContainer)
+				{
+					Push(Frame_Skip, token == '{', NULL, NULL, false);
+				}
+				else if (memberType != NULL)
+				{
+					Store(memberType, value, token);
+				}
+				return true;
+			}
+			case Frame_Array:
+				if (isContainer)
+					Push(Frame_Skip, token == '{', NULL, NULL, false);
+				else
+					Append(frame.type, frame.data, token);
+				return true;
+			default:
+				if (isContainer)
+					Push(Frame_Skip, token == '{', NULL, NULL, false);
+				return true;
+		}
+	}
+
+	void IncrementalJson::Push(FrameKind kind, bool isObject, const Type* frameType, char* data, bool root)
+	{
+		Frame frame = { kind, isObject ? Expect_FirstKey : Expect_FirstValue, isObject, root, false, frameType, data,
+			kind == Frame_Object ? &GetKeyShape(frameType) : NULL, 0, NULL };
+		stack.push_back(frame);
+	}
+
+	bool IncrementalJson::Close(char token)
+	{
+		const Frame& frame = stack.back();
+		if (frame.kind == Frame_Root || token != (frame.isObject ? '}' : ']'))
+		{
+			return Fail("mismatched close");
+		}
+
+		bool isObject = frame.kind == Frame_Object;
+		bool root = frame.root;
+		stack.pop_back();
+
+		if (isObject && (root || stack.back().kind == Frame_Objects))
+		{
+			++count;
+		}
+		if (stack.back().kind == Frame_Root)
+		{
+			status = Done;
+		}
+		return true;
+	}
+
+	//a scalar token into a member; values the member can't hold are dropped
+	void IncrementalJson::Store(const Type* memberType, char* value, char token)
+	{
+		switch (Classify(memberType))
+		{
+			case Kind_Signed:
+			case Kind_Unsigned:
+				if (token == '0')
+					StoreInteger(value, memberType->Size(), NumberToken<long long>(scratch));
+				break;
+			case Kind_Boolean:
+				if (token == 't' || token == 'f')
+					*reinterpret_cast<bool*>(value) = token == 't';
+				else if (token == '0')
+					*reinterpret_cast<bool*>(value) = NumberToken<long long>(scratch) != 0;
+				break;
+			case Kind_Real32:
+				if (token == '0')
+					*reinterpret_cast<float*>(value) = NumberToken<float>(scratch);
+				break;
+			case Kind_Real64:
+				if (token == '0')
+					*reinterpret_cast<double*>(value) = NumberToken<double>(scratch);
+				break;
+			case Kind_String:
+				if (token == '"')
+					reinterpret_cast<std::string*>(value)->assign(scratch);
+				break;
+			case Kind_ArenaString:
+				if (token == '"')
+					reinterpret_cast<ArenaString*>(value)->assign(scratch.data(), scratch.size());
+				break;
+			case Kind_Interned:
+				if (token == '"')
+					*reinterpret_cast<InternedString*>(value) = pool.Intern(scratch.data(), (unsigned)scratch.size());
+				break;
+			case Kind_Enumeration:
+				if (token == '"')
+				{
+					long long enumValue;
+					if (memberType->Enum()->FromString(scratch.data(), (unsigned)scratch.size(), enumValue))
+						memberType->Enum()->Set(value, enumValue);
+					else
+						std::cout << "ERROR: " << scratch << " isn't a " << memberType->Name() << std::endl;
+				}
+				else if (token == '0')
+				{
+					memberType->Enum()->Set(value, NumberToken<long long>(scratch));
+				}
+				break;
+			default:
+				break;
+		}
+	}
+
+	//an array element onto an arena vector; elements of the wrong json type are skipped
+	void IncrementalJson::Append(const Type* vectorType, char* vector, char token)
+	{
+		FieldKind kind = Classify(vectorType);
+		if (kind == Kind_Integers && token == '0')
+		{
+			reinterpret_cast<ArenaVector<int>*>(vector)->push_back((int)NumberToken<long long>(scratch));
+		}
+		else if (kind == Kind_Reals && token == '0')
+		{
+			reinterpret_cast<ArenaVector<float>*>(vector)->push_back(NumberToken<float>(scratch));
+		}
+		else if (kind == Kind_Strings && token == '"')
+		{
+			ArenaVector<ArenaString>& strings = *reinterpret_cast<ArenaVector<ArenaString>*>(vector);
+			strings.push_back(ArenaString(scratch.data(), scratch.size(), strings.get_allocator()));
+		}
+	}
+
+	bool IncrementalJson::Fail(const char* problem)
+	{
+		std::cout << "Malformed json (byte " << consumed + at << ", " << problem << ") loading " << type->Name() << std::endl;
+		status = Failed;
+		return false;
+	}
+}
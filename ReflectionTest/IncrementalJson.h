@@ -0,0 +1,138 @@
+#pragma once
+
+#include "Meta.h"
+#include "KeyShape.h"
+#include "StringPool.h"
+#include <deque>
+
+namespace meta
+{
+	//////////////////////////////////////////////////////////////////////////////
+	//  IncrementalJson
+	//////////////////////////////////////////////////////////////////////////////
+	// Purpose: Loads json text into registered types a slice at a time, for loading under a frame
+	//          budget. Text is fed in parts as it arrives and Resume parses until the text runs
+	//          out, a time budget is spent or a number of objects is done. The parse and object
+	//          stack is kept between calls, so a slice can end anywhere, mid object or mid token.
+	//
+	//          Values land like ParseJsonInSitu's, except that the text is copied and dropped as
+	//          it's consumed: StringView members are skipped, since nothing would outlive them.
+	//          The root is an array of objects, or one object (or a single member named after the
+	//          type, like ThingFile.json's {"Thing": {...}}). Data is taken to be in the current
+	//          schema (no migrations).
+	class IncrementalJson
+	{
+	public:
+		enum Status
+		{
+			NeedInput,	//the fed text is used up
+			Paused,		//the budget ran out
+			Done,		//the root value is complete
+			Failed		//the text is malformed, or holds more objects than capacity
+		};
+
+		//objects are filled in order, stride bytes apart (0 means type->Size()); a root object fills the first
+		IncrementalJson(const Type* type, void* objects, unsigned capacity, StringPool& pool, unsigned stride = 0);
+
+		//The next part of the text, copied so the caller's buffer can be reused at once. Parts are
+		//parsed one after another, never joined, so feeding faster than Resume parses never
+		//copies the backlog; only a token cut off by the end of a part is carried into the next.
+		void Feed(const char* data, size_t size);
+
+		//no more text is coming: a value cut off at the end is malformed from here on
+		void Finish(void);
+
+		//Parses for at most microseconds, or until objects more root objects are done (0 is no limit
+		//for either). The clock is read every few tokens, so a slice can run over by a few tokens.
+		Status Resume(unsigned microseconds, unsigned objects = 0);
+
+		Status GetStatus(void) const { return status; }
+
+		//Objects done so far. The one after them may be partly filled while the status is
+		//NeedInput or Paused.
+		unsigned Count(void) const { return count; }
+
+	private:
+		// Non-Copyable
+		IncrementalJson(const IncrementalJson&); // = delete
+		void operator=(const IncrementalJson&); // = delete
+
+		enum FrameKind
+		{
+			Frame_Root,
+			Frame_Objects,	//the root array
+			Frame_Object,
+			Frame_Array,	//into an arena vector
+			Frame_Skip
+		};
+
+		enum Expect
+		{
+			Expect_FirstValue,	//a value or the close of an empty array
+			Expect_Value,
+			Expect_FirstKey,	//a key or the close of an empty object
+			Expect_Key,
+			Expect_Colon,
+			Expect_Next,		//a comma or the close
+			Expect_End			//the root value is done
+		};
+
+		struct Frame
+		{
+			FrameKind kind;
+			Expect expect;
+			bool isObject;
+			bool root;				//an object directly under the root
+			bool wrapper;			//the pending value is the member named after the type
+			const Type* type;
+			char* data;
+			KeyShape* shape;
+			unsigned position;		//keys seen, for the shape
+			const Member* member;	//where the pending value goes; NULL skips it
+		};
+
+		enum Scan
+		{
+			Scan_Token,
+			Scan_Incomplete,
+			Scan_Malformed
+		};
+
+		void NextPart(void);
+		bool AtEnd(void) const { return finished && pending.empty(); }
+
+		Scan NextToken(char& token);
+		Scan String(void);
+		Scan Number(void);
+		Scan Literal(const char* word);
+
+		bool Process(char token);
+		bool Value(char token);
+		void Push(FrameKind kind, bool isObject, const Type* type, char* data, bool root);
+		bool Close(char token);
+		void Store(const Type* memberType, char* value, char token);
+		void Append(const Type* vectorType, char* vector, char token);
+		bool Fail(const char* problem);
+
+		const Type* type;
+		char* objects;
+		unsigned capacity;
+		unsigned stride;
+		StringPool& pool;
+
+		std::string text;	//the part being parsed
+		size_t at;			//next byte of text to scan
+		size_t consumed;	//bytes of the parts before
+		std::deque<std::string> pending;
+		bool finished;
+
+		std::vector<Frame> stack;
+		Status status;
+		unsigned count;
+
+		//the last string token, unescaped, or number token's text
+		std::string scratch;
+	};
+}
+
+void TestIncrementalJson();
@@ -0,0 +1,184 @@
+#include "IncrementalJson.h"
+#include "MmapJson.h"
+#include "SerializationTest.h"
+#include "Test.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+
+namespace
+{
+	//escapes, a surrogate pair, "$" stamps and containers the type doesn't have, for pieces to cut through
+	std::string ThingsJson(unsigned count)
+	{
+		std::string json = "[\n";
+		char thing[512];
+		for (unsigned i = 0; i < count; ++i)
+		{
+			sprintf(thing, "\t{ \"id\": %u, \"size\": -%u, \"name\": \"thing \\\"%u\\\" caf\\u00e9 \\ud83d\\ude00\", \"radius\": %u.25, "
+				"\"height\": -%u.5e1, \"position\": { \"x\": 1, \"y\": %u, \"z\": 3 }, \"kind\": \"%s\", \"$schema\": \"0\", "
+				"\"extra\": [1, { \"a\": [true, null] }] }%s\n",
+				i, i % 1000, i, i % 100, i % 10, i % 50, i & 1 ? "Thing_Apple" : "Thing_Banana", i + 1 < count ? "," : "");
+			json += thing;
+		}
+		json += "]\n";
+		return json;
+	}
+
+	bool SameThing(const Thing& lhs, const Thing& rhs)
+	{
+		return lhs.id == rhs.id && lhs.size == rhs.size && lhs.name == rhs.name && lhs.radius == rhs.radius && lhs.height == rhs.height &&
+			lhs.position.x == rhs.position.x && lhs.position.y == rhs.position.y && lhs.position.z == rhs.position.z && lhs.kind == rhs.kind;
+	}
+
+	//the whole text in one piece, then run to the end
+	meta::IncrementalJson::Status LoadAll(meta::IncrementalJson& loader, const char* text)
+	{
+		loader.Feed(text, strlen(text));
+		loader.Finish();
+		return loader.Resume(0);
+	}
+}
+
+void TestIncrementalJson()
+{
+	typedef std::chrono::high_resolution_clock Clock;
+	typedef std::chrono::duration<double, std::milli> Milliseconds;
+	typedef meta::IncrementalJson Loader;
+
+	const meta::Type* thingType = meta::get<Thing>();
+	meta::StringPool pool;
+
+	//fed in pieces that cut every token somewhere, and paused every few objects, it matches the in-situ parse
+	const unsigned small = 200;
+	std::string json = ThingsJson(small);
+	std::string copy = json;
+	std::vector<Thing> expected(small, Thing());
+	if (meta::ParseJsonArrayInSitu(&copy[0], copy.size(), thingType, expected.data(), small, pool) != small || expected[3].name != "thing \"3\" caf\xc3\xa9 \xf0\x9f\x98\x80")
+		printf("In-situ Things didn't parse\n");
+
+	const size_t pieces[] = { 1, 7, 4096 };
+	for (unsigned p = 0; p < 3; ++p)
+	{
+		std::vector<Thing> things(small, Thing());
+		Loader loader(thingType, things.data(), small, pool);
+		for (size_t at = 0; at < json.size(); at += pieces[p])
+		{
+			loader.Feed(json.data() + at, std::min(pieces[p], json.size() - at));
+			while (loader.Resume(0, 3) == Loader::Paused)
+			{
+			}
+		}
+		loader.Finish();
+
+		bool same = loader.Resume(0) == Loader::Done && loader.Count() == small;
+		for (unsigned i = 0; same && i < small; ++i)
+			same = SameThing(things[i], expected[i]);
+		if (!same)
+			printf("Things fed %u bytes at a time didn't load (%u)\n", (unsigned)pieces[p], loader.Count());
+	}
+
+	//an object budget pauses after exactly that many
+	{
+		std::vector<Thing> things(small, Thing());
+		Loader loader(thingType, things.data(), small, pool);
+		loader.Feed(json.data(), json.size());
+		if (loader.Resume(0, 10) != Loader::Paused || loader.Count() != 10 || loader.Resume(0, 10) != Loader::Paused || loader.Count() != 20 ||
+			!SameThing(things[19], expected[19]) || loader.Resume(0) != Loader::Done || loader.Count() != small)
+			printf("Object budgets paused after %u Things\n", loader.Count());
+	}
+
+	//a root object, through a member named after the type, a byte at a time; arrays into arena vectors
+	{
+		Thing thing = Thing();
+		const char* text = "{ \"$version\": 1, \"Thing\": { \"id\": 12, \"name\": \"Bob\", \"position\": { \"y\": 2.5 }, \"kind\": 1 } }";
+		Loader loader(thingType, &thing, 1, pool);
+		for (const char* c = text; *c != '\0'; ++c)
+		{
+			loader.Feed(c, 1);
+			loader.Resume(0);
+		}
+		if (loader.GetStatus() != Loader::Done || loader.Count() != 1 || thing.id != 12 || thing.name != "Bob" || thing.position.y != 2.5f || thing.kind != Thing_Apple)
+			printf("Root Thing didn't load a byte at a time\n");
+
+		meta::MonotonicArena arena;
+		Article* article = static_cast<Article*>(meta::NewObjects(meta::get<Article>(), 1, &arena));
+		Loader articleLoader(meta::get<Article>(), article, 1, pool);
+		if (LoadAll(articleLoader, "{ \"id\": 3, \"scores\": [1.5, 2], \"tags\": [\"a tag long enough to allocate\", 4, \"b\"] }") != Loader::Done ||
+			article->scores.size() != 2 || article->scores[0] != 1.5f || article->tags.size() != 2 || article->tags[0].get_allocator().Resource() != &arena)
+			printf("Article arrays didn't load incrementally\n");
+	}
+
+	//malformed, cut off and overfull text fails
+	{
+		std::vector<Thing> things(2, Thing());
+		Loader malformed(thingType, things.data(), 2, pool);
+		Loader cutOff(thingType, things.data(), 2, pool);
+		Loader cutNumber(thingType, things.data(), 2, pool);
+		Loader overfull(thingType, things.data(), 2, pool);
+		if (LoadAll(malformed, "[{ \"id\": 1 }, { \"id\": }]") != Loader::Failed || LoadAll(cutOff, "[{ \"id\": 1 }") != Loader::Failed ||
+			LoadAll(cutNumber, "{ \"id\": 12") != Loader::Failed || LoadAll(overfull, "[{}, {}, {}]") != Loader::Failed || overfull.Count() != 2)
+			printf("Bad json loaded incrementally\n");
+
+		//surrogates come in pairs, whether the text arrives whole or a byte at a time
+		const char* escapes[] = { "\\ud83d\\ude00", "\\ud83d", "\\ud83dx", "\\ude00", "\\ud83d\\u0041" };
+		for (unsigned e = 0; e < 5; ++e)
+		{
+			std::string text = std::string("{ \"name\": \"") + escapes[e] + "\" }";
+			Thing whole = Thing();
+			Thing bytes = Thing();
+			Loader wholeLoader(thingType, &whole, 1, pool);
+			Loader byteLoader(thingType, &bytes, 1, pool);
+			for (size_t c = 0; c < text.size(); ++c)
+			{
+				byteLoader.Feed(text.data() + c, 1);
+				byteLoader.Resume(0);
+			}
+			byteLoader.Finish();
+
+			bool loaded = LoadAll(wholeLoader, text.c_str()) == Loader::Done;
+			if (loaded != (e == 0) || (byteLoader.Resume(0) == Loader::Done) != loaded || (loaded && (whole.name != "\xf0\x9f\x98\x80" || bytes.name != whole.name)))
+				printf("Incremental load took %s wrongly\n", escapes[e]);
+		}
+	}
+
+	//a large document streamed in, 1MB a frame (faster than it parses), in 2ms slices, against one in-situ parse of it all
+	const unsigned count = 100000;
+	const size_t piece = 1024 * 1024;
+	const unsigned budget = 2000;
+	json = ThingsJson(count);
+	copy = json;
+
+	std::vector<Thing> things(count, Thing());
+	Clock::time_point start = Clock::now();
+	meta::ParseJsonArrayInSitu(&copy[0], copy.size(), thingType, things.data(), count, pool);
+	Milliseconds whole = Clock::now() - start;
+
+	std::vector<Thing> sliced(count, Thing());
+	Loader loader(thingType, sliced.data(), count, pool);
+	unsigned frames = 0;
+	Milliseconds longest(0.0), total(0.0);
+	for (size_t fed = 0; loader.GetStatus() != Loader::Done && loader.GetStatus() != Loader::Failed; ++frames)
+	{
+		start = Clock::now();
+		if (fed < json.size())
+		{
+			loader.Feed(json.data() + fed, std::min(piece, json.size() - fed));
+			fed += piece;
+			if (fed >= json.size())
+				loader.Finish();
+		}
+		loader.Resume(budget);
+		Milliseconds slice = Clock::now() - start;
+		longest = std::max(longest, slice);
+		total += slice;
+	}
+	if (loader.GetStatus() != Loader::Done || loader.Count() != count || !SameThing(sliced[count - 1], things[count - 1]))
+		printf("Streamed Things didn't load (%u)\n", loader.Count());
+
+	printf("%u Things (%u KB) loaded, ms:\n", count, (unsigned)(json.size() / 1024));
+	printf("%18s %8s %8s %8s\n", "", "frames", "longest", "total");
+	printf("%18s %8u %8.2f %8.2f\n", "in situ, one call", 1, whole.count(), whole.count());
+	printf("%18s %8u %8.2f %8.2f\n", "2ms slices", frames, longest.count(), total.count());
+	printf("\n");
+}
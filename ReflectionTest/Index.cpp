@@ -0,0 +1,265 @@
+#include "Index.h"
+#include "Sort.h"
+
+namespace meta
+{
+	size_t Index::KeyHash::operator()(const IndexKey& key) const
+	{
+		//FNV-1a over the number, then the characters
+		unsigned long long hash = 14695981039346656037ULL;
+		unsigned long long number = key.number;
+		for (unsigned i = 0; i < 8; ++i, number >>= 8)
+		{
+			hash = (hash ^ (number & 0xff)) * 1099511628211ULL;
+		}
+		for (size_t i = 0; i < key.text.size(); ++i)
+		{
+			hash = (hash ^ static_cast<unsigned char>(key.text[i])) * 1099511628211ULL;
+		}
+		return static_cast<size_t>(hash);
+	}
+
+	Index::Index(VariantStore& store, const PropertyPath& key, Kind kind) :
+		store(&store),
+		key(key),
+		kind(kind),
+		text(false),
+		valid(false),
+		size(0)
+	{
+		if (!Check())
+		{
+			return;
+		}
+
+		store.AddListener(key.Root(), this);
+
+		const VariantStore::Bucket* bucket = store.Find(key.Root());
+		for (unsigned i = 0; bucket != NULL && i < bucket->Count(); ++i)
+		{
+			Add(bucket->At(i), store.HandleAt(*bucket, i));
+		}
+	}
+
+	Index::Index(const PropertyPath& key, Kind kind, const void* objects, unsigned count, unsigned stride) :
+		store(NULL),
+		key(key),
+		kind(kind),
+		text(false),
+		valid(false),
+		size(0)
+	{
+		if (!Check())
+		{
+			return;
+		}
+
+		stride = stride != 0 ? stride : key.Root()->Size();
+		const char* object = static_cast<const char*>(objects);
+		for (unsigned i = 0; i < count; ++i, object += stride)
+		{
+			Handle handle = { i, 0 };
+			Add(object, handle);
+		}
+	}
+
+	Index::~Index()
+	{
+		if (valid && store != NULL)
+		{
+			store->RemoveListener(key.Root(), this);
+		}
+	}
+
+	//false, reported, for keys that can't be indexed
+	bool Index::Check(void)
+	{
+		if (!key.IsValid())
+		{
+			std::cout << "Can't index by an unknown member" << std::endl;
+			return false;
+		}
+
+		if (!IsSortable(key.Leaf()))
+		{
+			std::cout << "Can't index " << key.Root()->Name() << " by " << key.Leaf()->Name() << " keys" << std::endl;
+			return false;
+		}
+		text = IsStringKey(key.Leaf());
+		valid = true;
+		return true;
+	}
+
+	void Index::KeyOf(const void* leaf, IndexKey& out) const
+	{
+		if (text)
+		{
+			const char* data;
+			unsigned length;
+			StringKey(key.Leaf(), leaf, data, length);
+			out.number = 0;
+			out.text.assign(data, length);
+		}
+		else
+		{
+			NumericKey(key.Leaf(), leaf, out.number);
+			out.text.clear();
+		}
+	}
+
+	void Index::Add(const void* value, Handle handle)
+	{
+		if (handle.slot >= keyOfSlot.size())
+		{
+			keyOfSlot.resize(handle.slot + 1);
+			indexed.resize(handle.slot + 1, false);
+			positionOfSlot.resize(handle.slot + 1, 0);
+		}
+
+		IndexKey& filed = keyOfSlot[handle.slot];
+		KeyOf(key.Resolve(value), filed);
+		indexed[handle.slot] = true;
+		++size;
+
+		if (kind == Hash)
+		{
+			std::vector<Handle>& group = groups[filed];
+			positionOfSlot[handle.slot] = (unsigned)group.size();
+			group.push_back(handle);
+		}
+		else
+		{
+			Entry entry = { filed, handle };
+			ordered.insert(entry);
+		}
+	}
+
+	void Index::Remove(Handle handle)
+	{
+		if (handle.slot >= indexed.size() || !indexed[handle.slot])
+		{
+			return;
+		}
+
+		IndexKey& filed = keyOfSlot[handle.slot];
+		indexed[handle.slot] = false;
+		--size;
+
+		if (kind == Hash)
+		{
+			//swap with the group's last handle, and drop the group once it empties
+			Groups::iterator found = groups.find(filed);
+			std::vector<Handle>& group = found->second;
+			unsigned position = positionOfSlot[handle.slot];
+			group[position] = group.back();
+			positionOfSlot[group[position].slot] = position;
+			group.pop_back();
+			if (group.empty())
+			{
+				groups.erase(found);
+			}
+		}
+		else
+		{
+			Entry entry = { filed, handle };
+			ordered.erase(entry);
+		}
+	}
+
+	void Index::Find(const void* value, std::vector<Handle>& out) const
+	{
+		if (!valid)
+		{
+			return;
+		}
+
+		Entry probe;
+		KeyOf(value, probe.key);
+
+		if (kind == Hash)
+		{
+			Groups::const_iterator found = groups.find(probe.key);
+			if (found != groups.end())
+			{
+				out.insert(out.end(), found->second.begin(), found->second.end());
+			}
+			return;
+		}
+
+		FindRange(value, value, out);
+	}
+
+	void Index::FindRange(const void* low, const void* high, std::vector<Handle>& out) const
+	{
+		if (!valid)
+		{
+			return;
+		}
+		if (kind != Sorted)
+		{
+			std::cout << "Range lookup on hash index of " << key.Root()->Name() << " " << key.Path() << std::endl;
+			return;
+		}
+
+		Entry first;
+		KeyOf(low, first.key);
+		first.handle.slot = 0;
+		first.handle.generation = 0;
+
+		IndexKey last;
+		KeyOf(high, last);
+
+		for (std::set<Entry>::const_iterator it = ordered.lower_bound(first); it != ordered.end() && !(last < it->key); ++it)
+		{
+			out.push_back(it->handle);
+		}
+	}
+
+	void Index::Update(Handle handle)
+	{
+		if (valid && store != NULL && store->IsValid(handle))
+		{
+			Remove(handle);
+			Add(store->Get(handle), handle);
+		}
+	}
+
+	void Index::Insert(unsigned position, const void* object)
+	{
+		assert(store == NULL); //store indexes follow the store
+		if (valid)
+		{
+			Handle handle = { position, 0 };
+			Remove(handle);
+			Add(object, handle);
+		}
+	}
+
+	void Index::Erase(unsigned position)
+	{
+		assert(store == NULL); //store indexes follow the store
+		Handle handle = { position, 0 };
+		Remove(handle);
+	}
+
+	void Index::Inserted(const void* value, Handle handle)
+	{
+		Add(value, handle);
+	}
+
+	void Index::Erasing(const void* value, Handle handle)
+	{
+		(void)value;
+		Remove(handle);
+	}
+
+	void Index::Cleared(void)
+	{
+		keyOfSlot.clear();
+		indexed.clear();
+		positionOfSlot.clear();
+		groups.clear();
+		ordered.clear();
+		size = 0;
+	}
+}
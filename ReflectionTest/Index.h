@@ -0,0 +1,134 @@
+#pragma once
+
+#include "PropertyPath.h"
+#include "VariantStore.h"
+#include <set>
+
+namespace meta
+{
+	//////////////////////////////////////////////////////////////////////////////
+	//  Index
+	//////////////////////////////////////////////////////////////////////////////
+	// Purpose: Finds the values of one type in a VariantStore, or objects in an array, by a member
+	//          chosen at runtime, without scanning them. A Hash index answers equality lookups; a
+	//          Sorted index answers equality and inclusive range lookups, in key order. Lookups
+	//          return store handles; for an array, a handle's slot is the object's position.
+	//
+	// A store index listens to the store, so inserts, erases and clears keep it current. A value
+	// changed in place needs Update. An array can't be listened to, so its owner calls Insert and
+	// Erase as positions change. Keys can be any type Sort orders (numbers, bools, enums and
+	// strings); floats compare by value, so -0.0 finds 0.0. The store must outlive the index.
+	class Index : public VariantStore::Listener
+	{
+	public:
+		typedef VariantStore::Handle Handle;
+
+		enum Kind
+		{
+			Hash,
+			Sorted
+		};
+
+		//Indexes every value of key.Root() in store, now and from then on. An unindexable key
+		//is reported and leaves the index invalid and empty.
+		Index(VariantStore& store, const PropertyPath& key, Kind kind);
+
+		//Indexes count objects of key.Root(), stride bytes apart (0 means key.Root()->Size()).
+		//Later changes to the array go through Insert and Erase.
+		Index(const PropertyPath& key, Kind kind, const void* objects, unsigned count, unsigned stride = 0);
+		~Index();
+
+		bool IsValid(void) const { return valid; }
+		Kind GetKind(void) const { return kind; }
+		const PropertyPath& Key(void) const { return key; }
+		unsigned Size(void) const { return size; }
+
+		//appends the handles of values whose key equals *value, a value of the key's type
+		void Find(const void* value, std::vector<Handle>& out) const;
+
+		//appends the handles of values with *low <= key <= *high, in key order. Sorted indexes only.
+		void FindRange(const void* low, const void* high, std::vector<Handle>& out) const;
+
+		template <typename T>
+		void Equal(const T& value, std::vector<Handle>& out) const
+		{
+			assert(meta::get<T>() == key.Leaf()); //key is another type
+			Find(&value, out);
+		}
+
+		template <typename T>
+		void Between(const T& low, const T& high, std::vector<Handle>& out) const
+		{
+			assert(meta::get<T>() == key.Leaf()); //key is another type
+			FindRange(&low, &high, out);
+		}
+
+		//re-reads the key of a value that was changed in place
+		void Update(Handle handle);
+
+		//array indexes: files the object now at position, in place of any it held before
+		void Insert(unsigned position, const void* object);
+
+		//array indexes: forgets the object at position
+		void Erase(unsigned position);
+
+		//VariantStore::Listener
+		void Inserted(const void* value, Handle handle);
+		void Erasing(const void* value, Handle handle);
+		void Cleared(void);
+
+	private:
+		// Non-Copyable
+		Index(const Index&); // = delete
+		void operator=(const Index&); // = delete
+
+		//numbers as their order preserving sort key, strings as their characters
+		struct IndexKey
+		{
+			unsigned long long number;
+			std::string text;
+
+			bool operator==(const IndexKey& rhs) const { return number == rhs.number && text == rhs.text; }
+			bool operator<(const IndexKey& rhs) const { return number != rhs.number ? number < rhs.number : text < rhs.text; }
+		};
+
+		struct KeyHash
+		{
+			size_t operator()(const IndexKey& key) const;
+		};
+
+		struct Entry
+		{
+			IndexKey key;
+			Handle handle;
+
+			//slots break ties, so erasing one of many equal keys is a single lookup
+			bool operator<(const Entry& rhs) const { return key < rhs.key || (key == rhs.key && handle.slot < rhs.handle.slot); }
+		};
+
+		//a Hash index's values of one key; positionOfSlot finds each one's place
+		typedef std::unordered_map<IndexKey, std::vector<Handle>, KeyHash> Groups;
+
+		bool Check(void);
+		void KeyOf(const void* leaf, IndexKey& out) const;
+		void Add(const void* value, Handle handle);
+		void Remove(Handle handle);
+
+		VariantStore* store;	//NULL for an array
+		PropertyPath key;
+		Kind kind;
+		bool text;
+		bool valid;
+		unsigned size;
+
+		//by slot: the key each indexed value was filed under
+		std::vector<IndexKey> keyOfSlot;
+		std::vector<bool> indexed;
+
+		Groups groups;
+		std::vector<unsigned> positionOfSlot;
+		std::set<Entry> ordered;
+	};
+}
+
+void TestIndex();
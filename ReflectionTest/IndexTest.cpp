@@ -0,0 +1,237 @@
+#include "Index.h"
+#include "SerializationTest.h"
+#include <algorithm>
+#include <chrono>
+#include <random>
+
+namespace
+{
+	typedef meta::VariantStore::Handle Handle;
+
+	//the linear scans the indexes replace
+	void ScanSize(meta::VariantStore& store, int size, std::vector<Handle>& out)
+	{
+		meta::VariantStore::Bucket* bucket = store.Find(meta::get<Thing>());
+		for (unsigned i = 0; i < bucket->Count(); ++i)
+		{
+			if (static_cast<const Thing*>(bucket->At(i))->size == size)
+				out.push_back(store.HandleAt(*bucket, i));
+		}
+	}
+
+	void ScanHeight(meta::VariantStore& store, double low, double high, std::vector<Handle>& out)
+	{
+		meta::VariantStore::Bucket* bucket = store.Find(meta::get<Thing>());
+		for (unsigned i = 0; i < bucket->Count(); ++i)
+		{
+			double height = static_cast<const Thing*>(bucket->At(i))->height;
+			if (height >= low && height <= high)
+				out.push_back(store.HandleAt(*bucket, i));
+		}
+	}
+
+	bool SameHandles(std::vector<Handle> lhs, std::vector<Handle> rhs)
+	{
+		struct BySlot
+		{
+			bool operator()(const Handle& a, const Handle& b) const { return a.slot < b.slot; }
+		};
+		std::sort(lhs.begin(), lhs.end(), BySlot());
+		std::sort(rhs.begin(), rhs.end(), BySlot());
+		if (lhs.size() != rhs.size())
+			return false;
+		for (unsigned i = 0; i < lhs.size(); ++i)
+		{
+			if (lhs[i].slot != rhs[i].slot || lhs[i].generation != rhs[i].generation)
+				return false;
+		}
+		return true;
+	}
+
+	Thing MakeThing(std::mt19937& random, unsigned id)
+	{
+		Thing thing = Thing();
+		thing.id = id;
+		thing.size = (int)(random() % 1000) - 500;
+		thing.height = (double)(random() % 100000) / 100.0;
+		thing.radius = (float)(random() % 100);
+		thing.name = (random() & 1) ? "apple" : "banana";
+		return thing;
+	}
+
+	void CheckIndexes(meta::VariantStore& store, const meta::Index& bySize, const meta::Index& byHeight, const char* when)
+	{
+		std::vector<Handle> indexed, scanned;
+		for (int size = -500; size < 500; size += 37)
+		{
+			indexed.clear();
+			scanned.clear();
+			bySize.Equal(size, indexed);
+			ScanSize(store, size, scanned);
+			if (!SameHandles(indexed, scanned))
+			{
+				printf("Hash index on size disagrees with a scan for %d %s\n", size, when);
+				break;
+			}
+		}
+
+		for (double low = 0.0; low < 1000.0; low += 77.7)
+		{
+			indexed.clear();
+			scanned.clear();
+			byHeight.Between(low, low + 1.0, indexed);
+			ScanHeight(store, low, low + 1.0, scanned);
+			bool ordered = true;
+			for (unsigned i = 1; i < indexed.size(); ++i)
+				ordered = ordered && store.Get<Thing>(indexed[i - 1]).height <= store.Get<Thing>(indexed[i]).height;
+			if (!SameHandles(indexed, scanned) || !ordered)
+			{
+				printf("Sorted index on height disagrees with a scan for [%g, %g] %s\n", low, low + 1.0, when);
+				break;
+			}
+		}
+	}
+}
+
+void TestIndex()
+{
+	typedef std::chrono::high_resolution_clock Clock;
+
+	const unsigned count = 100000;
+	const meta::Type* thingType = meta::get<Thing>();
+	std::mt19937 random(40);
+
+	meta::VariantStore store;
+	std::vector<Handle> handles;
+	for (unsigned i = 0; i < count; ++i)
+		handles.push_back(store.Insert(MakeThing(random, i)));
+
+	//built over what's already there
+	Clock::time_point start = Clock::now();
+	meta::Index bySize(store, meta::PropertyPath(thingType, "size"), meta::Index::Hash);
+	meta::Index byHeight(store, meta::PropertyPath(thingType, "height"), meta::Index::Sorted);
+	std::chrono::duration<double, std::milli> build = Clock::now() - start;
+
+	if (bySize.Size() != count || byHeight.Size() != count)
+		printf("Indexes hold %u and %u of %u Things\n", bySize.Size(), byHeight.Size(), count);
+	CheckIndexes(store, bySize, byHeight, "after building");
+
+	//kept current through erases, inserts and in place changes
+	for (unsigned i = 0; i < count; i += 3)
+		store.Erase(handles[i]);
+	for (unsigned i = 0; i < count / 4; ++i)
+		store.Insert(MakeThing(random, count + i));
+	for (unsigned i = 1; i < count; i += 3)
+	{
+		store.Get<Thing>(handles[i]).size = 2;
+		store.Get<Thing>(handles[i]).height = 3.5;
+		bySize.Update(handles[i]);
+		byHeight.Update(handles[i]);
+	}
+	if (bySize.Size() != store.Size() || byHeight.Size() != store.Size())
+		printf("Indexes hold %u and %u of %u Things after changes\n", bySize.Size(), byHeight.Size(), store.Size());
+	CheckIndexes(store, bySize, byHeight, "after changes");
+
+	//string keys, and -0.0 finding 0.0
+	{
+		meta::Index byName(store, meta::PropertyPath(thingType, "name"), meta::Index::Sorted);
+		meta::Index byRadius(store, meta::PropertyPath(thingType, "radius"), meta::Index::Hash);
+		std::vector<Handle> apples, bananas, zero, between;
+		byName.Equal(std::string("apple"), apples);
+		byName.Equal(std::string("banana"), bananas);
+		byName.Between(std::string("a"), std::string("b"), between);
+		byRadius.Equal(-0.0f, zero);
+		if (apples.size() + bananas.size() != store.Size() || between.size() != apples.size() || zero.empty())
+			printf("String or float index lookups miss values\n");
+	}
+
+	//an index doesn't outlive a clear
+	{
+		meta::VariantStore cleared;
+		meta::Index byId(cleared, meta::PropertyPath(thingType, "id"), meta::Index::Sorted);
+		cleared.Insert(MakeThing(random, 1));
+		cleared.Clear();
+		cleared.Insert(MakeThing(random, 2));
+		std::vector<Handle> found;
+		unsigned low = 0, high = 10;
+		byId.Between(low, high, found);
+		if (byId.Size() != 1 || found.size() != 1 || cleared.Get<Thing>(found[0]).id != 2)
+			printf("Index didn't follow a cleared store\n");
+	}
+
+	//an array of Things, kept current by its owner: 10 is erased by moving the last Thing over it, 20 changes id
+	{
+		std::vector<Thing> things;
+		for (unsigned i = 0; i < 1000; ++i)
+			things.push_back(MakeThing(random, i));
+		meta::Index byId(meta::PropertyPath(thingType, "id"), meta::Index::Sorted, things.data(), (unsigned)things.size());
+		meta::Index byName(meta::PropertyPath(thingType, "name"), meta::Index::Hash, things.data(), (unsigned)things.size(), sizeof(Thing));
+
+		byId.Erase(10);
+		byName.Erase(10);
+		byId.Erase(999);
+		byName.Erase(999);
+		things[10] = things.back();
+		things.pop_back();
+		byId.Insert(10, &things[10]);
+		byName.Insert(10, &things[10]);
+		things[20].id = 5000;
+		byId.Insert(20, &things[20]);
+
+		std::vector<Handle> found, apples;
+		unsigned low = 999, high = 5000;
+		byId.Between(low, high, found);
+		byName.Equal(std::string("apple"), apples);
+		size_t scanned = 0;
+		for (unsigned i = 0; i < things.size(); ++i)
+			scanned += things[i].name == "apple";
+		if (byId.Size() != things.size() || found.size() != 2 || found[0].slot != 10 || found[1].slot != 20 || apples.size() != scanned)
+			printf("Array index didn't follow its Things\n");
+	}
+
+	//lookups: "all Things with size == 2" and "height between 3 and 4"
+	const unsigned queries = 1000;
+	std::vector<Handle> found;
+	size_t hits = 0;
+
+	start = Clock::now();
+	for (unsigned i = 0; i < queries; ++i, found.clear())
+	{
+		ScanSize(store, (int)(i % 1000) - 500, found);
+		hits += found.size();
+	}
+	std::chrono::duration<double, std::milli> scanEqual = Clock::now() - start;
+
+	start = Clock::now();
+	for (unsigned i = 0; i < queries; ++i, found.clear())
+	{
+		bySize.Equal((int)(i % 1000) - 500, found);
+		hits -= found.size();
+	}
+	std::chrono::duration<double, std::milli> indexEqual = Clock::now() - start;
+
+	start = Clock::now();
+	for (unsigned i = 0; i < queries; ++i, found.clear())
+	{
+		ScanHeight(store, (double)i, (double)i + 1.0, found);
+		hits += found.size();
+	}
+	std::chrono::duration<double, std::milli> scanRange = Clock::now() - start;
+
+	start = Clock::now();
+	for (unsigned i = 0; i < queries; ++i, found.clear())
+	{
+		byHeight.Between((double)i, (double)i + 1.0, found);
+		hits -= found.size();
+	}
+	std::chrono::duration<double, std::milli> indexRange = Clock::now() - start;
+
+	if (hits != 0)
+		printf("Index lookups and scans found different counts\n");
+
+	printf("%u lookups over %u Things, ms (indexes built in %.2f):\n", queries, store.Size(), build.count());
+	printf("%18s %10s %10s\n", "", "scan", "index");
+	printf("%18s %10.2f %10.2f\n", "size ==", scanEqual.count(), indexEqual.count());
+	printf("%18s %10.2f %10.2f\n", "height in range", scanRange.count(), indexRange.count());
+	printf("\n");
+}
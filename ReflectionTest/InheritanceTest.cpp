@@ -0,0 +1,41 @@
+#include "Test.h"
+#include <iostream>
+
+void TestInheritance()
+{
+	using namespace std;
+
+	//DerivedTest : Test, Tagged. Base members are flattened with offsets relative to DerivedTest.
+	const meta::Type* type = meta::get<DerivedTest>();
+	cout << type->Name() << " has " << type->bases.size() << " bases and members: " << endl;
+
+	DerivedTest d;
+	d.a = 1;
+	d.b = 2;
+	d.tag = 3;
+	d.weight = 4.0f;
+
+	for (const meta::Member* m : type->members)
+	{
+		cout << "    " << m->TypeName() << " " << m->Name() << " @" << m->Offset() << endl;
+	}
+
+	//offsets must match where the compiler put the base subobjects
+	const char* base = reinterpret_cast<const char*>(&d);
+	if (type->mamberNames.at("a")->Offset() != (unsigned)(reinterpret_cast<const char*>(&d.a) - base))
+		printf("DerivedTest::a has the wrong offset\n");
+	if (type->mamberNames.at("tag")->Offset() != (unsigned)(reinterpret_cast<const char*>(&d.tag) - base))
+		printf("DerivedTest::tag has the wrong offset\n");
+	if (type->mamberNames.at("weight")->Offset() != (unsigned)(reinterpret_cast<const char*>(&d.weight) - base))
+		printf("DerivedTest::weight has the wrong offset\n");
+
+	//LateDerived registers before its base LateBase, whose members still come ahead of its own
+	const meta::Type* late = meta::get<LateDerived>();
+	LateDerived l;
+	const char* lateBase = reinterpret_cast<const char*>(&l);
+	if (late->members.size() != 4 || late->members[0]->Name() != "tag" || late->members[1]->Name() != "early" || late->members[3]->Name() != "own" ||
+		late->mamberNames.count("late") == 0 || late->mamberNames.at("late")->Offset() != (unsigned)(reinterpret_cast<const char*>(&l.late) - lateBase))
+		printf("LateDerived didn't inherit the members of a base registered after it\n");
+
+	cout << endl;
+}
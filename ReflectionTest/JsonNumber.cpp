@@ -0,0 +1,348 @@
+#include "JsonNumber.h"
+#include <cfloat>
+#include <climits>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+//x87 code keeps doubles in wider registers and rounds them twice, so the fast path isn't exact there
+#if !defined(FLT_EVAL_METHOD) || FLT_EVAL_METHOD == 0 || FLT_EVAL_METHOD == 1
+#define META_CLINGER 1
+#endif
+
+//eight digits are read as one little endian word
+#if defined(_M_IX86) || defined(_M_X64) || (defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__)
+#define META_SWAR_DIGITS 1
+#endif
+
+namespace meta
+{
+	namespace
+	{
+		//the powers of ten that are exact doubles
+		const double powers[] =
+		{
+			1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+			1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+		};
+
+		const unsigned long long integerPowers[] =
+		{
+			1ULL, 10ULL, 100ULL, 1000ULL, 10000ULL, 100000ULL, 1000000ULL, 10000000ULL, 100000000ULL,
+			1000000000ULL, 10000000000ULL, 100000000000ULL, 1000000000000ULL, 10000000000000ULL,
+			100000000000000ULL, 1000000000000000ULL
+		};
+
+		const unsigned long long exactMantissa = 1ULL << 53;
+
+#if META_SWAR_DIGITS
+		//every byte is '0' to '9': the high nibbles are all 3, and adding 6 carries out of none of the low ones
+		bool IsEightDigits(unsigned long long chunk)
+		{
+			return ((chunk & 0xF0F0F0F0F0F0F0F0ULL) | (((chunk + 0x0606060606060606ULL) & 0xF0F0F0F0F0F0F0F0ULL) >> 4)) == 0x3333333333333333ULL;
+		}
+
+		//pairs of digits, then pairs of pairs, combined in place by multiplies
+		unsigned EightDigits(unsigned long long chunk)
+		{
+			chunk -= 0x3030303030303030ULL;
+			chunk = chunk * 10 + (chunk >> 8);
+			chunk = ((chunk & 0x000000FF000000FFULL) * (100 + (1000000ULL << 32)) +
+				((chunk >> 16) & 0x000000FF000000FFULL) * (1 + (10000ULL << 32))) >> 32;
+			return (unsigned)chunk;
+		}
+#endif
+
+		//the digits at onto mantissa, which wraps past 20 digits; returns the end of them
+		const char* Digits(const char* at, const char* end, unsigned long long& mantissa)
+		{
+#if META_SWAR_DIGITS
+			while (end - at >= 8)
+			{
+				unsigned long long chunk;
+				std::memcpy(&chunk, at, 8);
+				if (!IsEightDigits(chunk))
+				{
+					break;
+				}
+				mantissa = mantissa * 100000000 + EightDigits(chunk);
+				at += 8;
+			}
+#endif
+			for (; at < end && *at >= '0' && *at <= '9'; ++at)
+			{
+				mantissa = mantissa * 10 + (unsigned)(*at - '0');
+			}
+			return at;
+		}
+
+		//digits from the first that isn't a zero, over the digits and point of a mantissa
+		size_t Significant(const char* at, const char* end)
+		{
+			for (; at < end && (*at == '0' || *at == '.'); ++at)
+			{
+			}
+			size_t count = 0;
+			for (; at < end; ++at)
+			{
+				if (*at >= '0' && *at <= '9')
+					++count;
+				else if (*at != '.')
+					break;
+			}
+			return count;
+		}
+
+		//mantissa * 10^exponent
+		struct Decimal
+		{
+			unsigned long long mantissa;
+			int exponent;
+			bool negative;
+			bool integral;	//no fraction or exponent
+			bool exact;		//no more than 19 significant digits, so the mantissa didn't wrap
+		};
+
+		const char* Scan(const char* at, const char* end, Decimal& decimal)
+		{
+			decimal.mantissa = 0;
+			decimal.exponent = 0;
+			decimal.negative = false;
+			decimal.integral = true;
+
+			if (at < end && *at == '-')
+			{
+				decimal.negative = true;
+				++at;
+			}
+
+			const char* digits = at;
+			at = Digits(at, end, decimal.mantissa);
+			if (at == digits)
+			{
+				return NULL;
+			}
+			size_t count = at - digits;
+
+			if (at < end && *at == '.')
+			{
+				const char* fraction = ++at;
+				at = Digits(at, end, decimal.mantissa);
+				if (at == fraction)
+				{
+					return NULL;
+				}
+				decimal.exponent = -(int)(at - fraction);
+				decimal.integral = false;
+				count += at - fraction;
+			}
+			decimal.exact = count <= 19 || Significant(digits, at) <= 19;
+
+			if (at < end && (*at == 'e' || *at == 'E'))
+			{
+				decimal.integral = false;
+				++at;
+				bool negative = false;
+				if (at < end && (*at == '-' || *at == '+'))
+				{
+					negative = *at == '-';
+					++at;
+				}
+
+				//past any double's range either way, so larger exponents needn't be exact
+				const char* exponentDigits = at;
+				int exponent = 0;
+				for (; at < end && *at >= '0' && *at <= '9'; ++at)
+				{
+					if (exponent < 100000)
+						exponent = exponent * 10 + (*at - '0');
+				}
+				if (at == exponentDigits)
+				{
+					return NULL;
+				}
+				decimal.exponent += negative ? -exponent : exponent;
+			}
+			return at;
+		}
+
+		//Clinger's fast path: an exact mantissa and an exact power of ten round once, correctly
+		bool FastDouble(const Decimal& decimal, double& value)
+		{
+#if META_CLINGER
+			if (!decimal.exact)
+			{
+				return false;
+			}
+			if (decimal.mantissa == 0)
+			{
+				value = decimal.negative ? -0.0 : 0.0;
+				return true;
+			}
+			if (decimal.mantissa > exactMantissa)
+			{
+				return false;
+			}
+
+			double real = (double)decimal.mantissa;
+			if (decimal.exponent < 0)
+			{
+				if (decimal.exponent < -22)
+				{
+					return false;
+				}
+				real /= powers[-decimal.exponent];
+			}
+			else if (decimal.exponent <= 22)
+			{
+				real *= powers[decimal.exponent];
+			}
+			else
+			{
+				//part of a larger power can move into the mantissa while it stays exact: 12e25 is 12000e22
+				int shift = decimal.exponent - 22;
+				if (shift > 15 || decimal.mantissa > exactMantissa / integerPowers[shift])
+				{
+					return false;
+				}
+				real = (double)(decimal.mantissa * integerPowers[shift]) * powers[22];
+			}
+
+			value = decimal.negative ? -real : real;
+			return true;
+#else
+			(void)decimal;
+			(void)value;
+			return false;
+#endif
+		}
+
+		//The nearest double, narrowed. That rounds twice, which only goes wrong when the double is
+		//exactly halfway between two floats (the low 29 of its 52 mantissa bits are 1 then 0s),
+		//since a halfway point is a double itself. Subnormal and overflowing floats go to strtof.
+		bool FastFloat(const Decimal& decimal, float& value)
+		{
+			double real;
+			if (!FastDouble(decimal, real))
+			{
+				return false;
+			}
+
+			double magnitude = real < 0.0 ? -real : real;
+			if (magnitude != 0.0 && (magnitude < FLT_MIN || magnitude > FLT_MAX))
+			{
+				return false;
+			}
+			unsigned long long bits;
+			std::memcpy(&bits, &real, sizeof(bits));
+			if ((bits & ((1ULL << 29) - 1)) == 1ULL << 28)
+			{
+				return false;
+			}
+
+			value = (float)real;
+			return true;
+		}
+
+		//the number copied out and NUL terminated for the C library
+		class Terminated
+		{
+		public:
+			Terminated(const char* text, const char* stop)
+			{
+				size_t length = stop - text;
+				if (length < sizeof(buffer))
+				{
+					std::memcpy(buffer, text, length);
+					buffer[length] = '\0';
+					str = buffer;
+				}
+				else
+				{
+					heap.assign(text, length);
+					str = heap.c_str();
+				}
+			}
+
+			const char* c_str(void) const { return str; }
+
+		private:
+			// Non-Copyable
+			Terminated(const Terminated&); // = delete
+			void operator=(const Terminated&); // = delete
+
+			char buffer[64];
+			std::string heap;
+			const char* str;
+		};
+
+		double Real(const char* text, const char* stop, const Decimal& decimal)
+		{
+			double value;
+			if (!FastDouble(decimal, value))
+			{
+				value = strtod(Terminated(text, stop).c_str(), NULL);
+			}
+			return value;
+		}
+	}
+
+	const char* ParseNumber(const char* text, const char* end, float& value)
+	{
+		Decimal decimal;
+		const char* stop = Scan(text, end, decimal);
+		if (stop != NULL && !FastFloat(decimal, value))
+		{
+			value = strtof(Terminated(text, stop).c_str(), NULL);
+		}
+		return stop;
+	}
+
+	const char* ParseNumber(const char* text, const char* end, double& value)
+	{
+		Decimal decimal;
+		const char* stop = Scan(text, end, decimal);
+		if (stop != NULL)
+		{
+			value = Real(text, stop, decimal);
+		}
+		return stop;
+	}
+
+	const char* ParseNumber(const char* text, const char* end, long long& value)
+	{
+		Decimal decimal;
+		const char* stop = Scan(text, end, decimal);
+		if (stop == NULL)
+		{
+			return NULL;
+		}
+
+		if (!decimal.integral)
+		{
+			//clamped first: converting a double out of range is undefined
+			double real = Real(text, stop, decimal);
+			if (real >= 9223372036854775807.0)
+				value = LLONG_MAX;
+			else if (real <= -9223372036854775808.0)
+				value = LLONG_MIN;
+			else
+				value = (long long)real;
+		}
+		else if (decimal.exact && decimal.mantissa <= (unsigned long long)LLONG_MAX)
+		{
+			value = decimal.negative ? -(long long)decimal.mantissa : (long long)decimal.mantissa;
+		}
+		else
+		{
+			value = strtoll(Terminated(text, stop).c_str(), NULL, 10);
+		}
+		return stop;
+	}
+
+	const char* SkipNumber(const char* text, const char* end)
+	{
+		Decimal decimal;
+		return Scan(text, end, decimal);
+	}
+}
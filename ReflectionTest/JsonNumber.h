@@ -0,0 +1,34 @@
+#pragma once
+
+#include <cstddef>
+
+namespace meta
+{
+	//////////////////////////////////////////////////////////////////////////////
+	//  Json numbers
+	//////////////////////////////////////////////////////////////////////////////
+	// Purpose: Converts json number text straight to the type of the member it lands in, without
+	//          copying it out to NUL terminate it. Digits are read eight at a time where eight are
+	//          there. A float is the nearest float to the text, like strtof's, rather than a double
+	//          narrowed to float (which can round twice); a double is the nearest double, like strtod's.
+	//
+	//          Decimals whose digits make an exact double (up to 2^53, about 15 digits) with a
+	//          power of ten up to 10^22 take Clinger's fast path: both are exact doubles, so one
+	//          multiply or divide rounds correctly. Everything else (long mantissas, large exponents, floats
+	//          that land halfway between two floats, subnormals) falls back to strtod/strtof.
+	//
+	//          Text follows the json grammar, except that leading zeros are allowed: an optional
+	//          minus, digits, an optional fraction and an optional exponent.
+
+	//Each returns the end of the number at text, or NULL (value untouched) if text up to end doesn't
+	//start with one. A fraction or exponent into an integer truncates toward zero; integers out of
+	//range clamp like strtoll's.
+	const char* ParseNumber(const char* text, const char* end, float& value);
+	const char* ParseNumber(const char* text, const char* end, double& value);
+	const char* ParseNumber(const char* text, const char* end, long long& value);
+
+	//the end of the number at text, or NULL, with nothing converted
+	const char* SkipNumber(const char* text, const char* end);
+}
+
+void TestJsonNumber();
@@ -0,0 +1,258 @@
+#include "JsonNumber.h"
+#include "MmapJson.h"
+#include "SerializationTest.h"
+#include "Test.h"
+#include "jansson.h"
+#include <chrono>
+#include <climits>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+
+namespace
+{
+	template <typename T>
+	bool SameBits(T lhs, T rhs)
+	{
+		return std::memcmp(&lhs, &rhs, sizeof(T)) == 0;
+	}
+
+	//ParseNumber against the C library on the same text; prints the first few that differ
+	unsigned Check(const char* text, unsigned failures)
+	{
+		const char* end = text + std::strlen(text);
+		float f = 0.0f;
+		double d = 0.0;
+		long long i = 0;
+		bool same = meta::ParseNumber(text, end, f) == end && SameBits(f, strtof(text, NULL)) &&
+			meta::ParseNumber(text, end, d) == end && SameBits(d, strtod(text, NULL));
+		if (same && std::strpbrk(text, ".eE") == NULL)
+			same = meta::ParseNumber(text, end, i) == end && i == strtoll(text, NULL, 10);
+
+		if (!same && failures < 5)
+			printf("%s parsed to %.9g %.17g %lld, not %.9g %.17g\n", text, f, d, i, strtof(text, NULL), strtod(text, NULL));
+		return same ? failures : failures + 1;
+	}
+
+	//random digits with the point anywhere and any exponent, past both ends of the double range
+	void RandomDecimal(std::mt19937& random, char* text)
+	{
+		char* at = text;
+		if (random() & 1)
+			*at++ = '-';
+		unsigned digits = 1 + random() % 25;
+		unsigned point = random() % (digits + 1);
+		for (unsigned i = 0; i < digits; ++i)
+		{
+			if (i == point && i > 0)
+				*at++ = '.';
+			*at++ = (char)('0' + random() % 10);
+		}
+		if (random() % 3 == 0)
+			at += sprintf(at, "e%d", (int)(random() % 680) - 340);
+		*at = '\0';
+	}
+}
+
+void TestJsonNumber()
+{
+	typedef std::chrono::high_resolution_clock Clock;
+	typedef std::chrono::duration<double, std::milli> Milliseconds;
+
+	//edges: zeros, the fast path's limits, float and double halfway points, subnormals, overflow
+	const char* edges[] =
+	{
+		"0", "-0", "0.0", "-0.0e5", "0e999", "1", "-1", "007", "0.1", "0.2", "0.3", "3.14159265358979323846", "123456789012345678",
+		"9007199254740992", "9007199254740993", "9007199254740993e-22", "1e22", "1e23", "123e25", "12345678901234567e22",
+		"1e-22", "1e-23", "16777216", "16777217", "16777219", "1.00000005960464477539062500", "3.4028235e38", "3.4028236e38",
+		"1.1754943e-38", "1e-45", "1.4e-45", "1e-46", "2.2250738585072014e-308", "4.9e-324", "2e-324", "1.7976931348623157e308",
+		"1e309", "-1e400", "1e-400", "9223372036854775807", "9223372036854775808", "-9223372036854775808", "-9223372036854775809",
+		"18446744073709551616", "0.000000000000000000000000000012345", "1234567890123456789012345678901234567890",
+		"2.50000000000000000000000000000000000000000000000000000000000000000000000000000001"
+	};
+	unsigned failures = 0;
+	for (unsigned i = 0; i < sizeof(edges) / sizeof(edges[0]); ++i)
+		failures = Check(edges[i], failures);
+
+	//not numbers, and numbers that end before the text does
+	const char* malformed[] = { "", "-", "+1", ".5", "1.", "1.e5", "1e", "1e+", "-x", "e5" };
+	for (unsigned i = 0; i < sizeof(malformed) / sizeof(malformed[0]); ++i)
+	{
+		double d = 7.0;
+		if (meta::ParseNumber(malformed[i], malformed[i] + std::strlen(malformed[i]), d) != NULL || d != 7.0)
+			printf("\"%s\" parsed as a number\n", malformed[i]);
+	}
+	{
+		const char* text = "12345678.5e3, 9";
+		float f;
+		long long i;
+		if (meta::ParseNumber(text, text + 4, i) != text + 4 || i != 1234 || meta::ParseNumber(text, text + std::strlen(text), f) != text + 12 ||
+			f != 12345678500.0f || meta::ParseNumber("-2.75e0", "-2.75e0" + 7, i) == NULL || i != -2 || meta::ParseNumber("1e30", "1e30" + 4, i) == NULL || i != LLONG_MAX)
+			printf("Numbers didn't stop at the end of their text, or truncate into integers\n");
+	}
+
+	//random doubles and floats written out shortest-ish, and random decimals, against strtod and strtof
+	std::mt19937 random(48);
+	const unsigned rounds = 300000;
+	char text[128];
+	for (unsigned r = 0; r < rounds; ++r)
+	{
+		switch (r % 4)
+		{
+			case 0:
+			{
+				unsigned long long bits = ((unsigned long long)random() << 32) | random();
+				double d;
+				std::memcpy(&d, &bits, sizeof(d));
+				if (d != d || d - d != 0.0)
+					d = (double)bits;
+				sprintf(text, "%.17g", d);
+			}
+				break;
+			case 1:
+			{
+				unsigned bits = (unsigned)random();
+				float f;
+				std::memcpy(&f, &bits, sizeof(f));
+				if (f != f || f - f != 0.0f)
+					f = (float)bits;
+				sprintf(text, random() & 1 ? "%.9g" : "%.7g", f);
+			}
+				break;
+			case 2:
+				RandomDecimal(random, text);
+				break;
+			default:
+				sprintf(text, "%lld", (long long)(((unsigned long long)random() << 32) | random()) >> (random() % 64));
+				break;
+		}
+		failures = Check(text, failures);
+	}
+	if (failures > 0)
+		printf("%u of %u numbers didn't match the C library\n", failures, rounds);
+
+	//throughput on the kind of numbers positions and radii hold, one buffer of them
+	const unsigned count = 1000000;
+	std::string reals, integers;
+	for (unsigned i = 0; i < count; ++i)
+	{
+		sprintf(text, "%.*f,", (int)(random() % 7), (double)(int)(random() % 2000000 - 1000000) / 64.0);
+		reals += text;
+		sprintf(text, "%d,", (int)(random() % 2000000) - 1000000);
+		integers += text;
+	}
+
+	//the same sums both ways, so neither loop is optimized away
+	double sums[4] = { 0.0, 0.0, 0.0, 0.0 };
+	Clock::time_point start = Clock::now();
+	for (const char* at = reals.c_str(); *at != '\0'; ++at)
+	{
+		char* stop;
+		sums[0] += (float)strtod(at, &stop);
+		at = stop;
+	}
+	Milliseconds narrowed = Clock::now() - start;
+
+	start = Clock::now();
+	for (const char* at = reals.c_str(), *end = at + reals.size(); at < end; ++at)
+	{
+		float f = 0.0f;
+		at = meta::ParseNumber(at, end, f);
+		sums[1] += f;
+	}
+	Milliseconds floats = Clock::now() - start;
+
+	start = Clock::now();
+	for (const char* at = reals.c_str(); *at != '\0'; ++at)
+	{
+		char* stop;
+		sums[2] += strtod(at, &stop);
+		at = stop;
+	}
+	Milliseconds libraryDoubles = Clock::now() - start;
+
+	start = Clock::now();
+	for (const char* at = reals.c_str(), *end = at + reals.size(); at < end; ++at)
+	{
+		double d = 0.0;
+		at = meta::ParseNumber(at, end, d);
+		sums[3] += d;
+	}
+	Milliseconds doubles = Clock::now() - start;
+
+	long long totals[2] = { 0, 0 };
+	start = Clock::now();
+	for (const char* at = integers.c_str(); *at != '\0'; ++at)
+	{
+		char* stop;
+		totals[0] += strtoll(at, &stop, 10);
+		at = stop;
+	}
+	Milliseconds libraryIntegers = Clock::now() - start;
+
+	start = Clock::now();
+	for (const char* at = integers.c_str(), *end = at + integers.size(); at < end; ++at)
+	{
+		long long i = 0;
+		at = meta::ParseNumber(at, end, i);
+		totals[1] += i;
+	}
+	Milliseconds parsedIntegers = Clock::now() - start;
+
+	if (std::abs(sums[0] - sums[1]) > std::abs(sums[0]) * 1e-12 || sums[2] != sums[3] || totals[0] != totals[1])
+		printf("ParseNumber's sums differ from the C library's\n");
+
+	//a numeric heavy document through jansson and in situ
+	const unsigned bodies = 100000;
+	std::string json = "[\n";
+	for (unsigned i = 0; i < bodies; ++i)
+	{
+		sprintf(text, "\t{ \"id\": %u, \"x\": %.4f, \"y\": %.4f, \"z\": %.4f, \"radius\": %.2f, \"mass\": %.9g, \"charge\": %.3e }%s\n",
+			i, (int)(random() % 200000) / 100.0 - 1000.0, (int)(random() % 200000) / 100.0 - 1000.0, (int)(random() % 2000) / 7.0,
+			(random() % 1000) / 100.0, 1.0 + random() / 4294967296.0, (random() % 1000) / 997.0 - 0.5, i + 1 < bodies ? "," : "");
+		json += text;
+	}
+	json += "]\n";
+
+	std::vector<Body> janssonBodies(bodies);
+	start = Clock::now();
+	json_error_t error;
+	json_t* array = json_loads(json.c_str(), 0, &error);
+	for (unsigned i = 0; i < json_array_size(array); ++i)
+		DeSerializeJsonObject(json_array_get(array, i), &janssonBodies[i], "Body");
+	json_decref(array);
+	Milliseconds jansson = Clock::now() - start;
+
+	std::vector<Body> inSitu(bodies);
+	meta::StringPool pool;
+	std::string copy = json;
+	start = Clock::now();
+	unsigned loaded = meta::ParseJsonArrayInSitu(&copy[0], copy.size(), meta::get<Body>(), inSitu.data(), bodies, pool);
+	Milliseconds inSituParse = Clock::now() - start;
+
+	//jansson narrows its doubles, so floats can differ from the nearest float in the last bit
+	bool same = loaded == bodies;
+	for (unsigned i = 0; same && i < bodies; ++i)
+	{
+		const Body& lhs = janssonBodies[i];
+		const Body& rhs = inSitu[i];
+		same = lhs.id == rhs.id && lhs.mass == rhs.mass && lhs.charge == rhs.charge && std::abs(lhs.x - rhs.x) <= std::abs(lhs.x) * 1e-7f &&
+			std::abs(lhs.z - rhs.z) <= std::abs(lhs.z) * 1e-7f && std::abs(lhs.radius - rhs.radius) <= lhs.radius * 1e-7f;
+	}
+	if (!same)
+		printf("In-situ Bodies don't match jansson's (%u loaded)\n", loaded);
+
+	double megabytes = json.size() / (1024.0 * 1024.0);
+	printf("Parsing %u numbers, ms (library: strtod then narrowed, strtod, strtoll):\n", count);
+	printf("%18s %8s %8s\n", "", "library", "parsed");
+	printf("%18s %8.2f %8.2f\n", "float", narrowed.count(), floats.count());
+	printf("%18s %8.2f %8.2f\n", "double", libraryDoubles.count(), doubles.count());
+	printf("%18s %8.2f %8.2f\n", "integer", libraryIntegers.count(), parsedIntegers.count());
+	printf("Loading %u Bodies (%.1f MB), ms:\n", bodies, megabytes);
+	printf("%18s %8s %8s\n", "", "load", "MB/s");
+	printf("%18s %8.2f %8.1f\n", "jansson", jansson.count(), megabytes / (jansson.count() / 1000.0));
+	printf("%18s %8.2f %8.1f\n", "in situ", inSituParse.count(), megabytes / (inSituParse.count() / 1000.0));
+	printf("\n");
+}
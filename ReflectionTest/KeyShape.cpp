@@ -0,0 +1,65 @@
+#include "KeyShape.h"
+#include <mutex>
+
+namespace meta
+{
+	namespace
+	{
+		std::mutex shapeMutex;
+	}
+
+	KeyShape::KeyShape(const Type* type) :
+		type(type),
+		slots(NULL),
+		capacity((unsigned)type->members.size())
+	{
+		slots = new std::atomic<const Member*>[capacity > 0 ? capacity : 1];
+		for (unsigned i = 0; i < capacity; ++i)
+		{
+			slots[i].store(NULL, std::memory_order_relaxed);
+		}
+		misses.store(0, std::memory_order_relaxed);
+	}
+
+	KeyShape::~KeyShape()
+	{
+		delete[] slots;
+	}
+
+	const Member* KeyShape::Miss(unsigned position, const char* key)
+	{
+		misses.fetch_add(1, std::memory_order_relaxed);
+
+		std::unordered_map<std::string, const Member *>::const_iterator found = type->mamberNames.find(key);
+		if (found == type->mamberNames.end())
+		{
+			return NULL;
+		}
+
+		if (position < capacity)
+		{
+			slots[position].store(found->second, std::memory_order_relaxed);
+		}
+		return found->second;
+	}
+
+	KeyShape& GetKeyShape(const Type* type)
+	{
+		KeyShape* shape = type->keyShape.load(std::memory_order_acquire);
+		if (shape != NULL)
+		{
+			return *shape;
+		}
+
+		//types are registered before threads start, so only the first build needs guarding;
+		//the release store publishes the shape whole to threads that load it without the lock
+		std::lock_guard<std::mutex> lock(shapeMutex);
+		shape = type->keyShape.load(std::memory_order_relaxed);
+		if (shape == NULL)
+		{
+			shape = new KeyShape(type);
+			type->keyShape.store(shape, std::memory_order_release);
+		}
+		return *shape;
+	}
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include "Meta.h"
+#include <atomic>
+
+namespace meta
+{
+	//////////////////////////////////////////////////////////////////////////////
+	//  KeyShape
+	//////////////////////////////////////////////////////////////////////////////
+	// Purpose: The order in which a type's members last arrived from a keyed format like json.
+	//          Arrays of records list their keys in the same order, so the member at each key
+	//          position is predicted and checked with one string compare. The member name hash
+	//          is only used on a miss, which also updates the prediction.
+	//
+	//          Predictions are single pointers stored relaxed, so loaders on several threads
+	//          share a shape; a race costs at most another miss.
+	class KeyShape
+	{
+	public:
+		KeyShape(const Type* type);
+		~KeyShape();
+
+		//the member named key, found as the position-th key of an object. NULL if the type has no such member.
+		const Member* Find(unsigned position, const char* key)
+		{
+			if (position < capacity)
+			{
+				const Member* predicted = slots[position].load(std::memory_order_relaxed);
+				if (predicted != NULL && std::strcmp(predicted->Name().c_str(), key) == 0)
+				{
+					return predicted;
+				}
+			}
+			return Miss(position, key);
+		}
+
+		//lookups that went to the hash
+		unsigned long long Misses(void) const { return misses.load(std::memory_order_relaxed); }
+
+	private:
+		// Non-Copyable
+		KeyShape(const KeyShape&); // = delete
+		void operator=(const KeyShape&); // = delete
+
+		const Member* Miss(unsigned position, const char* key);
+
+		const Type* type;
+		std::atomic<const Member*>* slots;
+		unsigned capacity;
+		std::atomic<unsigned long long> misses;
+	};
+
+	//Built on first use and cached on the type.
+	KeyShape& GetKeyShape(const Type* type);
+}
+
+void TestKeyShape();
@@ -0,0 +1,115 @@
+#include "KeyShape.h"
+#include "SerializationTest.h"
+#include "jansson.h"
+#include <chrono>
+
+void TestKeyShape()
+{
+	typedef std::chrono::high_resolution_clock Clock;
+
+	//a data file's worth of Thing records, every one listing its keys in the same order
+	const unsigned count = 100000;
+	json_t* array = json_array();
+	for (unsigned i = 0; i < count; ++i)
+	{
+		Thing thing = Thing();
+		thing.id = i;
+		thing.name = "Thing";
+		thing.position = Vector3((float)i, 0.0f, 0.0f);
+		json_array_append_new(array, SerializeJsonObject(&thing, "Thing"));
+	}
+
+	const meta::Type* thingType = meta::get<Thing>();
+	meta::KeyShape& shape = meta::GetKeyShape(thingType);
+	meta::KeyShape& vectorShape = meta::GetKeyShape(meta::get<Vector3>());
+	unsigned long long missesBefore = shape.Misses() + vectorShape.Misses();
+
+	std::vector<Thing> things(count, Thing());
+	Clock::time_point start = Clock::now();
+	for (unsigned i = 0; i < count; ++i)
+		DeSerializeJsonObject(json_array_get(array, i), &things[i], "Thing");
+	std::chrono::duration<double, std::milli> loaded = Clock::now() - start;
+
+	unsigned long long misses = shape.Misses() + vectorShape.Misses() - missesBefore;
+	unsigned long long keys = (unsigned long long)count * (thingType->members.size() + meta::get<Vector3>()->members.size());
+	if (things[count - 1].id != count - 1 || things[count - 1].position.x != (float)(count - 1))
+		printf("DeSerializeJsonObject didn't load Thing through its key shape\n");
+	if (misses > thingType->members.size() + 3)
+		printf("Thing key shape missed %llu times on uniform records\n", misses);
+
+	const char* key;
+	json_t* value;
+
+	//the same records without stamps take the migrating path, which predicts members the same way.
+	//their keys are listed in reverse so the first record has to retrain the shape
+	json_t* unstamped = json_array();
+	for (unsigned i = 0; i < 1000; ++i)
+	{
+		std::vector<const char*> keys;
+		json_object_foreach(json_array_get(array, i), key, value)
+		{
+			if (key[0] != '$')
+				keys.push_back(key);
+		}
+
+		json_t* record = json_object();
+		for (size_t k = keys.size(); k-- > 0;)
+			json_object_set(record, keys[k], json_object_get(json_array_get(array, i), keys[k]));
+		json_array_append_new(unstamped, record);
+	}
+
+	missesBefore = shape.Misses() + vectorShape.Misses();
+	for (unsigned i = 0; i < json_array_size(unstamped); ++i)
+		DeSerializeJsonObject(json_array_get(unstamped, i), &things[i], "Thing");
+	unsigned long long unstampedMisses = shape.Misses() + vectorShape.Misses() - missesBefore;
+	json_decref(unstamped);
+
+	if (things[999].id != 999 || things[999].position.x != 999.0f)
+		printf("DeSerializeJsonObject didn't load unstamped Thing records\n");
+	if (unstampedMisses == 0 || unstampedMisses > thingType->members.size() + 3)
+		printf("Thing key shape missed %llu times on uniform unstamped records\n", unstampedMisses);
+
+	//the member lookups alone: name hash vs predicted member
+	size_t found = 0;
+
+	//walking the keys without looking them up, the part both lookups share
+	start = Clock::now();
+	for (unsigned i = 0; i < count; ++i)
+	{
+		json_object_foreach(json_array_get(array, i), key, value)
+			found += key[0] != '$';
+	}
+	std::chrono::duration<double, std::milli> walked = Clock::now() - start;
+
+	start = Clock::now();
+	for (unsigned i = 0; i < count; ++i)
+	{
+		json_object_foreach(json_array_get(array, i), key, value)
+		{
+			if (key[0] != '$')
+				found += thingType->mamberNames.count(key);
+		}
+	}
+	std::chrono::duration<double, std::milli> hashed = Clock::now() - start;
+
+	start = Clock::now();
+	for (unsigned i = 0; i < count; ++i)
+	{
+		unsigned position = 0;
+		json_object_foreach(json_array_get(array, i), key, value)
+		{
+			if (key[0] != '$')
+				found += shape.Find(position++, key) != NULL;
+		}
+	}
+	std::chrono::duration<double, std::milli> predicted = Clock::now() - start;
+
+	json_decref(array);
+
+	printf("Loading %u Thing records: %llu of %llu member keys hashed (%u found)\n", count, misses, keys, (unsigned)found);
+	printf("%18s %8.2f ms\n", "load", loaded.count());
+	printf("%18s %8.2f ms\n", "walk keys", walked.count());
+	printf("%18s %8.2f ms\n", "+ hash lookups", hashed.count());
+	printf("%18s %8.2f ms\n", "+ shape lookups", predicted.count());
+	printf("\n");
+}
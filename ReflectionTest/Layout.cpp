@@ -0,0 +1,324 @@
+#include "Layout.h"
+#include <algorithm>
+#include <cstdio>
+
+namespace meta
+{
+	namespace
+	{
+		unsigned AlignUp(unsigned offset, unsigned alignment)
+		{
+			alignment = alignment > 0 ? alignment : 1;
+			return (offset + alignment - 1) / alignment * alignment;
+		}
+
+		bool ByOffset(const Member* lhs, const Member* rhs)
+		{
+			return lhs->Offset() < rhs->Offset();
+		}
+
+		//widest alignment first, then largest, so small members fill the gaps big ones leave
+		bool ByAlignment(const Member* lhs, const Member* rhs)
+		{
+			if (lhs->Meta()->Alignment() != rhs->Meta()->Alignment())
+			{
+				return lhs->Meta()->Alignment() > rhs->Meta()->Alignment();
+			}
+			return lhs->Meta()->Size() > rhs->Meta()->Size();
+		}
+
+		//where the bases end; members before it can't move
+		unsigned BasesEnd(const Type* type)
+		{
+			unsigned end = 0;
+			for (unsigned i = 0; i < type->bases.size(); ++i)
+			{
+				end = std::max(end, type->bases[i].offset + type->bases[i].type->Size());
+			}
+			return end;
+		}
+
+		//first fit: the lowest aligned offset from start that overlaps nothing placed
+		unsigned FirstFit(const std::vector<LayoutHole>& placed, unsigned start, unsigned size, unsigned alignment)
+		{
+			unsigned offset = AlignUp(start, alignment);
+			for (unsigned i = 0; i < placed.size(); ++i)
+			{
+				const LayoutHole& taken = placed[i];
+				if (offset < taken.offset + taken.size && taken.offset < offset + size)
+				{
+					offset = AlignUp(taken.offset + taken.size, alignment);
+					i = ~0u; //look again from the first
+				}
+			}
+			return offset;
+		}
+
+		struct Run
+		{
+			unsigned offset;
+			unsigned size;
+		};
+
+		bool RunOrder(const Run& lhs, const Run& rhs)
+		{
+			return lhs.offset < rhs.offset;
+		}
+
+		bool CollectRuns(const Type* type, unsigned base, std::vector<Run>& runs)
+		{
+			for (unsigned i = 0; i < type->members.size(); ++i)
+			{
+				const Member* member = type->members[i];
+				const Type* leaf = member->Meta();
+				if (leaf == NULL)
+				{
+					continue;
+				}
+				if (!leaf->members.empty())
+				{
+					if (!CollectRuns(leaf, base + member->Offset(), runs))
+					{
+						return false;
+					}
+				}
+				else if (!leaf->IsTriviallyCopyable())
+				{
+					return false;
+				}
+				else if (leaf->Size() > 0)
+				{
+					Run run = { base + member->Offset(), leaf->Size() };
+					runs.push_back(run);
+				}
+			}
+			return true;
+		}
+
+		//the byte runs of a packed object, adjacent members merged
+		bool PackedRuns(const Type* type, std::vector<Run>& runs)
+		{
+			std::vector<Run> leaves;
+			if (!CollectRuns(type, 0, leaves))
+			{
+				return false;
+			}
+			std::sort(leaves.begin(), leaves.end(), RunOrder);
+
+			for (unsigned i = 0; i < leaves.size(); ++i)
+			{
+				if (!runs.empty() && runs.back().offset + runs.back().size >= leaves[i].offset)
+				{
+					unsigned end = std::max(runs.back().offset + runs.back().size, leaves[i].offset + leaves[i].size);
+					runs.back().size = end - runs.back().offset;
+				}
+				else
+				{
+					runs.push_back(leaves[i]);
+				}
+			}
+			return true;
+		}
+	}
+
+	void AnalyzeLayout(const Type* type, TypeLayout& layout)
+	{
+		layout.type = type;
+		layout.size = type->Size();
+		layout.padding = 0;
+		layout.holes.clear();
+		layout.suggestedOrder.clear();
+
+		std::vector<const Member*> members;
+		for (unsigned i = 0; i < type->members.size(); ++i)
+		{
+			if (type->members[i]->Meta() != NULL)
+			{
+				members.push_back(type->members[i]);
+			}
+		}
+
+		//holes, walking the members in memory order
+		std::stable_sort(members.begin(), members.end(), ByOffset);
+		unsigned end = 0;
+		for (unsigned i = 0; i < members.size(); ++i)
+		{
+			unsigned begin = members[i]->Offset();
+			if (begin > end)
+			{
+				LayoutHole hole = { end, begin - end };
+				layout.holes.push_back(hole);
+			}
+			end = std::max(end, begin + members[i]->Meta()->Size());
+		}
+		if (layout.size > end)
+		{
+			LayoutHole hole = { end, layout.size - end };
+			layout.holes.push_back(hole);
+		}
+		for (unsigned i = 0; i < layout.holes.size(); ++i)
+		{
+			layout.padding += layout.holes[i].size;
+		}
+
+		//the type's own members, placed first fit after the bases
+		unsigned basesEnd = BasesEnd(type);
+		std::vector<const Member*> own;
+		std::vector<LayoutHole> placed;
+		for (unsigned i = 0; i < members.size(); ++i)
+		{
+			if (members[i]->Offset() >= basesEnd)
+			{
+				own.push_back(members[i]);
+			}
+		}
+		if (basesEnd > 0)
+		{
+			LayoutHole bases = { 0, basesEnd };
+			placed.push_back(bases);
+		}
+
+		std::stable_sort(own.begin(), own.end(), ByAlignment);
+		std::vector<std::pair<unsigned, const Member*> > suggested;
+		unsigned suggestedEnd = basesEnd;
+		for (unsigned i = 0; i < own.size(); ++i)
+		{
+			const Type* leaf = own[i]->Meta();
+			unsigned offset = FirstFit(placed, basesEnd, leaf->Size(), leaf->Alignment());
+			LayoutHole taken = { offset, leaf->Size() };
+			placed.push_back(taken);
+			suggested.push_back(std::make_pair(offset, own[i]));
+			suggestedEnd = std::max(suggestedEnd, offset + leaf->Size());
+		}
+
+		std::stable_sort(suggested.begin(), suggested.end());
+		for (unsigned i = 0; i < suggested.size(); ++i)
+		{
+			layout.suggestedOrder.push_back(suggested[i].second);
+		}
+		layout.suggestedSize = std::min(layout.size, AlignUp(suggestedEnd, type->Alignment()));
+	}
+
+	void AnalyzeLayouts(std::vector<TypeLayout>& layouts)
+	{
+		std::vector<std::pair<std::string, const Type*> > types;
+		const Meta::MetaMap& map = Meta::GetMap();
+		for (Meta::MetaMap::const_iterator it = map.begin(); it != map.end(); ++it)
+		{
+			if (!it->second->members.empty())
+			{
+				types.push_back(std::make_pair(it->first, it->second));
+			}
+		}
+		std::sort(types.begin(), types.end());
+
+		layouts.resize(types.size());
+		for (unsigned i = 0; i < types.size(); ++i)
+		{
+			AnalyzeLayout(types[i].second, layouts[i]);
+		}
+	}
+
+	void WriteLayoutReport(std::string& out)
+	{
+		std::vector<TypeLayout> layouts;
+		AnalyzeLayouts(layouts);
+
+		char line[256];
+		sprintf(line, "%18s %8s %8s %10s  %s\n", "type", "size", "padding", "reordered", "holes (offset+size)");
+		out = line;
+
+		unsigned size = 0, padding = 0, reordered = 0;
+		for (unsigned i = 0; i < layouts.size(); ++i)
+		{
+			const TypeLayout& layout = layouts[i];
+			size += layout.size;
+			padding += layout.padding;
+			reordered += layout.suggestedSize;
+
+			sprintf(line, "%18s %8u %8u %10u", layout.type->Name().c_str(), layout.size, layout.padding, layout.suggestedSize);
+			out += line;
+			for (unsigned h = 0; h < layout.holes.size(); ++h)
+			{
+				sprintf(line, h == 0 ? "  %u+%u" : " %u+%u", layout.holes[h].offset, layout.holes[h].size);
+				out += line;
+			}
+			out += "\n";
+
+			if (layout.suggestedSize < layout.size)
+			{
+				out += "                   reorder:";
+				for (unsigned m = 0; m < layout.suggestedOrder.size(); ++m)
+				{
+					out += (m > 0 ? ", " : " ") + layout.suggestedOrder[m]->Name();
+				}
+				out += "\n";
+			}
+		}
+
+		sprintf(line, "%18s %8u %8u %10u\n", "total", size, padding, reordered);
+		out += line;
+	}
+
+	unsigned PackedSize(const Type* type)
+	{
+		std::vector<Run> runs;
+		if (!PackedRuns(type, runs))
+		{
+			return 0;
+		}
+
+		unsigned size = 0;
+		for (unsigned i = 0; i < runs.size(); ++i)
+		{
+			size += runs[i].size;
+		}
+		return size;
+	}
+
+	bool PackObjects(const Type* type, const void* objects, unsigned count, void* out, unsigned stride)
+	{
+		std::vector<Run> runs;
+		if (!PackedRuns(type, runs))
+		{
+			std::cout << type->Name() << " has members that can't be packed as bytes" << std::endl;
+			return false;
+		}
+
+		stride = stride != 0 ? stride : type->Size();
+		const char* object = static_cast<const char*>(objects);
+		char* to = static_cast<char*>(out);
+		for (unsigned i = 0; i < count; ++i, object += stride)
+		{
+			for (unsigned r = 0; r < runs.size(); ++r)
+			{
+				std::memcpy(to, object + runs[r].offset, runs[r].size);
+				to += runs[r].size;
+			}
+		}
+		return true;
+	}
+
+	bool UnpackObjects(const Type* type, const void* in, unsigned count, void* objects, unsigned stride)
+	{
+		std::vector<Run> runs;
+		if (!PackedRuns(type, runs))
+		{
+			std::cout << type->Name() << " has members that can't be packed as bytes" << std::endl;
+			return false;
+		}
+
+		stride = stride != 0 ? stride : type->Size();
+		const char* from = static_cast<const char*>(in);
+		char* object = static_cast<char*>(objects);
+		for (unsigned i = 0; i < count; ++i, object += stride)
+		{
+			for (unsigned r = 0; r < runs.size(); ++r)
+			{
+				std::memcpy(object + runs[r].offset, from, runs[r].size);
+				from += runs[r].size;
+			}
+		}
+		return true;
+	}
+}
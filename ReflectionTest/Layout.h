@@ -0,0 +1,62 @@
+#pragma once
+
+#include "Meta.h"
+
+namespace meta
+{
+	//////////////////////////////////////////////////////////////////////////////
+	//  Layout Analysis
+	//////////////////////////////////////////////////////////////////////////////
+	// Purpose: Finds the bytes of a type that no registered member covers, from the member
+	//          offsets and sizes the type already knows, and suggests a member order that needs
+	//          fewer. Those bytes are mostly padding, but vtable pointers and members that were
+	//          never registered count too. Members inherited from bases stay where they are; a
+	//          nested value type's own padding is reported under that type.
+
+	struct LayoutHole
+	{
+		unsigned offset;
+		unsigned size;
+	};
+
+	struct TypeLayout
+	{
+		const Type* type;
+		unsigned size;
+		unsigned padding; //bytes no member covers, holes included
+		std::vector<LayoutHole> holes;
+
+		//the type's own members, largest alignment first, each at the lowest offset it fits
+		std::vector<const Member*> suggestedOrder;
+		unsigned suggestedSize; //size with that order, never more than size
+	};
+
+	void AnalyzeLayout(const Type* type, TypeLayout& layout);
+
+	//every registered type that has members, by name
+	void AnalyzeLayouts(std::vector<TypeLayout>& layouts);
+
+	//A table of every registered type with members: size, padding, holes, and the reordering when
+	//it saves space, then the totals per instance of each type.
+	void WriteLayoutReport(std::string& out);
+
+	//////////////////////////////////////////////////////////////////////////////
+	//  Packed objects
+	//////////////////////////////////////////////////////////////////////////////
+	// Purpose: Raw object images without the padding, for serializers that copy objects as bytes.
+	//          Every leaf member (nested value types are walked) must be trivially copyable;
+	//          members that sit next to each other are copied as one run. Snapshot records
+	//          are already written leaf by leaf, so they never carry padding.
+
+	//bytes one packed object takes; 0 if the type has a leaf that isn't trivially copyable
+	unsigned PackedSize(const Type* type);
+
+	//Writes count objects, stride bytes apart (0 means type->Size()), back to back into out,
+	//PackedSize(type) bytes each. false if the type can't be packed.
+	bool PackObjects(const Type* type, const void* objects, unsigned count, void* out, unsigned stride = 0);
+
+	//reads packed objects back into count constructed objects; bytes no member covers are left alone
+	bool UnpackObjects(const Type* type, const void* in, unsigned count, void* objects, unsigned stride = 0);
+}
+
+void TestLayout();
@@ -0,0 +1,81 @@
+#include "Layout.h"
+#include "SerializationTest.h"
+#include "Test.h"
+#include <chrono>
+#include <cstdio>
+
+void TestLayout()
+{
+	typedef std::chrono::high_resolution_clock Clock;
+
+	meta::TypeLayout layout;
+	meta::AnalyzeLayout(meta::get<Particle>(), layout);
+	if (layout.size != sizeof(Particle) || layout.padding != 16 || layout.holes.size() != 3 ||
+		layout.holes[0].offset != 1 || layout.holes[0].size != 7 || layout.holes[2].offset != 26 || layout.holes[2].size != 6)
+		printf("Particle layout has %u bytes of padding in %u holes\n", layout.padding, (unsigned)layout.holes.size());
+	if (layout.suggestedSize != 16 || layout.suggestedOrder.size() != 5 || layout.suggestedOrder[0]->Name() != "mass" ||
+		layout.suggestedOrder[1]->Name() != "life" || layout.suggestedOrder[4]->Name() != "tag")
+		printf("Particle reordering suggests %u bytes\n", layout.suggestedSize);
+
+	//inherited members stay put; small own members fill holes after the bases
+	meta::AnalyzeLayout(meta::get<DerivedTest>(), layout);
+	if (layout.padding != 0 || layout.suggestedSize != sizeof(DerivedTest))
+		printf("DerivedTest layout reports %u bytes of padding\n", layout.padding);
+	meta::AnalyzeLayout(meta::get<Thing>(), layout);
+	if (layout.padding != sizeof(Thing) - sizeof(unsigned) - sizeof(int) - sizeof(std::string) - sizeof(float) - sizeof(double) - sizeof(Vector3) - sizeof(ThingType))
+		printf("Thing layout reports %u bytes of padding\n", layout.padding);
+
+	//packed objects round trip, and only trivially copyable leaves pack
+	const unsigned count = 1000000;
+	std::vector<Particle> particles(count);
+	for (unsigned i = 0; i < count; ++i)
+	{
+		Particle& particle = particles[i];
+		particle.alive = (i & 1) != 0;
+		particle.mass = i * 0.5;
+		particle.tag = (char)i;
+		particle.life = (float)i;
+		particle.flags = (short)(i * 3);
+	}
+
+	const meta::Type* particleType = meta::get<Particle>();
+	unsigned packedSize = meta::PackedSize(particleType);
+	if (packedSize != 16 || meta::PackedSize(meta::get<Thing>()) != 0 || meta::PackedSize(meta::get<Vector3>()) != sizeof(Vector3))
+		printf("Packed sizes are wrong: Particle %u\n", packedSize);
+
+	std::vector<char> raw(count * sizeof(Particle));
+	Clock::time_point start = Clock::now();
+	std::memcpy(raw.data(), particles.data(), raw.size());
+	std::chrono::duration<double, std::milli> rawCopy = Clock::now() - start;
+
+	std::vector<char> packed(count * packedSize);
+	start = Clock::now();
+	meta::PackObjects(particleType, particles.data(), count, packed.data());
+	std::chrono::duration<double, std::milli> pack = Clock::now() - start;
+
+	std::vector<Particle> unpacked(count);
+	start = Clock::now();
+	meta::UnpackObjects(particleType, packed.data(), count, unpacked.data());
+	std::chrono::duration<double, std::milli> unpack = Clock::now() - start;
+
+	for (unsigned i = 0; i < count; ++i)
+	{
+		const Particle& lhs = particles[i];
+		const Particle& rhs = unpacked[i];
+		if (lhs.alive != rhs.alive || lhs.mass != rhs.mass || lhs.tag != rhs.tag || lhs.life != rhs.life || lhs.flags != rhs.flags)
+		{
+			printf("Packed Particle %u didn't round trip\n", i);
+			break;
+		}
+	}
+
+	std::string report;
+	meta::WriteLayoutReport(report);
+	printf("Layout of registered types, bytes:\n%s\n", report.c_str());
+
+	printf("%u Particles, bytes and ms:\n", count);
+	printf("%18s %10s %8s %8s\n", "", "size", "write", "read");
+	printf("%18s %10u %8.2f %8s\n", "raw memcpy", (unsigned)raw.size(), rawCopy.count(), "");
+	printf("%18s %10u %8.2f %8.2f\n", "packed", (unsigned)packed.size(), pack.count(), unpack.count());
+	printf("\n");
+}
@@ -0,0 +1,227 @@
+#include "Loader.h"
+#include "SerializationTest.h"
+#include "Trace.h"
+#include "jansson.h"
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <deque>
+#include <mutex>
+#include <thread>
+
+namespace meta
+{
+	namespace
+	{
+		typedef std::chrono::high_resolution_clock Clock;
+		typedef std::chrono::duration<double, std::milli> Milliseconds;
+
+		//A fixed capacity queue between two stages. Push blocks while the queue is full, Pop blocks
+		//while it's empty, and returns false once it's closed and drained.
+		template <typename T>
+		class StageQueue
+		{
+		public:
+			StageQueue(unsigned capacity) : capacity(capacity), closed(false) {}
+
+			void Push(const T& item)
+			{
+				std::unique_lock<std::mutex> lock(mutex);
+				while (items.size() >= capacity)
+				{
+					notFull.wait(lock);
+				}
+				items.push_back(item);
+				notEmpty.notify_one();
+			}
+
+			bool Pop(T& item)
+			{
+				std::unique_lock<std::mutex> lock(mutex);
+				while (items.empty() && !closed)
+				{
+					notEmpty.wait(lock);
+				}
+				if (items.empty())
+				{
+					return false;
+				}
+				item = items.front();
+				items.pop_front();
+				notFull.notify_one();
+				return true;
+			}
+
+			void Close(void)
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				closed = true;
+				notEmpty.notify_all();
+			}
+
+		private:
+			std::deque<T> items;
+			std::mutex mutex;
+			std::condition_variable notEmpty;
+			std::condition_variable notFull;
+			unsigned capacity;
+			bool closed;
+		};
+
+		struct ReadFile
+		{
+			unsigned job;
+			std::vector<char>* bytes; //NULL if the file couldn't be read
+		};
+
+		struct ParsedFile
+		{
+			unsigned job;
+			json_t* json; //NULL if the file couldn't be read or parsed
+		};
+
+		bool ReadWholeFile(const std::string& path, std::vector<char>& bytes)
+		{
+			FILE* file = fopen(path.c_str(), "rb");
+			if (file == NULL)
+			{
+				return false;
+			}
+
+			long size = fseek(file, 0, SEEK_END) == 0 ? ftell(file) : -1;
+			if (size < 0 || fseek(file, 0, SEEK_SET) != 0)
+			{
+				fclose(file);
+				return false;
+			}
+
+			bytes.resize(size);
+			bool read = size == 0 || fread(&bytes[0], 1, size, file) == (size_t)size;
+			fclose(file);
+			return read;
+		}
+
+		void ReadStage(const std::vector<LoadJob>& jobs, StageQueue<ReadFile>& out, double& busy)
+		{
+			for (unsigned i = 0; i < jobs.size(); ++i)
+			{
+				Clock::time_point start = Clock::now();
+				ReadFile file = { i, new std::vector<char>() };
+				{
+					TraceSpan span("read file", jobs[i].type);
+					if (!ReadWholeFile(jobs[i].path, *file.bytes))
+					{
+						std::cout << "Couldn't read " << jobs[i].path << std::endl;
+						delete file.bytes;
+						file.bytes = NULL;
+					}
+					span.SetBytes(file.bytes != NULL ? file.bytes->size() : 0);
+				}
+				busy += Milliseconds(Clock::now() - start).count();
+
+				out.Push(file);
+			}
+			out.Close();
+		}
+
+		void ParseStage(const std::vector<LoadJob>& jobs, StageQueue<ReadFile>& in, StageQueue<ParsedFile>& out, double& busy)
+		{
+			ReadFile file;
+			while (in.Pop(file))
+			{
+				Clock::time_point start = Clock::now();
+				ParsedFile parsed = { file.job, NULL };
+				if (file.bytes != NULL)
+				{
+					TraceSpan span("parse", jobs[file.job].type, file.bytes->size());
+					json_error_t error;
+					parsed.json = json_loadb(file.bytes->empty() ? "" : &(*file.bytes)[0], file.bytes->size(), 0, &error);
+					if (parsed.json == NULL)
+					{
+						std::cout << jobs[file.job].path << "(" << error.line << "): " << error.text << std::endl;
+					}
+					delete file.bytes;
+				}
+				busy += Milliseconds(Clock::now() - start).count();
+
+				out.Push(parsed);
+			}
+		}
+	}
+
+	LoadStats LoadFiles(std::vector<LoadJob>& jobs, const LoadOptions& options)
+	{
+		LoadStats stats;
+		Clock::time_point start = Clock::now();
+
+		unsigned parseThreads = options.parseThreads;
+		if (parseThreads == 0)
+		{
+			unsigned hardware = std::thread::hardware_concurrency();
+			parseThreads = hardware > 2 ? hardware - 1 : 1;
+		}
+		stats.parseThreads = parseThreads;
+
+		unsigned depth = options.queueDepth > 0 ? options.queueDepth : 1;
+		StageQueue<ReadFile> readQueue(depth);
+		StageQueue<ParsedFile> parsedQueue(depth);
+
+		std::thread reader(ReadStage, std::cref(jobs), std::ref(readQueue), std::ref(stats.read));
+
+		std::vector<double> parseBusy(parseThreads, 0.0);
+		std::vector<std::thread> parsers;
+		for (unsigned i = 0; i < parseThreads; ++i)
+		{
+			parsers.push_back(std::thread(ParseStage, std::cref(jobs), std::ref(readQueue), std::ref(parsedQueue), std::ref(parseBusy[i])));
+		}
+
+		//the parsers close the parsed queue once they've all drained the read queue
+		std::thread closer([&parsers, &parsedQueue]()
+		{
+			for (unsigned i = 0; i < parsers.size(); ++i)
+			{
+				parsers[i].join();
+			}
+			parsedQueue.Close();
+		});
+
+		//materialization stays on the calling thread, since the objects belong to it
+		ParsedFile parsed;
+		while (parsedQueue.Pop(parsed))
+		{
+			Clock::time_point begin = Clock::now();
+			LoadJob& job = jobs[parsed.job];
+			if (parsed.json != NULL && json_is_object(parsed.json))
+			{
+				json_t* root = json_object_get(parsed.json, job.type->Name().c_str());
+				DeSerializeJsonObject(root != NULL && json_is_object(root) ? root : parsed.json, job.object, job.type->Name());
+				job.loaded = true;
+			}
+			else if (parsed.json != NULL)
+			{
+				std::cout << job.path << " doesn't contain a json object" << std::endl;
+			}
+			json_decref(parsed.json);
+			stats.materialize += Milliseconds(Clock::now() - begin).count();
+
+			if (job.loaded)
+			{
+				++stats.loaded;
+			}
+			else
+			{
+				++stats.failed;
+			}
+		}
+
+		reader.join();
+		closer.join();
+
+		for (unsigned i = 0; i < parseThreads; ++i)
+		{
+			stats.parse += parseBusy[i];
+		}
+		stats.total = Milliseconds(Clock::now() - start).count();
+		return stats;
+	}
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+#include "Meta.h"
+
+namespace meta
+{
+	//////////////////////////////////////////////////////////////////////////////
+	//  LoadFiles
+	//////////////////////////////////////////////////////////////////////////////
+	// Purpose: Loads many json data files into registered types with the three stages
+	//          overlapped: one thread reads files, a pool of workers parses them and the
+	//          calling thread materializes objects through the meta tables. The stages are
+	//          joined by bounded queues, so a slow stage holds the ones before it back
+	//          instead of letting read buffers or parsed documents pile up.
+
+	//One file to load. The file's root object is used, unless it has a member named after
+	//the type ({"Thing": {...}}), in which case that member is. object must already be constructed.
+	struct LoadJob
+	{
+		LoadJob() : type(NULL), object(NULL), loaded(false) {}
+		LoadJob(const std::string& path, const Type* type, void* object) : path(path), type(type), object(object), loaded(false) {}
+
+		std::string path;
+		const Type* type;
+		void* object;
+		bool loaded;
+	};
+
+	struct LoadOptions
+	{
+		LoadOptions() : parseThreads(0), queueDepth(32) {}
+
+		unsigned parseThreads; //0 picks one less than the hardware thread count
+		unsigned queueDepth;   //files in flight between two stages
+	};
+
+	//Busy time of each stage in milliseconds. parse is summed over the workers, so parse / parseThreads
+	//is the stage's share of the wall clock; total approaches the slowest stage when they overlap.
+	struct LoadStats
+	{
+		LoadStats() : read(0.0), parse(0.0), materialize(0.0), total(0.0), parseThreads(0), loaded(0), failed(0) {}
+
+		double read;
+		double parse;
+		double materialize;
+		double total;
+		unsigned parseThreads;
+		unsigned loaded;
+		unsigned failed;
+	};
+
+	LoadStats LoadFiles(std::vector<LoadJob>& jobs, const LoadOptions& options = LoadOptions());
+}
+
+void TestPipelinedLoad();
@@ -0,0 +1,90 @@
+#include "Loader.h"
+#include "SerializationTest.h"
+#include "jansson.h"
+#include <chrono>
+#include <cstdio>
+
+static std::string LoaderTestPath(unsigned i)
+{
+	char path[64];
+	sprintf(path, "LoaderTestThing%u.json", i);
+	return path;
+}
+
+void TestPipelinedLoad()
+{
+	typedef std::chrono::high_resolution_clock Clock;
+
+	//a few thousand small data files, like the ones loaded at startup
+	const unsigned count = 2000;
+	for (unsigned i = 0; i < count; ++i)
+	{
+		Thing thing = Thing();
+		thing.id = i;
+		thing.size = (int)i * 3;
+		thing.name = "loaded thing";
+		thing.radius = (float)i * 0.5f;
+		thing.position = Vector3((float)i, 0.0f, 1.0f);
+		thing.kind = (i & 1) ? Thing_Apple : Thing_Banana;
+
+		json_t* file = json_object();
+		json_object_set_new(file, "Thing", SerializeJsonObject(&thing, "Thing"));
+		json_dump_file(file, LoaderTestPath(i).c_str(), JSON_INDENT(4));
+		json_decref(file);
+	}
+
+	const meta::Type* thingType = meta::get<Thing>();
+
+	//one file after the other
+	std::vector<Thing> sequential(count, Thing());
+	Clock::time_point start = Clock::now();
+	for (unsigned i = 0; i < count; ++i)
+	{
+		json_error_t error;
+		json_t* json = json_load_file(LoaderTestPath(i).c_str(), 0, &error);
+		if (json != NULL)
+		{
+			DeSerializeJsonObject(json_object_get(json, "Thing"), &sequential[i], "Thing");
+			json_decref(json);
+		}
+	}
+	std::chrono::duration<double, std::milli> serial = Clock::now() - start;
+
+	std::vector<Thing> things(count, Thing());
+	std::vector<meta::LoadJob> jobs;
+	for (unsigned i = 0; i < count; ++i)
+		jobs.push_back(meta::LoadJob(LoaderTestPath(i), thingType, &things[i]));
+	jobs.push_back(meta::LoadJob("LoaderTestMissing.json", thingType, NULL));
+
+	meta::LoadStats stats = meta::LoadFiles(jobs);
+
+	if (stats.loaded != count || stats.failed != 1 || jobs[count].loaded)
+		printf("LoadFiles loaded %u and failed %u of %u files\n", stats.loaded, stats.failed, count + 1);
+	for (unsigned i = 0; i < count; ++i)
+	{
+		if (things[i].id != i || things[i].size != (int)i * 3 || things[i].name != "loaded thing" ||
+			things[i].position.x != (float)i || things[i].kind != sequential[i].kind)
+		{
+			printf("LoadFiles didn't load %s\n", jobs[i].path.c_str());
+			break;
+		}
+	}
+
+	//one deep queue: the reader can't run ahead of the parsers
+	meta::LoadOptions narrow;
+	narrow.queueDepth = 1;
+	jobs.pop_back();
+	meta::LoadStats narrowStats = meta::LoadFiles(jobs, narrow);
+
+	for (unsigned i = 0; i < count; ++i)
+		remove(LoaderTestPath(i).c_str());
+
+	printf("Loading %u Thing files, ms:\n", count);
+	printf("%18s %8.2f\n", "sequential", serial.count());
+	printf("%18s %8.2f\n", "read", stats.read);
+	printf("%18s %8.2f (%u threads, %.2f each)\n", "parse", stats.parse, stats.parseThreads, stats.parse / stats.parseThreads);
+	printf("%18s %8.2f\n", "materialize", stats.materialize);
+	printf("%18s %8.2f\n", "pipelined", stats.total);
+	printf("%18s %8.2f\n", "queue depth 1", narrowStats.total);
+	printf("\n");
+}
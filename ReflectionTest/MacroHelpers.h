@@ -10,3 +10,10 @@
 //generate a "random name using macro counter
 #define NAME_GENERATOR_INTERNAL( _ ) CAT( GENERATED_NAME, _ )
 #define NAME_GENERATOR( ) NAME_GENERATOR_INTERNAL( __COUNTER__ )
+
+//a variable each thread has its own copy of (VS2013 has no thread_local)
+#ifdef _MSC_VER
+#define META_THREAD_LOCAL __declspec(thread)
+#else
+#define META_THREAD_LOCAL __thread
+#endif
@@ -1,19 +1,173 @@
 #include "Meta.h"
+#include "StringPool.h"
+#include "Arena.h"
+#include "Clone.h"
+#include "KeyShape.h"
 
 namespace meta
 {
 	void Type::AddMember(const Member *member)
 	{
-		members.push_back(member);
-		mamberNames.insert(std::make_pair(member->Name(), member));
+		members.push_back(member); //members stays the inherited copies followed by ownMembers
+		ownMembers.push_back(member);
+		Flatten();
 	}
 
-	std::vector<Type> allTypesStorage(200);
+	void Type::AddBase(Type *base, unsigned offset)
+	{
+		BaseClass record = { base, offset };
+		bases.push_back(record);
+		base->derivedTypes.push_back(this);
+		Flatten();
+	}
+
+	//Rebuilds members from the bases' (already flattened) members and the own ones. A base that registers
+	//after this type, as static initializers in another file may, reaches it through derivedTypes.
+	void Type::Flatten(void)
+	{
+		for (size_t i = 0; i < members.size() - ownMembers.size(); ++i)
+		{
+			delete members[i]; //inherited copies belong to this type
+		}
+		members.clear();
+		mamberNames.clear();
+
+		for (unsigned b = 0; b < bases.size(); ++b)
+		{
+			const std::vector<const Member *>& inherited = bases[b].type->members;
+			for (unsigned i = 0; i < inherited.size(); ++i)
+			{
+				members.push_back(new Member(inherited[i]->Name(), inherited[i]->Offset() + bases[b].offset, inherited[i]->Meta()));
+			}
+		}
+		members.insert(members.end(), ownMembers.begin(), ownMembers.end());
+
+		for (unsigned i = 0; i < ownMembers.size(); ++i)
+		{
+			mamberNames[ownMembers[i]->Name()] = ownMembers[i]; //own members hide inherited ones of the same name
+		}
+		for (size_t i = 0; i < members.size() - ownMembers.size(); ++i)
+		{
+			mamberNames.insert(std::make_pair(members[i]->Name(), members[i])); //first declaration wins
+		}
+
+		schemaHash = 0;
+		delete copyPlan.exchange(NULL);
+		delete keyShape.exchange(NULL);
+
+		for (unsigned i = 0; i < derivedTypes.size(); ++i)
+		{
+			derivedTypes[i]->Flatten();
+		}
+	}
+
+	void Type::SetVersion(unsigned newVersion)
+	{
+		version = newVersion;
+		schemaHash = 0;
+	}
+
+	static void HashBytes(unsigned long long& hash, const void* data, size_t size)
+	{
+		//FNV-1a
+		const unsigned char* bytes = static_cast<const unsigned char*>(data);
+		for (size_t i = 0; i < size; ++i)
+		{
+			hash ^= bytes[i];
+			hash *= 1099511628211ULL;
+		}
+	}
+
+	unsigned long long Type::SchemaHash(void) const
+	{
+		//threads that miss compute the same hash, so a relaxed store publishes it
+		unsigned long long cached = schemaHash.load(std::memory_order_relaxed);
+		if (cached != 0)
+		{
+			return cached;
+		}
+
+		unsigned long long hash = 14695981039346656037ULL;
+		HashBytes(hash, name.data(), name.size());
+		HashBytes(hash, &size, sizeof(size));
+		HashBytes(hash, &version, sizeof(version));
+
+		for (unsigned i = 0; i < members.size(); ++i)
+		{
+			const Member* member = members[i];
+			unsigned offset = member->Offset();
+			HashBytes(hash, member->Name().data(), member->Name().size());
+			HashBytes(hash, &offset, sizeof(offset));
+
+			//a changed nested type changes every type that embeds it
+			unsigned long long nested = member->Meta()->SchemaHash();
+			HashBytes(hash, &nested, sizeof(nested));
+		}
+
+		//renumbered enumerators change what stored values mean
+		for (unsigned i = 0; enumTable != NULL && i < enumTable->Count(); ++i)
+		{
+			long long value = enumTable->ValueAt(i);
+			HashBytes(hash, enumTable->NameAt(i).data(), enumTable->NameAt(i).size());
+			HashBytes(hash, &value, sizeof(value));
+		}
+
+		hash = hash != 0 ? hash : 1;
+		schemaHash.store(hash, std::memory_order_relaxed);
+		return hash;
+	}
+
+	void Type::AddMigration(const Migration& migration)
+	{
+		migrations.push_back(migration);
+	}
+
+	const Migration* Type::FindMigration(const std::string& oldName) const
+	{
+		for (unsigned i = 0; i < migrations.size(); ++i)
+		{
+			if (migrations[i].oldName == oldName)
+			{
+				return &migrations[i];
+			}
+		}
+		return NULL;
+	}
+
+	void Type::AddEnumValue(const std::string& valueName, long long value, bool isSigned)
+	{
+		if (enumTable == NULL)
+		{
+			enumTable = new EnumTable(size, isSigned);
+		}
+		enumTable->AddValue(valueName, value);
+		schemaHash = 0;
+	}
+
+	void Type::BuildEnum(void)
+	{
+		if (enumTable != NULL)
+		{
+			enumTable->Build();
+		}
+	}
+
+	std::deque<Type>& AllTypes(void)
+	{
+		static std::deque<Type> types;
+		return types;
+	}
 
-	void InitType(Type* type, std::string& string, unsigned val)
+	void InitType(Type* type, std::string& string, unsigned val, const internal::Lifetime& ops)
 	{
 		type->name = string;
 		type->size = val;
+		type->version = 1;
+		type->schemaHash = 0;
+		type->enumTable = NULL;
+		type->ops = ops;
+		type->copyPlan.store(NULL);
+		type->keyShape.store(NULL);
 	}
 }
 
@@ -35,6 +189,12 @@ meta_define_pod(char*)
 meta_define_pod(unsigned char)
 meta_define_pod(unsigned char*)
 meta_define_pod(std::string)
+meta_define_pod(meta::StringView)
+meta_define_pod(meta::InternedString)
+meta_define_pod(meta::ArenaString)
+meta_define_pod(meta::ArenaVector<int>)
+meta_define_pod(meta::ArenaVector<float>)
+meta_define_pod(meta::ArenaVector<meta::ArenaString>)
 
 namespace namespace_for_meta_POD_types {
 		meta::TypeCreator<void> voidTypeCreator("void", 0);	
@@ -1,14 +1,18 @@
 #pragma once
 
 
+#include <deque>
 #include <string>
 #include <unordered_map>
 #include <vector>
 #include <assert.h>
+#include <atomic>
 #include <iostream>
+#include <type_traits>
 
 #include "MacroHelpers.h"
 #include "RemoveQualifiers.h"
+#include "Enum.h"
 
 
 namespace meta
@@ -18,6 +22,8 @@ namespace meta
 	class TypeCreator;
 	class Member;
 	class Meta;
+	struct CopyPlan;
+	class KeyShape;
 
 	namespace internal
 	{
@@ -38,8 +44,136 @@ namespace meta
 		{
 			static void move(void* dst, void* src) { new (dst)Type(*static_cast<Type*>(src)); }
 		};
+
+		typedef void(*ConstructFn)(void*);
+		typedef void(*CopyConstructFn)(void*, const void*);
+		typedef void(*CopyAssignFn)(void*, const void*);
+		typedef void(*MoveAssignFn)(void*, void*);
+		typedef void(*DestructFn)(void*);
+
+		//! \brief In-place lifetime operations of a type. Operations the type doesn't support are NULL.
+		struct Lifetime
+		{
+			unsigned alignment;
+			bool trivial; //!< trivially copyable: a memcpy is a copy
+			ConstructFn construct;
+			CopyConstructFn copyConstruct;
+			CopyAssignFn copyAssign;
+			MoveAssignFn moveAssign;
+			DestructFn destruct;
+		};
+
+		//! \brief Knows how to default construct a type, if it has a default constructor.
+		template <typename Type, bool = std::is_default_constructible<Type>::value> struct constructor
+		{
+			static void construct(void* obj) { new (obj)Type(); }
+			static ConstructFn get(void) { return &construct; }
+		};
+
+		template <typename Type> struct constructor<Type, false>
+		{
+			static ConstructFn get(void) { return NULL; }
+		};
+
+		//! \brief Knows how to copy construct a type, if it has a copy constructor.
+		template <typename Type, bool = std::is_copy_constructible<Type>::value> struct copy_constructor
+		{
+			static void copy(void* dst, const void* src) { new (dst)Type(*static_cast<const Type*>(src)); }
+			static CopyConstructFn get(void) { return &copy; }
+		};
+
+		template <typename Type> struct copy_constructor<Type, false>
+		{
+			static CopyConstructFn get(void) { return NULL; }
+		};
+
+		//! \brief Knows how to copy assign a type, if it has a copy assignment operator.
+		template <typename Type, bool = std::is_copy_assignable<Type>::value> struct copy_assigner
+		{
+			static void assign(void* dst, const void* src) { *static_cast<Type*>(dst) = *static_cast<const Type*>(src); }
+			static CopyAssignFn get(void) { return &assign; }
+		};
+
+		template <typename Type> struct copy_assigner<Type, false>
+		{
+			static CopyAssignFn get(void) { return NULL; }
+		};
+
+		//! \brief Knows how to move assign a type, if it has a move (or copy) assignment operator.
+		template <typename Type, bool = std::is_move_assignable<Type>::value> struct move_assigner
+		{
+			static void assign(void* dst, void* src) { *static_cast<Type*>(dst) = std::move(*static_cast<Type*>(src)); }
+			static MoveAssignFn get(void) { return &assign; }
+		};
+
+		template <typename Type> struct move_assigner<Type, false>
+		{
+			static MoveAssignFn get(void) { return NULL; }
+		};
+
+		//! \brief Collects the lifetime operations of a type.
+		template <typename Type> struct lifetime
+		{
+			static Lifetime get(void)
+			{
+				Lifetime ops = 
+				{
+					(unsigned)std::alignment_of<Type>::value,
+					std::is_trivially_copyable<Type>::value,
+					constructor<Type>::get(),
+					copy_constructor<Type>::get(),
+					copy_assigner<Type>::get(),
+					move_assigner<Type>::get(),
+					&destructor<Type>::destruct
+				};
+				return ops;
+			}
+		};
+
+		template <> struct lifetime<void>
+		{
+			static Lifetime get(void)
+			{
+				Lifetime ops = { 1, false, NULL, NULL, NULL, NULL, NULL };
+				return ops;
+			}
+		};
 	}
 	
+	//////////////////////////////////////////////////////////////////////////////
+	//  BaseClass
+	//////////////////////////////////////////////////////////////////////////////
+	// Purpose: A base class of a type, and the offset of the base subobject within the derived type.
+	struct BaseClass
+	{
+		const Type* type;
+		unsigned offset;
+	};
+
+	//////////////////////////////////////////////////////////////////////////////
+	//  Migration
+	//////////////////////////////////////////////////////////////////////////////
+	// Purpose: Tells loaders where a member stored by an older version of a type went.
+	//          Only consulted when loaded data doesn't match the type's current schema.
+	struct Migration
+	{
+		enum Kind
+		{
+			Renamed,	//oldName is now called newName
+			Removed,	//oldName is gone; its data is dropped
+			Retyped,	//oldName was stored as oldType; convert turns it into member newName
+		};
+
+		typedef void(*Converter)(const void* oldValue, void* newValue);
+
+		Kind kind;
+		std::string oldName;
+		std::string newName;
+		unsigned sinceVersion;	//first version of the type with the change
+		const Type* oldType;
+		Converter convert;
+	};
+
 	//////////////////////////////////////////////////////////////////////////////
 	//  Type
 	//////////////////////////////////////////////////////////////////////////////
@@ -47,24 +181,70 @@ namespace meta
 	class Type
 	{
 	public:
-		Type() {}
+		Type() : size(0), version(1), schemaHash(0), enumTable(NULL), copyPlan(NULL), keyShape(NULL) {}
 		~Type() {};
 
 		const std::string& Name(void) const { return name; }
 		unsigned Size(void) const { return size; }
+		unsigned Alignment(void) const { return ops.alignment; }
 
 		void AddMember(const Member *member);
+		void AddBase(Type *base, unsigned offset);
 
+		//Flattened member table: inherited members (offsets adjusted to this type) followed by own members.
+		//Kept up to date as bases register members, even after this type, so users never walk the hierarchy.
 		std::vector<const Member *> members;
 		std::unordered_map<std::string, const Member *> mamberNames;
 
+		//Direct bases, in declaration order.
+		std::vector<BaseClass> bases;
+
+		//Schema versioning. The hash covers the version and the whole member layout, nested types included.
+		unsigned Version(void) const { return version; }
+		void SetVersion(unsigned newVersion);
+		unsigned long long SchemaHash(void) const;
+
+		void AddMigration(const Migration& migration);
+		const Migration* FindMigration(const std::string& oldName) const; // NULL if none
+
+		std::vector<Migration> migrations;
+
+		//Name/value table for registered enums, NULL for everything else.
+		const EnumTable* Enum(void) const { return enumTable; }
+		void AddEnumValue(const std::string& valueName, long long value, bool isSigned);
+		void BuildEnum(void); //once the values are added; registration does it
+
+		//copy assigns src over the existing object dest
 		void Copy(void* dest, const void* src) const
 		{
-			std::memcpy(dest, src, size);
+			if (ops.trivial)
+			{
+				std::memcpy(dest, src, size);
+			}
+			else
+			{
+				assert(ops.copyAssign != NULL); //type has no copy assignment
+				ops.copyAssign(dest, src);
+			}
+		}
+
+		//move assigns src over the existing object dest, leaving src valid but unspecified
+		void Move(void* dest, void* src) const
+		{
+			if (ops.trivial)
+			{
+				std::memcpy(dest, src, size);
+			}
+			else
+			{
+				assert(ops.moveAssign != NULL); //type has no move or copy assignment
+				ops.moveAssign(dest, src);
+			}
 		}
 
 		void Delete(void* data) const
 		{
+			Destruct(data);
 			delete[] reinterpret_cast<char*>(data);
 			data = NULL;
 		}
@@ -72,22 +252,76 @@ namespace meta
 		void* NewCopy(const void* src) const
 		{
 			void* data = new char[size];
-			std::memcpy(data, src, size);
+			CopyConstruct(data, src);
 			return data;
 		}
 
 		void* New(void) const
 		{
-			return new char[size];
+			void* data = new char[size];
+			Construct(data);
+			return data;
+		}
+
+		//In-place lifetime management, for objects living in storage the caller owns.
+		bool IsConstructible(void) const { return ops.construct != NULL; }
+		bool IsCopyConstructible(void) const { return ops.copyConstruct != NULL; }
+		bool IsMovable(void) const { return ops.trivial || ops.moveAssign != NULL; }
+		bool IsTriviallyCopyable(void) const { return ops.trivial; }
+
+		void Construct(void* data) const
+		{
+			assert(ops.construct != NULL); //type has no default constructor
+			ops.construct(data);
+		}
+
+		void CopyConstruct(void* dest, const void* src) const
+		{
+			assert(ops.copyConstruct != NULL); //type has no copy constructor
+			ops.copyConstruct(dest, src);
 		}
 
+		void Destruct(void* data) const
+		{
+			if (ops.destruct != NULL)
+			{
+				ops.destruct(data);
+			}
+		}
+
+		//Strided member access over count objects of this type, stride bytes apart (0 means Size()).
+		//out/in hold count tightly packed member values. Defined in Gather.cpp.
+		void Gather(const Member* member, const void* objects, unsigned count, void* out, unsigned stride = 0) const;
+		void Scatter(const Member* member, void* objects, unsigned count, const void* in, unsigned stride = 0) const;
+		void Fill(const Member* member, void* objects, unsigned count, const void* value, unsigned stride = 0) const;
+
 	private:
-		friend void InitType(Type* type, std::string& string, unsigned val);
+		friend void InitType(Type* type, std::string& string, unsigned val, const internal::Lifetime& ops);
+		friend const CopyPlan& GetCopyPlan(const Type* type);
+		friend KeyShape& GetKeyShape(const Type* type);
+
+		void Flatten(void);
 
 		std::string name;
 		unsigned size;
+		unsigned version;
+		mutable std::atomic<unsigned long long> schemaHash; // 0 until computed, reset when the layout changes
+		EnumTable* enumTable;
+		internal::Lifetime ops;
+		mutable std::atomic<const CopyPlan*> copyPlan; // built by GetCopyPlan on first use, freed when the layout changes
+		mutable std::atomic<KeyShape*> keyShape; // built by GetKeyShape on first use, freed when the layout changes
+
+		//Members declared by this type itself; members holds them after the inherited ones.
+		std::vector<const Member *> ownMembers;
+
+		//Types that derive from this one, flattened again when this type's members change.
+		std::vector<Type *> derivedTypes;
 	};
 
+	//Every type, built on first use. A deque never moves its types, so the pointers handed out
+	//stay good as more register.
+	std::deque<Type>& AllTypes(void);
+
 	
 
 	//////////////////////////////////////////////////////////////////////////////
@@ -103,21 +337,17 @@ namespace meta
 	public:
 		TypeCreator(std::string name, unsigned size)
 		{
-			assert(instance == NULL);
-
-			allTypesStorage.emplace_back();
-			instance = &allTypesStorage.back();
-
 			Init(name, size);
 		}
 
 		static void Init(std::string name, unsigned size)
 		{
 			Type* newType = Get();			//construct
-			InitType(newType, name, size);	//set variables
+			InitType(newType, name, size, internal::lifetime<Metatype>::get());	//set variables
 			registerType<Metatype>();		//register
 
 			RegisterMetaData();
+			newType->BuildEnum();
 		}
 
 		static void RegisterMetaData(void);
@@ -127,14 +357,30 @@ namespace meta
 			Get()->AddMember(new Member(memberName, memberOffset, meta));
 		}
 
+		static void AddEnumValue(std::string valueName, long long value)
+		{
+			Get()->AddEnumValue(valueName, value, std::is_signed<typename std::underlying_type<Metatype>::type>::value);
+		}
+
+		static void AddBase(Type *base, unsigned baseOffset)
+		{
+			Get()->AddBase(base, baseOffset);
+		}
+
 		static Metatype* NullCast(void)
 		{
 			return reinterpret_cast<Metatype *>(NULL);
 		}
 
-		// Ensure a single instance can exist for this class type
+		// Ensure a single instance can exist for this class type. Built on first use: types in other files
+		// can derive from this one or hold it as a member before its own registration has run.
 		static Type* Get(void)
 		{
+			if (instance == NULL)
+			{
+				AllTypes().emplace_back();
+				instance = &AllTypes().back();
+			}
 			return instance;
 		}
 	private:
@@ -152,7 +398,7 @@ namespace meta
 	class Member
 	{
 	public:
-		Member::Member(std::string string, unsigned val, Type *meta) : name(string), offset(val), data(meta) {}
+		Member::Member(std::string string, unsigned val, const Type *meta) : name(string), offset(val), data(meta) {}
 		Member::~Member() {}
 
 		const std::string &Name(void) const { return name; } 	// Gettor for name
@@ -235,6 +481,22 @@ namespace meta
 		};
 
 		template <typename Type> struct make_any;
+
+		inline Migration make_migration(Migration::Kind kind, const char* oldName, const char* newName, unsigned sinceVersion,
+			const Type* oldType = NULL, Migration::Converter convert = NULL)
+		{
+			Migration migration = { kind, oldName, newName, sinceVersion, oldType, convert };
+			return migration;
+		}
+
+		//! \brief Offset of the Base subobject inside Derived. Only valid for non-virtual bases.
+		template <typename Derived, typename Base>
+		unsigned base_offset()
+		{
+			//cast a fake non-null address; static_cast leaves NULL as NULL, hiding the adjustment.
+			Derived* derived = reinterpret_cast<Derived*>(0x1000);
+			return (unsigned)(reinterpret_cast<char*>(static_cast<Base*>(derived)) - reinterpret_cast<char*>(derived));
+		}
 	}
 
 
@@ -297,10 +559,11 @@ namespace meta
 	//Defines RegisterMetaData for the TypeCreator, so this must be followed by {}.
 #define meta_define(TYPE) \
 		namespace namespace_for_meta_types {																									\
-			meta::TypeCreator<meta::RemoveQualifiers<TYPE>::type> NAME_GENERATOR()(#TYPE, sizeof(TYPE));										\
+			static meta::TypeCreator<meta::RemoveQualifiers<TYPE>::type> NAME_GENERATOR()(#TYPE, sizeof(TYPE));								\
 		}																																		\
 		meta::RemoveQualifiersPtr<TYPE>::type* TYPE::NullCast(void) { return reinterpret_cast<meta::RemoveQualifiers<TYPE>::type *>(NULL); }	\
 		void TYPE::AddMember(std::string name, unsigned offset, meta::Type *data) { return meta::TypeCreator<meta::RemoveQualifiersPtr<TYPE>::type>::AddMember(name, offset, data); } \
+		void TYPE::AddBase(meta::Type *base, unsigned offset) { return meta::TypeCreator<meta::RemoveQualifiersPtr<TYPE>::type>::AddBase(base, offset); } \
 		void meta::TypeCreator<meta::RemoveQualifiersPtr<TYPE>::type>::RegisterMetaData(void) { TYPE::RegisterMetaData(); }						\
 		void TYPE::RegisterMetaData(void) //define after this
 
@@ -308,20 +571,58 @@ namespace meta
 	//Allows RegisterMetaData (in meta_define) to get access to private members.
 	#define meta_expose_internal(TYPE) \
 		static void AddMember(std::string name, unsigned offset, meta::Type* data);		\
+		static void AddBase(meta::Type* base, unsigned offset);							\
 		static meta::RemoveQualifiers<TYPE>::type* NullCast(void);						\
 		static void TYPE::RegisterMetaData(void);
 
 	//registers a Plain Old DataType (POD) type with the meta system.
 	#define meta_define_pod(TYPE) \
 		namespace namespace_for_meta_POD_types {															\
-			meta::TypeCreator<meta::RemoveQualifiers<TYPE>::type> NAME_GENERATOR()(#TYPE, sizeof(TYPE));	\
+			static meta::TypeCreator<meta::RemoveQualifiers<TYPE>::type> NAME_GENERATOR()(#TYPE, sizeof(TYPE));	\
 		}																									\
 		void meta::TypeCreator<meta::RemoveQualifiers<TYPE>::type>::RegisterMetaData(void) {}
 
+	//registers an enum with the meta system.
+	//Defines RegisterMetaData for the TypeCreator, so this must be followed by { meta_enum_value(...); }.
+	#define meta_define_enum(TYPE) \
+		namespace namespace_for_meta_types {																\
+			static meta::TypeCreator<meta::RemoveQualifiers<TYPE>::type> NAME_GENERATOR()(#TYPE, sizeof(TYPE));	\
+		}																									\
+		void meta::TypeCreator<meta::RemoveQualifiers<TYPE>::type>::RegisterMetaData(void) //define after this
+
+	//registers an enumerator of an enum, inside a meta_define_enum body
+	#define meta_enum_value( VALUE ) \
+		AddEnumValue(#VALUE, (long long)(VALUE))
+
 	//registers a member of a type
 	#define meta_add_member( MEMBER ) \
 		AddMember(#MEMBER, (unsigned)(&(NullCast()->MEMBER)), meta::get(NullCast()->MEMBER))
 
+	//the type being registered, inside a meta_define body
+	#define meta_self() \
+		meta::get<meta::RemoveQualifiersPtr<decltype(NullCast())>::type>()
+
+	//sets the schema version of a type (default 1). Bump it when members are renamed, removed or retyped.
+	#define meta_version( VERSION ) \
+		meta_self()->SetVersion(VERSION)
+
+	//data from before VERSION stored MEMBER under the name OLD
+	#define meta_renamed_member( OLD, MEMBER, VERSION ) \
+		meta_self()->AddMigration(meta::internal::make_migration(meta::Migration::Renamed, #OLD, #MEMBER, VERSION))
+
+	//data from before VERSION has a member OLD that no longer exists
+	#define meta_removed_member( OLD, VERSION ) \
+		meta_self()->AddMigration(meta::internal::make_migration(meta::Migration::Removed, #OLD, "", VERSION))
+
+	//data from before VERSION stored MEMBER as an OLDTYPE. CONVERTER(const OLDTYPE*, MEMBER type*) fixes it up.
+	#define meta_retyped_member( MEMBER, OLDTYPE, CONVERTER, VERSION ) \
+		meta_self()->AddMigration(meta::internal::make_migration(meta::Migration::Retyped, #MEMBER, #MEMBER, VERSION, meta::get<OLDTYPE>(), CONVERTER))
+
+	//registers a (non-virtual) base class of a type. The base's members are flattened into the type's members,
+	//ahead of its own, whether the base registers before or after it.
+	#define meta_add_base( BASE ) \
+		AddBase(meta::get<BASE>(), meta::internal::base_offset<meta::RemoveQualifiersPtr<decltype(NullCast())>::type, BASE>())
+
 
 	//////////////////////////////////////////////////////////////////////////////
 	//  Meta Access Functions
@@ -387,11 +688,11 @@ namespace meta
 	//Friend function to initialize Type.
 	// A: InitType won't show up in Type as public function.
 	// B: Constructor for InitType called in singleton function.
-	void InitType(Type* type, std::string& string, unsigned val);
-
-	extern std::vector<Type> allTypesStorage;
+	void InitType(Type* type, std::string& string, unsigned val, const internal::Lifetime& ops);
 
 }
 
 #include "Variant.inl"
-#include "Any.inl"
\ No newline at end of file
+#include "Any.inl"
+
+void TestInheritance();
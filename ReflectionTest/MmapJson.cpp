@@ -0,0 +1,674 @@
+#include "MmapJson.h"
+#include "Arena.h"
+#include "FieldKind.h"
+#include "JsonNumber.h"
+#include "KeyShape.h"
+#include "Trace.h"
+#include <cstdlib>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace meta
+{
+	//////////////////////////////////////////////////////////////////////////////
+	//  MappedFile
+	//////////////////////////////////////////////////////////////////////////////
+
+#ifdef _WIN32
+	MappedFile::MappedFile() : data(NULL), size(0), file(INVALID_HANDLE_VALUE), mapping(NULL)
+	{
+	}
+
+	bool MappedFile::Open(const std::string& path)
+	{
+		Close();
+
+		file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+		if (file == INVALID_HANDLE_VALUE)
+		{
+			return false;
+		}
+
+		LARGE_INTEGER fileSize;
+		if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0)
+		{
+			Close();
+			return false;
+		}
+
+		//PAGE_WRITECOPY: writes go to private pages, never the file
+		mapping = CreateFileMappingA(file, NULL, PAGE_WRITECOPY, 0, 0, NULL);
+		if (mapping != NULL)
+		{
+			data = static_cast<char*>(MapViewOfFile(mapping, FILE_MAP_COPY, 0, 0, 0));
+		}
+		if (data == NULL)
+		{
+			Close();
+			return false;
+		}
+
+		size = (size_t)fileSize.QuadPart;
+		return true;
+	}
+
+	void MappedFile::Close(void)
+	{
+		if (data != NULL)
+		{
+			UnmapViewOfFile(data);
+		}
+		if (mapping != NULL)
+		{
+			CloseHandle(mapping);
+		}
+		if (file != INVALID_HANDLE_VALUE)
+		{
+			CloseHandle(file);
+		}
+
+		data = NULL;
+		size = 0;
+		mapping = NULL;
+		file = INVALID_HANDLE_VALUE;
+	}
+#else
+	MappedFile::MappedFile() : data(NULL), size(0), file(-1)
+	{
+	}
+
+	bool MappedFile::Open(const std::string& path)
+	{
+		Close();
+
+		file = open(path.c_str(), O_RDONLY);
+		if (file < 0)
+		{
+			return false;
+		}
+
+		struct stat info;
+		if (fstat(file, &info) != 0 || info.st_size == 0)
+		{
+			Close();
+			return false;
+		}
+
+		//MAP_PRIVATE: writes go to private pages, never the file
+		void* mapped = mmap(NULL, (size_t)info.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, file, 0);
+		if (mapped == MAP_FAILED)
+		{
+			Close();
+			return false;
+		}
+
+		data = static_cast<char*>(mapped);
+		size = (size_t)info.st_size;
+		return true;
+	}
+
+	void MappedFile::Close(void)
+	{
+		if (data != NULL)
+		{
+			munmap(data, size);
+		}
+		if (file >= 0)
+		{
+			close(file);
+		}
+
+		data = NULL;
+		size = 0;
+		file = -1;
+	}
+#endif
+
+	MappedFile::~MappedFile()
+	{
+		Close();
+	}
+
+	//////////////////////////////////////////////////////////////////////////////
+	//  In-situ json
+	//////////////////////////////////////////////////////////////////////////////
+
+	namespace
+	{
+		const unsigned maxDepth = 128;	//objects and arrays the text may nest
+
+		class InSituParser
+		{
+		public:
+			InSituParser(char* text, size_t size, StringPool& pool) : text(text), at(text), end(text + size), pool(pool), depth(0) {}
+
+			//object fills from the next json object. At the root, a member named after the type fills it instead.
+			bool Object(const Type* type, char* object, bool root)
+			{
+				Nesting nesting(depth);
+				if (depth > maxDepth || !Expect('{'))
+				{
+					return false;
+				}
+				if (Peek('}'))
+				{
+					++at;
+					return true;
+				}
+
+				KeyShape& shape = GetKeyShape(type);
+				unsigned position = 0;
+
+				while (true)
+				{
+					char* key;
+					unsigned length;
+					if (!String(key, length) || !Expect(':'))
+					{
+						return false;
+					}
+					key[length] = '\0';	//over the closing quote or an escape, both behind us
+
+					const Member* member = key[0] != '$' ? shape.Find(position++, key) : NULL;
+					bool parsed;
+					if (member != NULL)
+					{
+						parsed = Value(member->Meta(), object + member->Offset());
+					}
+					else if (root && type->Name() == key && Peek('{'))
+					{
+						parsed = Object(type, object, false);
+					}
+					else
+					{
+						parsed = Skip();
+					}
+
+					if (!parsed)
+					{
+						return false;
+					}
+					if (Peek(','))
+					{
+						++at;
+						continue;
+					}
+					return Expect('}');
+				}
+			}
+
+			bool Expect(char c)
+			{
+				SkipSpace();
+				if (at < end && *at == c)
+				{
+					++at;
+					return true;
+				}
+				return false;
+			}
+
+			bool Peek(char c)
+			{
+				SkipSpace();
+				return at < end && *at == c;
+			}
+
+			void Advance(void)
+			{
+				++at;
+			}
+
+			unsigned Line(void) const
+			{
+				unsigned line = 1;
+				for (const char* c = text; c < at; ++c)
+				{
+					line += *c == '\n';
+				}
+				return line;
+			}
+
+		private:
+			//one more object or array open for its scope
+			struct Nesting
+			{
+				Nesting(unsigned& depth) : depth(depth) { ++depth; }
+				~Nesting() { --depth; }
+
+				unsigned& depth;
+			};
+
+			void SkipSpace(void)
+			{
+				while (at < end && (*at == ' ' || *at == '\n' || *at == '\r' || *at == '\t'))
+				{
+					++at;
+				}
+			}
+
+			//a string, unescaped over itself. str points into the text and isn't NUL terminated.
+			bool String(char*& str, unsigned& length)
+			{
+				if (!Expect('"'))
+				{
+					return false;
+				}
+
+				char* begin = at;
+				while (at < end && *at != '"' && *at != '\\')
+				{
+					++at;
+				}
+
+				char* to = at;
+				while (at < end && *at != '"')
+				{
+					if (*at != '\\')
+					{
+						*to++ = *at++;
+						continue;
+					}
+
+					if (++at >= end)
+					{
+						return false;
+					}
+					switch (*at)
+					{
+						case '"': case '\\': case '/': *to++ = *at; break;
+						case 'b': *to++ = '\b'; break;
+						case 'f': *to++ = '\f'; break;
+						case 'n': *to++ = '\n'; break;
+						case 'r': *to++ = '\r'; break;
+						case 't': *to++ = '\t'; break;
+						case 'u':
+						{
+							unsigned code;
+							if (!Hex4(code))
+							{
+								return false;
+							}
+							//a high surrogate pairs with the \u escape after it; either half alone is malformed
+							unsigned low;
+							if (code >= 0xd800 && code < 0xdc00)
+							{
+								if (end - at <= 2 || at[1] != '\\' || at[2] != 'u')
+								{
+									return false;
+								}
+								at += 2;
+								if (!Hex4(low) || low < 0xdc00 || low >= 0xe000)
+								{
+									return false;
+								}
+								code = 0x10000 + ((code - 0xd800) << 10) + (low - 0xdc00);
+							}
+							else if (code >= 0xdc00 && code < 0xe000)
+							{
+								return false;
+							}
+							to = EncodeUtf8(to, code);
+						}
+							break;
+						default:
+							return false;
+					}
+					++at;
+				}
+
+				if (at >= end)
+				{
+					return false;
+				}
+				++at;
+
+				str = begin;
+				length = (unsigned)(to - begin);
+				return true;
+			}
+
+			//the four hex digits after the 'u' at; leaves at on the last one
+			bool Hex4(unsigned& code)
+			{
+				if (end - at < 5 || !meta::Hex4(at + 1, code))
+				{
+					return false;
+				}
+				at += 4;
+				return true;
+			}
+
+			bool Literal(const char* word)
+			{
+				size_t length = std::strlen(word);
+				if ((size_t)(end - at) < length || std::memcmp(at, word, length) != 0)
+				{
+					return false;
+				}
+				at += length;
+				return true;
+			}
+
+			//converted straight to the type it lands in: float, double or long long
+			template <typename T>
+			bool Number(T& value)
+			{
+				const char* stop = ParseNumber(at, end, value);
+				if (stop == NULL)
+				{
+					return false;
+				}
+				at += stop - at;
+				return true;
+			}
+
+			//the next value into value, a type. Values the type can't hold are skipped.
+			bool Value(const Type* type, char* value)
+			{
+				SkipSpace();
+				if (at >= end)
+				{
+					return false;
+				}
+
+				FieldKind kind = Classify(type);
+
+				switch (*at)
+				{
+					case '{':
+						return kind == Kind_Struct ? Object(type, value, false) : Skip();
+					case '[':
+						return kind == Kind_Integers || kind == Kind_Reals || kind == Kind_Strings ? Array(kind, value) : Skip();
+					case '"':
+					{
+						char* str;
+						unsigned length;
+						if (!String(str, length))
+						{
+							return false;
+						}
+
+						switch (kind)
+						{
+							case Kind_String: reinterpret_cast<std::string*>(value)->assign(str, length); break;
+							case Kind_View: *reinterpret_cast<StringView*>(value) = StringView(str, length); break;
+							case Kind_Interned: *reinterpret_cast<InternedString*>(value) = pool.Intern(str, length); break;
+							case Kind_ArenaString: reinterpret_cast<ArenaString*>(value)->assign(str, length); break;
+							case Kind_Enumeration:
+							{
+								long long enumValue;
+								if (type->Enum()->FromString(str, length, enumValue))
+									type->Enum()->Set(value, enumValue);
+								else
+									std::cout << "ERROR: " << std::string(str, length) << " isn't a " << type->Name() << std::endl;
+							}
+								break;
+							default: break;
+						}
+						return true;
+					}
+					case 't':
+					case 'f':
+					{
+						bool boolean = *at == 't';
+						if (!Literal(boolean ? "true" : "false"))
+						{
+							return false;
+						}
+						if (kind == Kind_Boolean)
+							*reinterpret_cast<bool*>(value) = boolean;
+						return true;
+					}
+					case 'n':
+						return Literal("null");
+					default:
+					{
+						if (kind == Kind_Real32)
+						{
+							return Number(*reinterpret_cast<float*>(value));
+						}
+						if (kind == Kind_Real64)
+						{
+							return Number(*reinterpret_cast<double*>(value));
+						}
+						if (kind != Kind_Signed && kind != Kind_Unsigned && kind != Kind_Boolean && kind != Kind_Enumeration)
+						{
+							return SkipNumber();
+						}
+
+						long long integer;
+						if (!Number(integer))
+						{
+							return false;
+						}
+						switch (kind)
+						{
+							case Kind_Signed:
+							case Kind_Unsigned: StoreInteger(value, type->Size(), integer); break;
+							case Kind_Boolean: *reinterpret_cast<bool*>(value) = integer != 0; break;
+							default: type->Enum()->Set(value, integer); break;
+						}
+						return true;
+					}
+				}
+			}
+
+			//An array into an arena vector, replacing what it held. Elements go through the vector's
+			//allocator; ones of the wrong json type are skipped.
+			bool Array(FieldKind kind, char* value)
+			{
+				Nesting nesting(depth);
+				if (depth > maxDepth)
+				{
+					return false;
+				}
+
+				ArenaVector<int>& integers = *reinterpret_cast<ArenaVector<int>*>(value);
+				ArenaVector<float>& reals = *reinterpret_cast<ArenaVector<float>*>(value);
+				ArenaVector<ArenaString>& strings = *reinterpret_cast<ArenaVector<ArenaString>*>(value);
+				switch (kind)
+				{
+					case Kind_Integers: integers.clear(); break;
+					case Kind_Reals: reals.clear(); break;
+					default: strings.clear(); break;
+				}
+
+				++at;
+				if (Peek(']'))
+				{
+					++at;
+					return true;
+				}
+
+				while (true)
+				{
+					SkipSpace();
+					bool isNumber = at < end && (*at == '-' || (*at >= '0' && *at <= '9'));
+					bool parsed;
+					if (kind == Kind_Strings && at < end && *at == '"')
+					{
+						char* str;
+						unsigned length;
+						parsed = String(str, length);
+						if (parsed)
+							strings.push_back(ArenaString(str, length, strings.get_allocator()));
+					}
+					else if (kind == Kind_Integers && isNumber)
+					{
+						long long integer;
+						parsed = Number(integer);
+						if (parsed)
+							integers.push_back((int)integer);
+					}
+					else if (kind == Kind_Reals && isNumber)
+					{
+						float real;
+						parsed = Number(real);
+						if (parsed)
+							reals.push_back(real);
+					}
+					else
+					{
+						parsed = Skip();
+					}
+
+					if (!parsed)
+					{
+						return false;
+					}
+					if (Peek(','))
+					{
+						++at;
+						continue;
+					}
+					return Expect(']');
+				}
+			}
+
+			bool SkipNumber(void)
+			{
+				const char* stop = meta::SkipNumber(at, end);
+				if (stop == NULL)
+				{
+					return false;
+				}
+				at += stop - at;
+				return true;
+			}
+
+			bool Skip(void)
+			{
+				SkipSpace();
+				if (at >= end)
+				{
+					return false;
+				}
+
+				switch (*at)
+				{
+					case '"':
+					{
+						char* str;
+						unsigned length;
+						return String(str, length);
+					}
+					case '{':
+					case '[':
+					{
+						Nesting nesting(depth);
+						if (depth > maxDepth)
+						{
+							return false;
+						}
+
+						bool isObject = *at == '{';
+						char close = isObject ? '}' : ']';
+						++at;
+						if (Peek(close))
+						{
+							++at;
+							return true;
+						}
+
+						while (true)
+						{
+							char* key;
+							unsigned length;
+							if (isObject && (!String(key, length) || !Expect(':')))
+							{
+								return false;
+							}
+							if (!Skip())
+							{
+								return false;
+							}
+							if (Peek(','))
+							{
+								++at;
+								continue;
+							}
+							return Expect(close);
+						}
+					}
+					case 't': return Literal("true");
+					case 'f': return Literal("false");
+					case 'n': return Literal("null");
+					default:
+						return SkipNumber();
+				}
+			}
+
+			char* text;
+			char* at;
+			char* end;
+			StringPool& pool;
+			unsigned depth;
+		};
+	}
+
+	bool ParseJsonInSitu(char* text, size_t size, const Type* type, void* object, StringPool& pool)
+	{
+		TraceSpan span("parse in situ", type, size);
+		InSituParser parser(text, size, pool);
+		if (!parser.Object(type, static_cast<char*>(object), true))
+		{
+			std::cout << "Malformed json (line " << parser.Line() << ") loading " << type->Name() << std::endl;
+			return false;
+		}
+		return true;
+	}
+
+	unsigned ParseJsonArrayInSitu(char* text, size_t size, const Type* type, void* objects, unsigned capacity, StringPool& pool, unsigned stride)
+	{
+		TraceSpan span("parse in situ", type, size);
+		InSituParser parser(text, size, pool);
+		stride = stride != 0 ? stride : type->Size();
+
+		if (!parser.Expect('['))
+		{
+			std::cout << "Json doesn't hold an array of " << type->Name() << std::endl;
+			return 0;
+		}
+		if (parser.Peek(']'))
+		{
+			return 0;
+		}
+
+		char* object = static_cast<char*>(objects);
+		unsigned count = 0;
+		while (count < capacity)
+		{
+			if (!parser.Object(type, object, false))
+			{
+				std::cout << "Malformed json (line " << parser.Line() << ") loading " << type->Name() << " " << count << std::endl;
+				return count;
+			}
+			++count;
+			object += stride;
+
+			if (parser.Peek(','))
+			{
+				parser.Advance();
+				continue;
+			}
+			if (!parser.Expect(']'))
+			{
+				std::cout << "Malformed json (line " << parser.Line() << ") after " << type->Name() << " " << count << std::endl;
+			}
+			return count;
+		}
+
+		std::cout << "Json array holds more than " << capacity << " " << type->Name() << std::endl;
+		return count;
+	}
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+#include "Meta.h"
+#include "StringPool.h"
+
+namespace meta
+{
+	//////////////////////////////////////////////////////////////////////////////
+	//  MappedFile
+	//////////////////////////////////////////////////////////////////////////////
+	// Purpose: A file mapped copy-on-write: Data() can be written, but the file never changes.
+	class MappedFile
+	{
+	public:
+		MappedFile();
+		~MappedFile();
+
+		bool Open(const std::string& path);
+		void Close(void);
+
+		bool IsOpen(void) const { return data != NULL; }
+		char* Data(void) { return data; }
+		size_t Size(void) const { return size; }
+
+	private:
+		// Non-Copyable
+		MappedFile(const MappedFile&); // = delete
+		void operator=(const MappedFile&); // = delete
+
+		char* data;
+		size_t size;
+#ifdef _WIN32
+		void* file;
+		void* mapping;
+#else
+		int file;
+#endif
+	};
+
+	//////////////////////////////////////////////////////////////////////////////
+	//  In-situ json
+	//////////////////////////////////////////////////////////////////////////////
+	// Purpose: Parses json text straight into objects of a registered type, with no DOM. Strings
+	//          with escapes are unescaped over themselves, so the text must be writable (a
+	//          MappedFile is). String members land according to their type:
+	//
+	//              meta::StringView      a view into the text, no copy; the text must outlive it
+	//              meta::InternedString  one copy into the pool, shared by equal strings
+	//              std::string           one copy
+	//              meta::ArenaString     one copy, through the member's own allocator
+	//
+	//          Arrays fill ArenaVector members. Keys are matched through the type's KeyShape; keys
+	//          the type doesn't have, "$" stamps and other arrays are skipped. Data is taken to be
+	//          in the current schema (no migrations). Text nesting objects and arrays more than
+	//          128 deep, or with half a surrogate pair escaped, is malformed.
+
+	//The text's root object fills object. A root object with a single member named after the type,
+	//like ThingFile.json's {"Thing": {...}}, fills object from that member instead.
+	bool ParseJsonInSitu(char* text, size_t size, const Type* type, void* object, StringPool& pool);
+
+	//A root array of objects fills objects, stride bytes apart (0 means type->Size()). Returns how many
+	//were filled; stops at capacity or on malformed text.
+	unsigned ParseJsonArrayInSitu(char* text, size_t size, const Type* type, void* objects, unsigned capacity, StringPool& pool, unsigned stride = 0);
+}
+
+void TestMmapJson();
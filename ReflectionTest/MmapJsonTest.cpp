@@ -0,0 +1,139 @@
+#include "MmapJson.h"
+#include "SerializationTest.h"
+#include "jansson.h"
+#include <chrono>
+#include <cstdio>
+
+//a string heavy record, owning its strings
+struct Note
+{
+	unsigned id;
+	std::string title;
+	std::string body;
+	std::string category;
+
+	meta_expose_internal(Note);
+};
+
+//the same record pointing into the mapped file, with categories shared through a pool
+struct NoteView
+{
+	unsigned id;
+	meta::StringView title;
+	meta::StringView body;
+	meta::InternedString category;
+
+	meta_expose_internal(NoteView);
+};
+
+meta_define(Note)
+{
+	meta_add_member(id);
+	meta_add_member(title);
+	meta_add_member(body);
+	meta_add_member(category);
+}
+
+meta_define(NoteView)
+{
+	meta_add_member(id);
+	meta_add_member(title);
+	meta_add_member(body);
+	meta_add_member(category);
+}
+
+void TestMmapJson()
+{
+	typedef std::chrono::high_resolution_clock Clock;
+
+	//ThingFile.json, mapped and parsed in place
+	{
+		meta::MappedFile file;
+		meta::StringPool pool;
+		Thing thing = Thing();
+		if (!file.Open("ThingFile.json") || !meta::ParseJsonInSitu(file.Data(), file.Size(), meta::get<Thing>(), &thing, pool) ||
+			thing.id != 12 || thing.name != "Bob" || thing.position.y != 2.63f || thing.kind != Thing_Apple)
+			printf("ThingFile.json didn't parse in place\n");
+	}
+
+	//skipped values nest up to a limit, and surrogates come in pairs
+	{
+		meta::StringPool pool;
+		const unsigned depths[] = { 16, 100000 };
+		for (unsigned d = 0; d < 2; ++d)
+		{
+			std::string text = "{ \"id\": 3, \"extra\": " + std::string(depths[d], '[') + std::string(depths[d], ']') + " }";
+			Note note;
+			if (meta::ParseJsonInSitu(&text[0], text.size(), meta::get<Note>(), &note, pool) != (depths[d] == 16))
+				printf("In-situ parse skipped arrays %u deep wrongly\n", depths[d]);
+		}
+
+		const char* escapes[] = { "\\ud83d\\ude00", "\\ud83d", "\\ud83dx", "\\ude00", "\\ud83d\\u0041" };
+		for (unsigned e = 0; e < 5; ++e)
+		{
+			std::string text = std::string("{ \"title\": \"") + escapes[e] + "\" }";
+			Note note;
+			bool parsed = meta::ParseJsonInSitu(&text[0], text.size(), meta::get<Note>(), &note, pool);
+			if (parsed != (e == 0) || (parsed && note.title != "\xf0\x9f\x98\x80"))
+				printf("In-situ parse took %s wrongly\n", escapes[e]);
+		}
+	}
+
+	const unsigned count = 100000;
+	const char* categories[] = { "food", "tools", "weapons", "armor", "potions", "scrolls", "keys", "junk" };
+	std::string body(200, 'x');
+
+	const char* path = "MmapJsonNotes.json";
+	FILE* out = fopen(path, "wb");
+	fprintf(out, "[\n");
+	for (unsigned i = 0; i < count; ++i)
+	{
+		fprintf(out, "\t{ \"id\": %u, \"title\": \"note \\\"%u\\\" caf\\u00e9\", \"body\": \"%s\", \"category\": \"%s\" }%s\n",
+			i, i, body.c_str(), categories[i % 8], i + 1 < count ? "," : "");
+	}
+	fprintf(out, "]\n");
+	fclose(out);
+
+	//jansson: the file into buffers, strings into nodes, nodes into std::string
+	std::vector<Note> notes(count);
+	Clock::time_point start = Clock::now();
+	json_error_t error;
+	json_t* array = json_load_file(path, 0, &error);
+	for (unsigned i = 0; i < json_array_size(array); ++i)
+		DeSerializeJsonObject(json_array_get(array, i), &notes[i], "Note");
+	json_decref(array);
+	std::chrono::duration<double, std::milli> jansson = Clock::now() - start;
+
+	//in place into std::string: one copy
+	std::vector<Note> copied(count);
+	meta::StringPool pool;
+	start = Clock::now();
+	meta::MappedFile file;
+	file.Open(path);
+	unsigned copiedCount = meta::ParseJsonArrayInSitu(file.Data(), file.Size(), meta::get<Note>(), copied.data(), count, pool);
+	std::chrono::duration<double, std::milli> inSituCopy = Clock::now() - start;
+
+	//in place into views and the pool: only the distinct categories are copied
+	std::vector<NoteView> views(count);
+	start = Clock::now();
+	file.Open(path);
+	unsigned viewCount = meta::ParseJsonArrayInSitu(file.Data(), file.Size(), meta::get<NoteView>(), views.data(), count, pool);
+	std::chrono::duration<double, std::milli> inSituView = Clock::now() - start;
+
+	const std::string title = "note \"7\" caf\xc3\xa9";
+	if (copiedCount != count || viewCount != count)
+		printf("In-situ parse loaded %u and %u of %u notes\n", copiedCount, viewCount, count);
+	else if (notes[7].title != title || copied[7].title != title || views[7].title.ToString() != title ||
+		copied[count - 1].body != body || views[count - 1].body.ToString() != body || views[9].category.length != 5)
+		printf("In-situ parse didn't unescape or place note strings\n");
+	if (pool.Count() != 8 || !(views[3].category == views[11].category) || std::strcmp(views[3].category.c_str(), "armor") != 0)
+		printf("In-situ parse didn't intern note categories\n");
+
+	remove(path);
+
+	printf("Loading %u notes (%u bytes), ms:\n", count, (unsigned)file.Size());
+	printf("%18s %8.2f\n", "jansson", jansson.count());
+	printf("%18s %8.2f\n", "in situ, copied", inSituCopy.count());
+	printf("%18s %8.2f (pool %u bytes)\n", "in situ, views", inSituView.count(), (unsigned)pool.Bytes());
+	printf("\n");
+}
@@ -0,0 +1,623 @@
+#include "MsgPack.h"
+#include "FieldKind.h"
+#include <mutex>
+
+namespace meta
+{
+	namespace
+	{
+		const unsigned maxSkipDepth = 128;	//arrays and maps a skipped value may nest
+
+		struct Layout;
+
+		struct Field
+		{
+			unsigned key;
+			unsigned offset;
+			unsigned size;
+			FieldKind kind;
+			const Type* type;
+			const Layout* nested; //Kind_Struct only
+		};
+
+		struct Layout
+		{
+			unsigned id;
+			std::vector<Field> fields;
+		};
+
+		//the layouts of everything reachable from one top level type, sharing one name table
+		struct Document
+		{
+			std::vector<std::string> names;
+			std::unordered_map<std::string, unsigned> keys;
+			std::vector<Layout*> layouts; //layouts[0] is the top level type
+			std::unordered_map<const Type*, Layout*> byType;
+		};
+
+		std::mutex documentMutex;
+		std::unordered_map<const Type*, Document*> documents;
+
+		//false for types that aren't written (raw pointers, arena and pooled strings)
+		bool Writable(FieldKind kind)
+		{
+			return kind <= Kind_String || kind == Kind_Enumeration || kind == Kind_Struct;
+		}
+
+		const Layout* AddLayout(Document& document, const Type* type)
+		{
+			std::unordered_map<const Type*, Layout*>::const_iterator found = document.byType.find(type);
+			if (found != document.byType.end())
+			{
+				return found->second;
+			}
+
+			Layout* layout = new Layout;
+			layout->id = (unsigned)document.layouts.size();
+			document.layouts.push_back(layout);
+			document.byType[type] = layout;
+
+			for (unsigned i = 0; i < type->members.size(); ++i)
+			{
+				const Member* member = type->members[i];
+				FieldKind kind = Classify(member->Meta());
+				if (!Writable(kind))
+				{
+					continue;
+				}
+
+				std::unordered_map<std::string, unsigned>::iterator key = document.keys.find(member->Name());
+				if (key == document.keys.end())
+				{
+					key = document.keys.insert(std::make_pair(member->Name(), (unsigned)document.names.size())).first;
+					document.names.push_back(member->Name());
+				}
+
+				Field field = { key->second, member->Offset(), member->Meta()->Size(), kind, member->Meta(), NULL };
+				if (kind == Kind_Struct)
+				{
+					field.nested = AddLayout(document, member->Meta());
+				}
+				layout->fields.push_back(field);
+			}
+
+			return layout;
+		}
+
+		//built once per type and never changed, so readers share it without locking
+		const Document& GetDocument(const Type* type)
+		{
+			std::lock_guard<std::mutex> lock(documentMutex);
+
+			Document*& document = documents[type];
+			if (document == NULL)
+			{
+				document = new Document;
+				AddLayout(*document, type);
+			}
+			return *document;
+		}
+
+		long long LoadSigned(const char* at, unsigned size)
+		{
+			switch (size)
+			{
+				case 1: { signed char v; std::memcpy(&v, at, 1); return v; }
+				case 2: { short v; std::memcpy(&v, at, 2); return v; }
+				case 4: { int v; std::memcpy(&v, at, 4); return v; }
+				default: { long long v; std::memcpy(&v, at, 8); return v; }
+			}
+		}
+
+		unsigned long long LoadUnsigned(const char* at, unsigned size)
+		{
+			switch (size)
+			{
+				case 1: { unsigned char v; std::memcpy(&v, at, 1); return v; }
+				case 2: { unsigned short v; std::memcpy(&v, at, 2); return v; }
+				case 4: { unsigned int v; std::memcpy(&v, at, 4); return v; }
+				default: { unsigned long long v; std::memcpy(&v, at, 8); return v; }
+			}
+		}
+
+		//////// Writing ////////
+
+		class Writer
+		{
+		public:
+			Writer(std::vector<char>& out) : out(out) {}
+
+			void Byte(unsigned char byte)
+			{
+				out.push_back((char)byte);
+			}
+
+			//tag followed by the low bytes of value, big endian
+			void Tagged(unsigned char tag, unsigned long long value, unsigned bytes)
+			{
+				size_t at = out.size();
+				out.resize(at + 1 + bytes);
+				char* to = &out[at];
+				to[0] = (char)tag;
+				for (unsigned i = 0; i < bytes; ++i)
+				{
+					to[1 + i] = (char)(value >> (8 * (bytes - 1 - i)));
+				}
+			}
+
+			void Unsigned(unsigned long long value)
+			{
+				if (value < 0x80)					Byte((unsigned char)value);
+				else if (value <= 0xff)				Tagged(0xcc, value, 1);
+				else if (value <= 0xffff)			Tagged(0xcd, value, 2);
+				else if (value <= 0xffffffffull)	Tagged(0xce, value, 4);
+				else								Tagged(0xcf, value, 8);
+			}
+
+			void Signed(long long value)
+			{
+				if (value >= 0)							Unsigned((unsigned long long)value);
+				else if (value >= -32)					Byte((unsigned char)value);
+				else if (value >= -128)					Tagged(0xd0, (unsigned long long)value, 1);
+				else if (value >= -32768)				Tagged(0xd1, (unsigned long long)value, 2);
+				else if (value >= -2147483647ll - 1)	Tagged(0xd2, (unsigned long long)value, 4);
+				else									Tagged(0xd3, (unsigned long long)value, 8);
+			}
+
+			void Real32(float value)
+			{
+				unsigned int bits;
+				std::memcpy(&bits, &value, 4);
+				Tagged(0xca, bits, 4);
+			}
+
+			void Real64(double value)
+			{
+				unsigned long long bits;
+				std::memcpy(&bits, &value, 8);
+				Tagged(0xcb, bits, 8);
+			}
+
+			void String(const char* str, size_t length)
+			{
+				if (length < 32)				Byte((unsigned char)(0xa0 | length));
+				else if (length <= 0xff)		Tagged(0xd9, length, 1);
+				else if (length <= 0xffff)		Tagged(0xda, length, 2);
+				else							Tagged(0xdb, length, 4);
+				out.insert(out.end(), str, str + length);
+			}
+
+			void Array(unsigned count)
+			{
+				if (count < 16)				Byte((unsigned char)(0x90 | count));
+				else if (count <= 0xffff)	Tagged(0xdc, count, 2);
+				else						Tagged(0xdd, count, 4);
+			}
+
+			void Map(unsigned count)
+			{
+				if (count < 16)				Byte((unsigned char)(0x80 | count));
+				else if (count <= 0xffff)	Tagged(0xde, count, 2);
+				else						Tagged(0xdf, count, 4);
+			}
+
+		private:
+			std::vector<char>& out;
+		};
+
+		void WriteObject(Writer& writer, const Layout& layout, const char* object)
+		{
+			writer.Map((unsigned)layout.fields.size());
+
+			for (unsigned i = 0; i < layout.fields.size(); ++i)
+			{
+				const Field& field = layout.fields[i];
+				const char* value = object + field.offset;
+
+				writer.Unsigned(field.key);
+				switch (field.kind)
+				{
+					case Kind_Signed: writer.Signed(LoadSigned(value, field.size)); break;
+					case Kind_Unsigned: writer.Unsigned(LoadUnsigned(value, field.size)); break;
+					case Kind_Boolean: writer.Byte(*reinterpret_cast<const bool*>(value) ? 0xc3 : 0xc2); break;
+					case Kind_Real32: writer.Real32(*reinterpret_cast<const float*>(value)); break;
+					case Kind_Real64: writer.Real64(*reinterpret_cast<const double*>(value)); break;
+					case Kind_String:
+					{
+						const std::string& str = *reinterpret_cast<const std::string*>(value);
+						writer.String(str.data(), str.size());
+					}
+						break;
+					case Kind_Enumeration: writer.Signed(field.type->Enum()->Get(value)); break;
+					case Kind_Struct: WriteObject(writer, *field.nested, value); break;
+					default: break;
+				}
+			}
+		}
+
+		//////// Reading ////////
+
+		enum TokenKind
+		{
+			Token_Nil,
+			Token_Boolean,
+			Token_Signed,
+			Token_Unsigned,
+			Token_Real,
+			Token_String,
+			Token_Binary,
+			Token_Array,
+			Token_Map
+		};
+
+		struct Token
+		{
+			TokenKind kind;
+			bool boolean;
+			unsigned long long integer; //two's complement for Token_Signed
+			double real;
+			const char* bytes;			//string and binary
+			unsigned length;			//string and binary bytes, array and map entries
+		};
+
+		class Reader
+		{
+		public:
+			Reader(const char* data, size_t size) :
+				at(reinterpret_cast<const unsigned char*>(data)),
+				end(reinterpret_cast<const unsigned char*>(data) + size)
+			{
+			}
+
+			//false at the end of the data or on a tag MessagePack doesn't have (ext types aren't read)
+			bool Next(Token& token)
+			{
+				if (at >= end)
+				{
+					return false;
+				}
+
+				unsigned char tag = *at++;
+				unsigned long long value;
+
+				if (tag < 0x80) { token.kind = Token_Unsigned; token.integer = tag; return true; }
+				if (tag >= 0xe0) { token.kind = Token_Signed; token.integer = (unsigned long long)(long long)(signed char)tag; return true; }
+				if (tag < 0x90) { token.kind = Token_Map; token.length = tag & 0x0f; return true; }
+				if (tag < 0xa0) { token.kind = Token_Array; token.length = tag & 0x0f; return true; }
+				if (tag < 0xc0) { return Bytes(Token_String, tag & 0x1f, token); }
+
+				switch (tag)
+				{
+					case 0xc0: token.kind = Token_Nil; return true;
+					case 0xc2: token.kind = Token_Boolean; token.boolean = false; return true;
+					case 0xc3: token.kind = Token_Boolean; token.boolean = true; return true;
+					case 0xc4: return Big(1, value) && Bytes(Token_Binary, value, token);
+					case 0xc5: return Big(2, value) && Bytes(Token_Binary, value, token);
+					case 0xc6: return Big(4, value) && Bytes(Token_Binary, value, token);
+					case 0xca:
+					{
+						if (!Big(4, value)) return false;
+						unsigned int bits = (unsigned int)value;
+						float real;
+						std::memcpy(&real, &bits, 4);
+						token.kind = Token_Real;
+						token.real = real;
+						return true;
+					}
+					case 0xcb:
+					{
+						if (!Big(8, value)) return false;
+						std::memcpy(&token.real, &value, 8);
+						token.kind = Token_Real;
+						return true;
+					}
+					case 0xcc: token.kind = Token_Unsigned; return Big(1, token.integer);
+					case 0xcd: token.kind = Token_Unsigned; return Big(2, token.integer);
+					case 0xce: token.kind = Token_Unsigned; return Big(4, token.integer);
+					case 0xcf: token.kind = Token_Unsigned; return Big(8, token.integer);
+					case 0xd0: token.kind = Token_Signed; if (!Big(1, value)) return false; token.integer = (unsigned long long)(long long)(signed char)value; return true;
+					case 0xd1: token.kind = Token_Signed; if (!Big(2, value)) return false; token.integer = (unsigned long long)(long long)(short)value; return true;
+					case 0xd2: token.kind = Token_Signed; if (!Big(4, value)) return false; token.integer = (unsigned long long)(long long)(int)value; return true;
+					case 0xd3: token.kind = Token_Signed; return Big(8, token.integer);
+					case 0xd9: return Big(1, value) && Bytes(Token_String, value, token);
+					case 0xda: return Big(2, value) && Bytes(Token_String, value, token);
+					case 0xdb: return Big(4, value) && Bytes(Token_String, value, token);
+					case 0xdc: token.kind = Token_Array; return Big(2, value) && Count(value, token);
+					case 0xdd: token.kind = Token_Array; return Big(4, value) && Count(value, token);
+					case 0xde: token.kind = Token_Map; return Big(2, value) && Count(value, token);
+					case 0xdf: token.kind = Token_Map; return Big(4, value) && Count(value, token);
+					default: return false;
+				}
+			}
+
+			//skips what follows an array or map token, failing past maxSkipDepth
+			bool SkipContents(const Token& token, unsigned depth = 0)
+			{
+				unsigned long long items = token.kind == Token_Map ? 2ull * token.length : token.kind == Token_Array ? token.length : 0;
+				if (items > 0 && depth >= maxSkipDepth)
+				{
+					return false;
+				}
+				for (unsigned long long i = 0; i < items; ++i)
+				{
+					Token child;
+					if (!Next(child) || !SkipContents(child, depth + 1))
+					{
+						return false;
+					}
+				}
+				return true;
+			}
+
+		private:
+			bool Big(unsigned bytes, unsigned long long& value)
+			{
+				if ((size_t)(end - at) < bytes)
+				{
+					return false;
+				}
+				value = 0;
+				for (unsigned i = 0; i < bytes; ++i)
+				{
+					value = (value << 8) | at[i];
+				}
+				at += bytes;
+				return true;
+			}
+
+			bool Bytes(TokenKind kind, unsigned long long length, Token& token)
+			{
+				if ((size_t)(end - at) < length)
+				{
+					return false;
+				}
+				token.kind = kind;
+				token.bytes = reinterpret_cast<const char*>(at);
+				token.length = (unsigned)length;
+				at += length;
+				return true;
+			}
+
+			bool Count(unsigned long long count, Token& token)
+			{
+				token.length = (unsigned)count;
+				return true;
+			}
+
+			const unsigned char* at;
+			const unsigned char* end;
+		};
+
+		//the stored keys of one document matched against the current type, once per document
+		struct Binding
+		{
+			const Document* document;
+			std::vector<std::vector<const Field*> > byKey; //[layout id][stored key], NULL for unknown names
+		};
+
+		void Bind(const Document& document, const std::vector<std::string>& stored, Binding& binding)
+		{
+			std::unordered_map<std::string, unsigned> storedKeys;
+			for (unsigned i = 0; i < stored.size(); ++i)
+			{
+				storedKeys[stored[i]] = i;
+			}
+
+			binding.document = &document;
+			binding.byKey.resize(document.layouts.size());
+			for (unsigned i = 0; i < document.layouts.size(); ++i)
+			{
+				const Layout& layout = *document.layouts[i];
+				binding.byKey[i].assign(stored.size(), (const Field*)NULL);
+
+				for (unsigned j = 0; j < layout.fields.size(); ++j)
+				{
+					std::unordered_map<std::string, unsigned>::const_iterator found = storedKeys.find(document.names[layout.fields[j].key]);
+					if (found != storedKeys.end())
+					{
+						binding.byKey[i][found->second] = &layout.fields[j];
+					}
+				}
+			}
+		}
+
+		bool ToReal(const Token& token, double& real)
+		{
+			switch (token.kind)
+			{
+				case Token_Real: real = token.real; return true;
+				case Token_Signed: real = (double)(long long)token.integer; return true;
+				case Token_Unsigned: real = (double)token.integer; return true;
+				default: return false;
+			}
+		}
+
+		//scalar values only; false if the token doesn't fit the member
+		bool Assign(const Field& field, const Token& token, char* value)
+		{
+			bool integer = token.kind == Token_Signed || token.kind == Token_Unsigned;
+			double real;
+
+			switch (field.kind)
+			{
+				case Kind_Signed:
+				case Kind_Unsigned:
+					if (integer)
+						StoreInteger(value, field.size, token.integer);
+					else if (token.kind == Token_Boolean)
+						StoreInteger(value, field.size, token.boolean ? 1 : 0);
+					else
+						return false;
+					return true;
+				case Kind_Boolean:
+					if (token.kind == Token_Boolean)
+						*reinterpret_cast<bool*>(value) = token.boolean;
+					else if (integer)
+						*reinterpret_cast<bool*>(value) = token.integer != 0;
+					else
+						return false;
+					return true;
+				case Kind_Real32:
+					if (!ToReal(token, real)) return false;
+					*reinterpret_cast<float*>(value) = (float)real;
+					return true;
+				case Kind_Real64:
+					if (!ToReal(token, real)) return false;
+					*reinterpret_cast<double*>(value) = real;
+					return true;
+				case Kind_String:
+					if (token.kind != Token_String) return false;
+					reinterpret_cast<std::string*>(value)->assign(token.bytes, token.length);
+					return true;
+				case Kind_Enumeration:
+				{
+					long long enumValue = (long long)token.integer;
+					if (token.kind == Token_String && !field.type->Enum()->FromString(token.bytes, token.length, enumValue))
+						return false;
+					if (!integer && token.kind != Token_String)
+						return false;
+					field.type->Enum()->Set(value, enumValue);
+					return true;
+				}
+				default:
+					return false;
+			}
+		}
+
+		//false if the data is malformed; values that don't fit are reported and skipped
+		bool ReadObject(Reader& reader, const Binding& binding, const Layout& layout, unsigned entries, char* object)
+		{
+			const std::vector<const Field*>& fields = binding.byKey[layout.id];
+
+			for (unsigned i = 0; i < entries; ++i)
+			{
+				Token key;
+				Token value;
+				if (!reader.Next(key) || !reader.Next(value))
+				{
+					return false;
+				}
+
+				const Field* field = key.kind == Token_Unsigned && key.integer < fields.size() ? fields[(size_t)key.integer] : NULL;
+
+				if (field != NULL && field->kind == Kind_Struct && value.kind == Token_Map)
+				{
+					if (!ReadObject(reader, binding, *field->nested, value.length, object + field->offset))
+					{
+						return false;
+					}
+					continue;
+				}
+
+				if (field == NULL || !Assign(*field, value, object + field->offset))
+				{
+					if (field != NULL)
+					{
+						std::cout << "ERROR: MessagePack value doesn't fit " << field->type->Name() << " " << binding.document->names[field->key] << std::endl;
+					}
+					if (!reader.SkipContents(value))
+					{
+						return false;
+					}
+				}
+			}
+
+			return true;
+		}
+
+		//names is NULL when only the header is wanted
+		bool ReadHeader(Reader& reader, MsgPackHeader& header, std::vector<std::string>* names)
+		{
+			Token token;
+			if (!reader.Next(token) || token.kind != Token_Array || token.length != 4)
+				return false;
+			if (!reader.Next(token) || token.kind != Token_String || token.length != 4 || std::memcmp(token.bytes, "meta", 4) != 0)
+				return false;
+			if (!reader.Next(token) || token.kind != Token_String)
+				return false;
+			header.typeName.assign(token.bytes, token.length);
+
+			if (!reader.Next(token) || token.kind != Token_Array)
+				return false;
+			for (unsigned i = 0; i < token.length; ++i)
+			{
+				Token name;
+				if (!reader.Next(name) || name.kind != Token_String)
+					return false;
+				if (names != NULL)
+					names->push_back(std::string(name.bytes, name.length));
+			}
+
+			if (!reader.Next(token) || token.kind != Token_Array)
+				return false;
+			header.count = token.length;
+			return true;
+		}
+	}
+
+	void WriteMsgPack(const Type* type, const void* objects, unsigned count, std::vector<char>& out, unsigned stride)
+	{
+		const Document& document = GetDocument(type);
+		stride = stride != 0 ? stride : type->Size();
+
+		Writer writer(out);
+		writer.Array(4);
+		writer.String("meta", 4);
+		writer.String(type->Name().data(), type->Name().size());
+
+		writer.Array((unsigned)document.names.size());
+		for (unsigned i = 0; i < document.names.size(); ++i)
+		{
+			writer.String(document.names[i].data(), document.names[i].size());
+		}
+
+		writer.Array(count);
+		const char* object = static_cast<const char*>(objects);
+		for (unsigned i = 0; i < count; ++i, object += stride)
+		{
+			WriteObject(writer, *document.layouts[0], object);
+		}
+	}
+
+	bool ReadMsgPackHeader(const char* data, size_t size, MsgPackHeader& header)
+	{
+		Reader reader(data, size);
+		return ReadHeader(reader, header, NULL);
+	}
+
+	bool ReadMsgPack(const Type* type, const char* data, size_t size, void* objects, unsigned capacity, unsigned stride)
+	{
+		Reader reader(data, size);
+		MsgPackHeader header;
+		std::vector<std::string> names;
+
+		if (!ReadHeader(reader, header, &names))
+		{
+			std::cout << "Not a meta MessagePack document" << std::endl;
+			return false;
+		}
+		if (header.count > capacity)
+		{
+			std::cout << "MessagePack document holds " << header.count << " " << header.typeName << ", room for " << capacity << std::endl;
+			return false;
+		}
+
+		const Document& document = GetDocument(type);
+		Binding binding;
+		Bind(document, names, binding);
+
+		stride = stride != 0 ? stride : type->Size();
+		char* object = static_cast<char*>(objects);
+		for (unsigned i = 0; i < header.count; ++i, object += stride)
+		{
+			Token token;
+			if (!reader.Next(token) || token.kind != Token_Map || !ReadObject(reader, binding, *document.layouts[0], token.length, object))
+			{
+				std::cout << "Malformed MessagePack " << header.typeName << " document" << std::endl;
+				return false;
+			}
+		}
+
+		return true;
+	}
+}
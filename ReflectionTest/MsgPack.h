@@ -0,0 +1,42 @@
+#pragma once
+
+#include "Meta.h"
+
+namespace meta
+{
+	//////////////////////////////////////////////////////////////////////////////
+	//  MessagePack Encoding
+	//////////////////////////////////////////////////////////////////////////////
+	// Purpose: A compact, self describing binary form of reflected types for data passed
+	//          between tools built at different versions. The output is plain MessagePack:
+	//
+	//              ["meta", typeName, [memberName...], [object...]]
+	//
+	// Member names are written once, in the name table, and each object is a map from a
+	// small integer key (the name's index in the table) to the member's value, with nested
+	// value types as nested maps. Integers take the fewest bytes that hold them.
+	//
+	// Reading matches the stored names against the type's members once per document, then
+	// decodes straight into the objects without building a DOM. Keys the type doesn't have
+	// and values of the wrong kind are skipped, so older and newer data both load. A skipped
+	// value nested more than 128 arrays and maps deep fails the document.
+	// Members json can't hold (raw pointers) aren't written.
+
+	struct MsgPackHeader
+	{
+		std::string typeName;
+		unsigned count;
+	};
+
+	//Appends count objects of a type to out. Objects are stride bytes apart (0 means type->Size()).
+	void WriteMsgPack(const Type* type, const void* objects, unsigned count, std::vector<char>& out, unsigned stride = 0);
+
+	//false if data isn't a meta MessagePack document
+	bool ReadMsgPackHeader(const char* data, size_t size, MsgPackHeader& header);
+
+	//Loads a document into header.count already constructed objects, stride bytes apart (0 means type->Size()).
+	//false if the data is malformed or capacity is too small.
+	bool ReadMsgPack(const Type* type, const char* data, size_t size, void* objects, unsigned capacity, unsigned stride = 0);
+}
+
+void TestMsgPack();
@@ -0,0 +1,99 @@
+#include "MsgPack.h"
+#include "SerializationTest.h"
+#include "jansson.h"
+#include <chrono>
+
+void TestMsgPack()
+{
+	typedef std::chrono::high_resolution_clock Clock;
+
+	//ThingFile.json's Thing, scaled up to a large array
+	const unsigned count = 100000;
+	std::vector<Thing> things(count, Thing());
+	for (unsigned i = 0; i < count; ++i)
+	{
+		things[i].id = i;
+		things[i].size = (int)(i % 1000) - 500;
+		things[i].name = "Thing";
+		things[i].radius = 5.0f + (float)i * 0.25f;
+		things[i].height = 22.5 * i;
+		things[i].position = Vector3(11.0f, 2.0f, (float)i);
+		things[i].kind = (i & 1) ? Thing_Apple : Thing_Banana;
+	}
+
+	const meta::Type* thingType = meta::get<Thing>();
+
+	Clock::time_point start = Clock::now();
+	std::vector<char> packed;
+	meta::WriteMsgPack(thingType, things.data(), count, packed);
+	std::chrono::duration<double, std::milli> packWrite = Clock::now() - start;
+
+	meta::MsgPackHeader header;
+	if (!meta::ReadMsgPackHeader(packed.data(), packed.size(), header) || header.typeName != "Thing" || header.count != count)
+		printf("MessagePack header didn't round trip\n");
+
+	std::vector<Thing> loaded(count, Thing());
+	start = Clock::now();
+	bool read = meta::ReadMsgPack(thingType, packed.data(), packed.size(), loaded.data(), count);
+	std::chrono::duration<double, std::milli> packRead = Clock::now() - start;
+
+	for (unsigned i = 0; read && i < count; ++i)
+	{
+		if (loaded[i].id != i || loaded[i].size != things[i].size || loaded[i].name != "Thing" || loaded[i].radius != things[i].radius ||
+			loaded[i].height != things[i].height || loaded[i].position.z != (float)i || loaded[i].kind != things[i].kind)
+		{
+			printf("MessagePack didn't round trip Thing %u\n", i);
+			break;
+		}
+	}
+	if (!read)
+		printf("MessagePack didn't read back\n");
+
+	//a tool that only knows Entity reads Thing data, skipping what it doesn't know
+	std::vector<Entity> entities(count);
+	if (!meta::ReadMsgPack(meta::get<Entity>(), packed.data(), packed.size(), entities.data(), count) || entities[count - 1].id != count - 1)
+		printf("MessagePack Thing data didn't load as Entity\n");
+
+	//truncated data is reported, not read past
+	if (meta::ReadMsgPack(thingType, packed.data(), packed.size() / 2, loaded.data(), count))
+		printf("MessagePack read a truncated document\n");
+
+	//a value for a key Thing doesn't have is skipped, unless it nests deep enough to run off the stack
+	const unsigned depths[] = { 16, 100000 };
+	for (unsigned d = 0; d < 2; ++d)
+	{
+		unsigned depth = depths[d];
+		const char prefix[] = "\x94\xa4meta\xa5Thing\x91\xa7unknown\x91\x81\x00";
+		std::vector<char> nested(prefix, prefix + sizeof(prefix) - 1);
+		nested.insert(nested.end(), depth, '\x91');
+		nested.push_back('\xc0');
+		Thing thing;
+		if (meta::ReadMsgPack(thingType, nested.data(), nested.size(), &thing, 1) != (depth == 16))
+			printf("MessagePack skipped a value %u arrays deep wrongly\n", depth);
+	}
+
+	//the json path, for comparison
+	start = Clock::now();
+	json_t* array = json_array();
+	for (unsigned i = 0; i < count; ++i)
+		json_array_append_new(array, SerializeJsonObject(&things[i], "Thing"));
+	char* text = json_dumps(array, JSON_COMPACT);
+	std::chrono::duration<double, std::milli> jsonWrite = Clock::now() - start;
+	size_t jsonSize = strlen(text);
+	json_decref(array);
+
+	start = Clock::now();
+	json_error_t error;
+	array = json_loads(text, 0, &error);
+	for (unsigned i = 0; i < json_array_size(array); ++i)
+		DeSerializeJsonObject(json_array_get(array, i), &loaded[i], "Thing");
+	std::chrono::duration<double, std::milli> jsonRead = Clock::now() - start;
+	json_decref(array);
+	free(text);
+
+	printf("%u Things, bytes and ms:\n", count);
+	printf("%18s %10s %8s %8s\n", "", "size", "write", "read");
+	printf("%18s %10u %8.2f %8.2f\n", "json", (unsigned)jsonSize, jsonWrite.count(), jsonRead.count());
+	printf("%18s %10u %8.2f %8.2f\n", "MessagePack", (unsigned)packed.size(), packWrite.count(), packRead.count());
+	printf("\n");
+}
@@ -0,0 +1,185 @@
+#include "NdJson.h"
+#include "MmapJson.h"
+#include "Trace.h"
+#include "WorkStealing.h"
+#include <algorithm>
+#include <chrono>
+
+namespace meta
+{
+	namespace
+	{
+		typedef std::chrono::high_resolution_clock Clock;
+		typedef std::chrono::duration<double, std::milli> Milliseconds;
+
+		struct Chunk
+		{
+			char* begin;
+			char* end;
+			char* objects;		//in the slab of the worker that parsed it
+			unsigned capacity;	//objects constructed: one per line
+			unsigned count;		//objects filled, the first ones
+			unsigned failed;
+			unsigned offset;	//of the first object in the joined array
+		};
+
+		bool IsBlank(const char* begin, const char* end)
+		{
+			for (; begin < end; ++begin)
+			{
+				if (*begin != ' ' && *begin != '\t' && *begin != '\r')
+				{
+					return false;
+				}
+			}
+			return true;
+		}
+
+		void ParseChunk(Chunk& chunk, const Type* type, MonotonicArena& slab, StringPool& pool)
+		{
+			TraceSpan span("parse chunk", type, chunk.end - chunk.begin);
+
+			chunk.capacity = 1;
+			for (const char* c = chunk.begin; c < chunk.end - 1; ++c)
+			{
+				chunk.capacity += *c == '\n';
+			}
+			chunk.objects = static_cast<char*>(NewObjects(type, chunk.capacity, &slab));
+			chunk.count = 0;
+			chunk.failed = 0;
+			if (chunk.objects == NULL)
+			{
+				chunk.capacity = 0;
+				return;
+			}
+
+			unsigned size = type->Size();
+			for (char* line = chunk.begin; line < chunk.end;)
+			{
+				char* end = static_cast<char*>(std::memchr(line, '\n', chunk.end - line));
+				end = end != NULL ? end : chunk.end;
+
+				if (!IsBlank(line, end))
+				{
+					char* object = chunk.objects + (size_t)chunk.count * size;
+					if (ParseJsonInSitu(line, end - line, type, object, pool))
+					{
+						++chunk.count;
+					}
+					else
+					{
+						//start the next line on a fresh object
+						++chunk.failed;
+						ScopedResource scope(&slab);
+						type->Destruct(object);
+						type->Construct(object);
+					}
+				}
+				line = end + 1;
+			}
+		}
+
+		//moves a chunk's objects to their place in the array and destructs every object it constructed
+		void JoinChunk(const Chunk& chunk, const Type* type, char* objects, MemoryResource* resource)
+		{
+			unsigned size = type->Size();
+			char* to = objects + (size_t)chunk.offset * size;
+			if (type->IsTriviallyCopyable())
+			{
+				if (chunk.count > 0)
+				{
+					std::memcpy(to, chunk.objects, (size_t)chunk.count * size);
+				}
+			}
+			else
+			{
+				ScopedResource scope(resource);
+				for (unsigned i = 0; i < chunk.count; ++i)
+				{
+					type->Construct(to + (size_t)i * size);
+					type->Move(to + (size_t)i * size, chunk.objects + (size_t)i * size);
+				}
+			}
+
+			for (unsigned i = 0; i < chunk.capacity; ++i)
+			{
+				type->Destruct(chunk.objects + (size_t)i * size);
+			}
+		}
+	}
+
+	IngestStats IngestNdJson(char* text, size_t size, const Type* type, void*& objects, StringPool& pool, const IngestOptions& options)
+	{
+		IngestStats stats;
+		objects = NULL;
+		if (!type->IsConstructible())
+		{
+			std::cout << type->Name() << " can't be default constructed" << std::endl;
+			return stats;
+		}
+
+		Clock::time_point start = Clock::now();
+
+		//chunks run on to the end of the line they stop in
+		std::vector<Chunk> chunks;
+		size_t chunkSize = options.chunkSize > 0 ? options.chunkSize : 1;
+		for (char* begin = text; begin < text + size;)
+		{
+			char* end = begin + std::min(chunkSize, (size_t)(text + size - begin));
+			char* newline = static_cast<char*>(std::memchr(end - 1, '\n', text + size - (end - 1)));
+			end = newline != NULL ? newline + 1 : text + size;
+
+			Chunk chunk = { begin, end, NULL, 0, 0, 0, 0 };
+			chunks.push_back(chunk);
+			begin = end;
+		}
+		stats.chunks = (unsigned)chunks.size();
+		stats.threads = WorkStealingThreads(stats.chunks, options.threads);
+		Clock::time_point split = Clock::now();
+
+		//one slab per worker
+		std::vector<MonotonicArena*> slabs(stats.threads);
+		for (unsigned i = 0; i < slabs.size(); ++i)
+		{
+			slabs[i] = new MonotonicArena(std::max(chunkSize * 2, (size_t)64 * 1024));
+		}
+
+		stats.steals = RunWorkStealing(stats.chunks, stats.threads, [&](unsigned index, unsigned worker)
+		{
+			ParseChunk(chunks[index], type, *slabs[worker], pool);
+		});
+		Clock::time_point parsed = Clock::now();
+
+		for (unsigned i = 0; i < chunks.size(); ++i)
+		{
+			chunks[i].offset = stats.records;
+			stats.records += chunks[i].count;
+			stats.failed += chunks[i].failed;
+		}
+
+		char* joined = NULL;
+		if (stats.records > 0)
+		{
+			joined = static_cast<char*>(options.resource->Allocate((size_t)stats.records * type->Size(), type->Alignment()));
+		}
+		//copies join on every worker, moves that allocate in the resource on one
+		unsigned joiners = type->IsTriviallyCopyable() ? stats.threads : 1;
+		stats.steals += RunWorkStealing(stats.chunks, joiners, [&](unsigned index, unsigned)
+		{
+			JoinChunk(chunks[index], type, joined, options.resource);
+		});
+
+		for (unsigned i = 0; i < slabs.size(); ++i)
+		{
+			delete slabs[i];
+		}
+		objects = joined;
+		Clock::time_point done = Clock::now();
+
+		stats.split = Milliseconds(split - start).count();
+		stats.parse = Milliseconds(parsed - split).count();
+		stats.join = Milliseconds(done - parsed).count();
+		stats.total = Milliseconds(done - start).count();
+		return stats;
+	}
+}
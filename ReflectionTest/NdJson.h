@@ -0,0 +1,53 @@
+#pragma once
+
+#include "Meta.h"
+#include "Arena.h"
+#include "StringPool.h"
+
+namespace meta
+{
+	//////////////////////////////////////////////////////////////////////////////
+	//  NDJSON ingestion
+	//////////////////////////////////////////////////////////////////////////////
+	// Purpose: Loads newline delimited json, one object per line, into one contiguous array with
+	//          every core. The text is split into chunks on line boundaries and the chunks are
+	//          parsed in situ on a work stealing pool. Each worker deserializes into objects in
+	//          its own slab (a MonotonicArena, so workers never share an allocator), and the slabs
+	//          are joined into the array in line order by moving the objects, again on the pool
+	//          unless the moves allocate in options.resource, which needn't be thread safe.
+	//
+	//          Lines parse like ParseJsonInSitu, so the text must be writable (a MappedFile is)
+	//          and StringView members point into it. Blank lines are skipped; lines that don't
+	//          parse are reported, counted and left out.
+
+	struct IngestOptions
+	{
+		IngestOptions() : threads(0), chunkSize(1024 * 1024), resource(HeapResource()) {}
+
+		unsigned threads;			//0 uses every hardware thread
+		size_t chunkSize;			//bytes per chunk, before running on to the end of a line
+		MemoryResource* resource;	//where the joined array and its arena members go
+	};
+
+	//milliseconds per phase; parse and join are wall clock over all the workers
+	struct IngestStats
+	{
+		IngestStats() : split(0.0), parse(0.0), join(0.0), total(0.0), threads(0), chunks(0), steals(0), records(0), failed(0) {}
+
+		double split;
+		double parse;
+		double join;
+		double total;
+		unsigned threads;
+		unsigned chunks;
+		unsigned steals;	//across both phases
+		unsigned records;	//objects in the array
+		unsigned failed;	//lines left out
+	};
+
+	//Sets objects to an array of stats.records objects of type, in options.resource, in line order;
+	//NULL if there are none. Free it with DeleteObjects(type, objects, stats.records, options.resource).
+	IngestStats IngestNdJson(char* text, size_t size, const Type* type, void*& objects, StringPool& pool, const IngestOptions& options = IngestOptions());
+}
+
+void TestNdJson();
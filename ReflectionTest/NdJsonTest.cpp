@@ -0,0 +1,111 @@
+#include "NdJson.h"
+#include "MmapJson.h"
+#include "SerializationTest.h"
+#include "Test.h"
+#include "WorkStealing.h"
+#include <atomic>
+#include <cstdio>
+#include <thread>
+
+void TestNdJson()
+{
+	//every task runs once, however the workers steal
+	{
+		const unsigned tasks = 1000;
+		std::vector<std::atomic<unsigned> > runs(tasks);
+		for (unsigned i = 0; i < tasks; ++i)
+			runs[i] = 0;
+		meta::RunWorkStealing(tasks, 7, [&](unsigned index, unsigned worker)
+		{
+			++runs[index];
+			if (worker == 0 && index % 3 == 0)
+				std::this_thread::yield();
+		});
+		for (unsigned i = 0; i < tasks; ++i)
+		{
+			if (runs[i] != 1)
+			{
+				printf("Work stealing ran task %u %u times\n", i, runs[i].load());
+				break;
+			}
+		}
+	}
+
+	//blank, \r\n terminated, wrapped and malformed lines; the malformed one is left out
+	const unsigned lines = 200000;
+	const char* path = "NdJsonThings.ndjson";
+	FILE* out = fopen(path, "wb");
+	for (unsigned i = 0; i < lines; ++i)
+	{
+		if (i == 5)
+			fprintf(out, "{ \"id\": 5, \"name\": }\n");
+		else if (i == 6)
+			fprintf(out, "{ \"Thing\": { \"id\": 6, \"name\": \"wrapped\" } }\r\n\n");
+		else
+			fprintf(out, "{ \"id\": %u, \"size\": %u, \"name\": \"thing number %u\", \"radius\": %u.5, \"height\": 2.25, \"position\": { \"x\": 1, \"y\": 2, \"z\": %u }, \"kind\": \"Thing_Apple\" }\n",
+				i, i % 77, i, i % 10, i % 1000);
+	}
+	fclose(out);
+
+	std::vector<unsigned> threadCounts;
+	for (unsigned threads = 1; threads <= 16; threads *= 2)
+		threadCounts.push_back(threads);
+
+	//rows are printed after the runs, so the malformed line's report doesn't split the table
+	std::string rows;
+	for (unsigned t = 0; t < threadCounts.size(); ++t)
+	{
+		meta::MappedFile file;
+		if (!file.Open(path))
+		{
+			printf("Can't map %s\n", path);
+			break;
+		}
+
+		meta::StringPool pool;
+		meta::IngestOptions options;
+		options.threads = threadCounts[t];
+		options.chunkSize = 256 * 1024;
+		void* objects;
+		meta::IngestStats stats = meta::IngestNdJson(file.Data(), file.Size(), meta::get<Thing>(), objects, pool, options);
+
+		Thing* things = static_cast<Thing*>(objects);
+		bool ordered = stats.records == lines - 1 && stats.failed == 1 && things[5].id == 6 && things[5].name == "wrapped";
+		for (unsigned i = 0; ordered && i < stats.records; ++i)
+		{
+			unsigned id = i < 5 ? i : i + 1;
+			ordered = things[i].id == id && (id == 6 || (things[i].size == (int)(id % 77) && things[i].position.z == (float)(id % 1000)));
+		}
+		if (!ordered)
+			printf("%u threads ingested %u Things out of order\n", threadCounts[t], stats.records);
+
+		char row[128];
+		sprintf(row, "%18u %8u %8u %8.2f %8.2f %8.2f %8.1f\n", stats.threads, stats.chunks, stats.steals, stats.parse, stats.join, stats.total,
+			file.Size() / 1048576.0 / (stats.total / 1000.0));
+		rows += row;
+		meta::DeleteObjects(meta::get<Thing>(), objects, stats.records, options.resource);
+	}
+	printf("%u NDJSON Things, ms:\n", lines);
+	printf("%18s %8s %8s %8s %8s %8s %8s\n", "threads", "chunks", "steals", "parse", "join", "total", "MB/s");
+	printf("%s\n", rows.c_str());
+	remove(path);
+
+	//joined into an arena, arena members and all
+	{
+		char text[] = "{ \"id\": 1, \"title\": \"the first article, long enough to allocate\", \"tags\": [\"one tag long enough to allocate\"] }\n\n"
+			"{ \"id\": 2, \"title\": \"the second article, long enough to allocate\", \"scores\": [2.5] }";
+		meta::MonotonicArena arena;
+		meta::StringPool pool;
+		meta::IngestOptions options;
+		options.threads = 2;
+		options.chunkSize = 16;
+		options.resource = &arena;
+		void* objects;
+		meta::IngestStats stats = meta::IngestNdJson(text, sizeof(text) - 1, meta::get<Article>(), objects, pool, options);
+		Article* articles = static_cast<Article*>(objects);
+		if (stats.records != 2 || stats.chunks != 2 || articles[1].id != 2 || articles[1].scores.size() != 1 ||
+			articles[0].title.get_allocator().Resource() != &arena || articles[0].tags.get_allocator().Resource() != &arena ||
+			articles[0].tags[0].get_allocator().Resource() != &arena)
+			printf("Articles didn't ingest into an arena\n");
+	}
+}
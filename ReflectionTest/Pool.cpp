@@ -0,0 +1,226 @@
+#include "Pool.h"
+#include <memory>
+
+namespace meta
+{
+	//////////////////////////////////////////////////////////////////////////////
+	//  TypePool
+	//////////////////////////////////////////////////////////////////////////////
+
+	TypePool::TypePool(const Type* type, unsigned objectsPerSlab) :
+		type(type),
+		objectsPerSlab(objectsPerSlab > 0 ? objectsPerSlab : 1),
+		live(0),
+		bump(NULL),
+		bumpEnd(NULL),
+		freeList(NULL)
+	{
+		assert(type->Size() > 0);				//can't pool void
+		assert(type->Alignment() <= sizeof(double) * 2);	//slabs come from operator new[]
+
+		//every slot must be able to hold a free list link, and keep the next slot aligned
+		unsigned align = type->Alignment();
+		unsigned slot = type->Size() > sizeof(FreeSlot) ? type->Size() : (unsigned)sizeof(FreeSlot);
+		stride = (slot + align - 1) / align * align;
+	}
+
+	TypePool::~TypePool()
+	{
+		//instances still alive are not destructed; their memory goes away with the slabs.
+		for (unsigned i = 0; i < slabs.size(); ++i)
+		{
+			delete[] slabs[i];
+		}
+	}
+
+	void TypePool::AddSlab(unsigned count)
+	{
+		//keep what is left of the current slab around for later runs
+		if (bump != bumpEnd)
+		{
+			FreeRun leftover = { bump, (unsigned)((bumpEnd - bump) / stride) };
+			freeRuns.push_back(leftover);
+		}
+
+		char* slab = new char[count * stride];
+		slabs.push_back(slab);
+		bump = slab;
+		bumpEnd = slab + count * stride;
+	}
+
+	char* TypePool::Allocate(unsigned count)
+	{
+		if ((unsigned)((bumpEnd - bump) / stride) < count)
+		{
+			AddSlab(count > objectsPerSlab ? count : objectsPerSlab);
+		}
+
+		char* first = bump;
+		bump += count * stride;
+		return first;
+	}
+
+	char* TypePool::TakeSlot(void)
+	{
+		char* object;
+
+		if (freeList != NULL)
+		{
+			object = reinterpret_cast<char*>(freeList);
+			freeList = freeList->next;
+		}
+		else if (!freeRuns.empty())
+		{
+			FreeRun& run = freeRuns.back();
+			object = run.first;
+			run.first += stride;
+			if (--run.count == 0)
+			{
+				freeRuns.pop_back();
+			}
+		}
+		else
+		{
+			object = Allocate(1);
+		}
+
+		return object;
+	}
+
+	void* TypePool::Create(void)
+	{
+		char* object = TakeSlot();
+		type->Construct(object);
+		++live;
+		return object;
+	}
+
+	void* TypePool::CreateCopy(const void* src)
+	{
+		char* object = TakeSlot();
+		type->CopyConstruct(object, src);
+		++live;
+		return object;
+	}
+
+	void TypePool::Destroy(void* object)
+	{
+		if (object == NULL)
+		{
+			return;
+		}
+
+		type->Destruct(object);
+
+		FreeSlot* slot = reinterpret_cast<FreeSlot*>(object);
+		slot->next = freeList;
+		freeList = slot;
+		--live;
+	}
+
+	void* TypePool::CreateN(unsigned count)
+	{
+		if (count == 0)
+		{
+			return NULL;
+		}
+
+		char* first = NULL;
+
+		//first fit over previously freed runs
+		for (unsigned i = 0; i < freeRuns.size(); ++i)
+		{
+			FreeRun& run = freeRuns[i];
+			if (run.count >= count)
+			{
+				first = run.first;
+				run.first += count * stride;
+				run.count -= count;
+				if (run.count == 0)
+				{
+					freeRuns[i] = freeRuns.back();
+					freeRuns.pop_back();
+				}
+				break;
+			}
+		}
+
+		if (first == NULL)
+		{
+			first = Allocate(count);
+		}
+
+		for (unsigned i = 0; i < count; ++i)
+		{
+			type->Construct(first + i * stride);
+		}
+
+		live += count;
+		return first;
+	}
+
+	void TypePool::DestroyN(void* first, unsigned count)
+	{
+		if (first == NULL || count == 0)
+		{
+			return;
+		}
+
+		char* object = static_cast<char*>(first);
+		for (unsigned i = 0; i < count; ++i)
+		{
+			type->Destruct(object + i * stride);
+		}
+
+		FreeRun run = { object, count };
+		freeRuns.push_back(run);
+		live -= count;
+	}
+
+	//////////////////////////////////////////////////////////////////////////////
+	//  Pool Factory Functions
+	//////////////////////////////////////////////////////////////////////////////
+
+	TypePool& GetPool(const Type* type)
+	{
+		typedef std::unordered_map<const Type*, std::unique_ptr<TypePool> > PoolMap;
+		static PoolMap pools;
+
+		std::unique_ptr<TypePool>& pool = pools[type];
+		if (!pool)
+		{
+			pool.reset(new TypePool(type));
+		}
+		return *pool;
+	}
+
+	void* Create(const Type* type)
+	{
+		return GetPool(type).Create();
+	}
+
+	void* Create(const std::string& typeName)
+	{
+		const Type* type = meta::get_name(typeName);
+		if (type == NULL)
+		{
+			return NULL;
+		}
+		return GetPool(type).Create();
+	}
+
+	void Destroy(const Type* type, void* object)
+	{
+		GetPool(type).Destroy(object);
+	}
+
+	void* CreateN(const Type* type, unsigned count)
+	{
+		return GetPool(type).CreateN(count);
+	}
+
+	void DestroyN(const Type* type, void* first, unsigned count)
+	{
+		GetPool(type).DestroyN(first, count);
+	}
+}
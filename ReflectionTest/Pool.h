@@ -0,0 +1,85 @@
+#pragma once
+
+#include "Meta.h"
+
+namespace meta
+{
+	//////////////////////////////////////////////////////////////////////////////
+	//  TypePool
+	//////////////////////////////////////////////////////////////////////////////
+	// Purpose: Constructs and destroys instances of one meta::Type out of slabs of memory.
+	//          Freed instances go onto a per-type free list, and bulk requests are served
+	//          as contiguous runs so instances of a type stay next to each other.
+	//          Not thread safe.
+	class TypePool
+	{
+	public:
+		TypePool(const Type* type, unsigned objectsPerSlab = 256);
+		~TypePool();
+
+		const Type* GetType(void) const { return type; }
+		unsigned Stride(void) const { return stride; }
+		unsigned LiveCount(void) const { return live; }
+
+		//Single instances. Destroy must be given a pointer from Create/CreateCopy.
+		void* Create(void);
+		void* CreateCopy(const void* src);
+		void Destroy(void* object);
+
+		//Contiguous runs. Instance i lives at (char*)first + i * Stride().
+		void* CreateN(unsigned count);
+		void DestroyN(void* first, unsigned count);
+
+	private:
+		// Non-Copyable
+		TypePool(const TypePool&); // = delete
+		void operator=(const TypePool&); // = delete
+
+		struct FreeSlot { FreeSlot* next; };
+		struct FreeRun { char* first; unsigned count; };
+
+		char* TakeSlot(void);
+		char* Allocate(unsigned count);
+		void AddSlab(unsigned count);
+
+		const Type* type;
+		unsigned stride;
+		unsigned objectsPerSlab;
+		unsigned live;
+
+		std::vector<char*> slabs;
+		char* bump;					//next unused slot of the newest slab
+		char* bumpEnd;
+		FreeSlot* freeList;			//single freed slots
+		std::vector<FreeRun> freeRuns;	//freed runs, reused first-fit by CreateN
+	};
+
+	//////////////////////////////////////////////////////////////////////////////
+	//  Pool Factory Functions
+	//////////////////////////////////////////////////////////////////////////////
+
+	//Get the pool owning instances of a type. Created on first use.
+	TypePool& GetPool(const Type* type);
+
+	//construct instances by type or by registered type name (NULL if the name isn't registered)
+	void* Create(const Type* type);
+	void* Create(const std::string& typeName);
+	void Destroy(const Type* type, void* object);
+
+	void* CreateN(const Type* type, unsigned count);
+	void DestroyN(const Type* type, void* first, unsigned count);
+
+	template<typename T>
+	T* Create()
+	{
+		return static_cast<T*>(Create(meta::get<T>()));
+	}
+
+	template<typename T>
+	void Destroy(T* object)
+	{
+		Destroy(meta::get<T>(), object);
+	}
+}
+
+void TestObjectPool();
@@ -0,0 +1,101 @@
+#include "Pool.h"
+#include "SerializationTest.h"
+#include <chrono>
+
+//counts live instances, to check the pools run constructors and destructors
+struct Counted
+{
+	static int alive;
+
+	double value;
+
+	Counted() : value(7.0) { ++alive; }
+	Counted(const Counted& other) : value(other.value) { ++alive; }
+	~Counted() { --alive; }
+
+	//assigning changes no count
+	Counted& operator=(const Counted& other) { value = other.value; return *this; }
+
+	meta_expose_internal(Counted);
+};
+
+int Counted::alive = 0;
+
+meta_define(Counted)
+{
+	meta_add_member(value);
+}
+
+static double ElapsedNs(std::chrono::high_resolution_clock::time_point start, unsigned count)
+{
+	std::chrono::duration<double, std::nano> elapsed = std::chrono::high_resolution_clock::now() - start;
+	return elapsed.count() / count;
+}
+
+void TestObjectPool()
+{
+	typedef std::chrono::high_resolution_clock Clock;
+
+	//spawn by type name
+	Thing* thing = static_cast<Thing*>(meta::Create("Thing"));
+	thing->name = "spawned by name";
+	printf("Create(\"Thing\"): %s, radius %.2f\n", thing->name.c_str(), thing->radius);
+	meta::Destroy(thing);
+
+	//constructors and destructors run, bulk instances are contiguous, freed runs are reused
+	meta::TypePool& pool = meta::GetPool(meta::get<Counted>());
+	Counted* run = static_cast<Counted*>(pool.CreateN(100));
+	if (Counted::alive != 100 || run[99].value != 7.0)
+		printf("CreateN didn't construct 100 Counted\n");
+	if (pool.Stride() != sizeof(Counted))
+		printf("Counted instances aren't contiguous\n");
+
+	pool.DestroyN(run, 100);
+	if (Counted::alive != 0)
+		printf("DestroyN didn't destruct 100 Counted\n");
+
+	Counted* reused = static_cast<Counted*>(pool.CreateN(50));
+	if (reused != run)
+		printf("DestroyN'd run wasn't reused\n");
+	pool.DestroyN(reused, 50);
+
+	//spawn/despawn rates against plain new/delete
+	const unsigned count = 100000;
+	const unsigned rounds = 10;
+	std::vector<Thing*> things(count);
+	const meta::Type* thingType = meta::get<Thing>();
+
+	Clock::time_point start = Clock::now();
+	for (unsigned r = 0; r < rounds; ++r)
+	{
+		for (unsigned i = 0; i < count; ++i)
+			things[i] = new Thing;
+		for (unsigned i = 0; i < count; ++i)
+			delete things[i];
+	}
+	double newDelete = ElapsedNs(start, count * rounds);
+
+	start = Clock::now();
+	for (unsigned r = 0; r < rounds; ++r)
+	{
+		for (unsigned i = 0; i < count; ++i)
+			things[i] = static_cast<Thing*>(meta::Create(thingType));
+		for (unsigned i = 0; i < count; ++i)
+			meta::Destroy(thingType, things[i]);
+	}
+	double createDestroy = ElapsedNs(start, count * rounds);
+
+	start = Clock::now();
+	for (unsigned r = 0; r < rounds; ++r)
+	{
+		void* first = meta::CreateN(thingType, count);
+		meta::DestroyN(thingType, first, count);
+	}
+	double createN = ElapsedNs(start, count * rounds);
+
+	printf("Thing spawn+despawn, ns per object:\n");
+	printf("%18s %8.2f\n", "new/delete", newDelete);
+	printf("%18s %8.2f\n", "Create/Destroy", createDestroy);
+	printf("%18s %8.2f\n", "CreateN/DestroyN", createN);
+	printf("\n");
+}
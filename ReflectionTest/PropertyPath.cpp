@@ -0,0 +1,64 @@
+#include "PropertyPath.h"
+#include "Gather.h"
+
+namespace meta
+{
+	PropertyPath::PropertyPath(const Type* root, const std::string& path) :
+		root(root),
+		leaf(NULL),
+		offset(0),
+		path(path)
+	{
+		const Type* type = root;
+		unsigned total = 0;
+		size_t begin = 0;
+
+		while (true)
+		{
+			size_t dot = path.find('.', begin);
+			std::string segment = path.substr(begin, dot == std::string::npos ? std::string::npos : dot - begin);
+
+			std::unordered_map<std::string, const Member *>::const_iterator found = type->mamberNames.find(segment);
+			if (found == type->mamberNames.end())
+			{
+				std::cout << type->Name() << " doesn't contain member: " << segment << " (in path " << path << ")" << std::endl;
+				return;
+			}
+
+			total += found->second->Offset();
+			type = found->second->Meta();
+
+			if (dot == std::string::npos)
+			{
+				break;
+			}
+			begin = dot + 1;
+		}
+
+		leaf = type;
+		offset = total;
+	}
+
+	void PropertyPath::Read(const void* objects, unsigned count, unsigned stride, void* out) const
+	{
+		assert(IsValid());
+		if (stride == 0)
+		{
+			stride = root->Size();
+		}
+
+		const char* object = static_cast<const char*>(objects) + offset;
+
+		if (!leaf->IsTriviallyCopyable())
+		{
+			char* to = static_cast<char*>(out);
+			for (unsigned i = 0; i < count; ++i, object += stride)
+			{
+				leaf->Copy(to + i * leaf->Size(), object);
+			}
+			return;
+		}
+
+		GatherBytes(objects, offset, leaf->Size(), count, stride, out);
+	}
+}
@@ -0,0 +1,69 @@
+#pragma once
+
+#include "Meta.h"
+
+namespace meta
+{
+	//////////////////////////////////////////////////////////////////////////////
+	//  PropertyPath
+	//////////////////////////////////////////////////////////////////////////////
+	// Purpose: A dotted member path ("position.x") compiled once against a type.
+	//          Nested value members collapse into one byte offset from the root object and
+	//          the leaf's type, so reading or writing through the path is a pointer add.
+	class PropertyPath
+	{
+	public:
+		PropertyPath() : root(NULL), leaf(NULL), offset(0) {}
+
+		//Compiles path against root. Check IsValid(); an unknown segment is reported and leaves it invalid.
+		PropertyPath(const Type* root, const std::string& path);
+
+		bool IsValid(void) const { return leaf != NULL; }
+		const Type* Root(void) const { return root; }
+		const Type* Leaf(void) const { return leaf; }
+		unsigned Offset(void) const { return offset; }
+		const std::string& Path(void) const { return path; }
+
+		void* Resolve(void* object) const { return static_cast<char*>(object) + offset; }
+		const void* Resolve(const void* object) const { return static_cast<const char*>(object) + offset; }
+
+		template <typename T>
+		T& Get(void* object) const
+		{
+			assert(meta::get<T>() == leaf); //path leads to another type
+			return *reinterpret_cast<T*>(static_cast<char*>(object) + offset);
+		}
+
+		template <typename T>
+		const T& Get(const void* object) const
+		{
+			assert(meta::get<T>() == leaf); //path leads to another type
+			return *reinterpret_cast<const T*>(static_cast<const char*>(object) + offset);
+		}
+
+		template <typename T>
+		void Set(void* object, const T& value) const
+		{
+			Get<T>(object) = value;
+		}
+
+		//Reads the leaf out of count objects, stride bytes apart (0 means Root()->Size()), into out (count
+		//leaf values, already constructed). Trivially copyable leaves go through the GatherBytes kernels.
+		void Read(const void* objects, unsigned count, unsigned stride, void* out) const;
+
+		template <typename T>
+		void Read(const void* objects, unsigned count, unsigned stride, T* out) const
+		{
+			assert(meta::get<T>() == leaf); //path leads to another type
+			Read(objects, count, stride, static_cast<void*>(out));
+		}
+
+	private:
+		const Type* root;
+		const Type* leaf;
+		unsigned offset;
+		std::string path;
+	};
+}
+
+void TestPropertyPath();
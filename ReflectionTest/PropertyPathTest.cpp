@@ -0,0 +1,97 @@
+#include "PropertyPath.h"
+#include "SerializationTest.h"
+#include <chrono>
+
+//what editor bindings did before: look every segment up, one level at a time
+static void* WalkPath(const meta::Type* type, void* object, const std::vector<std::string>& segments)
+{
+	char* at = static_cast<char*>(object);
+	for (unsigned i = 0; i < segments.size(); ++i)
+	{
+		const meta::Member* member = type->mamberNames.at(segments[i]);
+		at += member->Offset();
+		type = member->Meta();
+	}
+	return at;
+}
+
+void TestPropertyPath()
+{
+	typedef std::chrono::high_resolution_clock Clock;
+
+	const meta::Type* thingType = meta::get<Thing>();
+	meta::PropertyPath x(thingType, "position.x");
+	meta::PropertyPath id(thingType, "id");
+
+	Thing thing = Thing();
+	thing.position = Vector3(1.0f, 2.0f, 3.0f);
+	thing.id = 5;
+
+	if (!x.IsValid() || x.Leaf() != meta::get<float>() || x.Get<float>(&thing) != 1.0f)
+		printf("position.x didn't compile to Thing::position.x\n");
+	if (!id.IsValid() || id.Get<unsigned>(&thing) != 5)
+		printf("id didn't compile to Entity::id\n");
+
+	x.Set(&thing, 9.0f);
+	if (thing.position.x != 9.0f)
+		printf("PropertyPath::Set didn't write Thing::position.x\n");
+
+	meta::PropertyPath bad(thingType, "position.w");
+	if (bad.IsValid())
+		printf("position.w compiled\n");
+
+	//batch reads: stride 0 steps by the root's size, and leaves like std::string are copied through their type
+	Thing pair[2] = { thing, thing };
+	pair[1].position.x = 4.0f;
+	pair[1].name = "second";
+	float xs[2] = {};
+	std::string names[2];
+	x.Read(pair, 2, 0, xs);
+	meta::PropertyPath(thingType, "name").Read(pair, 2, 0, names);
+	if (xs[0] != 9.0f || xs[1] != 4.0f)
+		printf("PropertyPath::Read didn't read position.x with stride 0\n");
+	if (names[1] != "second")
+		printf("PropertyPath::Read didn't copy Thing::name\n");
+
+	//reading position.x from N things
+	const unsigned count = 1000000;
+	std::vector<Thing> things(count, thing);
+	for (unsigned i = 0; i < count; ++i)
+		things[i].position.x = (float)i;
+
+	std::vector<std::string> segments;
+	segments.push_back("position");
+	segments.push_back("x");
+
+	std::vector<float> out(count);
+	float sum = 0.0f;
+
+	Clock::time_point start = Clock::now();
+	for (unsigned i = 0; i < count; ++i)
+		sum += *static_cast<float*>(WalkPath(thingType, &things[i], segments));
+	std::chrono::duration<double, std::nano> walked = Clock::now() - start;
+
+	start = Clock::now();
+	for (unsigned i = 0; i < count; ++i)
+		sum += x.Get<float>(&things[i]);
+	std::chrono::duration<double, std::nano> compiled = Clock::now() - start;
+
+	start = Clock::now();
+	for (unsigned i = 0; i < count; ++i)
+		sum += things[i].position.x;
+	std::chrono::duration<double, std::nano> raw = Clock::now() - start;
+
+	start = Clock::now();
+	x.Read(things.data(), count, sizeof(Thing), out.data());
+	std::chrono::duration<double, std::nano> batch = Clock::now() - start;
+
+	if (out[count - 1] != (float)(count - 1))
+		printf("PropertyPath::Read didn't read position.x\n");
+
+	printf("Reading Thing position.x, ns per read (sum %g):\n", sum);
+	printf("%18s %8.2f\n", "walk members", walked.count() / count);
+	printf("%18s %8.2f\n", "PropertyPath", compiled.count() / count);
+	printf("%18s %8.2f\n", "raw member", raw.count() / count);
+	printf("%18s %8.2f\n", "batch Read", batch.count() / count);
+	printf("\n");
+}
@@ -1,5 +1,9 @@
 #include "SerializationTest.h"
+#include "Arena.h"
 #include "jansson.h"
+#include "Loader.h"
+#include "KeyShape.h"
+#include "Trace.h"
 
 meta_define(Vector3)
 {
@@ -8,13 +12,26 @@ meta_define(Vector3)
 	meta_add_member(z);
 }
 
+meta_define_enum(ThingType)
+{
+	meta_enum_value(Thing_Banana);
+	meta_enum_value(Thing_Apple);
+}
+
+meta_define(Entity)
+{
+	meta_add_member(id);
+}
+
 meta_define(Thing)
 {
+	meta_add_base(Entity);
 	meta_add_member(size);
 	meta_add_member(name);
 	meta_add_member(radius);
 	meta_add_member(height);
 	meta_add_member(position);
+	meta_add_member(kind);
 }
 
 template<typename T>
@@ -37,15 +54,69 @@ void assignProperty(const meta::Member* member, void* object, json_t* jObject)
 			break;
 		case JSON_ARRAY:
 		{
-			//going to require another parse
+			//arena vectors only; elements of the wrong type are left out
+			const meta::Type* memberType = member->Meta();
+			size_t count = json_array_size(jObject);
+			if (memberType == meta::get<meta::ArenaVector<int> >())
+			{
+				meta::ArenaVector<int>& integers = *PointerAdd<meta::ArenaVector<int> >(object, member->Offset());
+				integers.clear();
+				for (size_t i = 0; i < count; ++i)
+				{
+					json_t* element = json_array_get(jObject, i);
+					if (json_is_number(element))
+						integers.push_back((int)json_number_value(element));
+				}
+			}
+			else if (memberType == meta::get<meta::ArenaVector<float> >())
+			{
+				meta::ArenaVector<float>& reals = *PointerAdd<meta::ArenaVector<float> >(object, member->Offset());
+				reals.clear();
+				for (size_t i = 0; i < count; ++i)
+				{
+					json_t* element = json_array_get(jObject, i);
+					if (json_is_number(element))
+						reals.push_back((float)json_number_value(element));
+				}
+			}
+			else if (memberType == meta::get<meta::ArenaVector<meta::ArenaString> >())
+			{
+				meta::ArenaVector<meta::ArenaString>& strings = *PointerAdd<meta::ArenaVector<meta::ArenaString> >(object, member->Offset());
+				strings.clear();
+				for (size_t i = 0; i < count; ++i)
+				{
+					json_t* element = json_array_get(jObject, i);
+					if (json_is_string(element))
+						strings.push_back(meta::ArenaString(json_string_value(element), strings.get_allocator()));
+				}
+			}
 		}
 			break;
 		case JSON_STRING:
 		{
-			if (member->TypeName().compare("std::string") == 0)
+			const meta::EnumTable* enumTable = member->Meta()->Enum();
+
+			if (enumTable != NULL)
+			{
+				const char* str = json_string_value(jObject);
+				long long value;
+				if (enumTable->FromString(str, strlen(str), value))
+				{
+					enumTable->Set(PointerAdd<void>(object, member->Offset()), value);
+				}
+				else
+				{
+					std::cout << "ERROR: " << str << " isn't a " << member->TypeName() << std::endl;
+				}
+			}
+			else if (member->TypeName().compare("std::string") == 0)
 			{
 				*PointerAdd<std::string>(object, member->Offset()) = json_string_value(jObject);
 			}
+			else if (member->Meta() == meta::get<meta::ArenaString>())
+			{
+				*PointerAdd<meta::ArenaString>(object, member->Offset()) = json_string_value(jObject);
+			}
 			else if (member->TypeName().compare("char*") == 0)
 			{
 				const char* str = json_string_value(jObject);
@@ -56,7 +127,14 @@ void assignProperty(const meta::Member* member, void* object, json_t* jObject)
 			break;
 		case JSON_INTEGER:
 		{
-			*PointerAdd<int>(object, member->Offset()) = (int)json_integer_value(jObject);
+			if (member->Meta()->Enum() != NULL)
+			{
+				member->Meta()->Enum()->Set(PointerAdd<void>(object, member->Offset()), json_integer_value(jObject));
+			}
+			else
+			{
+				*PointerAdd<int>(object, member->Offset()) = (int)json_integer_value(jObject);
+			}
 		}
 			break;
 		case JSON_REAL:
@@ -90,24 +168,125 @@ void assignProperty(const meta::Member* member, void* object, json_t* jObject)
 }
 
 
-void DeSerializeJsonObject(json_t* jThing, void* thingToBuild, const std::string& typeName)
+static void DeSerializeCurrent(json_t* jThing, void* thingToBuild, const meta::Type* type);
+static void DeSerializeMigrating(json_t* jThing, void* thingToBuild, const meta::Type* type, unsigned dataVersion);
+
+//Data written with the type's current schema. Every key names a current member, so no migration checks.
+static void DeSerializeCurrent(json_t* jThing, void* thingToBuild, const meta::Type* type)
+{
+	const char *c_key;
+	json_t *value;
+
+	//records of one type list their keys in the same order, so most keys hit the shape's prediction
+	meta::KeyShape& shape = meta::GetKeyShape(type);
+	unsigned position = 0;
+
+	json_object_foreach(jThing, c_key, value)
+	{
+		if (c_key[0] == '$')
+		{
+			continue;	//"$version" and "$schema" stamps
+		}
+
+		const meta::Member* member = shape.Find(position++, c_key);
+		if (member == NULL)
+		{
+			continue;
+		}
+
+		if (json_is_object(value))	//if an object, recursively parse
+		{
+			DeSerializeCurrent(value, PointerAdd<void>(thingToBuild, member->Offset()), member->Meta());
+		}
+		else						//assign primitives
+		{
+			assignProperty(member, thingToBuild, value);
+		}
+	}
+}
+
+static void applyMigration(const meta::Migration* migration, const meta::Type* type, void* thingToBuild, json_t* value)
+{
+	if (migration->kind == meta::Migration::Removed)
+	{
+		return;
+	}
+
+	std::unordered_map<std::string, const meta::Member *>::const_iterator found = type->mamberNames.find(migration->newName);
+	if (found == type->mamberNames.end())
+	{
+		std::cout << type->Name() << " migrates " << migration->oldName << " to missing member: " << migration->newName << std::endl;
+		return;
+	}
+
+	const meta::Member* member = found->second;
+
+	if (migration->kind == meta::Migration::Renamed)
+	{
+		if (json_is_object(value))
+		{
+			DeSerializeMigrating(value, PointerAdd<void>(thingToBuild, member->Offset()), member->Meta(), 0);
+		}
+		else
+		{
+			assignProperty(member, thingToBuild, value);
+		}
+	}
+	else //Retyped: load the value as its old type, then convert it into the member
+	{
+		const meta::Type* oldType = migration->oldType;
+		void* oldValue = oldType->New();
+
+		if (json_is_object(value))
+		{
+			DeSerializeMigrating(value, oldValue, oldType, 0);
+		}
+		else
+		{
+			meta::Member oldMember(migration->oldName, 0, oldType);
+			assignProperty(&oldMember, oldValue, value);
+		}
+
+		migration->convert(oldValue, PointerAdd<void>(thingToBuild, member->Offset()));
+		oldType->Delete(oldValue);
+	}
+}
+
+//Data from another version of the type, or without a schema stamp. dataVersion is 0 when unknown.
+static void DeSerializeMigrating(json_t* jThing, void* thingToBuild, const meta::Type* type, unsigned dataVersion)
 {
 	const char *c_key;
 	json_t *value;
 
-	meta::Type* thingType = meta::get_name(typeName);
+	//unstamped records are as uniform as current ones, so members are found through the shape too
+	meta::KeyShape& shape = meta::GetKeyShape(type);
+	unsigned position = 0;
 
 	json_object_foreach(jThing, c_key, value)
 	{
-		std::string key = c_key;
+		if (c_key[0] == '$')
+		{
+			continue;	//stamps
+		}
+
+		const meta::Member* member = shape.Find(position++, c_key);
 
-		if (thingType->mamberNames.count(key) > 0)
+		//a key that is still a member name only migrates when the data predates the change
+		const meta::Migration* migration = NULL;
+		if (member == NULL || dataVersion != 0)
 		{
-			const meta::Member* member = thingType->mamberNames.at(key);
+			migration = type->FindMigration(c_key);
+		}
 
+		if (migration != NULL && (member == NULL || dataVersion < migration->sinceVersion))
+		{
+			applyMigration(migration, type, thingToBuild, value);
+		}
+		else if (member != NULL)
+		{
 			if (json_is_object(value))	//if an object, recursively parse
 			{
-				DeSerializeJsonObject(value, PointerAdd<void>(thingToBuild, member->Offset()), member->TypeName());
+				DeSerializeMigrating(value, PointerAdd<void>(thingToBuild, member->Offset()), member->Meta(), 0);
 			}
 			else						//assign primitives
 			{
@@ -116,45 +295,111 @@ void DeSerializeJsonObject(json_t* jThing, void* thingToBuild, const std::string
 		}
 		else
 		{
-			std::cout << typeName << " doesn't contain member: " << key << std::endl;
+			std::cout << type->Name() << " doesn't contain member: " << c_key << std::endl;
 		}
 	}
 }
 
-bool parseFile(std::string filename)
+void DeSerializeJsonObject(json_t* jThing, void* thingToBuild, const std::string& typeName)
 {
-	json_t *json;
-	json_error_t error;
+	const meta::Type* thingType = meta::get_name(typeName);
+	meta::TraceSpan span("materialize", thingType, thingType->Size());
 
-	json = json_load_file(filename.c_str(), 0, &error);
-	if (!json) 
+	//the schema stamp picks the path once per object; current data never looks at migrations
+	json_t* schema = json_object_get(jThing, "$schema");
+	if (schema != NULL && json_is_string(schema) && 
+		strtoull(json_string_value(schema), NULL, 16) == thingType->SchemaHash())
 	{
-		return false;
+		DeSerializeCurrent(jThing, thingToBuild, thingType);
 	}
-	
-	Thing thing;
+	else
+	{
+		unsigned dataVersion = (unsigned)json_integer_value(json_object_get(jThing, "$version"));
+		DeSerializeMigrating(jThing, thingToBuild, thingType, dataVersion);
+	}
+}
 
-	json_t *obj = json;
-	const char *key;
-	json_t *value;
+static json_t* SerializeJsonMembers(const void* thing, const meta::Type* type);
+
+//NULL for types json can't hold (raw pointers)
+static json_t* serializeProperty(const meta::Type* type, const void* value)
+{
+	if (type == meta::get<int>())				return json_integer(*static_cast<const int*>(value));
+	if (type == meta::get<unsigned int>())		return json_integer(*static_cast<const unsigned int*>(value));
+	if (type == meta::get<short>())				return json_integer(*static_cast<const short*>(value));
+	if (type == meta::get<unsigned short>())	return json_integer(*static_cast<const unsigned short*>(value));
+	if (type == meta::get<long>())				return json_integer(*static_cast<const long*>(value));
+	if (type == meta::get<unsigned long>())		return json_integer(*static_cast<const unsigned long*>(value));
+	if (type == meta::get<char>())				return json_integer(*static_cast<const char*>(value));
+	if (type == meta::get<unsigned char>())		return json_integer(*static_cast<const unsigned char*>(value));
+	if (type == meta::get<bool>())				return json_boolean(*static_cast<const bool*>(value));
+	if (type == meta::get<float>())				return json_real(*static_cast<const float*>(value));
+	if (type == meta::get<double>())			return json_real(*static_cast<const double*>(value));
+	if (type == meta::get<std::string>())		return json_string(static_cast<const std::string*>(value)->c_str());
+	if (type->Enum() != NULL)
+	{
+		//by name, falling back to the number for values without one
+		long long enumValue = type->Enum()->Get(value);
+		const char* name = type->Enum()->ToString(enumValue);
+		return name != NULL ? json_string(name) : json_integer(enumValue);
+	}
+	if (!type->members.empty())					return SerializeJsonMembers(value, type);
+	return NULL;
+}
 
-	json_object_foreach(obj, key, value) 
+static json_t* SerializeJsonMembers(const void* thing, const meta::Type* type)
+{
+	json_t* jThing = json_object();
+
+	for (unsigned i = 0; i < type->members.size(); ++i)
 	{
-		if (json_is_object(obj) && strcmp(key, "Thing") == 0)
+		const meta::Member* member = type->members[i];
+		json_t* value = serializeProperty(member->Meta(), PointerAdd<const void>(const_cast<void*>(thing), member->Offset()));
+		if (value != NULL)
 		{
-			DeSerializeJsonObject(value, &thing, key);
+			json_object_set_new(jThing, member->Name().c_str(), value);
 		}
 	}
 
+	return jThing;
+}
+
+json_t* SerializeJsonObject(const void* thing, const std::string& typeName)
+{
+	const meta::Type* thingType = meta::get_name(typeName);
+	json_t* jThing = SerializeJsonMembers(thing, thingType);
+
+	//stamp the schema, so loading it back into the same schema takes the fast path
+	char schema[17];
+	sprintf(schema, "%016llx", thingType->SchemaHash());
+	json_object_set_new(jThing, "$version", json_integer(thingType->Version()));
+	json_object_set_new(jThing, "$schema", json_string(schema));
+
+	return jThing;
+}
+
+bool parseFile(std::string filename)
+{
+	Thing thing;
+
+	std::vector<meta::LoadJob> jobs(1, meta::LoadJob(filename, meta::get<Thing>(), &thing));
+	meta::LoadFiles(jobs);
+	if (!jobs[0].loaded)
+	{
+		return false;
+	}
+
 	std::cout <<
 		"Thing" << std::endl <<
 		"{" << std::endl;
 
+	printf("%18s %8u\n", "unsigned id", thing.id);
 	printf("%18s %8d\n", "int size", thing.size);
 	printf("%18s %8s\n", "std::string name", thing.name.c_str());
 	printf("%18s %8.2f\n", "float radius", thing.radius);
 	printf("%18s %8.2f\n", "double height", thing.height);
 	printf("%18s %8.2f, %4.2f, %4.2f\n", "Vector3 position", thing.position.x, thing.position.y, thing.position.z);
+	printf("%18s %8s\n", "ThingType kind", meta::get<ThingType>()->Enum()->ToString(thing.kind));
 	printf("}\n");
 	printf("\n");
 
@@ -24,7 +24,15 @@ enum ThingType
 	Thing_Apple
 };
 
-class Thing
+class Entity
+{
+public:
+	unsigned id;
+
+	meta_expose_internal(Entity);
+};
+
+class Thing : public Entity
 {
 public:
 	int size;
@@ -32,8 +40,17 @@ public:
 	float radius;
 	double height;
 	Vector3 position;
+	ThingType kind;
 
 	meta_expose_internal(Thing);
 };
 
-void TestDeSerialization();
\ No newline at end of file
+//builds an object of a registered type from a json object. Schema stamped data loads without
+//migration checks; anything else goes through the type's registered migrations.
+void DeSerializeJsonObject(json_t* jThing, void* thingToBuild, const std::string& typeName);
+
+//writes an object of a registered type as a json object, stamped with the type's schema
+json_t* SerializeJsonObject(const void* thing, const std::string& typeName);
+
+void TestDeSerialization();
+void TestSchemaMigration();
\ No newline at end of file
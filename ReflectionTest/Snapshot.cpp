@@ -0,0 +1,784 @@
+#include "Snapshot.h"
+#include "Arena.h"
+#include "Compression.h"
+#include "FieldKind.h"
+#include "WorkStealing.h"
+#include <algorithm>
+
+namespace meta
+{
+	namespace
+	{
+		const char snapshotMagic[4] = { 'M', 'S', 'N', 'P' };
+		const char compressedMagic[4] = { 'M', 'S', 'N', 'Z' };
+		const unsigned snapshotFormat = 2;	//1 left arena leaves out
+
+		enum LeafKind
+		{
+			PodLeaf,
+			StringLeaf,
+			ArenaStringLeaf,		//stored like StringLeaf
+			IntVectorLeaf,			//a count, then the elements
+			FloatVectorLeaf,
+			StringVectorLeaf,		//a count, then each string like StringLeaf
+		};
+
+		//a member with no members of its own, reached from the snapshot's type
+		struct Leaf
+		{
+			std::string path;
+			const Type* type;
+			unsigned offset;
+			LeafKind kind;
+		};
+
+		//one step of loading a record
+		struct Step
+		{
+			enum Action
+			{
+				Copy,		//read into the object at offset
+				Skip,		//stored data the current type doesn't have
+				Convert,	//read as oldType, then convert into the object at offset
+			};
+
+			Action action;
+			LeafKind kind;
+			unsigned offset;
+			unsigned size;
+			const Type* oldType;
+			Migration::Converter convert;
+			void* oldValue;
+		};
+
+		//false for leaves a snapshot leaves out: pointers and anything else that isn't trivially copyable
+		bool LeafKindOf(const Type* type, LeafKind& kind)
+		{
+			switch (Classify(type))
+			{
+				case Kind_String: kind = StringLeaf; return true;
+				case Kind_ArenaString: kind = ArenaStringLeaf; return true;
+				case Kind_Integers: kind = IntVectorLeaf; return true;
+				case Kind_Reals: kind = FloatVectorLeaf; return true;
+				case Kind_Strings: kind = StringVectorLeaf; return true;
+				default: break;
+			}
+			if (type->Size() > 0 && type->IsTriviallyCopyable() && type != meta::get<char*>() && type != meta::get<unsigned char*>())
+			{
+				kind = PodLeaf;
+				return true;
+			}
+			return false;
+		}
+
+		void CollectLeaves(const Type* type, const std::string& prefix, unsigned offset, std::vector<Leaf>& leaves)
+		{
+			for (unsigned i = 0; i < type->members.size(); ++i)
+			{
+				const Member* member = type->members[i];
+				const Type* memberType = member->Meta();
+				LeafKind kind;
+
+				if (!memberType->members.empty())
+				{
+					CollectLeaves(memberType, prefix + member->Name() + ".", offset + member->Offset(), leaves);
+				}
+				else if (LeafKindOf(memberType, kind))
+				{
+					Leaf leaf = { prefix + member->Name(), memberType, offset + member->Offset(), kind };
+					leaves.push_back(leaf);
+				}
+			}
+		}
+
+		//the plan for data with the current schema. Pod leaves that sit next to each other
+		//in memory are merged, so e.g. a Vector3 is one copy.
+		void CurrentPlan(const std::vector<Leaf>& leaves, std::vector<Step>& plan)
+		{
+			for (unsigned i = 0; i < leaves.size(); ++i)
+			{
+				const Leaf& leaf = leaves[i];
+
+				if (leaf.kind == PodLeaf && !plan.empty() && plan.back().kind == PodLeaf &&
+					plan.back().offset + plan.back().size == leaf.offset)
+				{
+					plan.back().size += leaf.type->Size();
+					continue;
+				}
+
+				Step step = { Step::Copy, leaf.kind, leaf.offset, leaf.type->Size(), NULL, NULL, NULL };
+				plan.push_back(step);
+			}
+		}
+
+		//whether a leaf stored with kind (and for a pod, size) loads into a type
+		bool SameLeaf(const Type* type, unsigned storedSize, LeafKind kind)
+		{
+			LeafKind typeKind;
+			return LeafKindOf(type, typeKind) && typeKind == kind && (kind != PodLeaf || type->Size() == storedSize);
+		}
+
+		//Finds where a leaf stored by another schema lives in the current type. A path segment
+		//that isn't a current member (or is stored with another type) goes through migrations.
+		Step ResolveLeaf(const Type* type, const std::string& path, const std::string& storedTypeName, unsigned storedSize, LeafKind kind)
+		{
+			Step step = { Step::Skip, kind, 0, storedSize, NULL, NULL, NULL };
+			unsigned offset = 0;
+			size_t begin = 0;
+
+			while (true)
+			{
+				size_t dot = path.find('.', begin);
+				bool last = dot == std::string::npos;
+				std::string segment = path.substr(begin, last ? std::string::npos : dot - begin);
+
+				std::unordered_map<std::string, const Member*>::const_iterator found = type->mamberNames.find(segment);
+				bool matches = found != type->mamberNames.end() &&
+					(!last || found->second->TypeName() == storedTypeName);
+
+				if (!matches)
+				{
+					const Migration* migration = type->FindMigration(segment);
+					if (migration == NULL)
+					{
+						std::cout << type->Name() << " doesn't contain member: " << segment << std::endl;
+						return step;
+					}
+					if (migration->kind == Migration::Removed)
+					{
+						return step;
+					}
+
+					found = type->mamberNames.find(migration->newName);
+					if (found == type->mamberNames.end())
+					{
+						std::cout << type->Name() << " migrates " << segment << " to missing member: " << migration->newName << std::endl;
+						return step;
+					}
+
+					if (last && migration->kind == Migration::Retyped)
+					{
+						if (migration->oldType->Name() != storedTypeName || !SameLeaf(migration->oldType, storedSize, kind))
+						{
+							std::cout << type->Name() << "::" << segment << " stored as unexpected type " << storedTypeName << std::endl;
+							return step;
+						}
+
+						step.action = Step::Convert;
+						step.offset = offset + found->second->Offset();
+						step.oldType = migration->oldType;
+						step.convert = migration->convert;
+						step.oldValue = migration->oldType->New();
+						return step;
+					}
+
+					if (last && found->second->TypeName() != storedTypeName)
+					{
+						std::cout << type->Name() << "::" << migration->newName << " stored as unexpected type " << storedTypeName << std::endl;
+						return step;
+					}
+				}
+
+				offset += found->second->Offset();
+
+				if (last)
+				{
+					if (!SameLeaf(found->second->Meta(), storedSize, kind))
+					{
+						std::cout << type->Name() << "::" << segment << " stored as a different kind of " << storedTypeName << std::endl;
+						return step;
+					}
+					step.action = Step::Copy;
+					step.offset = offset;
+					return step;
+				}
+
+				type = found->second->Meta();
+				begin = dot + 1;
+			}
+		}
+
+		//////// Byte Streams ////////
+
+		void Write(std::vector<char>& out, const void* data, size_t size)
+		{
+			const char* bytes = static_cast<const char*>(data);
+			out.insert(out.end(), bytes, bytes + size);
+		}
+
+		void WriteU32(std::vector<char>& out, unsigned value)
+		{
+			Write(out, &value, sizeof(value));
+		}
+
+		template <typename String>
+		void WriteString(std::vector<char>& out, const String& str)
+		{
+			WriteU32(out, (unsigned)str.size());
+			Write(out, str.data(), str.size());
+		}
+
+		template <typename T>
+		void WriteVector(std::vector<char>& out, const ArenaVector<T>& vec)
+		{
+			WriteU32(out, (unsigned)vec.size());
+			Write(out, vec.data(), vec.size() * sizeof(T));
+		}
+
+		void WriteVector(std::vector<char>& out, const ArenaVector<ArenaString>& vec)
+		{
+			WriteU32(out, (unsigned)vec.size());
+			for (unsigned i = 0; i < vec.size(); ++i)
+				WriteString(out, vec[i]);
+		}
+
+		struct Reader
+		{
+			const char* cursor;
+			const char* end;
+
+			bool Read(void* dest, size_t size)
+			{
+				if ((size_t)(end - cursor) < size)
+					return false;
+				std::memcpy(dest, cursor, size);
+				cursor += size;
+				return true;
+			}
+
+			bool Skip(size_t size)
+			{
+				if ((size_t)(end - cursor) < size)
+					return false;
+				cursor += size;
+				return true;
+			}
+
+			bool ReadU32(unsigned& value)
+			{
+				return Read(&value, sizeof(value));
+			}
+
+			//arena strings assign through their own allocator
+			template <typename String>
+			bool ReadString(String& str)
+			{
+				unsigned length;
+				if (!ReadU32(length) || (size_t)(end - cursor) < length)
+					return false;
+				str.assign(cursor, length);
+				cursor += length;
+				return true;
+			}
+
+			bool SkipString(void)
+			{
+				unsigned length;
+				if (!ReadU32(length) || (size_t)(end - cursor) < length)
+					return false;
+				cursor += length;
+				return true;
+			}
+
+			//count is checked against what's left before the vector grows
+			template <typename T>
+			bool ReadVector(ArenaVector<T>& vec)
+			{
+				unsigned count;
+				if (!ReadU32(count) || (size_t)(end - cursor) / sizeof(T) < count)
+					return false;
+				vec.resize(count);
+				return count == 0 || Read(vec.data(), count * sizeof(T));
+			}
+
+			bool ReadVector(ArenaVector<ArenaString>& vec)
+			{
+				unsigned count;
+				if (!ReadU32(count) || (size_t)(end - cursor) / sizeof(unsigned) < count)
+					return false;
+				vec.resize(count);
+				for (unsigned i = 0; i < count; ++i)
+				{
+					if (!ReadString(vec[i]))
+						return false;
+				}
+				return true;
+			}
+
+			bool SkipVector(size_t elementSize)
+			{
+				unsigned count;
+				return ReadU32(count) && (size_t)(end - cursor) / elementSize >= count && Skip(count * elementSize);
+			}
+
+			bool SkipStringVector(void)
+			{
+				unsigned count;
+				if (!ReadU32(count))
+					return false;
+				for (unsigned i = 0; i < count; ++i)
+				{
+					if (!SkipString())
+						return false;
+				}
+				return true;
+			}
+
+			//one leaf of the kind into dest, size bytes for a pod
+			bool ReadLeaf(LeafKind kind, unsigned size, void* dest)
+			{
+				switch (kind)
+				{
+					case PodLeaf: return Read(dest, size);
+					case StringLeaf: return ReadString(*static_cast<std::string*>(dest));
+					case ArenaStringLeaf: return ReadString(*static_cast<ArenaString*>(dest));
+					case IntVectorLeaf: return ReadVector(*static_cast<ArenaVector<int>*>(dest));
+					case FloatVectorLeaf: return ReadVector(*static_cast<ArenaVector<float>*>(dest));
+					case StringVectorLeaf: return ReadVector(*static_cast<ArenaVector<ArenaString>*>(dest));
+				}
+				return false;
+			}
+
+			bool SkipLeaf(LeafKind kind, unsigned size)
+			{
+				switch (kind)
+				{
+					case PodLeaf: return Skip(size);
+					case StringLeaf: case ArenaStringLeaf: return SkipString();
+					case IntVectorLeaf: return SkipVector(sizeof(int));
+					case FloatVectorLeaf: return SkipVector(sizeof(float));
+					case StringVectorLeaf: return SkipStringVector();
+				}
+				return false;
+			}
+		};
+
+		bool ReadHeader(Reader& reader, SnapshotHeader& header, unsigned& schemaBytes)
+		{
+			char magic[4];
+			unsigned format;
+
+			if (!reader.Read(magic, sizeof(magic)) || !reader.ReadU32(format) || format == 0 || format > snapshotFormat)
+			{
+				return false;
+			}
+
+			header.format = format;
+			header.compressed = std::memcmp(magic, compressedMagic, sizeof(magic)) == 0;
+			header.blocks = 0;
+			return
+				(header.compressed || std::memcmp(magic, snapshotMagic, sizeof(magic)) == 0) &&
+				reader.ReadString(header.typeName) &&
+				reader.ReadU32(header.version) &&
+				reader.Read(&header.schemaHash, sizeof(header.schemaHash)) &&
+				reader.ReadU32(header.count) &&
+				(!header.compressed || reader.ReadU32(header.blocks)) &&
+				reader.ReadU32(schemaBytes);
+		}
+
+		//the header and the schema; only compressed snapshots store a block count
+		void WriteHeader(std::vector<char>& out, const Type* type, unsigned count, const std::vector<Leaf>& leaves, bool compressed, unsigned blocks)
+		{
+			unsigned long long schemaHash = type->SchemaHash();
+			Write(out, compressed ? compressedMagic : snapshotMagic, sizeof(snapshotMagic));
+			WriteU32(out, snapshotFormat);
+			WriteString(out, type->Name());
+			WriteU32(out, type->Version());
+			Write(out, &schemaHash, sizeof(schemaHash));
+			WriteU32(out, count);
+			if (compressed)
+			{
+				WriteU32(out, blocks);
+			}
+
+			std::vector<char> schema;
+			WriteU32(schema, (unsigned)leaves.size());
+			for (unsigned i = 0; i < leaves.size(); ++i)
+			{
+				WriteString(schema, leaves[i].path);
+				WriteString(schema, leaves[i].type->Name());
+				WriteU32(schema, leaves[i].type->Size());
+				schema.push_back((char)leaves[i].kind);
+			}
+			WriteU32(out, (unsigned)schema.size());
+			Write(out, schema.data(), schema.size());
+		}
+
+		void WriteRecord(std::vector<char>& out, const std::vector<Step>& plan, const char* object)
+		{
+			for (unsigned s = 0; s < plan.size(); ++s)
+			{
+				const char* leaf = object + plan[s].offset;
+				switch (plan[s].kind)
+				{
+					case PodLeaf: Write(out, leaf, plan[s].size); break;
+					case StringLeaf: WriteString(out, *reinterpret_cast<const std::string*>(leaf)); break;
+					case ArenaStringLeaf: WriteString(out, *reinterpret_cast<const ArenaString*>(leaf)); break;
+					case IntVectorLeaf: WriteVector(out, *reinterpret_cast<const ArenaVector<int>*>(leaf)); break;
+					case FloatVectorLeaf: WriteVector(out, *reinterpret_cast<const ArenaVector<float>*>(leaf)); break;
+					case StringVectorLeaf: WriteVector(out, *reinterpret_cast<const ArenaVector<ArenaString>*>(leaf)); break;
+				}
+			}
+		}
+
+		//The plan for loading records stored with the schema. The current schema skips it; anything
+		//else maps every stored leaf onto the current type once. Convert steps own an old value.
+		//Older formats left leaves out, so they always go through their stored schema.
+		bool ReadPlan(const Type* type, const SnapshotHeader& header, Reader schema, std::vector<Step>& plan)
+		{
+			if (header.schemaHash == type->SchemaHash() && header.format == snapshotFormat)
+			{
+				std::vector<Leaf> leaves;
+				CollectLeaves(type, "", 0, leaves);
+				CurrentPlan(leaves, plan);
+				return true;
+			}
+
+			unsigned leafCount;
+			if (!schema.ReadU32(leafCount))
+			{
+				return false;
+			}
+
+			for (unsigned i = 0; i < leafCount; ++i)
+			{
+				std::string path, typeName;
+				unsigned leafSize;
+				char kind;
+
+				if (!schema.ReadString(path) || !schema.ReadString(typeName) || !schema.ReadU32(leafSize) || !schema.Read(&kind, 1) ||
+					kind < PodLeaf || kind > StringVectorLeaf)
+				{
+					return false;
+				}
+
+				plan.push_back(ResolveLeaf(type, path, typeName, leafSize, (LeafKind)kind));
+			}
+			return true;
+		}
+
+		//the same plan with old values of its own, for another thread
+		std::vector<Step> ClonePlan(const std::vector<Step>& plan)
+		{
+			std::vector<Step> clone = plan;
+			for (unsigned s = 0; s < clone.size(); ++s)
+			{
+				if (clone[s].oldValue != NULL)
+				{
+					clone[s].oldValue = clone[s].oldType->New();
+				}
+			}
+			return clone;
+		}
+
+		void FreePlan(std::vector<Step>& plan)
+		{
+			for (unsigned s = 0; s < plan.size(); ++s)
+			{
+				if (plan[s].oldValue != NULL)
+				{
+					plan[s].oldType->Delete(plan[s].oldValue);
+					plan[s].oldValue = NULL;
+				}
+			}
+		}
+
+		bool RunPlan(Reader& reader, const std::vector<Step>& plan, char* objects, unsigned count, unsigned stride)
+		{
+			for (unsigned i = 0; i < count; ++i)
+			{
+				char* object = objects + i * stride;
+
+				for (unsigned s = 0; s < plan.size(); ++s)
+				{
+					const Step& step = plan[s];
+					bool ok = true;
+
+					switch (step.action)
+					{
+						case Step::Copy:
+							ok = reader.ReadLeaf(step.kind, step.size, object + step.offset);
+							break;
+						case Step::Skip:
+							ok = reader.SkipLeaf(step.kind, step.size);
+							break;
+						case Step::Convert:
+							ok = reader.ReadLeaf(step.kind, step.size, step.oldValue);
+							if (ok)
+								step.convert(step.oldValue, object + step.offset);
+							break;
+					}
+
+					if (!ok)
+						return false;
+				}
+			}
+			return true;
+		}
+
+		//past count records without loading them
+		bool SkipRecords(Reader& reader, const std::vector<Step>& plan, unsigned count)
+		{
+			for (unsigned i = 0; i < count; ++i)
+			{
+				for (unsigned s = 0; s < plan.size(); ++s)
+				{
+					if (!reader.SkipLeaf(plan[s].kind, plan[s].size))
+						return false;
+				}
+			}
+			return true;
+		}
+
+		//one block of a compressed snapshot: whole records, from firstRecord on
+		struct BlockEntry
+		{
+			unsigned firstRecord;
+			unsigned rawSize;
+			unsigned packedSize;	//rawSize when the block is stored uncompressed
+		};
+
+		bool ReadBlockIndex(Reader& reader, const SnapshotHeader& header, std::vector<BlockEntry>& index, std::vector<const char*>& blocks)
+		{
+			index.resize(header.blocks);
+			for (unsigned b = 0; b < header.blocks; ++b)
+			{
+				BlockEntry& entry = index[b];
+				if (!reader.ReadU32(entry.firstRecord) || !reader.ReadU32(entry.rawSize) || !reader.ReadU32(entry.packedSize) ||
+					entry.packedSize > entry.rawSize || entry.rawSize > MaxDecompressedSize(entry.packedSize) || entry.firstRecord > header.count ||
+					(b == 0 ? entry.firstRecord != 0 : entry.firstRecord < index[b - 1].firstRecord))
+				{
+					return false;
+				}
+			}
+
+			blocks.resize(header.blocks);
+			for (unsigned b = 0; b < header.blocks; ++b)
+			{
+				blocks[b] = reader.cursor;
+				if (!reader.Skip(index[b].packedSize))
+				{
+					return false;
+				}
+			}
+			return header.count == 0 || header.blocks > 0;
+		}
+
+		//Decompresses only the blocks that hold records first to first + count, a block per task,
+		//and loads each straight into its records' objects
+		bool LoadBlocks(Reader& reader, const SnapshotHeader& header, const std::vector<Step>& plan, unsigned first, unsigned count, char* objects, unsigned stride, unsigned threads)
+		{
+			std::vector<BlockEntry> index;
+			std::vector<const char*> blocks;
+			if (!ReadBlockIndex(reader, header, index, blocks))
+			{
+				return false;
+			}
+			if (count == 0)
+			{
+				return true;
+			}
+
+			unsigned last = first + count;
+			unsigned firstBlock = 0;
+			while (firstBlock + 1 < index.size() && index[firstBlock + 1].firstRecord <= first)
+			{
+				++firstBlock;
+			}
+			unsigned endBlock = firstBlock + 1;
+			while (endBlock < index.size() && index[endBlock].firstRecord < last)
+			{
+				++endBlock;
+			}
+
+			//arena leaves allocate from the objects' arenas, which needn't be thread safe
+			for (unsigned s = 0; s < plan.size(); ++s)
+			{
+				if (plan[s].kind >= ArenaStringLeaf && plan[s].action != Step::Skip)
+					threads = 1;
+			}
+
+			unsigned tasks = endBlock - firstBlock;
+			unsigned workers = WorkStealingThreads(tasks, threads);
+			std::vector<std::vector<char> > buffers(workers);
+			std::vector<std::vector<Step> > plans(workers);
+			for (unsigned w = 0; w < workers; ++w)
+			{
+				plans[w] = ClonePlan(plan);
+			}
+
+			std::vector<char> failed(tasks, 0);
+			RunWorkStealing(tasks, workers, [&](unsigned task, unsigned worker)
+			{
+				unsigned b = firstBlock + task;
+				const BlockEntry& entry = index[b];
+				const char* raw = blocks[b];
+				if (entry.packedSize < entry.rawSize)
+				{
+					std::vector<char>& buffer = buffers[worker];
+					buffer.resize(entry.rawSize);
+					if (!DecompressBlock(blocks[b], entry.packedSize, buffer.data(), entry.rawSize))
+					{
+						failed[task] = 1;
+						return;
+					}
+					raw = buffer.data();
+				}
+
+				unsigned blockEnd = b + 1 < index.size() ? index[b + 1].firstRecord : header.count;
+				unsigned from = std::max(first, entry.firstRecord);
+				unsigned to = std::min(last, blockEnd);
+				Reader records = { raw, raw + entry.rawSize };
+				if (!SkipRecords(records, plans[worker], from - entry.firstRecord) ||
+					!RunPlan(records, plans[worker], objects + (size_t)(from - first) * stride, to - from, stride))
+				{
+					failed[task] = 1;
+				}
+			});
+
+			for (unsigned w = 0; w < workers; ++w)
+			{
+				FreePlan(plans[w]);
+			}
+			return std::find(failed.begin(), failed.end(), 1) == failed.end();
+		}
+
+		bool LoadRecords(const Type* type, const char* data, size_t size, unsigned first, unsigned count, void* objects, unsigned stride, unsigned threads)
+		{
+			if (stride == 0)
+			{
+				stride = type->Size();
+			}
+
+			Reader reader = { data, data + size };
+			SnapshotHeader header;
+			unsigned schemaBytes;
+
+			if (!ReadHeader(reader, header, schemaBytes) || first > header.count || count > header.count - first ||
+				(size_t)(reader.end - reader.cursor) < schemaBytes)
+			{
+				return false;
+			}
+			if (header.typeName != type->Name())
+			{
+				std::cout << "Snapshot of " << header.typeName << " can't load as " << type->Name() << std::endl;
+				return false;
+			}
+
+			Reader schema = { reader.cursor, reader.cursor + schemaBytes };
+			reader.cursor += schemaBytes;
+
+			std::vector<Step> plan;
+			bool ok = ReadPlan(type, header, schema, plan);
+			if (ok && header.compressed)
+				ok = LoadBlocks(reader, header, plan, first, count, static_cast<char*>(objects), stride, threads);
+			else if (ok)
+				ok = SkipRecords(reader, plan, first) && RunPlan(reader, plan, static_cast<char*>(objects), count, stride);
+
+			FreePlan(plan);
+			return ok;
+		}
+	}
+
+	void WriteSnapshot(const Type* type, const void* objects, unsigned count, std::vector<char>& out, unsigned stride)
+	{
+		if (stride == 0)
+		{
+			stride = type->Size();
+		}
+
+		std::vector<Leaf> leaves;
+		CollectLeaves(type, "", 0, leaves);
+		WriteHeader(out, type, count, leaves, false, 0);
+
+		std::vector<Step> plan;
+		CurrentPlan(leaves, plan);
+
+		const char* object = static_cast<const char*>(objects);
+		for (unsigned i = 0; i < count; ++i, object += stride)
+		{
+			WriteRecord(out, plan, object);
+		}
+	}
+
+	void WriteCompressedSnapshot(const Type* type, const void* objects, unsigned count, std::vector<char>& out, const SnapshotCompression& compression, unsigned stride)
+	{
+		if (stride == 0)
+		{
+			stride = type->Size();
+		}
+
+		std::vector<Leaf> leaves;
+		CollectLeaves(type, "", 0, leaves);
+		std::vector<Step> plan;
+		CurrentPlan(leaves, plan);
+
+		//records back to back, cut into a block at the first record boundary past blockSize
+		std::vector<char> records;
+		std::vector<BlockEntry> index;
+		std::vector<size_t> starts;
+		const char* object = static_cast<const char*>(objects);
+		for (unsigned i = 0; i < count; ++i, object += stride)
+		{
+			if (index.empty() || records.size() - starts.back() >= compression.blockSize)
+			{
+				BlockEntry entry = { i, 0, 0 };
+				index.push_back(entry);
+				starts.push_back(records.size());
+			}
+			WriteRecord(records, plan, object);
+		}
+		starts.push_back(records.size());
+
+		std::vector<std::vector<char> > packed(index.size());
+		RunWorkStealing((unsigned)index.size(), compression.threads, [&](unsigned b, unsigned)
+		{
+			const char* raw = records.data() + starts[b];
+			size_t rawSize = starts[b + 1] - starts[b];
+			if (compression.level > 0)
+			{
+				CompressBlock(raw, rawSize, packed[b], compression.level);
+			}
+			if (compression.level == 0 || packed[b].size() >= rawSize)
+			{
+				packed[b].assign(raw, raw + rawSize);
+			}
+			index[b].rawSize = (unsigned)rawSize;
+			index[b].packedSize = (unsigned)packed[b].size();
+		});
+
+		WriteHeader(out, type, count, leaves, true, (unsigned)index.size());
+		for (unsigned b = 0; b < index.size(); ++b)
+		{
+			WriteU32(out, index[b].firstRecord);
+			WriteU32(out, index[b].rawSize);
+			WriteU32(out, index[b].packedSize);
+		}
+		for (unsigned b = 0; b < packed.size(); ++b)
+		{
+			Write(out, packed[b].data(), packed[b].size());
+		}
+	}
+
+	bool ReadSnapshotHeader(const char* data, size_t size, SnapshotHeader& header)
+	{
+		Reader reader = { data, data + size };
+		unsigned schemaBytes;
+		return ReadHeader(reader, header, schemaBytes);
+	}
+
+	bool ReadSnapshot(const Type* type, const char* data, size_t size, void* objects, unsigned capacity, unsigned stride, unsigned threads)
+	{
+		SnapshotHeader header;
+		if (!ReadSnapshotHeader(data, size, header) || header.count > capacity)
+		{
+			return false;
+		}
+		return LoadRecords(type, data, size, 0, header.count, objects, stride, threads);
+	}
+
+	bool ReadSnapshotRange(const Type* type, const char* data, size_t size, unsigned first, unsigned count, void* objects, unsigned stride, unsigned threads)
+	{
+		return LoadRecords(type, data, size, first, count, objects, stride, threads);
+	}
+}
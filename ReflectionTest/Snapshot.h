@@ -0,0 +1,66 @@
+#pragma once
+
+#include "Meta.h"
+
+namespace meta
+{
+	//////////////////////////////////////////////////////////////////////////////
+	//  Binary Snapshots
+	//////////////////////////////////////////////////////////////////////////////
+	// Purpose: Saves arrays of a reflected type in a compact binary form.
+	//
+	// The header carries the type's version and schema hash, followed by the schema
+	// (the leaf members: dotted path, type name and size) written once per snapshot.
+	// Records are the leaf values back to back, with std::string and ArenaString as a length and
+	// bytes, and ArenaVector<int>, <float> and <ArenaString> as a count and their elements. Arena
+	// leaves load through the object's own allocator. Pointers and other leaves that aren't
+	// trivially copyable are left out.
+	//
+	// Loading data whose schema hash matches the type skips the schema entirely and copies
+	// records with a precomputed plan. Anything else maps the stored leaves onto the current
+	// type through its registered migrations, once per snapshot, then runs that plan per record.
+	//
+	// Compressed snapshots keep the header and schema as they are and cut the records into
+	// blocks of whole records, each compressed on its own (see Compression.h), behind an index
+	// of each block's first record and sizes. Blocks decompress and load in parallel, straight
+	// into their records' objects, and reading a range of records decompresses only the blocks
+	// that hold it. Blocks that don't shrink are stored as they are.
+
+	struct SnapshotHeader
+	{
+		unsigned format;	//of the snapshot itself; format 1 left arena leaves out
+		std::string typeName;
+		unsigned version;
+		unsigned long long schemaHash;
+		unsigned count;
+		bool compressed;
+		unsigned blocks;	//compressed blocks of records
+	};
+
+	struct SnapshotCompression
+	{
+		SnapshotCompression() : level(1), blockSize(256 * 1024), threads(0) {}
+
+		unsigned level;		//1 is fastest, maxCompressionLevel smallest; 0 stores the blocks
+		unsigned blockSize;	//record bytes per block, before running on to the end of a record
+		unsigned threads;	//0 uses every hardware thread
+	};
+
+	//Appends count objects of a type to out. Objects are stride bytes apart (0 means type->Size()).
+	void WriteSnapshot(const Type* type, const void* objects, unsigned count, std::vector<char>& out, unsigned stride = 0);
+
+	//Like WriteSnapshot, with the records in compressed blocks. Blocks are compressed in parallel.
+	void WriteCompressedSnapshot(const Type* type, const void* objects, unsigned count, std::vector<char>& out, const SnapshotCompression& compression, unsigned stride = 0);
+
+	//false if data isn't a snapshot, compressed or not
+	bool ReadSnapshotHeader(const char* data, size_t size, SnapshotHeader& header);
+
+	//Loads a snapshot into header.count already constructed objects, stride bytes apart (0 means type->Size()).
+	//false if the data is malformed, holds another type or capacity is too small. Compressed blocks load on threads workers
+	//(0 uses every hardware thread), or on one when the type has arena leaves.
+	bool ReadSnapshot(const Type* type, const char* data, size_t size, void* objects, unsigned capacity, unsigned stride = 0, unsigned threads = 0);
+
+	//Loads records first to first + count into count objects. Records before first in a compressed
+	//block are skipped over; in an uncompressed snapshot every record before first is.
+	bool ReadSnapshotRange(const Type* type, const char* data, size_t size, unsigned first, unsigned count, void* objects, unsigned stride = 0, unsigned threads = 0);
+}
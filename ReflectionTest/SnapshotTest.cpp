@@ -0,0 +1,252 @@
+#include "Snapshot.h"
+#include "Arena.h"
+#include "SerializationTest.h"
+#include "Test.h"
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <thread>
+
+//Fruit as it was saved by version 1
+struct FruitV1
+{
+	int count;
+	std::string name;
+	int weight;
+	std::string color;
+	Vector3 position;
+
+	meta_expose_internal(FruitV1);
+};
+
+//Fruit now: name became label, weight became a float, color was dropped
+struct Fruit
+{
+	int count;
+	std::string label;
+	float weight;
+	Vector3 position;
+
+	meta_expose_internal(Fruit);
+};
+
+static void WeightFromInt(const void* oldValue, void* newValue)
+{
+	*static_cast<float*>(newValue) = (float)*static_cast<const int*>(oldValue);
+}
+
+meta_define(FruitV1)
+{
+	meta_add_member(count);
+	meta_add_member(name);
+	meta_add_member(weight);
+	meta_add_member(color);
+	meta_add_member(position);
+}
+
+meta_define(Fruit)
+{
+	meta_version(2);
+	meta_add_member(count);
+	meta_add_member(label);
+	meta_add_member(weight);
+	meta_add_member(position);
+
+	meta_renamed_member(name, label, 2);
+	meta_removed_member(color, 2);
+	meta_retyped_member(weight, int, WeightFromInt, 2);
+}
+
+static void MakeArticle(Article& article, unsigned i)
+{
+	char text[64];
+	article.id = i;
+	sprintf(text, "Article number %06u about snapshots", i);
+	article.title = text;
+	article.body = i % 3 ? text : "";
+	for (unsigned s = 0; s < i % 4; ++s)
+		article.scores.push_back((float)(i + s) * 0.5f);
+	for (unsigned t = 0; t < i % 3; ++t)
+	{
+		sprintf(text, "a tag long enough to allocate %u", t);
+		article.tags.push_back(meta::ArenaString(text, article.tags.get_allocator()));
+	}
+}
+
+static bool SameArticle(const Article& a, const Article& b, meta::MemoryResource* resource)
+{
+	bool same = a.id == b.id && a.title == b.title && a.body == b.body && a.scores.size() == b.scores.size() && a.tags.size() == b.tags.size() &&
+		b.title.get_allocator().Resource() == resource && b.tags.get_allocator().Resource() == resource;
+	for (unsigned i = 0; same && i < a.scores.size(); ++i)
+		same = a.scores[i] == b.scores[i];
+	for (unsigned i = 0; same && i < a.tags.size(); ++i)
+		same = a.tags[i] == b.tags[i] && b.tags[i].get_allocator().Resource() == resource;
+	return same;
+}
+
+//a snapshot as version 1 of typeName would have written it, under that name
+static void RenameSnapshot(std::vector<char>& data, const std::string& typeName)
+{
+	const size_t nameAt = 8;	//past the magic and format
+	unsigned length, newLength = (unsigned)typeName.size();
+	std::memcpy(&length, &data[nameAt], sizeof(length));
+	std::memcpy(&data[nameAt], &newLength, sizeof(newLength));
+	data.erase(data.begin() + nameAt + sizeof(length), data.begin() + nameAt + sizeof(length) + length);
+	data.insert(data.begin() + nameAt + sizeof(length), typeName.begin(), typeName.end());
+}
+
+static bool SameFruit(const Fruit& a, const Fruit& b)
+{
+	return a.count == b.count && a.label == b.label && a.weight == b.weight &&
+		a.position.x == b.position.x && a.position.y == b.position.y && a.position.z == b.position.z;
+}
+
+void TestSchemaMigration()
+{
+	typedef std::chrono::high_resolution_clock Clock;
+
+	Fruit fruit;
+	fruit.count = 3;
+	fruit.label = "kiwi";
+	fruit.weight = 2.5f;
+	fruit.position = Vector3(1.0f, 2.0f, 3.0f);
+
+	//json with the current schema stamp round trips on the fast path
+	json_t* json = SerializeJsonObject(&fruit, "Fruit");
+	Fruit loaded;
+	DeSerializeJsonObject(json, &loaded, "Fruit");
+	json_decref(json);
+	if (!SameFruit(fruit, loaded))
+		printf("Fruit didn't survive a json round trip\n");
+
+	//threads that all find the hash uncomputed agree on it
+	{
+		meta::Type* grantType = meta::get<Grant>();
+		grantType->SetVersion(grantType->Version());	//forgets the cached hash
+		unsigned long long hashes[4] = {};
+		std::vector<std::thread> threads;
+		for (unsigned t = 0; t < 4; ++t)
+		{
+			threads.push_back(std::thread([grantType, &hashes, t]()
+			{
+				hashes[t] = grantType->SchemaHash();
+			}));
+		}
+		for (unsigned t = 0; t < threads.size(); ++t)
+			threads[t].join();
+		if (hashes[0] == 0 || hashes[1] != hashes[0] || hashes[2] != hashes[0] || hashes[3] != hashes[0])
+			printf("Threads computed different Grant schema hashes\n");
+	}
+
+	//json written by version 1 migrates
+	const char* oldJson = "{ \"$version\": 1, \"count\": 3, \"name\": \"kiwi\", \"weight\": 2, \"color\": \"green\", "
+		"\"position\": { \"x\": 1.0, \"y\": 2.0, \"z\": 3.0 } }";
+	json_error_t error;
+	json = json_loads(oldJson, 0, &error);
+	Fruit migrated;
+	DeSerializeJsonObject(json, &migrated, "Fruit");
+	json_decref(json);
+	fruit.weight = 2.0f;
+	if (!SameFruit(fruit, migrated))
+		printf("Fruit version 1 json didn't migrate\n");
+
+	//binary snapshots, current and version 1
+	const unsigned count = 200000;
+	std::vector<Fruit> fruits(count);
+	std::vector<FruitV1> oldFruits(count);
+	for (unsigned i = 0; i < count; ++i)
+	{
+		fruits[i].count = i;
+		fruits[i].label = "fruit";
+		fruits[i].weight = (float)(i % 100);
+		fruits[i].position = Vector3((float)i, 0.5f, 0.25f);
+
+		oldFruits[i].count = i;
+		oldFruits[i].name = "fruit";
+		oldFruits[i].weight = i % 100;
+		oldFruits[i].color = "red";
+		oldFruits[i].position = fruits[i].position;
+	}
+
+	std::vector<char> current, old;
+	meta::WriteSnapshot(meta::get<Fruit>(), fruits.data(), count, current);
+	meta::WriteSnapshot(meta::get<FruitV1>(), oldFruits.data(), count, old);
+	if (meta::ReadSnapshot(meta::get<Fruit>(), old.data(), old.size(), fruits.data(), count))
+		printf("FruitV1 snapshot loaded as Fruit\n");
+	RenameSnapshot(old, "Fruit");
+
+	std::vector<Fruit> fromCurrent(count), fromOld(count);
+
+	Clock::time_point start = Clock::now();
+	bool currentOk = meta::ReadSnapshot(meta::get<Fruit>(), current.data(), current.size(), fromCurrent.data(), count);
+	std::chrono::duration<double, std::nano> currentTime = Clock::now() - start;
+
+	start = Clock::now();
+	bool oldOk = meta::ReadSnapshot(meta::get<Fruit>(), old.data(), old.size(), fromOld.data(), count);
+	std::chrono::duration<double, std::nano> oldTime = Clock::now() - start;
+
+	//compressed, version 1 migrates block by block, each worker converting through its own old values
+	std::vector<char> compressedOld;
+	meta::SnapshotCompression compression;
+	compression.blockSize = 16 * 1024;
+	meta::WriteCompressedSnapshot(meta::get<FruitV1>(), oldFruits.data(), count, compressedOld, compression);
+	RenameSnapshot(compressedOld, "Fruit");
+	std::vector<Fruit> fromCompressed(count);
+	if (!meta::ReadSnapshot(meta::get<Fruit>(), compressedOld.data(), compressedOld.size(), fromCompressed.data(), count, 0, 4) ||
+		!SameFruit(fruits[count - 1], fromCompressed[count - 1]) || !SameFruit(fruits[777], fromCompressed[777]))
+		printf("Fruit didn't migrate from a compressed version 1 snapshot\n");
+
+	for (unsigned i = 0; i < count && currentOk && oldOk; ++i)
+	{
+		if (!SameFruit(fruits[i], fromCurrent[i]))
+		{
+			printf("Fruit %u didn't survive a snapshot round trip\n", i);
+			currentOk = false;
+		}
+		if (!SameFruit(fruits[i], fromOld[i]))
+		{
+			printf("Fruit %u didn't migrate from a version 1 snapshot\n", i);
+			oldOk = false;
+		}
+	}
+
+	//arena strings and vectors, loaded through the allocators of Articles in another arena
+	{
+		const unsigned articles = 2000;
+		const meta::Type* articleType = meta::get<Article>();
+		meta::MonotonicArena source, target;
+		Article* written = static_cast<Article*>(meta::NewObjects(articleType, articles, &source));
+		for (unsigned i = 0; i < articles; ++i)
+			MakeArticle(written[i], i);
+
+		std::vector<char> plain, packed;
+		meta::WriteSnapshot(articleType, written, articles, plain);
+		meta::SnapshotCompression articleCompression;
+		articleCompression.blockSize = 4096;
+		meta::WriteCompressedSnapshot(articleType, written, articles, packed, articleCompression);
+
+		Article* fromPlain = static_cast<Article*>(meta::NewObjects(articleType, articles, &target));
+		Article* fromPacked = static_cast<Article*>(meta::NewObjects(articleType, articles, &target));
+		bool ok = meta::ReadSnapshot(articleType, plain.data(), plain.size(), fromPlain, articles) &&
+			meta::ReadSnapshot(articleType, packed.data(), packed.size(), fromPacked, articles, 0, 4);
+		for (unsigned i = 0; ok && i < articles; ++i)
+			ok = SameArticle(written[i], fromPlain[i], &target) && SameArticle(written[i], fromPacked[i], &target);
+		if (!ok)
+			printf("Articles didn't round trip through a snapshot into an arena\n");
+
+		//damaged counts fail or load something, never outside their bounds
+		std::mt19937 random(44);
+		for (unsigned i = 0; i < 200; ++i)
+		{
+			std::vector<char> damaged = plain;
+			damaged[plain.size() / 2 + random() % (plain.size() / 2)] ^= (char)(1 + random() % 255);
+			meta::ReadSnapshot(articleType, damaged.data(), damaged.size(), fromPlain, articles);
+		}
+	}
+
+	printf("Fruit snapshot load, ns per record:\n");
+	printf("%18s %8.2f %s\n", "current schema", currentTime.count() / count, currentOk ? "" : "FAILED");
+	printf("%18s %8.2f %s\n", "version 1", oldTime.count() / count, oldOk ? "" : "FAILED");
+	printf("\n");
+}
@@ -0,0 +1,398 @@
+#include "Sort.h"
+#include "FieldKind.h"
+#include "StringPool.h"
+#include <algorithm>
+#include <iostream>
+
+namespace meta
+{
+	namespace
+	{
+		//kinds with an order preserving key; bools sort as unsigned
+		bool Sortable(FieldKind kind)
+		{
+			return kind <= Kind_Interned || kind == Kind_Enumeration;
+		}
+
+		//a key and the index of the object it came from
+		template <typename Key>
+		struct Keyed
+		{
+			Key key;
+			unsigned index;
+		};
+
+		//////// Order preserving unsigned keys ////////
+
+		long long LoadSigned(const char* field, unsigned size)
+		{
+			switch (size)
+			{
+			case 1: return *reinterpret_cast<const signed char*>(field);
+			case 2: return *reinterpret_cast<const short*>(field);
+			case 4: return *reinterpret_cast<const int*>(field);
+			default: return *reinterpret_cast<const long long*>(field);
+			}
+		}
+
+		unsigned long long LoadUnsigned(const char* field, unsigned size)
+		{
+			switch (size)
+			{
+			case 1: return *reinterpret_cast<const unsigned char*>(field);
+			case 2: return *reinterpret_cast<const unsigned short*>(field);
+			case 4: return *reinterpret_cast<const unsigned*>(field);
+			default: return *reinterpret_cast<const unsigned long long*>(field);
+			}
+		}
+
+		//two's complement with the sign bit flipped orders as unsigned
+		template <typename Key>
+		Key SignedKey(long long value)
+		{
+			return static_cast<Key>(value) ^ (static_cast<Key>(1) << (sizeof(Key) * 8 - 1));
+		}
+
+		//IEEE floats: negatives get every bit flipped, positives just the sign bit
+		unsigned FloatKey(const char* field)
+		{
+			unsigned bits;
+			std::memcpy(&bits, field, sizeof(bits));
+			bits = (bits & 0x7fffffffu) != 0 ? bits : 0u; //-0.0 == 0.0
+			return (bits & 0x80000000u) ? ~bits : bits | 0x80000000u;
+		}
+
+		unsigned long long DoubleKey(const char* field)
+		{
+			unsigned long long bits;
+			std::memcpy(&bits, field, sizeof(bits));
+			bits = (bits & 0x7fffffffffffffffULL) != 0 ? bits : 0ULL;
+			return (bits & 0x8000000000000000ULL) ? ~bits : bits | 0x8000000000000000ULL;
+		}
+
+		void StringAt(FieldKind kind, const char* field, const char*& data, unsigned& length)
+		{
+			switch (kind)
+			{
+			case Kind_String:
+			{
+				const std::string& string = *reinterpret_cast<const std::string*>(field);
+				data = string.data();
+				length = (unsigned)string.size();
+				break;
+			}
+			case Kind_View:
+			{
+				const StringView& view = *reinterpret_cast<const StringView*>(field);
+				data = view.data;
+				length = view.length;
+				break;
+			}
+			default:
+			{
+				const InternedString& interned = *reinterpret_cast<const InternedString*>(field);
+				data = interned.c_str();
+				length = interned.length;
+				break;
+			}
+			}
+		}
+
+		//the first 8 bytes, big endian, zero padded
+		unsigned long long PrefixKey(const char* data, unsigned length)
+		{
+			unsigned long long key = 0;
+			for (unsigned i = 0; i < 8; ++i)
+			{
+				key = (key << 8) | (i < length ? static_cast<unsigned char>(data[i]) : 0u);
+			}
+			return key;
+		}
+
+		template <typename Key>
+		void ExtractKeys(FieldKind kind, const Type* leaf, const char* field, unsigned count, unsigned stride, bool descending, Keyed<Key>* keys)
+		{
+			const unsigned size = leaf->Size();
+			for (unsigned i = 0; i < count; ++i, field += stride)
+			{
+				Key key;
+				switch (kind)
+				{
+				case Kind_Signed: key = SignedKey<Key>(LoadSigned(field, size)); break;
+				case Kind_Unsigned:
+				case Kind_Boolean: key = static_cast<Key>(LoadUnsigned(field, size)); break;
+				case Kind_Real32: key = static_cast<Key>(FloatKey(field)); break;
+				case Kind_Real64: key = static_cast<Key>(DoubleKey(field)); break;
+				case Kind_Enumeration: key = leaf->Enum()->IsSigned() ? SignedKey<Key>(leaf->Enum()->Get(field)) : static_cast<Key>(leaf->Enum()->Get(field)); break;
+				default:
+				{
+					const char* data;
+					unsigned length;
+					StringAt(kind, field, data, length);
+					key = static_cast<Key>(PrefixKey(data, length));
+					break;
+				}
+				}
+				keys[i].key = descending ? static_cast<Key>(~key) : key;
+				keys[i].index = i;
+			}
+		}
+
+		//////// LSD radix sort, 8 bit digits ////////
+
+		template <typename Key>
+		void RadixSort(std::vector<Keyed<Key> >& keys)
+		{
+			const unsigned digits = sizeof(Key);
+			const unsigned count = (unsigned)keys.size();
+			if (count < 2)
+			{
+				return;
+			}
+
+			//every digit's histogram in one pass over the keys
+			std::vector<unsigned> histogram(digits * 256, 0);
+			for (unsigned i = 0; i < count; ++i)
+			{
+				Key key = keys[i].key;
+				for (unsigned digit = 0; digit < digits; ++digit, key >>= 8)
+				{
+					++histogram[digit * 256 + static_cast<unsigned>(key & 0xff)];
+				}
+			}
+
+			std::vector<Keyed<Key> > scratch(count);
+			Keyed<Key>* from = keys.data();
+			Keyed<Key>* to = scratch.data();
+
+			for (unsigned digit = 0; digit < digits; ++digit)
+			{
+				const unsigned shift = digit * 8;
+				unsigned* bucket = &histogram[digit * 256];
+
+				//every key shares this digit, so the pass wouldn't move anything
+				if (bucket[static_cast<unsigned>(from[0].key >> shift) & 0xff] == count)
+				{
+					continue;
+				}
+
+				unsigned offset = 0;
+				for (unsigned b = 0; b < 256; ++b)
+				{
+					unsigned n = bucket[b];
+					bucket[b] = offset;
+					offset += n;
+				}
+
+				for (unsigned i = 0; i < count; ++i)
+				{
+					to[bucket[static_cast<unsigned>(from[i].key >> shift) & 0xff]++] = from[i];
+				}
+				std::swap(from, to);
+			}
+
+			if (from != keys.data())
+			{
+				keys.swap(scratch);
+			}
+		}
+
+		//full string order, for runs that share a prefix
+		struct StringLess
+		{
+			FieldKind kind;
+			const char* field;
+			unsigned stride;
+			bool descending;
+
+			int Compare(unsigned lhs, unsigned rhs) const
+			{
+				const char* lhsData;
+				const char* rhsData;
+				unsigned lhsLength, rhsLength;
+				StringAt(kind, field + (size_t)lhs * stride, lhsData, lhsLength);
+				StringAt(kind, field + (size_t)rhs * stride, rhsData, rhsLength);
+
+				int result = std::memcmp(lhsData, rhsData, std::min(lhsLength, rhsLength));
+				if (result != 0)
+				{
+					return result;
+				}
+				return lhsLength < rhsLength ? -1 : (lhsLength > rhsLength ? 1 : 0);
+			}
+
+			bool operator()(const Keyed<unsigned long long>& lhs, const Keyed<unsigned long long>& rhs) const
+			{
+				return descending ? Compare(rhs.index, lhs.index) < 0 : Compare(lhs.index, rhs.index) < 0;
+			}
+		};
+
+		template <typename Key>
+		void ToOrder(const std::vector<Keyed<Key> >& keys, std::vector<unsigned>& order)
+		{
+			order.resize(keys.size());
+			for (unsigned i = 0; i < keys.size(); ++i)
+			{
+				order[i] = keys[i].index;
+			}
+		}
+
+		bool SortOrder(const Type* root, const Type* leaf, unsigned offset, const void* objects, unsigned count, std::vector<unsigned>& order, bool descending, unsigned stride)
+		{
+			if (root == NULL || leaf == NULL)
+			{
+				std::cout << "Can't sort by an unknown member" << std::endl;
+				return false;
+			}
+
+			FieldKind kind = Classify(leaf);
+			if (!Sortable(kind))
+			{
+				std::cout << "Can't sort " << root->Name() << " by " << leaf->Name() << " keys" << std::endl;
+				return false;
+			}
+
+			stride = stride != 0 ? stride : root->Size();
+			const char* field = static_cast<const char*>(objects) + offset;
+
+			//small integers and floats fit 32 bit keys, which halves the traffic of every pass
+			bool narrow = (kind == Kind_Signed || kind == Kind_Unsigned || kind == Kind_Boolean || kind == Kind_Real32) && leaf->Size() <= 4;
+			if (narrow)
+			{
+				std::vector<Keyed<unsigned> > keys(count);
+				ExtractKeys(kind, leaf, field, count, stride, descending, keys.data());
+				RadixSort(keys);
+				ToOrder(keys, order);
+				return true;
+			}
+
+			std::vector<Keyed<unsigned long long> > keys(count);
+			ExtractKeys(kind, leaf, field, count, stride, descending, keys.data());
+			RadixSort(keys);
+
+			if (kind == Kind_String || kind == Kind_View || kind == Kind_Interned)
+			{
+				StringLess less = { kind, field, stride, descending };
+				unsigned begin = 0;
+				for (unsigned i = 1; i <= count; ++i)
+				{
+					if (i == count || keys[i].key != keys[begin].key)
+					{
+						if (i - begin > 1)
+						{
+							std::stable_sort(keys.begin() + begin, keys.begin() + i, less);
+						}
+						begin = i;
+					}
+				}
+			}
+
+			ToOrder(keys, order);
+			return true;
+		}
+	}
+
+	bool SortOrder(const PropertyPath& key, const void* objects, unsigned count, std::vector<unsigned>& order, bool descending, unsigned stride)
+	{
+		return SortOrder(key.Root(), key.Leaf(), key.Offset(), objects, count, order, descending, stride);
+	}
+
+	bool SortOrder(const Type* type, const Member* member, const void* objects, unsigned count, std::vector<unsigned>& order, bool descending, unsigned stride)
+	{
+		return SortOrder(type, member != NULL ? member->Meta() : NULL, member != NULL ? member->Offset() : 0, objects, count, order, descending, stride);
+	}
+
+	bool SortBy(const PropertyPath& key, void* objects, unsigned count, bool descending, unsigned stride)
+	{
+		std::vector<unsigned> order;
+		if (!SortOrder(key, objects, count, order, descending, stride))
+		{
+			return false;
+		}
+		Permute(key.Root(), objects, order, stride);
+		return true;
+	}
+
+	bool SortBy(const Type* type, const Member* member, void* objects, unsigned count, bool descending, unsigned stride)
+	{
+		std::vector<unsigned> order;
+		if (!SortOrder(type, member, objects, count, order, descending, stride))
+		{
+			return false;
+		}
+		Permute(type, objects, order, stride);
+		return true;
+	}
+
+	bool IsSortable(const Type* type)
+	{
+		return type != NULL && Sortable(Classify(type));
+	}
+
+	bool IsStringKey(const Type* type)
+	{
+		FieldKind kind = type != NULL ? Classify(type) : Kind_Other;
+		return kind == Kind_String || kind == Kind_View || kind == Kind_Interned;
+	}
+
+	bool NumericKey(const Type* type, const void* value, unsigned long long& key)
+	{
+		const char* field = static_cast<const char*>(value);
+		switch (Classify(type))
+		{
+		case Kind_Signed: key = SignedKey<unsigned long long>(LoadSigned(field, type->Size())); return true;
+		case Kind_Unsigned:
+		case Kind_Boolean: key = LoadUnsigned(field, type->Size()); return true;
+		case Kind_Real32: key = FloatKey(field); return true;
+		case Kind_Real64: key = DoubleKey(field); return true;
+		case Kind_Enumeration: key = type->Enum()->IsSigned() ? SignedKey<unsigned long long>(type->Enum()->Get(field)) : type->Enum()->Get(field); return true;
+		default: return false;
+		}
+	}
+
+	bool StringKey(const Type* type, const void* value, const char*& data, unsigned& length)
+	{
+		if (!IsStringKey(type))
+		{
+			return false;
+		}
+		StringAt(Classify(type), static_cast<const char*>(value), data, length);
+		return true;
+	}
+
+	void Permute(const Type* type, void* objects, const std::vector<unsigned>& order, unsigned stride)
+	{
+		const unsigned count = (unsigned)order.size();
+		if (count < 2)
+		{
+			return;
+		}
+		stride = stride != 0 ? stride : type->Size();
+		char* base = static_cast<char*>(objects);
+
+		//follow each cycle of the permutation, carrying its first object in temp
+		void* temp = type->IsConstructible() ? type->New() : type->NewCopy(base);
+		std::vector<bool> placed(count, false);
+
+		for (unsigned start = 0; start < count; ++start)
+		{
+			if (placed[start] || order[start] == start)
+			{
+				continue;
+			}
+
+			type->Move(temp, base + (size_t)start * stride);
+			unsigned at = start;
+			while (order[at] != start)
+			{
+				type->Move(base + (size_t)at * stride, base + (size_t)order[at] * stride);
+				placed[at] = true;
+				at = order[at];
+			}
+			type->Move(base + (size_t)at * stride, temp);
+			placed[at] = true;
+		}
+
+		type->Delete(temp);
+	}
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+#include "PropertyPath.h"
+
+namespace meta
+{
+	//////////////////////////////////////////////////////////////////////////////
+	//  Reflective Sort
+	//////////////////////////////////////////////////////////////////////////////
+	// Purpose: Sorts arrays of a reflected type by a member picked at runtime. The keys are pulled
+	//          out once into a compact key+index array: numbers, bools and enums become unsigned
+	//          integers with the same order and are radix sorted; strings are radix sorted on an
+	//          8 byte prefix and only runs sharing a prefix are compared in full. The objects are
+	//          then permuted into place once. Sorts are stable.
+	//
+	// Keys can be any integer, float, double, bool, enum, std::string, StringView or InternedString.
+	// Anything else is reported and the objects are left alone.
+
+	//order[i] is the index of the object that sorts i-th. Objects are stride bytes apart (0 means key.Root()->Size()).
+	bool SortOrder(const PropertyPath& key, const void* objects, unsigned count, std::vector<unsigned>& order, bool descending = false, unsigned stride = 0);
+	bool SortOrder(const Type* type, const Member* member, const void* objects, unsigned count, std::vector<unsigned>& order, bool descending = false, unsigned stride = 0);
+
+	//sorts count objects in place
+	bool SortBy(const PropertyPath& key, void* objects, unsigned count, bool descending = false, unsigned stride = 0);
+	bool SortBy(const Type* type, const Member* member, void* objects, unsigned count, bool descending = false, unsigned stride = 0);
+
+	//moves object order[i] to position i, each object once. Non trivial types go through Type::Move.
+	void Permute(const Type* type, void* objects, const std::vector<unsigned>& order, unsigned stride = 0);
+
+	//true if values of type can be sort keys
+	bool IsSortable(const Type* type);
+
+	//true for std::string, StringView and InternedString
+	bool IsStringKey(const Type* type);
+
+	//The 64 bit key the sort orders an integer, float, double, bool or enum value by: unsigned keys
+	//compare like the values. -0.0 and 0.0 get the same key. false for other types.
+	bool NumericKey(const Type* type, const void* value, unsigned long long& key);
+
+	//the characters of a std::string, StringView or InternedString value; false for other types
+	bool StringKey(const Type* type, const void* value, const char*& data, unsigned& length);
+}
+
+void TestReflectiveSort();
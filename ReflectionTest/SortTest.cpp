@@ -0,0 +1,183 @@
+#include "Sort.h"
+#include "SerializationTest.h"
+#include <algorithm>
+#include <chrono>
+#include <random>
+
+namespace
+{
+	//what tooling did before: look the column up on every comparison
+	struct ReflectiveLess
+	{
+		const meta::Type* type;
+		std::string column;
+
+		bool operator()(const Thing& lhs, const Thing& rhs) const
+		{
+			const meta::Member* member = type->mamberNames.find(column)->second;
+			const meta::Type* leaf = member->Meta();
+			const char* a = reinterpret_cast<const char*>(&lhs) + member->Offset();
+			const char* b = reinterpret_cast<const char*>(&rhs) + member->Offset();
+
+			if (leaf == meta::get<float>())
+				return *reinterpret_cast<const float*>(a) < *reinterpret_cast<const float*>(b);
+			if (leaf == meta::get<double>())
+				return *reinterpret_cast<const double*>(a) < *reinterpret_cast<const double*>(b);
+			if (leaf == meta::get<int>())
+				return *reinterpret_cast<const int*>(a) < *reinterpret_cast<const int*>(b);
+			if (leaf == meta::get<unsigned>())
+				return *reinterpret_cast<const unsigned*>(a) < *reinterpret_cast<const unsigned*>(b);
+			if (leaf == meta::get<std::string>())
+				return *reinterpret_cast<const std::string*>(a) < *reinterpret_cast<const std::string*>(b);
+			return false;
+		}
+	};
+
+	void MakeThings(std::vector<Thing>& things, unsigned count)
+	{
+		std::mt19937 random(39);
+		std::uniform_real_distribution<float> radius(-1000.0f, 1000.0f);
+		std::uniform_real_distribution<double> height(0.0, 1.0e6);
+
+		things.assign(count, Thing());
+		for (unsigned i = 0; i < count; ++i)
+		{
+			Thing& thing = things[i];
+			thing.id = i;
+			thing.size = (int)(random() % 2001) - 1000;
+			thing.radius = radius(random);
+			thing.height = height(random);
+			thing.kind = (random() & 1) ? Thing_Apple : Thing_Banana;
+
+			//short lowercase names: many share their first bytes, some share all 8
+			unsigned length = 4 + random() % 9;
+			thing.name.resize(length);
+			for (unsigned c = 0; c < length; ++c)
+				thing.name[c] = (char)('a' + (c < 3 ? random() % 4 : random() % 26));
+		}
+		std::shuffle(things.begin(), things.end(), random);
+	}
+
+	//true if both tables hold the same column values in the same order
+	bool SameOrder(const std::vector<Thing>& lhs, const std::vector<Thing>& rhs, const ReflectiveLess& less)
+	{
+		for (unsigned i = 0; i < lhs.size(); ++i)
+		{
+			if (less(lhs[i], rhs[i]) || less(rhs[i], lhs[i]))
+				return false;
+		}
+		return true;
+	}
+
+	void BenchmarkSort(const std::vector<Thing>& source, const char* column)
+	{
+		typedef std::chrono::high_resolution_clock Clock;
+		const meta::Type* thingType = meta::get<Thing>();
+		ReflectiveLess less = { thingType, column };
+
+		std::vector<Thing> compared(source);
+		Clock::time_point start = Clock::now();
+		std::sort(compared.begin(), compared.end(), less);
+		std::chrono::duration<double, std::milli> comparator = Clock::now() - start;
+
+		std::vector<Thing> sorted(source);
+		start = Clock::now();
+		meta::SortBy(thingType, thingType->mamberNames.find(column)->second, sorted.data(), (unsigned)sorted.size());
+		std::chrono::duration<double, std::milli> radix = Clock::now() - start;
+
+		if (!SameOrder(compared, sorted, less))
+			printf("Reflective sort by %s doesn't match std::sort\n", column);
+
+		printf("%18s %10u %10.2f %10.2f\n", column, (unsigned)source.size(), comparator.count(), radix.count());
+	}
+}
+
+void TestReflectiveSort()
+{
+	const meta::Type* thingType = meta::get<Thing>();
+
+	//a small table, through every kind of key
+	{
+		std::vector<Thing> things;
+		MakeThings(things, 1000);
+
+		meta::PropertyPath z(thingType, "position.z");
+		for (unsigned i = 0; i < things.size(); ++i)
+			things[i].position.z = (float)(things[i].id % 7) - 3.0f;
+
+		//stable: equal z keeps the shuffled id order
+		std::vector<Thing> expected(things);
+		std::stable_sort(expected.begin(), expected.end(), [](const Thing& lhs, const Thing& rhs) { return lhs.position.z < rhs.position.z; });
+		if (!meta::SortBy(z, things.data(), (unsigned)things.size()))
+			printf("Reflective sort rejected position.z\n");
+		for (unsigned i = 0; i < things.size(); ++i)
+		{
+			if (things[i].id != expected[i].id)
+			{
+				printf("Reflective sort by position.z isn't stable at %u\n", i);
+				break;
+			}
+		}
+
+		std::vector<unsigned> order;
+		meta::PropertyPath size(thingType, "size");
+		if (!meta::SortOrder(size, things.data(), (unsigned)things.size(), order, true))
+			printf("Reflective sort rejected size\n");
+		for (unsigned i = 1; i < order.size(); ++i)
+		{
+			if (things[order[i - 1]].size < things[order[i]].size)
+			{
+				printf("Descending sort by size is out of order at %u\n", i);
+				break;
+			}
+		}
+
+		meta::PropertyPath kind(thingType, "kind");
+		meta::SortBy(kind, things.data(), (unsigned)things.size());
+		if (things.front().kind != Thing_Banana || things.back().kind != Thing_Apple)
+			printf("Reflective sort by kind is out of order\n");
+
+		meta::PropertyPath name(thingType, "name");
+		meta::SortBy(name, things.data(), (unsigned)things.size(), true);
+		for (unsigned i = 1; i < things.size(); ++i)
+		{
+			if (things[i - 1].name < things[i].name)
+			{
+				printf("Descending sort by name is out of order at %u\n", i);
+				break;
+			}
+		}
+
+		//trivially copyable objects are permuted with memcpy
+		std::vector<Vector3> points(100);
+		for (unsigned i = 0; i < points.size(); ++i)
+			points[i] = Vector3((float)i, (float)((i * 37) % 100) - 50.0f, 0.0f);
+		meta::SortBy(meta::PropertyPath(meta::get<Vector3>(), "y"), points.data(), (unsigned)points.size());
+		for (unsigned i = 0; i < points.size(); ++i)
+		{
+			if (points[i].y != (float)i - 50.0f || points[i].y != (float)(((unsigned)points[i].x * 37) % 100) - 50.0f)
+			{
+				printf("Reflective sort of Vector3 by y is out of order at %u\n", i);
+				break;
+			}
+		}
+	}
+
+	printf("Sorting Things, ms:\n");
+	printf("%18s %10s %10s %10s\n", "", "rows", "std::sort", "radix");
+	{
+		std::vector<Thing> things;
+		MakeThings(things, 1000000);
+		BenchmarkSort(things, "radius");
+		BenchmarkSort(things, "height");
+		BenchmarkSort(things, "id");
+		BenchmarkSort(things, "name");
+	}
+	{
+		std::vector<Thing> things;
+		MakeThings(things, 10000000);
+		BenchmarkSort(things, "radius");
+		BenchmarkSort(things, "name");
+	}
+	printf("\n");
+}
@@ -0,0 +1,65 @@
+#include "StringPool.h"
+
+namespace meta
+{
+	size_t StringPool::ViewHash::operator()(const StringView& view) const
+	{
+		//FNV-1a
+		size_t hash = 2166136261u;
+		for (unsigned i = 0; i < view.length; ++i)
+		{
+			hash = (hash ^ (unsigned char)view.data[i]) * 16777619u;
+		}
+		return hash;
+	}
+
+	StringPool::StringPool(unsigned chunkSize) :
+		at(NULL),
+		end(NULL),
+		chunkSize(chunkSize),
+		bytes(0)
+	{
+	}
+
+	StringPool::~StringPool()
+	{
+		for (unsigned i = 0; i < chunks.size(); ++i)
+		{
+			delete[] chunks[i];
+		}
+	}
+
+	InternedString StringPool::Intern(const char* str, unsigned length)
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+
+		InternedString interned;
+		std::unordered_set<StringView, ViewHash>::const_iterator found = strings.find(StringView(str, length));
+		if (found != strings.end())
+		{
+			interned.str = found->data;
+			interned.length = found->length;
+			return interned;
+		}
+
+		//long strings get a chunk of their own
+		if ((size_t)(end - at) < (size_t)length + 1)
+		{
+			size_t size = length + 1 > chunkSize ? length + 1 : chunkSize;
+			chunks.push_back(new char[size]);
+			at = chunks.back();
+			end = at + size;
+		}
+
+		char* copy = at;
+		std::memcpy(copy, str, length);
+		copy[length] = '\0';
+		at += length + 1;
+		bytes += length + 1;
+
+		strings.insert(StringView(copy, length));
+		interned.str = copy;
+		interned.length = length;
+		return interned;
+	}
+}
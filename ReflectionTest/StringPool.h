@@ -0,0 +1,73 @@
+#pragma once
+
+#include "Meta.h"
+#include <mutex>
+#include <unordered_set>
+
+namespace meta
+{
+	//////////////////////////////////////////////////////////////////////////////
+	//  String Members Without Ownership
+	//////////////////////////////////////////////////////////////////////////////
+
+	//length bytes owned by someone else, like a mapped file. Not NUL terminated.
+	struct StringView
+	{
+		StringView() : data(NULL), length(0) {}
+		StringView(const char* data, unsigned length) : data(data), length(length) {}
+
+		std::string ToString(void) const { return std::string(data, length); }
+		bool operator==(const StringView& rhs) const { return length == rhs.length && std::memcmp(data, rhs.data, length) == 0; }
+
+		const char* data;
+		unsigned length;
+	};
+
+	//a NUL terminated string owned by a StringPool. Equal strings from one pool share one copy,
+	//so they compare by pointer.
+	struct InternedString
+	{
+		InternedString() : str(NULL), length(0) {}
+
+		const char* c_str(void) const { return str != NULL ? str : ""; }
+		bool operator==(const InternedString& rhs) const { return str == rhs.str; }
+
+		const char* str;
+		unsigned length;
+	};
+
+	//////////////////////////////////////////////////////////////////////////////
+	//  StringPool
+	//////////////////////////////////////////////////////////////////////////////
+	// Purpose: Keeps one copy of each distinct string, packed into large chunks that live as long
+	//          as the pool. Thread safe.
+	class StringPool
+	{
+	public:
+		StringPool(unsigned chunkSize = 64 * 1024);
+		~StringPool();
+
+		InternedString Intern(const char* str, unsigned length);
+
+		unsigned Count(void) const { return (unsigned)strings.size(); }
+		size_t Bytes(void) const { return bytes; }
+
+	private:
+		// Non-Copyable
+		StringPool(const StringPool&); // = delete
+		void operator=(const StringPool&); // = delete
+
+		struct ViewHash
+		{
+			size_t operator()(const StringView& view) const;
+		};
+
+		std::mutex mutex;
+		std::unordered_set<StringView, ViewHash> strings; //views of the pooled copies
+		std::vector<char*> chunks;
+		char* at;
+		char* end;
+		unsigned chunkSize;
+		size_t bytes;
+	};
+}
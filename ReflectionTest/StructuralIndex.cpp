@@ -0,0 +1,370 @@
+#include "StructuralIndex.h"
+#include "MmapJson.h"
+#include "Trace.h"
+#include "WorkStealing.h"
+#include <algorithm>
+#include <chrono>
+
+#if defined(_M_IX86) || defined(_M_X64) || defined(__SSE2__)
+#define META_SSE2 1
+#include <emmintrin.h>
+#endif
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+namespace meta
+{
+	namespace
+	{
+		typedef unsigned long long Bits;
+
+		unsigned LowestBit(Bits bits)
+		{
+#if defined(_MSC_VER) && defined(_M_X64)
+			unsigned long index;
+			_BitScanForward64(&index, bits);
+			return index;
+#elif defined(__GNUC__)
+			return (unsigned)__builtin_ctzll(bits);
+#else
+			unsigned index = 0;
+			for (; (bits & 1) == 0; bits >>= 1)
+			{
+				++index;
+			}
+			return index;
+#endif
+		}
+
+		//bit i is the xor of bits 0 to i: set from an opening quote up to, not including, its closing quote
+		Bits PrefixXor(Bits bits)
+		{
+			bits ^= bits << 1;
+			bits ^= bits << 2;
+			bits ^= bits << 4;
+			bits ^= bits << 8;
+			bits ^= bits << 16;
+			bits ^= bits << 32;
+			return bits;
+		}
+
+		//one bit per byte of a 64 byte block for backslashes, quotes and structural characters
+#if META_SSE2
+		void Classify(const char* block, Bits& backslashes, Bits& quotes, Bits& structurals)
+		{
+			const __m128i backslash = _mm_set1_epi8('\\');
+			const __m128i quote = _mm_set1_epi8('"');
+			const __m128i lowercase = _mm_set1_epi8(0x20);
+			const __m128i openBrace = _mm_set1_epi8('{');
+			const __m128i closeBrace = _mm_set1_epi8('}');
+			const __m128i colon = _mm_set1_epi8(':');
+			const __m128i comma = _mm_set1_epi8(',');
+
+			backslashes = quotes = structurals = 0;
+			for (unsigned i = 0; i < 4; ++i)
+			{
+				__m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(block + 16 * i));
+				__m128i folded = _mm_or_si128(bytes, lowercase); //[ and ] become { and }
+				__m128i structural = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(folded, openBrace), _mm_cmpeq_epi8(folded, closeBrace)),
+					_mm_or_si128(_mm_cmpeq_epi8(bytes, colon), _mm_cmpeq_epi8(bytes, comma)));
+
+				backslashes |= (Bits)(unsigned)_mm_movemask_epi8(_mm_cmpeq_epi8(bytes, backslash)) << (16 * i);
+				quotes |= (Bits)(unsigned)_mm_movemask_epi8(_mm_cmpeq_epi8(bytes, quote)) << (16 * i);
+				structurals |= (Bits)(unsigned)_mm_movemask_epi8(structural) << (16 * i);
+			}
+		}
+#else
+		void Classify(const char* block, Bits& backslashes, Bits& quotes, Bits& structurals)
+		{
+			backslashes = quotes = structurals = 0;
+			for (unsigned i = 0; i < 64; ++i)
+			{
+				char c = block[i];
+				Bits bit = (Bits)1 << i;
+				if (c == '\\')
+					backslashes |= bit;
+				else if (c == '"')
+					quotes |= bit;
+				else if (c == '{' || c == '}' || c == '[' || c == ']' || c == ':' || c == ',')
+					structurals |= bit;
+			}
+		}
+#endif
+
+		//carries the escape and in-string state from one block to the next
+		class BlockScanner
+		{
+		public:
+			BlockScanner() : escapeCarry(0), stringCarry(0) {}
+
+			void Next(const char* block, Bits& structurals, Bits& quotes)
+			{
+				Bits backslashes, quoteBits, structuralBits;
+				Classify(block, backslashes, quoteBits, structuralBits);
+
+				quotes = quoteBits & ~Escaped(backslashes);
+				Bits inString = PrefixXor(quotes) ^ stringCarry;
+				stringCarry = (Bits)((long long)inString >> 63);
+				structurals = structuralBits & ~inString;
+			}
+
+		private:
+			//the characters escaped by a backslash; each backslash escapes the next, unless it's escaped itself
+			Bits Escaped(Bits backslashes)
+			{
+				Bits escaped = escapeCarry;
+				escapeCarry = 0;
+				backslashes &= ~escaped;
+				while (backslashes != 0)
+				{
+					unsigned bit = LowestBit(backslashes);
+					if (bit == 63)
+					{
+						escapeCarry = 1;
+						break;
+					}
+					escaped |= (Bits)2 << bit;
+					backslashes &= ~((Bits)3 << bit);
+				}
+				return escaped;
+			}
+
+			Bits escapeCarry;
+			Bits stringCarry;
+		};
+
+		//visit(base, structurals, quotes) for each 64 byte block, the last padded with spaces, until it returns false
+		template <typename Visit>
+		void ScanBlocks(const char* text, size_t size, Visit visit)
+		{
+			BlockScanner scanner;
+			Bits structurals, quotes;
+			size_t base = 0;
+			for (; base + 64 <= size; base += 64)
+			{
+				scanner.Next(text + base, structurals, quotes);
+				if (!visit(base, structurals, quotes))
+				{
+					return;
+				}
+			}
+
+			if (base < size)
+			{
+				char tail[64];
+				std::memset(tail, ' ', sizeof(tail));
+				std::memcpy(tail, text + base, size - base);
+				scanner.Next(tail, structurals, quotes);
+				visit(base, structurals, quotes);
+			}
+		}
+
+		bool IsBlank(const char* begin, const char* end)
+		{
+			for (; begin < end; ++begin)
+			{
+				if (*begin != ' ' && *begin != '\n' && *begin != '\r' && *begin != '\t')
+				{
+					return false;
+				}
+			}
+			return true;
+		}
+	}
+
+	void IndexStructurals(const char* text, size_t size, std::vector<size_t>& positions)
+	{
+		positions.clear();
+		ScanBlocks(text, size, [&](size_t base, Bits structurals, Bits quotes)
+		{
+			for (Bits bits = structurals | quotes; bits != 0; bits &= bits - 1)
+			{
+				positions.push_back(base + LowestBit(bits));
+			}
+			return true;
+		});
+	}
+
+	bool FindArrayElements(const char* text, size_t size, std::vector<JsonSpan>& elements)
+	{
+		elements.clear();
+		unsigned depth = 0;
+		size_t start = 0;
+		bool closed = false;
+		bool malformed = false;
+
+		ScanBlocks(text, size, [&](size_t base, Bits structurals, Bits)
+		{
+			for (; structurals != 0; structurals &= structurals - 1)
+			{
+				size_t at = base + LowestBit(structurals);
+				switch (text[at])
+				{
+					case '[':
+					case '{':
+						if (depth == 0 && text[at] != '[')
+						{
+							malformed = true;
+							return false;
+						}
+						if (depth++ == 0)
+						{
+							start = at + 1;
+						}
+						break;
+					case ']':
+					case '}':
+						if (depth == 0)
+						{
+							malformed = true;
+							return false;
+						}
+						if (--depth == 0)
+						{
+							if (!IsBlank(text + start, text + at))
+							{
+								JsonSpan element = { start, at };
+								elements.push_back(element);
+							}
+							closed = true;
+							return false;
+						}
+						break;
+					case ',':
+						if (depth == 1)
+						{
+							JsonSpan element = { start, at };
+							elements.push_back(element);
+							start = at + 1;
+						}
+						break;
+					default:
+						break;
+				}
+			}
+			return true;
+		});
+
+		return closed && !malformed;
+	}
+
+	IngestStats ParseJsonArrayParallel(char* text, size_t size, const Type* type, void*& objects, StringPool& pool, const IngestOptions& options)
+	{
+		typedef std::chrono::high_resolution_clock Clock;
+		typedef std::chrono::duration<double, std::milli> Milliseconds;
+
+		IngestStats stats;
+		objects = NULL;
+		if (!type->IsConstructible())
+		{
+			std::cout << type->Name() << " can't be default constructed" << std::endl;
+			return stats;
+		}
+
+		Clock::time_point start = Clock::now();
+		std::vector<JsonSpan> elements;
+		{
+			TraceSpan span("index structurals", type, size);
+			if (!FindArrayElements(text, size, elements))
+			{
+				std::cout << "Json doesn't hold an array of " << type->Name() << std::endl;
+				return stats;
+			}
+		}
+
+		//batches of whole elements, about chunkSize bytes each: [first element, next batch's first)
+		std::vector<unsigned> batches;
+		size_t chunkSize = options.chunkSize > 0 ? options.chunkSize : 1;
+		for (unsigned i = 0; i < elements.size(); ++i)
+		{
+			if (batches.empty() || elements[i].end - elements[batches.back()].begin > chunkSize)
+			{
+				batches.push_back(i);
+			}
+		}
+		stats.chunks = (unsigned)batches.size();
+		stats.threads = WorkStealingThreads(stats.chunks, options.threads);
+		stats.records = (unsigned)elements.size();
+		batches.push_back(stats.records);
+		Clock::time_point split = Clock::now();
+
+		//each worker builds its batches in a slab of its own, so workers never share an allocator
+		std::vector<MonotonicArena*> slabs(stats.threads);
+		for (unsigned i = 0; i < slabs.size(); ++i)
+		{
+			slabs[i] = new MonotonicArena(std::max(chunkSize * 2, (size_t)64 * 1024));
+		}
+
+		unsigned objectSize = type->Size();
+		std::vector<char*> parsed(stats.chunks, NULL);
+		std::vector<unsigned> failed(stats.chunks, 0);
+		stats.steals = RunWorkStealing(stats.chunks, stats.threads, [&](unsigned batch, unsigned worker)
+		{
+			TraceSpan span("parse chunk", type, elements[batches[batch + 1] - 1].end - elements[batches[batch]].begin);
+			MonotonicArena& slab = *slabs[worker];
+			parsed[batch] = static_cast<char*>(NewObjects(type, batches[batch + 1] - batches[batch], &slab));
+			for (unsigned i = batches[batch]; i < batches[batch + 1]; ++i)
+			{
+				char* object = parsed[batch] + (size_t)(i - batches[batch]) * objectSize;
+				if (!ParseJsonInSitu(text + elements[i].begin, elements[i].end - elements[i].begin, type, object, pool))
+				{
+					++failed[batch];
+					ScopedResource scope(&slab);
+					type->Destruct(object);
+					type->Construct(object);
+				}
+			}
+		});
+		Clock::time_point parsedAt = Clock::now();
+
+		//then moves them to their place in the array, in options.resource: copies on every worker,
+		//moves that allocate in the resource on one
+		char* array = NULL;
+		if (stats.records > 0)
+		{
+			array = static_cast<char*>(options.resource->Allocate((size_t)stats.records * objectSize, type->Alignment()));
+		}
+		unsigned joiners = type->IsTriviallyCopyable() ? stats.threads : 1;
+		stats.steals += RunWorkStealing(stats.chunks, joiners, [&](unsigned batch, unsigned)
+		{
+			unsigned count = batches[batch + 1] - batches[batch];
+			char* to = array + (size_t)batches[batch] * objectSize;
+			if (type->IsTriviallyCopyable())
+			{
+				std::memcpy(to, parsed[batch], (size_t)count * objectSize);
+			}
+			else
+			{
+				ScopedResource scope(options.resource);
+				for (unsigned i = 0; i < count; ++i)
+				{
+					type->Construct(to + (size_t)i * objectSize);
+					type->Move(to + (size_t)i * objectSize, parsed[batch] + (size_t)i * objectSize);
+				}
+			}
+			for (unsigned i = 0; i < count; ++i)
+			{
+				type->Destruct(parsed[batch] + (size_t)i * objectSize);
+			}
+		});
+
+		for (unsigned i = 0; i < slabs.size(); ++i)
+		{
+			delete slabs[i];
+		}
+		for (unsigned i = 0; i < failed.size(); ++i)
+		{
+			stats.failed += failed[i];
+		}
+		objects = array;
+		Clock::time_point done = Clock::now();
+
+		stats.split = Milliseconds(split - start).count();
+		stats.parse = Milliseconds(parsedAt - split).count();
+		stats.join = Milliseconds(done - parsedAt).count();
+		stats.total = Milliseconds(done - start).count();
+		return stats;
+	}
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include "Meta.h"
+#include "NdJson.h"
+
+namespace meta
+{
+	//////////////////////////////////////////////////////////////////////////////
+	//  Structural index
+	//////////////////////////////////////////////////////////////////////////////
+	// Purpose: A first pass over json text that finds its structural characters ({ } [ ] : ,)
+	//          and string quotes 64 bytes at a time, with SSE2 compares where there's SSE2.
+	//          Quotes that aren't escaped open and close strings, and a prefix xor over the
+	//          quote bits masks out every byte inside a string, so a bracket or comma in a
+	//          string is never taken for structure. Escapes are resolved bit by bit, and only
+	//          in blocks that have a backslash.
+
+	//every structural character outside strings and every quote that opens or closes a string, in order
+	void IndexStructurals(const char* text, size_t size, std::vector<size_t>& positions);
+
+	struct JsonSpan
+	{
+		size_t begin;
+		size_t end;
+	};
+
+	//The text of each element of the root array, found from the structural index without parsing:
+	//elements end at the commas one level deep. false if the root isn't an array or it never closes.
+	bool FindArrayElements(const char* text, size_t size, std::vector<JsonSpan>& elements);
+
+	//////////////////////////////////////////////////////////////////////////////
+	//  Parallel array parsing
+	//////////////////////////////////////////////////////////////////////////////
+	// Purpose: Loads one large json document whose root is an array of objects with every core.
+	//          The elements are found by FindArrayElements, grouped into batches of about
+	//          options.chunkSize bytes, and parsed in situ on the work stealing pool. Like
+	//          IngestNdJson, each worker parses into its own slab and the batches are then moved
+	//          to their place in one array in options.resource, so a resource that isn't thread
+	//          safe (a MonotonicArena) is only ever used by one worker at a time; element i is
+	//          object i. Elements parse like ParseJsonInSitu's root, so {"Thing": {...}}
+	//          elements fill a Thing.
+	//
+	//          Elements that don't parse are reported, counted in stats.failed and left default
+	//          constructed. stats.split is the indexing pass.
+
+	//Sets objects to an array of stats.records objects of type in options.resource; NULL if there are
+	//none. Free it with DeleteObjects(type, objects, stats.records, options.resource).
+	IngestStats ParseJsonArrayParallel(char* text, size_t size, const Type* type, void*& objects, StringPool& pool, const IngestOptions& options = IngestOptions());
+}
+
+void TestStructuralIndex();
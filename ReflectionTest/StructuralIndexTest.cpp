@@ -0,0 +1,207 @@
+#include "StructuralIndex.h"
+#include "SerializationTest.h"
+#include "Test.h"
+#include "jansson.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+
+namespace
+{
+	//byte at a time, for checking the blocks against
+	void ReferenceIndex(const char* text, size_t size, std::vector<size_t>& positions)
+	{
+		positions.clear();
+		bool inString = false, escaped = false;
+		for (size_t i = 0; i < size; ++i)
+		{
+			char c = text[i];
+			if (inString)
+			{
+				if (escaped)
+					escaped = false;
+				else if (c == '\\')
+					escaped = true;
+				else if (c == '"')
+				{
+					inString = false;
+					positions.push_back(i);
+				}
+			}
+			else if (c == '"')
+			{
+				inString = true;
+				positions.push_back(i);
+			}
+			else if (c == '{' || c == '}' || c == '[' || c == ']' || c == ':' || c == ',')
+			{
+				positions.push_back(i);
+			}
+		}
+	}
+
+	//json shaped text whose strings hold structural characters and runs of backslashes, cut anywhere by the blocks
+	std::string RandomJson(unsigned length)
+	{
+		const char* pieces[] = { "{", "}", "[", "]", ":", ",", " ", "12", "\"", "\\\\", "\\\"", "x,", "]}", "\\\\\\\"" };
+		std::string text;
+		bool inString = false;
+		while (text.size() < length)
+		{
+			const char* piece = pieces[rand() % 14];
+			//escapes only inside strings, as in json
+			if (piece[0] == '\\' && !inString)
+				continue;
+			if (piece[0] == '"')
+				inString = !inString;
+			text += piece;
+		}
+		return text;
+	}
+
+	//ThingFile.json's shape, many times over
+	std::string ThingFileArray(unsigned count)
+	{
+		std::string json = "[\n";
+		char thing[512];
+		for (unsigned i = 0; i < count; ++i)
+		{
+			sprintf(thing, "{\n\t\"Thing\":\n\t{\n\t\t\"id\": %u,\n\t\t\"size\": %u,\n\t\t\"name\": \"Bob [%u], \\\"the {%u}th\\\"\",\n\t\t\"radius\": 4.5,\n"
+				"\t\t\"height\": %u.8,\n\t\t\"position\": { \"x\":1.5, \"y\":2.63, \"z\":%u.11 },\n\t\t\"kind\": \"%s\"\n\t}\n}%s\n",
+				i, i % 9, i, i, i % 100, i % 7, i & 1 ? "Thing_Apple" : "Thing_Banana", i + 1 < count ? "," : "");
+			json += thing;
+		}
+		json += "]\n";
+		return json;
+	}
+
+	bool SameThing(const Thing& lhs, const Thing& rhs)
+	{
+		return lhs.id == rhs.id && lhs.size == rhs.size && lhs.name == rhs.name && lhs.radius == rhs.radius && lhs.height == rhs.height &&
+			lhs.position.x == rhs.position.x && lhs.position.y == rhs.position.y && lhs.position.z == rhs.position.z && lhs.kind == rhs.kind;
+	}
+}
+
+void TestStructuralIndex()
+{
+	typedef std::chrono::high_resolution_clock Clock;
+	typedef std::chrono::duration<double, std::milli> Milliseconds;
+
+	//the blocks agree with a byte at a time, escapes and strings crossing block boundaries included
+	std::vector<size_t> expected, positions;
+	srand(47);
+	for (unsigned i = 0; i < 200; ++i)
+	{
+		std::string text = RandomJson(1 + rand() % 600);
+		ReferenceIndex(text.data(), text.size(), expected);
+		meta::IndexStructurals(text.data(), text.size(), positions);
+		if (positions != expected)
+		{
+			printf("Structural index of %s is wrong\n", text.c_str());
+			break;
+		}
+	}
+
+	//elements end at commas one level deep, never at ones in strings or nested values
+	const char* elementsText = " [ {\"a\": \"x,]}\\\"[\", \"b\": \"\\\\\"}, [1, {\"c\": \",\"}], \"str,ing\" , 7 ] ";
+	std::vector<meta::JsonSpan> elements;
+	if (!meta::FindArrayElements(elementsText, strlen(elementsText), elements) || elements.size() != 4 ||
+		std::string(elementsText + elements[1].begin, elementsText + elements[1].end) != " [1, {\"c\": \",\"}]" ||
+		std::string(elementsText + elements[3].begin, elementsText + elements[3].end) != " 7 ")
+		printf("Array elements weren't found (%u)\n", (unsigned)elements.size());
+	if (meta::FindArrayElements("{ \"a\": [1, 2] }", 15, elements) || meta::FindArrayElements("[1, [2]", 7, elements) ||
+		!meta::FindArrayElements(" [ ] ", 5, elements) || !elements.empty())
+		printf("Array elements were found where there's no array\n");
+
+	//a large document of ThingFile.json shaped elements
+	const unsigned count = 100000;
+	const std::string json = ThingFileArray(count);
+	const double megabytes = json.size() / 1048576.0;
+
+	Clock::time_point start = Clock::now();
+	ReferenceIndex(json.data(), json.size(), expected);
+	Milliseconds byteIndex = Clock::now() - start;
+	start = Clock::now();
+	meta::IndexStructurals(json.data(), json.size(), positions);
+	Milliseconds blockIndex = Clock::now() - start;
+	if (positions != expected)
+		printf("Structural index of the Things is wrong\n");
+	start = Clock::now();
+	meta::FindArrayElements(json.data(), json.size(), elements);
+	Milliseconds elementIndex = Clock::now() - start;
+	if (elements.size() != count)
+		printf("Found %u of %u Things\n", (unsigned)elements.size(), count);
+
+	//jansson, one core: parse the document, then materialize every element
+	std::vector<Thing> reference(count, Thing());
+	start = Clock::now();
+	json_t* root = json_loads(json.c_str(), 0, NULL);
+	for (unsigned i = 0; i < json_array_size(root); ++i)
+		DeSerializeJsonObject(json_object_get(json_array_get(root, i), "Thing"), &reference[i], "Thing");
+	Milliseconds jansson = Clock::now() - start;
+	json_decref(root);
+
+	std::string rows;
+	for (unsigned threads = 1; threads <= 16; threads *= 2)
+	{
+		std::string text = json;
+		meta::StringPool pool;
+		meta::IngestOptions options;
+		options.threads = threads;
+		options.chunkSize = 256 * 1024;
+		void* objects;
+		meta::IngestStats stats = meta::ParseJsonArrayParallel(&text[0], text.size(), meta::get<Thing>(), objects, pool, options);
+
+		Thing* things = static_cast<Thing*>(objects);
+		bool same = stats.records == count && stats.failed == 0;
+		for (unsigned i = 0; same && i < count; ++i)
+			same = SameThing(things[i], reference[i]);
+		if (!same)
+			printf("%u threads parsed %u Things that differ from jansson's\n", threads, stats.records);
+
+		char row[128];
+		sprintf(row, "%18u %8u %8.2f %8.2f %8.2f %8.2f %8.1f\n", stats.threads, stats.steals, stats.split, stats.parse, stats.join, stats.total, megabytes / (stats.total / 1000.0));
+		rows += row;
+		meta::DeleteObjects(meta::get<Thing>(), objects, stats.records, options.resource);
+	}
+
+	//Articles into an arena on several workers, arena members and all
+	{
+		std::string text = "[";
+		for (unsigned i = 0; i < 4000; ++i)
+		{
+			text += i > 0 ? ", " : "";
+			text += "{ \"id\": " + std::to_string(i) + ", \"title\": \"an article long enough to allocate, number " + std::to_string(i) +
+				"\", \"scores\": [1.5, 2.5], \"tags\": [\"one tag that is long enough to allocate\"] }";
+		}
+		text += "]";
+		meta::MonotonicArena arena;
+		meta::StringPool pool;
+		meta::IngestOptions options;
+		options.threads = 4;
+		options.chunkSize = 4096;
+		options.resource = &arena;
+		void* objects;
+		meta::IngestStats stats = meta::ParseJsonArrayParallel(&text[0], text.size(), meta::get<Article>(), objects, pool, options);
+		Article* articles = static_cast<Article*>(objects);
+		bool same = stats.records == 4000 && stats.failed == 0;
+		for (unsigned i = 0; same && i < stats.records; ++i)
+		{
+			same = articles[i].id == (int)i && articles[i].title.size() > 40 && articles[i].scores.size() == 2 && articles[i].tags.size() == 1 &&
+				articles[i].title.get_allocator().Resource() == &arena && articles[i].tags[0].get_allocator().Resource() == &arena;
+		}
+		if (!same)
+			printf("Articles didn't parse into an arena on %u threads\n", stats.threads);
+		meta::DeleteObjects(meta::get<Article>(), objects, stats.records, options.resource);
+	}
+
+	printf("Structural index of %u ThingFile.json elements (%.1f MB), ms:\n", count, megabytes);
+	printf("%18s %8s %8s\n", "", "index", "MB/s");
+	printf("%18s %8.2f %8.1f\n", "byte at a time", byteIndex.count(), megabytes / (byteIndex.count() / 1000.0));
+	printf("%18s %8.2f %8.1f\n", "64 byte blocks", blockIndex.count(), megabytes / (blockIndex.count() / 1000.0));
+	printf("%18s %8.2f %8.1f\n", "elements only", elementIndex.count(), megabytes / (elementIndex.count() / 1000.0));
+	printf("Parsed into Things, ms:\n");
+	printf("%18s %8s %8s %8s %8s %8s %8s\n", "threads", "steals", "index", "parse", "join", "total", "MB/s");
+	printf("%18s %8s %8s %8s %8s %8.2f %8.1f\n", "jansson", "", "", "", "", jansson.count(), megabytes / (jansson.count() / 1000.0));
+	printf("%s\n", rows.c_str());
+}
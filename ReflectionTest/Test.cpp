@@ -1,8 +1,147 @@
 #include "Test.h"
+#include <cstring>
 
 meta_define(Test)
 {
 	meta_add_member(a);
 	meta_add_member(b);
 	meta_add_member(c);
-}
\ No newline at end of file
+}
+
+meta_define_enum(TestFlags)
+{
+	meta_enum_value(Flag_None);
+	meta_enum_value(Flag_Red);
+	meta_enum_value(Flag_Big);
+	meta_enum_value(Flag_Huge);
+}
+
+meta_define_enum(AccessMask)
+{
+	meta_enum_value(Access_None);
+	meta_enum_value(Access_Read);
+	meta_enum_value(Access_Admin);
+}
+
+meta_define(Grant)
+{
+	meta_add_member(id);
+	meta_add_member(access);
+}
+
+meta_define(Tagged)
+{
+	meta_add_member(tag);
+}
+
+meta_define(DerivedTest)
+{
+	meta_add_base(Test);
+	meta_add_base(Tagged);
+	meta_add_member(weight);
+}
+
+//before its base, so LateBase's members reach it as they register
+meta_define(LateDerived)
+{
+	meta_add_base(Tagged);
+	meta_add_base(LateBase);
+	meta_add_member(own);
+}
+
+meta_define(LateBase)
+{
+	meta_add_member(early);
+	meta_add_member(late);
+}
+
+meta_define(DamageArgs)
+{
+	meta_add_member(base);
+	meta_add_member(armor);
+	meta_add_member(level);
+}
+
+meta_define(Particle)
+{
+	meta_add_member(alive);
+	meta_add_member(mass);
+	meta_add_member(tag);
+	meta_add_member(life);
+	meta_add_member(flags);
+}
+
+meta_define(Article)
+{
+	meta_add_member(id);
+	meta_add_member(title);
+	meta_add_member(body);
+	meta_add_member(scores);
+	meta_add_member(tags);
+}
+
+meta_define(Body)
+{
+	meta_add_member(id);
+	meta_add_member(x);
+	meta_add_member(y);
+	meta_add_member(z);
+	meta_add_member(radius);
+	meta_add_member(mass);
+	meta_add_member(charge);
+}
+
+meta_define(Sample)
+{
+	meta_add_member(flag);
+	meta_add_member(letter);
+	meta_add_member(byte);
+	meta_add_member(small);
+	meta_add_member(smallCount);
+	meta_add_member(large);
+	meta_add_member(largeCount);
+	meta_add_member(ratio);
+	meta_add_member(value);
+	meta_add_member(label);
+}
+
+Label::Label(const char* str) : text(NULL)
+{
+	if (str != NULL)
+	{
+		text = new char[std::strlen(str) + 1];
+		std::memcpy(text, str, std::strlen(str) + 1);
+	}
+}
+
+Label::Label(const Label& other) : text(NULL)
+{
+	*this = other;
+}
+
+Label& Label::operator=(const Label& other)
+{
+	if (this != &other)
+	{
+		Label copy(other.text);
+		std::swap(text, copy.text);
+	}
+	return *this;
+}
+
+Label::~Label()
+{
+	delete[] text;
+}
+
+meta_define(Label)
+{
+	meta_add_member(text);
+}
+
+meta_define(Badge)
+{
+	meta_add_member(id);
+	meta_add_member(label);
+	meta_add_member(scale);
+}
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "Meta.h"
+#include "Arena.h"
 
 class Test
 {
@@ -18,4 +19,152 @@ public:
 
 private:
 	int c;
-};
\ No newline at end of file
+};
+
+//sparse values, so value -> name can't use a dense table
+enum TestFlags
+{
+	Flag_None = 0,
+	Flag_Red = 1,
+	Flag_Big = 64,
+	Flag_Huge = 1 << 20
+};
+
+//unsigned, with a value past the top of int
+enum AccessMask : unsigned
+{
+	Access_None = 0,
+	Access_Read = 1,
+	Access_Admin = 0x80000000u
+};
+
+struct Grant
+{
+	int id;
+	AccessMask access;
+
+	meta_expose_internal(Grant);
+};
+
+class Tagged
+{
+public:
+	int tag;
+
+	meta_expose_internal(Tagged);
+};
+
+//multiple non-virtual bases; members of both are flattened into DerivedTest
+class DerivedTest : public Test, public Tagged
+{
+public:
+	float weight;
+
+	meta_expose_internal(DerivedTest);
+};
+
+//registered after LateDerived (Test.cpp defines it later), as a base in another file may be
+class LateBase
+{
+public:
+	int early;
+	double late;
+
+	meta_expose_internal(LateBase);
+};
+
+class LateDerived : public Tagged, public LateBase
+{
+public:
+	float own;
+
+	meta_expose_internal(LateDerived);
+};
+
+//one argument set of a rules engine call, for calling a function over an array of them
+struct DamageArgs
+{
+	float base;
+	float armor;
+	int level;
+
+	meta_expose_internal(DamageArgs);
+};
+
+//declared in an order that pads it to twice its packed size
+struct Particle
+{
+	bool alive;
+	double mass;
+	char tag;
+	float life;
+	short flags;
+
+	meta_expose_internal(Particle);
+};
+
+//every allocation it owns goes through the allocator it was constructed with
+struct Article
+{
+	int id;
+	meta::ArenaString title;
+	meta::ArenaString body;
+	meta::ArenaVector<float> scores;
+	meta::ArenaVector<meta::ArenaString> tags;
+
+	meta_expose_internal(Article);
+};
+
+//a numeric heavy record
+struct Body
+{
+	int id;
+	float x;
+	float y;
+	float z;
+	float radius;
+	double mass;
+	double charge;
+
+	meta_expose_internal(Body);
+};
+
+//a leaf of each kind a column holds
+struct Sample
+{
+	bool flag;
+	char letter;
+	unsigned char byte;
+	short small;
+	unsigned short smallCount;
+	long large;
+	unsigned long largeCount;
+	float ratio;
+	double value;
+	std::string label;
+
+	meta_expose_internal(Sample);
+};
+
+//owns a copy of its text, so only its copy constructor copies it
+struct Label
+{
+	Label() : text(NULL) {}
+	explicit Label(const char* str);
+	Label(const Label& other);
+	Label& operator=(const Label& other);
+	~Label();
+
+	char* text;
+
+	meta_expose_internal(Label);
+};
+
+struct Badge
+{
+	int id;
+	Label label;
+	float scale;
+
+	meta_expose_internal(Badge);
+};
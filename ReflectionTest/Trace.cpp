@@ -0,0 +1,227 @@
+#include "Trace.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <mutex>
+
+namespace meta
+{
+	namespace internal
+	{
+		std::atomic<bool> tracing(false);
+	}
+
+	namespace
+	{
+		typedef std::chrono::high_resolution_clock Clock;
+
+		struct SpanRecord
+		{
+			const char* name;
+			const Type* type;
+			unsigned long long bytes;
+			long long begin; //ns since the trace epoch
+			long long end;
+		};
+
+		//A span in its ring. sequence is the span's index + 1 once written and 0 while it's being
+		//written, so a reader can tell a whole span from one the writer is overwriting.
+		struct SpanSlot
+		{
+			std::atomic<unsigned long long> sequence;
+			std::atomic<const char*> name;
+			std::atomic<const Type*> type;
+			std::atomic<unsigned long long> bytes;
+			std::atomic<long long> begin;
+			std::atomic<long long> end;
+		};
+
+		//One thread's spans. Only that thread writes them; readers copy from behind head, checking
+		//each slot's sequence before and after, and pass over spans that were overwritten meanwhile.
+		struct SpanRing
+		{
+			static const unsigned Capacity = 1 << 16;
+
+			SpanRing(unsigned thread) : head(0), cleared(0), thread(thread)
+			{
+				for (unsigned i = 0; i < Capacity; ++i)
+				{
+					spans[i].sequence.store(0, std::memory_order_relaxed);
+				}
+			}
+
+			SpanSlot spans[Capacity];
+			std::atomic<unsigned long long> head; //spans ever written
+			std::atomic<unsigned long long> cleared; //spans before this were cleared
+			unsigned thread;
+		};
+
+		//rings are registered once per thread and never freed, so spans outlive their threads
+		std::mutex ringsMutex;
+		std::vector<SpanRing*> rings;
+		META_THREAD_LOCAL SpanRing* threadRing = NULL;
+
+		const Clock::time_point epoch = Clock::now();
+
+		SpanRing* ThreadRing(void)
+		{
+			if (threadRing == NULL)
+			{
+				std::lock_guard<std::mutex> lock(ringsMutex);
+				threadRing = new SpanRing((unsigned)rings.size() + 1);
+				rings.push_back(threadRing);
+			}
+			return threadRing;
+		}
+
+		//copies out a ring's live spans, oldest first
+		void CopySpans(const SpanRing& ring, std::vector<SpanRecord>& out)
+		{
+			unsigned long long end = ring.head.load(std::memory_order_acquire);
+			unsigned long long begin = ring.cleared.load(std::memory_order_acquire);
+			if (end - begin > SpanRing::Capacity)
+			{
+				begin = end - SpanRing::Capacity;
+			}
+
+			for (unsigned long long i = begin; i < end; ++i)
+			{
+				const SpanSlot& slot = ring.spans[i % SpanRing::Capacity];
+				if (slot.sequence.load(std::memory_order_acquire) != i + 1)
+				{
+					continue; //already overwritten by a newer span
+				}
+
+				SpanRecord span =
+				{
+					slot.name.load(std::memory_order_relaxed),
+					slot.type.load(std::memory_order_relaxed),
+					slot.bytes.load(std::memory_order_relaxed),
+					slot.begin.load(std::memory_order_relaxed),
+					slot.end.load(std::memory_order_relaxed)
+				};
+				std::atomic_thread_fence(std::memory_order_acquire);
+				if (slot.sequence.load(std::memory_order_relaxed) == i + 1)
+				{
+					out.push_back(span);
+				}
+			}
+		}
+
+		void AppendEscaped(std::string& out, const std::string& text)
+		{
+			for (size_t i = 0; i < text.size(); ++i)
+			{
+				if (text[i] == '"' || text[i] == '\\')
+				{
+					out += '\\';
+				}
+				out += text[i];
+			}
+		}
+	}
+
+	namespace internal
+	{
+		long long TraceNow(void)
+		{
+			return std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - epoch).count();
+		}
+
+		void RecordSpan(const char* name, const Type* type, unsigned long long bytes, long long begin, long long end)
+		{
+			SpanRing* ring = ThreadRing();
+			unsigned long long at = ring->head.load(std::memory_order_relaxed);
+			SpanSlot& slot = ring->spans[at % SpanRing::Capacity];
+			slot.sequence.store(0, std::memory_order_relaxed);
+			std::atomic_thread_fence(std::memory_order_release);
+			slot.name.store(name, std::memory_order_relaxed);
+			slot.type.store(type, std::memory_order_relaxed);
+			slot.bytes.store(bytes, std::memory_order_relaxed);
+			slot.begin.store(begin, std::memory_order_relaxed);
+			slot.end.store(end, std::memory_order_relaxed);
+			slot.sequence.store(at + 1, std::memory_order_release);
+			ring->head.store(at + 1, std::memory_order_release);
+		}
+	}
+
+	void StartTracing(void)
+	{
+		internal::tracing.store(true, std::memory_order_relaxed);
+	}
+
+	void StopTracing(void)
+	{
+		internal::tracing.store(false, std::memory_order_relaxed);
+	}
+
+	void ClearTrace(void)
+	{
+		std::lock_guard<std::mutex> lock(ringsMutex);
+		for (unsigned i = 0; i < rings.size(); ++i)
+		{
+			rings[i]->cleared.store(rings[i]->head.load(std::memory_order_acquire), std::memory_order_release);
+		}
+	}
+
+	unsigned TraceSpanCount(void)
+	{
+		std::lock_guard<std::mutex> lock(ringsMutex);
+		unsigned count = 0;
+		for (unsigned i = 0; i < rings.size(); ++i)
+		{
+			unsigned long long live = rings[i]->head.load(std::memory_order_acquire) - rings[i]->cleared.load(std::memory_order_acquire);
+			count += (unsigned)std::min<unsigned long long>(live, SpanRing::Capacity);
+		}
+		return count;
+	}
+
+	void WriteChromeTrace(std::string& out)
+	{
+		std::vector<SpanRecord> spans;
+		std::vector<unsigned> threads; //of each span
+
+		{
+			std::lock_guard<std::mutex> lock(ringsMutex);
+			for (unsigned i = 0; i < rings.size(); ++i)
+			{
+				CopySpans(*rings[i], spans);
+				threads.resize(spans.size(), rings[i]->thread);
+			}
+		}
+
+		out = "{\"traceEvents\":[";
+		char buffer[256];
+		for (size_t i = 0; i < spans.size(); ++i)
+		{
+			const SpanRecord& span = spans[i];
+			sprintf(buffer, "%s\n{\"name\":\"%s\",\"cat\":\"meta\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f,\"args\":{\"bytes\":%llu",
+				i > 0 ? "," : "", span.name, threads[i], span.begin / 1000.0, (span.end - span.begin) / 1000.0, span.bytes);
+			out += buffer;
+			if (span.type != NULL)
+			{
+				out += ",\"type\":\"";
+				AppendEscaped(out, span.type->Name());
+				out += "\"";
+			}
+			out += "}}";
+		}
+		out += "\n],\"displayTimeUnit\":\"ns\"}\n";
+	}
+
+	bool SaveChromeTrace(const std::string& path)
+	{
+		std::string trace;
+		WriteChromeTrace(trace);
+
+		FILE* file = fopen(path.c_str(), "wb");
+		if (file == NULL)
+		{
+			std::cout << "Can't write trace to " << path << std::endl;
+			return false;
+		}
+		bool written = fwrite(trace.data(), 1, trace.size(), file) == trace.size();
+		fclose(file);
+		return written;
+	}
+}
@@ -0,0 +1,106 @@
+#pragma once
+
+#include "Meta.h"
+#include <atomic>
+
+//Spans compile to nothing with META_TRACING 0
+#ifndef META_TRACING
+#define META_TRACING 1
+#endif
+
+namespace meta
+{
+	//////////////////////////////////////////////////////////////////////////////
+	//  Tracing
+	//////////////////////////////////////////////////////////////////////////////
+	// Purpose: An opt-in timeline of where loading spends its time. Each span records a name,
+	//          the Type it worked on and a byte count. Spans go into a fixed ring buffer per
+	//          thread with no locks (the oldest spans are overwritten once it fills), and are
+	//          written out as Chrome trace-event JSON for chrome://tracing or Perfetto.
+	//
+	// Compiled in but stopped, a span costs one relaxed load and a branch that always goes the
+	// same way. Loading spans: "read file" and "parse" in LoadFiles, "parse in situ" in the
+	// in-situ json parser, "parse incremental" for every IncrementalJson slice, "index structurals"
+	// and "parse chunk" for NDJSON ingestion and parallel array parsing, and "materialize" for
+	// every DeSerializeJsonObject. Parsing spans count the bytes of text they worked through;
+	// "materialize" counts the object's size.
+
+	void StartTracing(void);
+	void StopTracing(void);
+
+	//drops every span recorded so far
+	void ClearTrace(void);
+
+	//spans held by the ring buffers
+	unsigned TraceSpanCount(void);
+
+	//{"traceEvents": [...]}, one complete ("X") event per span, on its recording thread's track.
+	//Best taken once tracing is stopped; spans overwritten while it's written are left out.
+	void WriteChromeTrace(std::string& out);
+	bool SaveChromeTrace(const std::string& path);
+
+	namespace internal
+	{
+		extern std::atomic<bool> tracing;
+
+		long long TraceNow(void);
+		void RecordSpan(const char* name, const Type* type, unsigned long long bytes, long long begin, long long end);
+	}
+
+	inline bool IsTracing(void)
+	{
+		return internal::tracing.load(std::memory_order_relaxed);
+	}
+
+	//////////////////////////////////////////////////////////////////////////////
+	//  TraceSpan
+	//////////////////////////////////////////////////////////////////////////////
+	// Purpose: Times the scope it lives in, if tracing was on when it opened. name must be a
+	//          string that lives as long as the program (a literal). The flag is read once, into
+	//          name, so the constructor and destructor test the same value and compile to one branch.
+#if META_TRACING
+	class TraceSpan
+	{
+	public:
+		TraceSpan(const char* spanName, const Type* type = NULL, unsigned long long bytes = 0) : name(IsTracing() ? spanName : NULL), type(type), bytes(bytes)
+		{
+			if (name != NULL)
+			{
+				begin = internal::TraceNow();
+			}
+		}
+
+		~TraceSpan()
+		{
+			if (name != NULL)
+			{
+				internal::RecordSpan(name, type, bytes, begin, internal::TraceNow());
+			}
+		}
+
+		//for what's only known once the work is done
+		void SetType(const Type* spanType) { type = spanType; }
+		void SetBytes(unsigned long long spanBytes) { bytes = spanBytes; }
+
+	private:
+		// Non-Copyable
+		TraceSpan(const TraceSpan&); // = delete
+		void operator=(const TraceSpan&); // = delete
+
+		const char* name; //NULL when not tracing
+		const Type* type;
+		unsigned long long bytes;
+		long long begin;
+	};
+#else
+	class TraceSpan
+	{
+	public:
+		TraceSpan(const char*, const Type* = NULL, unsigned long long = 0) {}
+		void SetType(const Type*) {}
+		void SetBytes(unsigned long long) {}
+	};
+#endif
+}
+
+void TestTracing();
@@ -0,0 +1,161 @@
+#include "Trace.h"
+#include "Loader.h"
+#include "SerializationTest.h"
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+
+namespace
+{
+	unsigned Occurrences(const std::string& text, const char* needle)
+	{
+		unsigned count = 0;
+		for (size_t at = text.find(needle); at != std::string::npos; at = text.find(needle, at + 1))
+			++count;
+		return count;
+	}
+
+	//whether every "odd" span has Thing and odd bytes, and every "even" one Vector3 and even bytes
+	bool WholeSpans(const std::string& trace)
+	{
+		for (size_t at = trace.find("{\"name\":"); at != std::string::npos; at = trace.find("{\"name\":", at + 1))
+		{
+			size_t lineEnd = trace.find('\n', at);
+			std::string line = trace.substr(at, lineEnd == std::string::npos ? std::string::npos : lineEnd - at);
+			bool odd = line.find("\"name\":\"odd\"") != std::string::npos;
+			bool even = line.find("\"name\":\"even\"") != std::string::npos;
+			size_t bytesAt = line.find("\"bytes\":");
+			unsigned long long bytes = bytesAt != std::string::npos ? strtoull(line.c_str() + bytesAt + 8, NULL, 10) : 0;
+			if ((odd && (line.find("\"type\":\"Thing\"") == std::string::npos || bytes % 2 != 1)) ||
+				(even && (line.find("\"type\":\"Vector3\"") == std::string::npos || bytes % 2 != 0)))
+				return false;
+		}
+		return true;
+	}
+
+	//spans opened and closed per ns, the cost of the span itself being what's measured
+	double NsPerSpan(unsigned count)
+	{
+		typedef std::chrono::high_resolution_clock Clock;
+		Clock::time_point start = Clock::now();
+		for (unsigned i = 0; i < count; ++i)
+		{
+			meta::TraceSpan span("empty", NULL, i);
+		}
+		return std::chrono::duration<double, std::nano>(Clock::now() - start).count() / count;
+	}
+}
+
+void TestTracing()
+{
+	//loading spans, tagged with the type and the bytes
+	const unsigned fileCount = 8;
+	std::vector<meta::LoadJob> jobs;
+	std::vector<Thing> things(fileCount, Thing());
+	int fileBytes = 0;
+	for (unsigned i = 0; i < fileCount; ++i)
+	{
+		char path[64];
+		sprintf(path, "TraceThing%u.json", i);
+		FILE* out = fopen(path, "wb");
+		fileBytes = fprintf(out, "{ \"Thing\": { \"id\": %u, \"name\": \"Bob\", \"position\": { \"x\": 1 } } }", i);
+		fclose(out);
+		jobs.push_back(meta::LoadJob(path, meta::get<Thing>(), &things[i]));
+	}
+
+	meta::ClearTrace();
+	meta::StartTracing();
+	meta::LoadFiles(jobs);
+	meta::StopTracing();
+
+	std::string trace;
+	meta::WriteChromeTrace(trace);
+	if (Occurrences(trace, "\"name\":\"read file\"") != fileCount || Occurrences(trace, "\"name\":\"parse\"") != fileCount ||
+		Occurrences(trace, "\"name\":\"materialize\"") != fileCount || Occurrences(trace, "\"type\":\"Thing\"") != 3 * fileCount)
+		printf("Tracing missed loading spans:\n%s\n", trace.c_str());
+	char fileSpan[64], objectSpan[64];
+	sprintf(fileSpan, "\"bytes\":%d,\"type\":\"Thing\"", fileBytes);
+	sprintf(objectSpan, "\"bytes\":%u,\"type\":\"Thing\"", (unsigned)sizeof(Thing));
+	if (Occurrences(trace, fileSpan) != 2 * fileCount || Occurrences(trace, objectSpan) != fileCount)
+		printf("Loading spans didn't count the file's and object's bytes\n");
+	if (trace.find("\"ph\":\"X\"") == std::string::npos || trace.compare(0, 16, "{\"traceEvents\":[") != 0)
+		printf("Trace isn't Chrome trace-event json\n");
+
+	for (unsigned i = 0; i < fileCount; ++i)
+		remove(jobs[i].path.c_str());
+
+	//stopped: nothing is recorded
+	meta::ClearTrace();
+	json_t* json = json_loads("{ \"id\": 3 }", 0, NULL);
+	DeSerializeJsonObject(json, &things[0], "Thing");
+	json_decref(json);
+	if (meta::TraceSpanCount() != 0)
+		printf("Tracing recorded spans while stopped\n");
+
+	//each thread gets its own track; a full ring keeps the newest spans
+	meta::StartTracing();
+	std::vector<std::thread> threads;
+	for (unsigned t = 0; t < 3; ++t)
+	{
+		threads.push_back(std::thread([]()
+		{
+			for (unsigned i = 0; i < 100000; ++i)
+			{
+				meta::TraceSpan span("worker", meta::get<Vector3>(), i);
+			}
+		}));
+	}
+	for (unsigned t = 0; t < threads.size(); ++t)
+		threads[t].join();
+	meta::StopTracing();
+
+	meta::WriteChromeTrace(trace);
+	if (meta::TraceSpanCount() != 3 * 65536 || Occurrences(trace, "\"name\":\"worker\"") != 3 * 65536 || trace.find("\"bytes\":99999,") == std::string::npos)
+		printf("Tracing didn't keep the newest worker spans (%u)\n", meta::TraceSpanCount());
+	meta::ClearTrace();
+
+	//read while the writers lap their rings: spans come out whole or not at all
+	{
+		std::atomic<bool> stop(false);
+		std::vector<std::thread> writers;
+		meta::StartTracing();
+		for (unsigned t = 0; t < 2; ++t)
+		{
+			writers.push_back(std::thread([&stop]()
+			{
+				for (unsigned i = 0; !stop.load(std::memory_order_relaxed); ++i)
+				{
+					meta::TraceSpan span(i % 2 ? "odd" : "even", i % 2 ? meta::get<Thing>() : meta::get<Vector3>(), i);
+				}
+			}));
+		}
+		bool whole = true;
+		for (unsigned r = 0; r < 20 && whole; ++r)
+		{
+			meta::WriteChromeTrace(trace);
+			whole = WholeSpans(trace);
+		}
+		stop.store(true);
+		for (unsigned t = 0; t < writers.size(); ++t)
+			writers[t].join();
+		meta::StopTracing();
+		meta::ClearTrace();
+		if (!whole)
+			printf("Tracing wrote a span torn by its writer\n");
+	}
+
+	//the cost of a span
+	const unsigned spans = 10000000;
+	double stopped = NsPerSpan(spans);
+	meta::StartTracing();
+	double recording = NsPerSpan(spans);
+	meta::StopTracing();
+	meta::ClearTrace();
+
+	printf("Trace span cost, ns:\n");
+	printf("%18s %8.2f\n", "stopped", stopped);
+	printf("%18s %8.2f\n", "recording", recording);
+	printf("\n");
+}
@@ -19,6 +19,29 @@ namespace meta
 			data = meta->NewCopy(&value);
 		}
 
+		Variant(const Variant& rhs) : meta(rhs.meta), data(rhs.meta->NewCopy(rhs.data)) {}
+
+		~Variant()
+		{
+			meta->Delete(data);
+		}
+
+		Variant& operator=(const Variant& rhs)
+		{
+			if (meta != rhs.meta)
+			{
+				void* copy = rhs.meta->NewCopy(rhs.data);
+				meta->Delete(data);
+				meta = rhs.meta;
+				data = copy;
+			}
+			else
+			{
+				meta->Copy(data, rhs.data);
+			}
+			return *this;
+		}
+
 		template <typename TYPE>
 		Variant& operator=(const TYPE& rhs)
 		{
@@ -57,6 +80,10 @@ namespace meta
 			return meta->Name();
 		}
 
+		const Type* GetType() const { return meta; }
+		void* GetData() { return data; }
+		const void* GetData() const { return data; }
+
 	private:
 		const meta::Type* meta;
 		void* data;
@@ -110,6 +137,9 @@ namespace meta
 			return *reinterpret_cast<T *>(reference);
 		}
 
+		const Type* GetType() const { return meta; }
+		void* GetData() const { return reference; }
+
 	private:
 		const meta::Type* meta;
 		void* reference;
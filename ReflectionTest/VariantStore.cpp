@@ -0,0 +1,261 @@
+#include "VariantStore.h"
+#include <algorithm>
+
+namespace meta
+{
+	VariantStore::VariantStore() : lastBucket(NULL), live(0)
+	{
+	}
+
+	VariantStore::~VariantStore()
+	{
+		Clear();
+		for (unsigned i = 0; i < buckets.size(); ++i)
+		{
+			delete[] buckets[i]->data;
+			delete buckets[i];
+		}
+	}
+
+	VariantStore::Bucket* VariantStore::FindOrAddBucket(const Type* type)
+	{
+		if (lastBucket != NULL && lastBucket->type == type)
+		{
+			return lastBucket;
+		}
+
+		std::unordered_map<const Type*, unsigned>::const_iterator found = bucketOf.find(type);
+		if (found != bucketOf.end())
+		{
+			lastBucket = buckets[found->second];
+			return lastBucket;
+		}
+
+		assert(type->IsCopyConstructible()); //values are copied into their bucket
+		assert(type->Alignment() <= sizeof(double) * 2);	//buckets come from operator new[]
+
+		bucketOf[type] = (unsigned)buckets.size();
+		buckets.push_back(new Bucket(type, (unsigned)buckets.size()));
+		lastBucket = buckets.back();
+		return lastBucket;
+	}
+
+	VariantStore::Bucket* VariantStore::Find(const Type* type)
+	{
+		std::unordered_map<const Type*, unsigned>::const_iterator found = bucketOf.find(type);
+		return found != bucketOf.end() ? buckets[found->second] : NULL;
+	}
+
+	const VariantStore::Bucket* VariantStore::Find(const Type* type) const
+	{
+		std::unordered_map<const Type*, unsigned>::const_iterator found = bucketOf.find(type);
+		return found != bucketOf.end() ? buckets[found->second] : NULL;
+	}
+
+	void VariantStore::Grow(Bucket* bucket)
+	{
+		const Type* type = bucket->type;
+		unsigned capacity = bucket->capacity > 0 ? bucket->capacity * 2 : 16;
+		char* data = new char[capacity * type->Size()];
+
+		if (type->IsTriviallyCopyable())
+		{
+			if (bucket->count > 0)
+			{
+				std::memcpy(data, bucket->data, bucket->count * type->Size());
+			}
+		}
+		else if (type->IsConstructible() && type->IsMovable())
+		{
+			for (unsigned i = 0; i < bucket->count; ++i)
+			{
+				type->Construct(data + i * type->Size());
+				type->Move(data + i * type->Size(), bucket->At(i));
+				type->Destruct(bucket->At(i));
+			}
+		}
+		else
+		{
+			for (unsigned i = 0; i < bucket->count; ++i)
+			{
+				type->CopyConstruct(data + i * type->Size(), bucket->At(i));
+				type->Destruct(bucket->At(i));
+			}
+		}
+
+		delete[] bucket->data;
+		bucket->data = data;
+		bucket->capacity = capacity;
+	}
+
+	VariantStore::Handle VariantStore::Insert(const Type* type, const void* value)
+	{
+		assert(type != NULL);
+		Bucket* bucket = FindOrAddBucket(type);
+
+		if (bucket->count == bucket->capacity)
+		{
+			//a value from the bucket itself moves with it
+			const char* from = static_cast<const char*>(value);
+			size_t offset = (size_t)(from - bucket->data);
+			bool inside = bucket->data != NULL && from >= bucket->data && offset < (size_t)bucket->count * type->Size();
+			Grow(bucket);
+			if (inside)
+			{
+				value = bucket->data + offset;
+			}
+		}
+
+		unsigned index = bucket->count;
+		type->CopyConstruct(bucket->At(index), value);
+		++bucket->count;
+
+		unsigned slot;
+		if (!freeSlots.empty())
+		{
+			slot = freeSlots.back();
+			freeSlots.pop_back();
+		}
+		else
+		{
+			slot = (unsigned)slots.size();
+			Slot fresh = { Dead, 0, 0 };
+			slots.push_back(fresh);
+		}
+
+		slots[slot].bucket = bucket->id;
+		slots[slot].index = index;
+		bucket->slots.push_back(slot);
+
+		Handle handle = { slot, slots[slot].generation };
+		order.push_back(handle);
+		++live;
+
+		for (unsigned i = 0; i < bucket->listeners.size(); ++i)
+		{
+			bucket->listeners[i]->Inserted(bucket->At(index), handle);
+		}
+		return handle;
+	}
+
+	void VariantStore::Erase(Handle handle)
+	{
+		if (!IsValid(handle))
+		{
+			std::cout << "VariantStore: erasing a value that is already gone" << std::endl;
+			return;
+		}
+
+		Slot& slot = slots[handle.slot];
+		Bucket* bucket = buckets[slot.bucket];
+		const Type* type = bucket->type;
+		unsigned last = bucket->count - 1;
+
+		for (unsigned i = 0; i < bucket->listeners.size(); ++i)
+		{
+			bucket->listeners[i]->Erasing(bucket->At(slot.index), handle);
+		}
+
+		//fill the hole with the last value of the bucket
+		if (slot.index != last)
+		{
+			if (type->IsMovable())
+				type->Move(bucket->At(slot.index), bucket->At(last));
+			else
+				type->Copy(bucket->At(slot.index), bucket->At(last));
+			unsigned moved = bucket->slots[last];
+			slots[moved].index = slot.index;
+			bucket->slots[slot.index] = moved;
+		}
+		type->Destruct(bucket->At(last));
+		bucket->slots.pop_back();
+		--bucket->count;
+
+		slot.bucket = Dead;
+		++slot.generation;
+		freeSlots.push_back(handle.slot);
+		--live;
+
+		if (order.size() > 64 && order.size() > live * 2)
+		{
+			CompactOrder();
+		}
+	}
+
+	void VariantStore::CompactOrder(void)
+	{
+		unsigned kept = 0;
+		for (unsigned i = 0; i < order.size(); ++i)
+		{
+			if (IsValid(order[i]))
+			{
+				order[kept++] = order[i];
+			}
+		}
+		order.resize(kept);
+	}
+
+	void VariantStore::Clear(void)
+	{
+		for (unsigned i = 0; i < buckets.size(); ++i)
+		{
+			Bucket* bucket = buckets[i];
+			for (unsigned j = 0; j < bucket->count; ++j)
+			{
+				bucket->type->Destruct(bucket->At(j));
+			}
+			bucket->count = 0;
+			bucket->slots.clear();
+
+			for (unsigned j = 0; j < bucket->listeners.size(); ++j)
+			{
+				bucket->listeners[j]->Cleared();
+			}
+		}
+
+		//bump generations so handles from before the clear read as erased
+		freeSlots.clear();
+		for (unsigned i = 0; i < slots.size(); ++i)
+		{
+			slots[i].bucket = Dead;
+			++slots[i].generation;
+			freeSlots.push_back((unsigned)slots.size() - 1 - i);
+		}
+		order.clear();
+		live = 0;
+	}
+
+	void VariantStore::AddListener(const Type* type, Listener* listener)
+	{
+		FindOrAddBucket(type)->listeners.push_back(listener);
+	}
+
+	void VariantStore::RemoveListener(const Type* type, Listener* listener)
+	{
+		Bucket* bucket = Find(type);
+		if (bucket != NULL)
+		{
+			std::vector<Listener*>& listeners = bucket->listeners;
+			listeners.erase(std::remove(listeners.begin(), listeners.end(), listener), listeners.end());
+		}
+	}
+
+	const Type* VariantStore::TypeOf(Handle handle) const
+	{
+		return IsValid(handle) ? buckets[slots[handle.slot].bucket]->type : NULL;
+	}
+
+	void* VariantStore::Get(Handle handle)
+	{
+		assert(IsValid(handle)); //value was erased
+		const Slot& slot = slots[handle.slot];
+		return buckets[slot.bucket]->At(slot.index);
+	}
+
+	const void* VariantStore::Get(Handle handle) const
+	{
+		assert(IsValid(handle)); //value was erased
+		const Slot& slot = slots[handle.slot];
+		return buckets[slot.bucket]->At(slot.index);
+	}
+}
@@ -0,0 +1,175 @@
+#pragma once
+
+#include "Meta.h"
+
+namespace meta
+{
+	//////////////////////////////////////////////////////////////////////////////
+	//  VariantStore
+	//////////////////////////////////////////////////////////////////////////////
+	// Purpose: Holds values of any registered type like a std::vector<Variant>, but keeps the
+	//          values of each type packed together in that type's bucket, so scanning every
+	//          value of one type walks a plain array. Values are reached through handles that
+	//          stay valid while other values come and go, and can still be visited in the
+	//          order they were inserted. Erasing moves the last value of the bucket into the
+	//          hole, so raw pointers into a bucket don't survive inserts or erases.
+	//          Not thread safe.
+	class VariantStore
+	{
+	public:
+		//a handle to a value. The generation tells a live handle from one to an erased value
+		//whose slot was handed out again.
+		struct Handle
+		{
+			unsigned slot;
+			unsigned generation;
+		};
+
+		//told about the values of one type as they are inserted, just before they are erased,
+		//and when the store is cleared
+		class Listener
+		{
+		public:
+			virtual ~Listener() {}
+			virtual void Inserted(const void* value, Handle handle) = 0;
+			virtual void Erasing(const void* value, Handle handle) = 0;
+			virtual void Cleared(void) = 0;
+		};
+
+		//all values of one type, Count() of them, Stride() bytes apart from Data()
+		class Bucket
+		{
+		public:
+			const Type* GetType(void) const { return type; }
+			unsigned Count(void) const { return count; }
+			unsigned Stride(void) const { return type->Size(); }
+			void* Data(void) { return data; }
+			const void* Data(void) const { return data; }
+			void* At(unsigned i) { return data + i * type->Size(); }
+			const void* At(unsigned i) const { return data + i * type->Size(); }
+
+		private:
+			friend class VariantStore;
+
+			Bucket(const Type* type, unsigned id) : type(type), id(id), data(NULL), count(0), capacity(0) {}
+
+			const Type* type;
+			unsigned id;
+			char* data;
+			unsigned count;
+			unsigned capacity;
+			std::vector<unsigned> slots; //slot of each value, to fix up handles when values move
+			std::vector<Listener*> listeners;
+		};
+
+		VariantStore();
+		~VariantStore();
+
+		Handle Insert(const Type* type, const void* value);
+		Handle Insert(const Variant& value) { return Insert(value.GetType(), value.GetData()); }
+
+		template <typename T>
+		Handle Insert(const T& value)
+		{
+			return Insert(meta::get<T>(), &value);
+		}
+
+		void Erase(Handle handle);
+		void Clear(void);
+
+		bool IsValid(Handle handle) const
+		{
+			return handle.slot < slots.size() && slots[handle.slot].generation == handle.generation && slots[handle.slot].bucket != Dead;
+		}
+
+		const Type* TypeOf(Handle handle) const;
+		void* Get(Handle handle);
+		const void* Get(Handle handle) const;
+
+		template <typename T>
+		T& Get(Handle handle)
+		{
+			assert(TypeOf(handle) == meta::get<T>()); //handle holds another type
+			return *static_cast<T*>(Get(handle));
+		}
+
+		unsigned Size(void) const { return live; }
+
+		//the bucket of type, or NULL if no value of it was ever inserted
+		Bucket* Find(const Type* type);
+		const Bucket* Find(const Type* type) const;
+		unsigned BucketCount(void) const { return (unsigned)buckets.size(); }
+		Bucket& BucketAt(unsigned i) { return *buckets[i]; }
+
+		//the handle of the i-th value of a bucket
+		Handle HandleAt(const Bucket& bucket, unsigned i) const
+		{
+			unsigned slot = bucket.slots[i];
+			Handle handle = { slot, slots[slot].generation };
+			return handle;
+		}
+
+		//listeners are told about values of type from then on; they must be removed before they die
+		void AddListener(const Type* type, Listener* listener);
+		void RemoveListener(const Type* type, Listener* listener);
+
+		//calls f(T&) on every value of type T, straight down its bucket
+		template <typename T, typename F>
+		void ForEach(F f)
+		{
+			Bucket* bucket = Find(meta::get<T>());
+			if (bucket != NULL)
+			{
+				T* values = reinterpret_cast<T*>(bucket->data);
+				for (unsigned i = 0; i < bucket->count; ++i)
+				{
+					f(values[i]);
+				}
+			}
+		}
+
+		//calls f(const Type*, void*, Handle) on every value in insertion order
+		template <typename F>
+		void Visit(F f)
+		{
+			for (unsigned i = 0; i < order.size(); ++i)
+			{
+				const Slot& slot = slots[order[i].slot];
+				if (slot.generation == order[i].generation && slot.bucket != Dead)
+				{
+					Bucket* bucket = buckets[slot.bucket];
+					f(bucket->type, bucket->At(slot.index), order[i]);
+				}
+			}
+		}
+
+	private:
+		// Non-Copyable
+		VariantStore(const VariantStore&); // = delete
+		void operator=(const VariantStore&); // = delete
+
+		static const unsigned Dead = ~0u;
+
+		struct Slot
+		{
+			unsigned bucket; //Dead once erased
+			unsigned index;
+			unsigned generation;
+		};
+
+		Bucket* FindOrAddBucket(const Type* type);
+		void Grow(Bucket* bucket);
+		void CompactOrder(void);
+
+		std::vector<Bucket*> buckets;
+		std::unordered_map<const Type*, unsigned> bucketOf;
+		Bucket* lastBucket; //runs of one type skip the map lookup
+
+		std::vector<Slot> slots;
+		std::vector<unsigned> freeSlots;
+		std::vector<Handle> order; //every handle ever inserted, erased ones dropped lazily
+		unsigned live;
+	};
+}
+
+void TestVariantStore();
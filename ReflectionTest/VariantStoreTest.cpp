@@ -0,0 +1,99 @@
+#include "VariantStore.h"
+#include "SerializationTest.h"
+#include <chrono>
+
+void TestVariantStore()
+{
+	typedef std::chrono::high_resolution_clock Clock;
+
+	//a property bag: floats, ints, strings and vectors mixed together
+	const unsigned count = 1000000;
+	std::vector<meta::Variant> variants;
+	variants.reserve(count);
+	meta::VariantStore store;
+	std::vector<meta::VariantStore::Handle> handles;
+	handles.reserve(count);
+
+	for (unsigned i = 0; i < count; ++i)
+	{
+		switch (i % 4)
+		{
+			case 0: variants.push_back(meta::Variant((float)i)); break;
+			case 1: variants.push_back(meta::Variant((int)i)); break;
+			case 2: variants.push_back(meta::Variant(Vector3((float)i, 0.0f, 0.0f))); break;
+			case 3: variants.push_back(meta::Variant(std::string("property"))); break;
+		}
+		handles.push_back(store.Insert(variants.back()));
+	}
+
+	if (store.Size() != count || store.BucketCount() != 4 || store.Find(meta::get<float>())->Count() != count / 4)
+		printf("VariantStore didn't bucket %u values by type\n", count);
+
+	//erasing moves values around inside their bucket, but other handles keep their value
+	for (unsigned i = 0; i < count; i += 8)
+		store.Erase(handles[i]);
+	if (store.IsValid(handles[0]) || store.TypeOf(handles[0]) != NULL)
+		printf("VariantStore handle survived Erase\n");
+	if (store.Get<float>(handles[4]) != 4.0f || store.Get<int>(handles[9]) != 9 || store.Get<Vector3>(handles[10]).x != 10.0f)
+		printf("VariantStore handle lost its value after Erase\n");
+
+	unsigned visited = 0;
+	bool ordered = true;
+	store.Visit([&](const meta::Type* type, void*, meta::VariantStore::Handle handle)
+	{
+		//every 8th value is gone, so the nth visited value is value 8 * (n / 7) + n % 7 + 1
+		unsigned expected = 8 * (visited / 7) + visited % 7 + 1;
+		if (handle.slot != handles[expected].slot || type != variants[expected].GetType())
+			ordered = false;
+		++visited;
+	});
+	if (!ordered || visited != store.Size())
+		printf("VariantStore::Visit didn't visit in insertion order\n");
+
+	//handles from the erased values don't see the values reusing their slots
+	meta::VariantStore::Handle reused = store.Insert(1.5f);
+	if (reused.slot == handles[0].slot && store.IsValid(handles[0]))
+		printf("VariantStore stale handle sees a new value\n");
+	store.Erase(reused);
+
+	//inserting a copy of a value in a full bucket, which grows out from under it
+	{
+		meta::VariantStore strings;
+		meta::VariantStore::Handle first = strings.Insert(std::string("a string long enough to live on the heap"));
+		while (strings.Find(meta::get<std::string>())->Count() < 16)
+			strings.Insert(std::string("another string long enough to live on the heap"));
+		meta::VariantStore::Handle copy = strings.Insert(meta::get<std::string>(), strings.Get(first));
+		if (strings.Get<std::string>(copy) != "a string long enough to live on the heap" || strings.Get<std::string>(first) != strings.Get<std::string>(copy))
+			printf("VariantStore didn't insert a value from its own full bucket\n");
+	}
+
+	//summing every float: type check per element vs one bucket
+	double sum = 0.0;
+	const meta::Type* floatType = meta::get<float>();
+
+	Clock::time_point start = Clock::now();
+	for (unsigned i = 0; i < variants.size(); ++i)
+	{
+		if (variants[i].GetType() == floatType)
+			sum += variants[i].GetValue<float>();
+	}
+	std::chrono::duration<double, std::milli> scattered = Clock::now() - start;
+
+	start = Clock::now();
+	store.ForEach<float>([&sum](float value) { sum += value; });
+	std::chrono::duration<double, std::milli> bucketed = Clock::now() - start;
+
+	start = Clock::now();
+	store.Visit([&sum, floatType](const meta::Type* type, void* value, meta::VariantStore::Handle)
+	{
+		if (type == floatType)
+			sum += *static_cast<float*>(value);
+	});
+	std::chrono::duration<double, std::milli> inOrder = Clock::now() - start;
+
+	printf("Scanning the floats of %u mixed values, ms (sum %g):\n", count, sum);
+	printf("%18s %8.2f\n", "vector<Variant>", scattered.count());
+	printf("%18s %8.2f\n", "VariantStore", bucketed.count());
+	printf("%18s %8.2f\n", "insertion order", inOrder.count());
+	printf("\n");
+}
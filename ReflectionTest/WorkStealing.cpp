@@ -0,0 +1,116 @@
+#include "WorkStealing.h"
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace meta
+{
+	namespace
+	{
+		//the tasks a worker has left, [next, end)
+		struct TaskRange
+		{
+			TaskRange() : next(0), end(0) {}
+
+			std::mutex mutex;
+			unsigned next;
+			unsigned end;
+		};
+
+		bool TakeOwn(TaskRange& range, unsigned& index)
+		{
+			std::lock_guard<std::mutex> lock(range.mutex);
+			if (range.next >= range.end)
+			{
+				return false;
+			}
+			index = range.next++;
+			return true;
+		}
+
+		//the back half of victim's tasks become thief's, which has run dry
+		bool Steal(TaskRange& victim, TaskRange& thief)
+		{
+			unsigned next, end;
+			{
+				std::lock_guard<std::mutex> lock(victim.mutex);
+				if (victim.next >= victim.end)
+				{
+					return false;
+				}
+				end = victim.end;
+				next = victim.end - (victim.end - victim.next + 1) / 2;
+				victim.end = next;
+			}
+
+			std::lock_guard<std::mutex> lock(thief.mutex);
+			thief.next = next;
+			thief.end = end;
+			return true;
+		}
+
+		void Work(std::vector<TaskRange>& ranges, unsigned worker, const std::function<void(unsigned, unsigned)>& task, std::atomic<unsigned>& steals)
+		{
+			while (true)
+			{
+				unsigned index;
+				while (TakeOwn(ranges[worker], index))
+				{
+					task(index, worker);
+				}
+
+				//done once nobody has tasks left to take; ones still running are their workers' to finish
+				bool stole = false;
+				for (unsigned i = 1; i < ranges.size() && !stole; ++i)
+				{
+					stole = Steal(ranges[(worker + i) % ranges.size()], ranges[worker]);
+				}
+				if (!stole)
+				{
+					return;
+				}
+				++steals;
+			}
+		}
+	}
+
+	unsigned WorkStealingThreads(unsigned count, unsigned threads)
+	{
+		if (threads == 0)
+		{
+			threads = std::thread::hardware_concurrency();
+		}
+		threads = threads < count ? threads : count;
+		return threads > 0 ? threads : 1;
+	}
+
+	unsigned RunWorkStealing(unsigned count, unsigned threads, const std::function<void(unsigned index, unsigned worker)>& task)
+	{
+		if (count == 0)
+		{
+			return 0;
+		}
+
+		threads = WorkStealingThreads(count, threads);
+		std::vector<TaskRange> ranges(threads);
+		for (unsigned w = 0; w < threads; ++w)
+		{
+			ranges[w].next = (unsigned)((unsigned long long)count * w / threads);
+			ranges[w].end = (unsigned)((unsigned long long)count * (w + 1) / threads);
+		}
+
+		std::atomic<unsigned> steals(0);
+		std::vector<std::thread> workers;
+		for (unsigned w = 1; w < threads; ++w)
+		{
+			workers.push_back(std::thread(Work, std::ref(ranges), w, std::cref(task), std::ref(steals)));
+		}
+		Work(ranges, 0, task, steals);
+		for (unsigned w = 0; w < workers.size(); ++w)
+		{
+			workers[w].join();
+		}
+		return steals.load();
+	}
+}
@@ -0,0 +1,19 @@
+#pragma once
+
+#include <functional>
+
+namespace meta
+{
+	//////////////////////////////////////////////////////////////////////////////
+	//  Work stealing
+	//////////////////////////////////////////////////////////////////////////////
+	// Purpose: Runs task(index, worker) for every index below count, on threads workers (0 uses
+	//          every hardware thread); the calling thread is worker 0. Each worker starts on its
+	//          own contiguous run of indices and takes them in order, so neighbouring tasks stay
+	//          on one worker. A worker that runs dry steals the back half of another's run.
+	//          Returns how many steals it took to balance.
+	unsigned RunWorkStealing(unsigned count, unsigned threads, const std::function<void(unsigned index, unsigned worker)>& task);
+
+	//the workers RunWorkStealing would use for count tasks
+	unsigned WorkStealingThreads(unsigned count, unsigned threads);
+}
@@ -4,6 +4,27 @@
 #include <type_traits>
 #include "SerializationTest.h"
 #include "FunctionTest.h"
+#include "Pool.h"
+#include "Clone.h"
+#include "PropertyPath.h"
+#include "Gather.h"
+#include "Loader.h"
+#include "VariantStore.h"
+#include "MsgPack.h"
+#include "KeyShape.h"
+#include "MmapJson.h"
+#include "Sort.h"
+#include "Index.h"
+#include "HotReload.h"
+#include "Trace.h"
+#include "Layout.h"
+#include "Arena.h"
+#include "IncrementalJson.h"
+#include "NdJson.h"
+#include "StructuralIndex.h"
+#include "JsonNumber.h"
+#include "Compression.h"
+#include "Columnar.h"
 
 void BasicTypeTest()
 {
@@ -77,8 +98,33 @@ int main(int argc, const char* argv[])
 {
 	//BasicTypeTest();
 	//TestVariant();
+	TestInheritance();
+	TestEnumReflection();
 	TestDeSerialization();
 	FunctionSignatureTest();
+	FunctionBatchTest();
+	TestObjectPool();
+	TestSchemaMigration();
+	TestClone();
+	TestPropertyPath();
+	TestGatherScatter();
+	TestPipelinedLoad();
+	TestVariantStore();
+	TestMsgPack();
+	TestKeyShape();
+	TestMmapJson();
+	TestReflectiveSort();
+	TestIndex();
+	TestHotReload();
+	TestTracing();
+	TestLayout();
+	TestArena();
+	TestIncrementalJson();
+	TestNdJson();
+	TestStructuralIndex();
+	TestJsonNumber();
+	TestCompression();
+	TestColumnar();
 
 	return 0;
 }
\ No newline at end of file